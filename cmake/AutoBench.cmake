@@ -0,0 +1,43 @@
+# Copyright (c) 2017 Quenza Inc. All rights reserved.
+# Copyright (c) 2018 Blub Corp. All rights reserved.
+#
+# This file is part of the Cryptox project.
+#
+# Use of this source code is governed by a private license
+# that can be found in the LICENSE file. Content can not be 
+# copied and/or distributed without the express of the author.
+
+function(enable_auto_bench BENCH_NAME)
+	if(NOT PROJECT_NAME)
+		message(FATAL_ERROR "Enable auto benchmarks after project preperations")
+	endif()
+
+	if(NOT ${${Cryptox_ID}_BUILD_BENCHMARK})
+		return()
+	endif()
+
+	# Enable benchmarks if there are benchmark sources
+	if(EXISTS ${CMAKE_CURRENT_SOURCE_DIR}/${${PROJECT_NAME}_BENCH})
+		message(STATUS "Enable benchmarks for ${PROJECT_NAME}")
+
+		file(GLOB ${PROJECT_NAME}_BENCH_SRC ${${PROJECT_NAME}_BENCH}/*.cpp)
+		add_executable(${PROJECT_NAME}_bench
+			${${PROJECT_NAME}_BENCH_SRC}
+		)
+
+		string(TOLOWER ${PROJECT_NAME}_bench ${PROJECT_NAME}_OUT_EXE)
+		set_target_properties(${PROJECT_NAME}_bench
+			PROPERTIES
+			OUTPUT_NAME ${${PROJECT_NAME}_OUT_EXE}
+			PROJECT_LABEL "${BENCH_NAME}"
+			ARCHIVE_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/lib"
+			LIBRARY_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/lib"
+			RUNTIME_OUTPUT_DIRECTORY "${CMAKE_BINARY_DIR}/bin"
+		)
+
+		target_link_libraries(${PROJECT_NAME}_bench
+			${PROJECT_NAME}
+			${Boost_LIBRARIES}
+		)
+	endif()
+endfunction()
@@ -75,6 +75,8 @@ extern "C" {
 		int keep_comment : 1;
 		// Prevent the removal of unused structures.
 		int keep_zero_ref_cnt : 1;
+		// Lower program into register bytecode.
+		int emit_bytecode : 1;
 	};
 
 	// Source unit metadata.
@@ -161,12 +163,17 @@ extern "C" {
 	// Retrieve resulting section from program.
 	COILCLAPI void GetResultSection(result_t *) NOTHROW;
 
+	// Restore program from resulting section. The function bodies are only
+	// loaded when used. If the section cannot be restored no program is set.
+	COILCLAPI void LoadResultSection(result_t *) NOTHROW;
+
 	// Library version information.
 	COILCLAPI void GetLibraryInfo(library_info_t *) NOTHROW;
 
 	// C function defines.
 #define coilcl_compile(p) Compile(p)
 #define coilcl_get_result_section(p) GetResultSection(p)
+#define coilcl_load_result_section(p) LoadResultSection(p)
 #define coilcl_get_library_info(p) GetLibraryInfo(p)
 
 #ifdef __cplusplus
@@ -9,7 +9,16 @@
 #include "Sequencer.h"
 
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <unordered_map>
 
 // TODO:
 // - Visitor can be simplified
@@ -28,40 +37,243 @@ using namespace CryCC::AST;
 // AIIPX marker to recognize this particular sequencer
 static uint8_t initMarker[] = { 0x9, 0x3, 0xef, 0x17 };
 
+// Stream format versions. Version 1 streams have no version byte and the
+// marker is directly followed by the first node. The first byte of a node
+// never has the high bit set, which tells both formats apart. Version 3
+// streams state the highest node identifier in the declaration index.
+enum : uint8_t { AIIPX_V1 = 1, AIIPX_V2 = 2, AIIPX_V3 = 3 };
+constexpr const uint8_t versionFlag = 0x80;
+
+// Size of the version 2 stream header.
+constexpr const size_t headerSize = sizeof(initMarker) + sizeof(uint8_t) + sizeof(uint32_t);
+
+// Upper bound on the node list size. Larger lengths are taken for a corrupt
+// stream, rather than allocated up front.
+constexpr const size_t maxNodeListSize = 256 * 1024 * 1024;
+
+// Average size of a serialized node, used as reserve hint.
+constexpr const size_t nodeSizeHint = 24;
+
+// Trees below these sizes are not worth the thread overhead.
+constexpr const size_t parallelNodeThreshold = 4096;
+constexpr const size_t parallelByteThreshold = 64 * 1024;
+
 using OutputCallback = std::function<void(uint8_t *data, size_t sz)>;
 using InputCallback = std::function<void(uint8_t *data, size_t sz)>;
+using BufferCallback = std::function<void(std::vector<uint8_t>&&)>;
 
 class ChildGroup;
+class Visitor;
+
+// Decoder state shared with deferred sections. The string table
+// belongs to the chunk, the node list is program wide.
+struct StreamState
+{
+	std::vector<std::string> stringTable;
+	std::shared_ptr<std::map<int, std::weak_ptr<ASTNode>>> nodeList;
+};
+
+ASTNodeType DecodeNodes(Visitor *visitor, size_t length);
+
+// Input callback on a memory range. Reads past the end of the range
+// mean the stream is corrupt.
+InputCallback MakeMemoryInput(const uint8_t *data, size_t size)
+{
+	return [data, size, offset = size_t{ 0 }](uint8_t *out, size_t sz) mutable
+	{
+		if (sz > size - offset) {
+			throw ASTFactory::InvalidStreamException{};
+		}
+		std::copy_n(data + offset, sz, out);
+		offset += sz;
+	};
+}
+
+// Process wide set of worker threads shared by all pack and unpack
+// operations. The threads are started on first use and live until the
+// process exits.
+class WorkerPool final
+{
+public:
+	static WorkerPool& Shared()
+	{
+		static WorkerPool pool{ std::max<size_t>(std::thread::hardware_concurrency(), 2) - 1 };
+		return pool;
+	}
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	~WorkerPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_stop = true;
+		}
+		m_workQueued.notify_all();
+
+		for (auto& thread : m_threads) {
+			thread.join();
+		}
+	}
+
+	// Queue the work item, the work item must not throw.
+	void Submit(std::function<void()> work)
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_queue.push_back(std::move(work));
+		}
+		m_workQueued.notify_one();
+	}
+
+	// Number of worker threads.
+	inline size_t ThreadCount() const noexcept { return m_threads.size(); }
+
+private:
+	explicit WorkerPool(size_t threads)
+	{
+		m_threads.reserve(threads);
+		for (size_t i = 0; i < threads; ++i) {
+			m_threads.emplace_back(&WorkerPool::Worker, this);
+		}
+	}
+
+	void Worker()
+	{
+		for (;;) {
+			std::function<void()> work;
+			{
+				std::unique_lock<std::mutex> lock{ m_mutex };
+				m_workQueued.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+				if (m_queue.empty()) { return; }
+
+				work = std::move(m_queue.front());
+				m_queue.pop_front();
+			}
+
+			work();
+		}
+	}
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_workQueued;
+	std::deque<std::function<void()>> m_queue;
+	bool m_stop{ false };
+	std::vector<std::thread> m_threads;
+};
+
+// Run the work items on the shared worker threads. The calling thread takes
+// part in the work. The first exception thrown by any item is rethrown.
+template<typename CallableType>
+void ParallelFor(size_t count, size_t workers, CallableType&& func)
+{
+	WorkerPool& pool = WorkerPool::Shared();
+	workers = std::min({ workers, count, pool.ThreadCount() + 1 });
+	if (workers < 2) {
+		for (size_t i = 0; i < count; ++i) {
+			func(i);
+		}
+		return;
+	}
+
+	std::atomic<size_t> next{ 0 };
+	std::exception_ptr error;
+	std::mutex lock;
+	std::condition_variable helpersDone;
+	size_t helpers = workers - 1;
+	auto worker = [&]()
+	{
+		for (size_t i = next++; i < count; i = next++) {
+			try {
+				func(i);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> guard{ lock };
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+		}
+	};
+
+	// The helpers refer to this frame, wait for all of them to finish even
+	// when the calling thread has run out of work.
+	for (size_t i = 1; i < workers; ++i) {
+		pool.Submit([&]()
+		{
+			worker();
+			std::lock_guard<std::mutex> guard{ lock };
+			if (!--helpers) {
+				helpersDone.notify_one();
+			}
+		});
+	}
+	worker();
+
+	std::unique_lock<std::mutex> guard{ lock };
+	helpersDone.wait(guard, [&helpers] { return !helpers; });
+
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+// Number of worker threads, an explicit count is taken as is. Zero selects
+// the hardware concurrency, or a single thread if the work is below the
+// threshold.
+size_t WorkerCount(size_t workers, size_t work, size_t threshold)
+{
+	if (workers) { return workers; }
+	if (work < threshold) { return 1; }
+	return std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
 
 class Visitor final : public Serializable::VisitorInterface
 {
 	int level;
 	int nodeId;
 	int parentId;
-	std::stringstream ss;
+	int m_version{ AIIPX_V3 };
+	std::vector<uint8_t> m_buffer;
+	size_t m_readOffset{ 0 };
+	size_t m_consumed{ 0 };
+	std::unordered_map<std::string, uint32_t> m_stringIndex;
+	std::vector<const std::string *> m_stringOrder;
+	std::vector<std::string> m_stringTable;
+	size_t m_stringBase{ 0 };
+	size_t m_sectionOffset{ 0 };
+	size_t m_sectionEnd{ 0 };
+	size_t m_sectionMark{ 0 };
+	std::shared_ptr<StreamState> m_deferredState;
+	std::shared_ptr<const StreamState> m_baseState;
 	std::multimap<int, std::function<void(const std::shared_ptr<ASTNode>&)>> m_nodeHookList;
 	std::map<int, std::shared_ptr<ASTNode>> m_passedList;
 	InputCallback inputCallback;
 
 	friend ChildGroup;
 
-	void WriteProxy(const std::stringstream::char_type *str, std::streamsize count)
+	void WriteProxy(const char *str, size_t count)
 	{
-		ss.write(str, count);
+		m_buffer.insert(m_buffer.end(), str, str + count);
 	}
 
 	template<typename NativeType>
 	void WriteProxy(const NativeType& value);
 
-	void ReadProxy(std::stringstream::char_type *str, std::streamsize count)
+	void ReadProxy(char *str, size_t count)
 	{
-		// If stream is empty, redirect read to callback
-		if (!ss.rdbuf()->in_avail()) {
-			inputCallback(reinterpret_cast<uint8_t *>(str), static_cast<size_t>(count));
-			return;
+		// Consume the buffered data first, redirect the remainder to callback
+		const size_t avail = std::min(count, m_buffer.size() - m_readOffset);
+		if (avail) {
+			std::copy_n(m_buffer.data() + m_readOffset, avail, str);
+			m_readOffset += avail;
+		}
+		if (count > avail) {
+			inputCallback(reinterpret_cast<uint8_t *>(str + avail), count - avail);
+			m_consumed += count - avail;
 		}
-
-		ss.read(str, count);
 	}
 
 	template<typename NativeType>
@@ -74,6 +286,10 @@ public:
 	// Initialize with input callback.
 	Visitor(InputCallback&);
 
+	// Initialize deferred section decoder. Strings before the string base
+	// and nodes outside the section are resolved from the stream state.
+	Visitor(InputCallback&, std::shared_ptr<const StreamState>, size_t);
+
 	// Copy and increment level.
 	Visitor(Visitor&);
 
@@ -81,8 +297,158 @@ public:
 	Visitor(Visitor&&) = delete;
 
 	int Level() { return level; }
-	// Clear internal buffer.
-	void Clear() noexcept { ss = std::stringstream{}; }
+	// Stream format version.
+	int Version() const noexcept { return m_version; }
+	// Set the stream format version.
+	void SetVersion(int version) noexcept { m_version = version; }
+	// Size of the output buffer.
+	size_t Size() const noexcept { return m_buffer.size(); }
+	// Number of bytes read from the input stream.
+	size_t Consumed() const noexcept { return m_consumed; }
+	// Clear internal buffer, the buffer capacity is retained.
+	void Clear() noexcept
+	{
+		m_buffer.clear();
+		m_readOffset = 0;
+	}
+	// Reserve output buffer capacity.
+	void Reserve(size_t size) { m_buffer.reserve(size); }
+	// Append raw data to the output buffer.
+	void Write(const uint8_t *data, size_t sz)
+	{
+		WriteProxy(reinterpret_cast<const char *>(data), sz);
+	}
+	// Read raw data from the input stream.
+	void Read(uint8_t *data, size_t sz)
+	{
+		ReadProxy(reinterpret_cast<char *>(data), sz);
+	}
+	// Overwrite integer at offset in the output buffer.
+	void Patch(size_t offset, uint32_t value)
+	{
+		std::memcpy(m_buffer.data() + offset, &value, sizeof(uint32_t));
+	}
+
+	// Write unsigned integer, LEB128 encoded from version 2.
+	void WriteUnsigned(uint32_t value)
+	{
+		if (m_version < AIIPX_V2) {
+			WriteProxy(reinterpret_cast<const char *>(&value), sizeof(uint32_t));
+			return;
+		}
+
+		do {
+			uint8_t byte = value & 0x7f;
+			value >>= 7;
+			if (value) {
+				byte |= 0x80;
+			}
+			m_buffer.push_back(byte);
+		} while (value);
+	}
+
+	// Read unsigned integer.
+	uint32_t ReadUnsigned()
+	{
+		uint32_t value = 0;
+		if (m_version < AIIPX_V2) {
+			ReadProxy(reinterpret_cast<char *>(&value), sizeof(uint32_t));
+			return value;
+		}
+
+		uint8_t byte;
+		int shift = 0;
+		do {
+			byte = 0;
+			ReadProxy(reinterpret_cast<char *>(&byte), sizeof(uint8_t));
+			value |= static_cast<uint32_t>(byte & 0x7f) << shift;
+			shift += 7;
+		} while ((byte & 0x80) && shift < 35);
+		return value;
+	}
+
+	// Write signed integer, zigzag encoded so small negative values stay short.
+	void WriteSigned(int value)
+	{
+		const auto bits = static_cast<uint32_t>(value);
+		WriteUnsigned(m_version < AIIPX_V2 ? bits : (bits << 1) ^ static_cast<uint32_t>(value >> 31));
+	}
+
+	// Read signed integer.
+	int ReadSigned()
+	{
+		const uint32_t bits = ReadUnsigned();
+		if (m_version < AIIPX_V2) {
+			return static_cast<int>(bits);
+		}
+		return static_cast<int>((bits >> 1) ^ (0 - (bits & 1)));
+	}
+
+	// Write node identifier.
+	void WriteNodeId(NodeID node)
+	{
+		if (m_version < AIIPX_V2) {
+			WriteProxy(reinterpret_cast<const char *>(&node), sizeof(NodeID));
+			return;
+		}
+		WriteUnsigned(static_cast<uint32_t>(node));
+	}
+
+	// Read node identifier.
+	NodeID ReadNodeId()
+	{
+		if (m_version < AIIPX_V2) {
+			NodeID node{ NodeID::INVAL };
+			ReadProxy(reinterpret_cast<char *>(&node), sizeof(NodeID));
+			return node;
+		}
+		return static_cast<NodeID>(ReadUnsigned());
+	}
+
+	// Start a section owned by the node. A section is prefixed with its
+	// length so it can be skipped without decoding. Strings first used
+	// in the section are local to the section.
+	void BeginSection(int ownerId)
+	{
+		WriteNodeId(NodeID::INVAL);
+		WriteUnsigned(static_cast<uint32_t>(ownerId));
+		m_sectionOffset = m_buffer.size();
+		m_sectionMark = m_stringOrder.size();
+		m_buffer.resize(m_buffer.size() + sizeof(uint32_t));
+	}
+
+	// Write the section length and drop the section local strings.
+	void EndSection()
+	{
+		Patch(m_sectionOffset, static_cast<uint32_t>(m_buffer.size() - m_sectionOffset - sizeof(uint32_t)));
+
+		for (size_t i = m_sectionMark; i < m_stringOrder.size(); ++i) {
+			m_stringIndex.erase(m_stringIndex.find((*m_stringOrder[i])));
+		}
+		m_stringOrder.resize(m_sectionMark);
+	}
+
+	// Read section if the stream is positioned at a section.
+	bool ReadSection();
+	// Close the current section if all section data was read.
+	void CloseSection();
+
+	// Retain sections instead of decoding them.
+	void SetDeferred(const std::shared_ptr<std::map<int, std::weak_ptr<ASTNode>>>& nodeList)
+	{
+		m_deferredState = std::make_shared<StreamState>(StreamState{ {}, nodeList });
+	}
+	// Hand the decoder state over to the deferred sections.
+	void ShareState();
+
+	// Append the output buffer of another visitor.
+	void Append(const Visitor& other)
+	{
+		m_buffer.insert(m_buffer.end(), other.m_buffer.cbegin(), other.m_buffer.cend());
+	}
+
+	// Resolve the dependencies between chunks. The chunks must be in stream order.
+	void Resolve(std::vector<std::unique_ptr<Visitor>>& chunks);
 
 	// Create list of child groups and write the number of groups to the 
 	// output stream. Each child group in the list is allocated with the 
@@ -95,6 +461,11 @@ public:
 	virtual void SetId(int id) override { nodeId = id; }
 	// Retrieve the first commited node identifier.
 	virtual NodeID GetNodeId();
+	// Node layout which belongs to the stream version.
+	virtual int LayoutVersion() const noexcept
+	{
+		return m_version < AIIPX_V2 ? Serializable::NODE_LAYOUT_V1 : Serializable::NODE_LAYOUT_V2;
+	}
 	// Invoke registered callbacks
 	virtual void FireDependencies(std::shared_ptr<ASTNode>&);
 
@@ -119,8 +490,8 @@ public:
 
 	// Write output to streaming backend
 	void WriteOutput(OutputCallback& outputCallback);
-	// Write output to streaming backend
-	void WriteOutput(std::function<void(std::vector<uint8_t>&)>& outputCallback);
+	// Move output buffer to streaming backend
+	void WriteOutput(BufferCallback& outputCallback);
 };
 
 template<>
@@ -135,94 +506,95 @@ void Visitor::WriteProxy(const bool& value)
 	WriteProxy(reinterpret_cast<const char *>(&value), sizeof(bool));
 }
 
+// From version 2 on strings are kept in a string table. The first occurrence
+// of a string is written inline and is assigned the next table index, any
+// further occurrence only refers to the table index.
 template<>
 void Visitor::WriteProxy(const std::string& value)
 {
-	const size_t sz = value.size();
-	WriteProxy(reinterpret_cast<const char *>(&sz), sizeof(uint32_t));
-	ss << value;
+	if (m_version >= AIIPX_V2) {
+		const auto result = m_stringIndex.emplace(value, static_cast<uint32_t>(m_stringIndex.size()));
+		if (!result.second) {
+			WriteUnsigned(result.first->second + 1);
+			return;
+		}
+		m_stringOrder.push_back(&result.first->first);
+		WriteUnsigned(0);
+	}
+
+	WriteUnsigned(static_cast<uint32_t>(value.size()));
+	WriteProxy(value.data(), value.size());
 }
 
 template<>
 void Visitor::WriteProxy(const std::vector<uint8_t>& value)
 {
-	const size_t sz = value.size();
-	WriteProxy(reinterpret_cast<const char *>(&sz), sizeof(uint32_t));
+	WriteUnsigned(static_cast<uint32_t>(value.size()));
 	WriteProxy(reinterpret_cast<const char *>(value.data()), value.size());
 }
 
 template<>
 void Visitor::ReadProxy(double& value)
 {
-	// If stream is empty, redirect read to callback
-	if (!ss.rdbuf()->in_avail()) {
-		ReadProxy(reinterpret_cast<char *>(&value), sizeof(double));
-		return;
-	}
-
-	ss >> value;
+	ReadProxy(reinterpret_cast<char *>(&value), sizeof(double));
 }
 
 template<>
 void Visitor::ReadProxy(bool& value)
 {
-	// If stream is empty, redirect read to callback
-	if (!ss.rdbuf()->in_avail()) {
-		ReadProxy(reinterpret_cast<char *>(&value), sizeof(bool));
-		return;
-	}
-
-	ss >> value;
+	ReadProxy(reinterpret_cast<char *>(&value), sizeof(bool));
 }
 
 template<>
 void Visitor::ReadProxy(std::string& value)
 {
-	// If stream is empty, redirect read to callback
-	if (!ss.rdbuf()->in_avail()) {
-		size_t sz = 0;
-		ReadProxy(reinterpret_cast<char *>(&sz), sizeof(uint32_t));
-		if (!sz) { return; }
+	if (m_version >= AIIPX_V2) {
+		const uint32_t ref = ReadUnsigned();
+		if (ref) {
+			const size_t index = ref - 1;
+			if (index < m_stringBase) {
+				value = m_baseState->stringTable.at(index);
+				return;
+			}
+			if (index - m_stringBase >= m_stringTable.size()) {
+				throw ASTFactory::InvalidStreamException{};
+			}
+			value = m_stringTable[index - m_stringBase];
+			return;
+		}
+	}
+
+	const uint32_t sz = ReadUnsigned();
+	if (sz) {
 		value.resize(sz);
-		inputCallback(reinterpret_cast<uint8_t *>(&value[0]), sz);
-		return;
+		ReadProxy(&value[0], sz);
 	}
 
-	size_t sz = 0;
-	ReadProxy(reinterpret_cast<char *>(&sz), sizeof(uint32_t));
-	ss >> value;
+	if (m_version >= AIIPX_V2) {
+		m_stringTable.push_back(value);
+	}
 }
 
 template<>
 void Visitor::ReadProxy(std::vector<uint8_t>& value)
 {
-	// If stream is empty, redirect read to callback
-	if (!ss.rdbuf()->in_avail()) {
-		size_t sz = 0;
-		ReadProxy(reinterpret_cast<char *>(&sz), sizeof(uint32_t));
-		if (!sz) { return; }
-		value.resize(sz);
-		inputCallback(reinterpret_cast<uint8_t *>(&value[0]), sz);
-		return;
-	}
-
-	size_t sz = 0;
-	ReadProxy(reinterpret_cast<char *>(&sz), sizeof(uint32_t));
+	const uint32_t sz = ReadUnsigned();
+	if (!sz) { return; }
 	value.resize(sz);
 	ReadProxy(reinterpret_cast<char *>(value.data()), sz);
 }
 
-void Visitor::operator<<(int i) { WriteProxy(reinterpret_cast<const char *>(&i), sizeof(uint32_t)); }
+void Visitor::operator<<(int i) { WriteSigned(i); }
 void Visitor::operator<<(double d) { WriteProxy(d); }
 void Visitor::operator<<(bool b) { WriteProxy(b); }
-void Visitor::operator<<(NodeID n) { WriteProxy(reinterpret_cast<const char *>(&n), sizeof(NodeID)); }
+void Visitor::operator<<(NodeID n) { WriteNodeId(n); }
 void Visitor::operator<<(std::string s) { WriteProxy(s); }
 void Visitor::operator<<(std::vector<uint8_t> b) { WriteProxy(b); }
 
-void Visitor::operator>>(int& i) { ReadProxy(reinterpret_cast<char *>(&i), sizeof(uint32_t)); }
+void Visitor::operator>>(int& i) { i = ReadSigned(); }
 void Visitor::operator>>(double& d) { ReadProxy(d); }
 void Visitor::operator>>(bool& b) { ReadProxy(b); }
-void Visitor::operator>>(NodeID& n) { ReadProxy(reinterpret_cast<char *>(&n), sizeof(NodeID)); }
+void Visitor::operator>>(NodeID& n) { n = ReadNodeId(); }
 void Visitor::operator>>(std::string& s) { ReadProxy(s); }
 void Visitor::operator>>(std::vector<uint8_t>& b) { ReadProxy(b); }
 
@@ -239,15 +611,13 @@ class ChildGroup : public Serializable::ChildGroupInterface
 
 		// Read the initial data from the input stream if there are no elements
 		if (!m_elements) {
-			m_visitor.ReadProxy(reinterpret_cast<char *>(&m_elements), sizeof(uint32_t));
+			m_elements = m_visitor.ReadUnsigned();
 			assert(m_elements > 0);
 		}
 
-		uint32_t nodeId;
 		for (size_t i = 0; i < m_elements; i++)
 		{
-			m_visitor.ReadProxy(reinterpret_cast<char *>(&nodeId), sizeof(uint32_t));
-			m_nodeIdList.push_back(static_cast<int>(nodeId));
+			m_nodeIdList.push_back(static_cast<int>(m_visitor.ReadUnsigned()));
 		}
 	}
 
@@ -259,15 +629,14 @@ public:
 
 	virtual void SaveNode(std::shared_ptr<ASTNode>& node)
 	{
-		m_visitor.WriteProxy(reinterpret_cast<const char *>(&node->Id()), sizeof(uint32_t));
+		m_visitor.WriteUnsigned(static_cast<uint32_t>(node->Id()));
 		m_nodeIdList.push_back(node->Id());
 	}
 
 	virtual void SaveNode(nullptr_t)
 	{
-		constexpr const uint32_t n = 0;
-		m_visitor.WriteProxy(reinterpret_cast<const char *>(&n), sizeof(uint32_t));
-		m_nodeIdList.push_back(n);
+		m_visitor.WriteUnsigned(0);
+		m_nodeIdList.push_back(0);
 	}
 
 	virtual int LoadNode(int index)
@@ -281,8 +650,7 @@ public:
 	virtual void SetSize(size_t size)
 	{
 		// Read the number of groups elements to the stream
-		auto _size = static_cast<uint32_t>(size);
-		m_visitor.WriteProxy(reinterpret_cast<const char *>(&_size), sizeof(uint32_t));
+		m_visitor.WriteUnsigned(static_cast<uint32_t>(size));
 		m_elements = size;
 	}
 
@@ -308,19 +676,29 @@ Visitor::Visitor(InputCallback& inputCallback)
 {
 }
 
+Visitor::Visitor(InputCallback& inputCallback, std::shared_ptr<const StreamState> state, size_t stringBase)
+	: inputCallback{ inputCallback }
+	, level{ 0 }
+	, nodeId{ 0 }
+	, parentId{ 0 }
+	, m_stringBase{ stringBase }
+	, m_baseState{ state }
+{
+}
+
 Visitor::Visitor(Visitor& other)
 	: inputCallback{ other.inputCallback }
 	, level{ other.level + 1 }
 	, nodeId{ 0 }
 	, parentId{ other.nodeId }
+	, m_version{ other.m_version }
 {
 }
 
 Serializable::GroupListType Visitor::CreateChildGroups(size_t size)
 {
 	// Write the number of groups to the stream
-	auto _size = static_cast<uint32_t>(size);
-	WriteProxy(reinterpret_cast<const char *>(&_size), sizeof(uint32_t));
+	WriteUnsigned(static_cast<uint32_t>(size));
 
 	Serializable::GroupListType group;
 	for (size_t i = 0; i < size; i++)
@@ -335,8 +713,7 @@ Serializable::GroupListType Visitor::CreateChildGroups(size_t size)
 Serializable::GroupListType Visitor::GetChildGroups()
 {
 	// Write the number of groups to the stream
-	uint32_t size = 0;
-	ReadProxy(reinterpret_cast<char *>(&size), sizeof(uint32_t));
+	const uint32_t size = ReadUnsigned();
 	assert(size > 0);
 
 	Serializable::GroupListType group;
@@ -350,9 +727,9 @@ Serializable::GroupListType Visitor::GetChildGroups()
 
 NodeID Visitor::GetNodeId()
 {
-	NodeID node;
-	ReadProxy(reinterpret_cast<char *>(&node), sizeof(NodeID));
-	WriteProxy(reinterpret_cast<const char *>(&node), sizeof(NodeID));
+	// Return the node identifier to the buffer for the node to read.
+	const NodeID node = ReadNodeId();
+	WriteNodeId(node);
 	return node;
 }
 
@@ -374,74 +751,392 @@ void Visitor::operator<<=(std::pair<int, std::function<void(const std::shared_pt
 		value.second(it->second);
 		return;
 	}
+
+	// Sections can refer to nodes outside the section.
+	if (m_baseState) {
+		auto baseIt = m_baseState->nodeList->find(value.first);
+		if (baseIt != m_baseState->nodeList->end()) {
+			if (auto node = baseIt->second.lock()) {
+				value.second(node);
+				return;
+			}
+		}
+	}
+
 	m_nodeHookList.emplace(std::move(value));
 }
 
+bool Visitor::ReadSection()
+{
+	const NodeID node = ReadNodeId();
+	if (node != NodeID::INVAL) {
+		WriteNodeId(node);
+		return false;
+	}
+
+	const auto ownerId = static_cast<int>(ReadUnsigned());
+	uint32_t length = 0;
+	ReadProxy(reinterpret_cast<char *>(&length), sizeof(uint32_t));
+	if (!length) { return true; }
+
+	// Decode the section in place.
+	if (!m_deferredState) {
+		m_sectionEnd = m_consumed + length;
+		m_sectionMark = m_stringTable.size();
+		return true;
+	}
+
+	if (length > maxNodeListSize) {
+		throw ASTFactory::InvalidStreamException{};
+	}
+
+	auto section = std::make_shared<std::vector<uint8_t>>(length);
+	ReadProxy(reinterpret_cast<char *>(section->data()), length);
+
+	// Sections are owned by a function which precedes the section.
+	auto it = m_passedList.find(ownerId);
+	if (it == m_passedList.end()) {
+		throw ASTFactory::InvalidStreamException{};
+	}
+	auto owner = std::dynamic_pointer_cast<FunctionDecl>(it->second);
+	if (!owner) {
+		throw ASTFactory::InvalidStreamException{};
+	}
+
+	owner->SetCompoundLoader([state = m_deferredState, section, stringBase = m_stringTable.size()]() -> std::shared_ptr<CompoundStmt>
+	{
+		InputCallback input = MakeMemoryInput(section->data(), section->size());
+		Visitor visit{ input, state, stringBase };
+		return std::dynamic_pointer_cast<CompoundStmt>(DecodeNodes(&visit, section->size()));
+	});
+
+	return true;
+}
+
+void Visitor::CloseSection()
+{
+	if (m_sectionEnd && m_consumed >= m_sectionEnd) {
+		m_stringTable.resize(m_sectionMark);
+		m_sectionEnd = 0;
+	}
+}
+
+void Visitor::ShareState()
+{
+	if (!m_deferredState) { return; }
+
+	m_deferredState->stringTable = std::move(m_stringTable);
+	for (const auto& passed : m_passedList) {
+		m_deferredState->nodeList->emplace(passed.first, passed.second);
+	}
+}
+
+// Hooks which could not be resolved within a chunk refer to nodes in other
+// chunks. The hooks are collected and fired in stream order, which keeps the
+// order in which children are attached equal to sequential decoding.
+void Visitor::Resolve(std::vector<std::unique_ptr<Visitor>>& chunks)
+{
+	for (auto& chunk : chunks) {
+		m_nodeHookList.insert(std::make_move_iterator(chunk->m_nodeHookList.begin()), std::make_move_iterator(chunk->m_nodeHookList.end()));
+		chunk->m_nodeHookList.clear();
+	}
+
+	for (auto& chunk : chunks) {
+		for (auto& passed : chunk->m_passedList) {
+			FireDependencies(passed.second);
+		}
+	}
+}
+
 void Visitor::WriteOutput(OutputCallback& outputCallback)
 {
-	outputCallback((uint8_t*)ss.str().c_str(), ss.str().size());
-	ss.str(std::string{});
+	outputCallback(m_buffer.data(), m_buffer.size());
+	Clear();
 }
 
-void Visitor::WriteOutput(std::function<void(std::vector<uint8_t>&)>& outputCallback)
+void Visitor::WriteOutput(BufferCallback& outputCallback)
 {
-	std::vector<uint8_t> t;
-	outputCallback(t);
+	outputCallback(std::move(m_buffer));
+	m_buffer = std::vector<uint8_t>{};
+	m_readOffset = 0;
 }
 
-void CompressNode(ASTNode *node, Visitor visitor, OutputCallback callback)
+// Count the nodes in the tree, this is used as reserve hint.
+size_t NodeCount(ASTNode *node)
 {
-	//std::cout << "visitor.Level " << visitor.Level() << std::endl;
+	size_t count = 1;
+	for (ASTNode *child : node->ChildNodes()) {
+		if (child) {
+			count += NodeCount(child);
+		}
+	}
+	return count;
+}
+
+// Highest node identifier in the tree.
+int HighestNodeId(ASTNode *node)
+{
+	int id = node->Id();
+	for (ASTNode *child : node->ChildNodes()) {
+		if (child) {
+			id = std::max(id, HighestNodeId(child));
+		}
+	}
+	return id;
+}
+
+// Serialize the node and all its children into the visitor buffer. The
+// body of a top level function is written as section, which allows the
+// body to be loaded on first use.
+void CompressNode(ASTNode *node, Visitor& visitor, bool topLevel = true)
+{
+	// Deferred bodies are loaded before the function is written.
+	if (node->Label() == NodeID::FUNCTION_DECL_ID) {
+		static_cast<FunctionDecl *>(node)->LoadCompound();
+	}
 
 	node->Serialize(visitor);
 
-	// Let the visitor determine how to write the output to the stream
-	visitor.WriteOutput(callback);
-	for (const auto& weakChild : node->Children()) {
-		if (auto delegateChildren = weakChild.lock()) {
-			CompressNode(delegateChildren.get(), visitor, callback);
+	ASTNode *body = nullptr;
+	if (topLevel && node->Label() == NodeID::FUNCTION_DECL_ID) {
+		body = static_cast<FunctionDecl *>(node)->FunctionCompound().get();
+	}
+
+	for (ASTNode *child : node->ChildNodes()) {
+		if (!child) { continue; }
+		if (child == body) {
+			visitor.BeginSection(node->Id());
+			CompressNode(child, visitor, false);
+			visitor.EndSection();
+			continue;
 		}
+
+		CompressNode(child, visitor, false);
+	}
+}
+
+// Write the declaration index, followed by the fixed size offset of the index
+// so the index can be located from the end of the stream. Version 3 streams
+// start the index with the highest node identifier.
+void WriteIndex(Visitor& visitor, const std::vector<AIIPX::IndexEntry>& index, int highestNodeId)
+{
+	const auto indexOffset = static_cast<uint32_t>(visitor.Size());
+	if (visitor.Version() >= AIIPX_V3) {
+		visitor.WriteUnsigned(static_cast<uint32_t>(highestNodeId));
+	}
+	visitor.WriteUnsigned(static_cast<uint32_t>(index.size()));
+	for (const auto& entry : index) {
+		visitor.WriteUnsigned(static_cast<uint32_t>(entry.nodeId));
+		visitor.WriteUnsigned(static_cast<uint32_t>(entry.offset));
 	}
+	visitor.Write(reinterpret_cast<const uint8_t *>(&indexOffset), sizeof(uint32_t));
 }
 
-AST UncompressNode(Visitor *visitor, InputCallback callback)
+// Read the declaration index, returns the highest node identifier. Version 2
+// streams do not state the identifier, zero is returned instead. Every entry
+// points into the node list, which bounds the number of entries.
+int ReadIndex(Visitor& visitor, std::vector<AIIPX::IndexEntry>& index, size_t nodeListSize)
+{
+	const auto highestNodeId = visitor.Version() < AIIPX_V3 ? 0 : static_cast<int>(visitor.ReadUnsigned());
+	const uint32_t count = visitor.ReadUnsigned();
+	if (count > nodeListSize) {
+		throw ASTFactory::InvalidStreamException{};
+	}
+	index.reserve(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		const auto nodeId = static_cast<int>(visitor.ReadUnsigned());
+		const auto offset = static_cast<size_t>(visitor.ReadUnsigned());
+		index.push_back({ nodeId, offset });
+	}
+
+	// Skip over the index offset.
+	uint32_t indexOffset;
+	visitor.Read(reinterpret_cast<uint8_t *>(&indexOffset), sizeof(uint32_t));
+	return highestNodeId;
+}
+
+// Decode nodes until the length is consumed. Version 1 streams carry no
+// length, the end of the stream is signaled by the factory instead.
+ASTNodeType DecodeNodes(Visitor *visitor, size_t length)
 {
 	ASTNodeType root;
 
-	try
-	{
-		do {
-			// Get node from AST factory
-			auto _node = ASTFactory::MakeNode(visitor);
-			visitor->Clear();
-			assert(_node);
-
-			// Set tree root
-			if (!root) {
-				root = _node;
-			}
-		} while (true);
+	// Restored nodes take the identifier from the stream. The identifiers
+	// allocated on construction are discarded, without touching the
+	// allocator bound to this thread.
+	UniqueIdAllocator restoreAllocator;
+	UniqueIdAllocator::Scope restoreScope{ restoreAllocator };
+
+	if (visitor->Version() < AIIPX_V2) {
+		try
+		{
+			do {
+				// Get node from AST factory
+				auto _node = ASTFactory::MakeNode(visitor);
+				visitor->Clear();
+				assert(_node);
+
+				// Set tree root
+				if (!root) {
+					root = _node;
+				}
+			} while (true);
+		}
+		catch (ASTFactory::InvalidStreamException&)
+		{
+			return root;
+		}
 	}
-	catch (ASTFactory::InvalidStreamException&)
+
+	while (visitor->Consumed() < length) {
+		if (visitor->ReadSection()) { continue; }
+
+		// Get node from AST factory
+		auto _node = ASTFactory::MakeNode(visitor);
+		visitor->Clear();
+		visitor->CloseSection();
+		assert(_node);
+
+		// Set tree root
+		if (!root) {
+			root = _node;
+		}
+	}
+
+	return root;
+}
+
+AST UncompressNode(Visitor *visitor, size_t length)
+{
+	// Return root as program tree. The AST wrapper
+	// will incorporate the root as tree.
+	return DecodeNodes(visitor, length);
+}
+
+// Decode the chunks of a version 2 stream. The first chunk holds the root
+// node, every other chunk holds a single top level declaration. Chunks are
+// decoded independently, after which the dependencies between the chunks
+// are resolved in stream order.
+AST UncompressChunks(Visitor& visitor, const std::vector<uint8_t>& nodes, const std::vector<AIIPX::IndexEntry>& index, size_t workers, bool lazy)
+{
+	std::vector<size_t> boundaries{ 0 };
+	for (const auto& entry : index) {
+		if (entry.offset < headerSize + boundaries.back() || entry.offset > headerSize + nodes.size()) {
+			throw ASTFactory::InvalidStreamException{};
+		}
+		boundaries.push_back(entry.offset - headerSize);
+	}
+	boundaries.push_back(nodes.size());
+
+	auto nodeList = std::make_shared<std::map<int, std::weak_ptr<ASTNode>>>();
+
+	const size_t chunkCount = boundaries.size() - 1;
+	std::vector<std::unique_ptr<Visitor>> chunks(chunkCount);
+	std::vector<ASTNodeType> chunkRoots(chunkCount);
+
+	ParallelFor(chunkCount, workers, [&](size_t i)
 	{
-		// Return root as program tree. The AST wrapper
-		// will incorporate the root as tree.
-		return root;
+		const size_t length = boundaries[i + 1] - boundaries[i];
+		InputCallback input = MakeMemoryInput(nodes.data() + boundaries[i], length);
+
+		chunks[i] = std::make_unique<Visitor>(input);
+		if (lazy) {
+			chunks[i]->SetDeferred(nodeList);
+		}
+		chunkRoots[i] = DecodeNodes(chunks[i].get(), length);
+	});
+
+	visitor.Resolve(chunks);
+	for (auto& chunk : chunks) {
+		chunk->ShareState();
 	}
 
-	return nullptr;
+	return chunkRoots.front();
 }
 
 void AIIPX::PackAST(AST tree)
 {
+	ASTNode *root = (*tree);
+
+	const int streamVersion = m_streamVersion ? m_streamVersion : AIIPX_V3;
+	if (streamVersion < AIIPX_V1 || streamVersion > AIIPX_V3) {
+		throw std::invalid_argument{ "unsupported AIIPX stream version" };
+	}
+
+	// Version 1 streams are the marker followed by the nodes in tree order.
+	if (streamVersion == AIIPX_V1) {
+		Visitor visit;
+		visit.SetVersion(AIIPX_V1);
+		visit.Reserve(sizeof(initMarker) + NodeCount(root) * nodeSizeHint);
+		visit.Write(&initMarker[0], sizeof(initMarker));
+		CompressNode(root, visit, false);
+
+		if (m_bufferCallback) {
+			visit.WriteOutput(m_bufferCallback);
+			return;
+		}
+
+		visit.WriteOutput(m_outputCallback);
+		return;
+	}
+
+	std::vector<ASTNode *> declarations;
+	for (ASTNode *child : root->ChildNodes()) {
+		if (child) {
+			declarations.push_back(child);
+		}
+	}
+
+	// The root node is the first chunk, followed by a chunk per top level
+	// declaration. Chunks have no shared state and are encoded concurrently.
+	const size_t nodeCount = NodeCount(root);
+	std::vector<Visitor> chunks(declarations.size() + 1);
+	for (auto& chunk : chunks) {
+		chunk.SetVersion(streamVersion);
+	}
+	root->Serialize(chunks.front());
+
+	const size_t workers = WorkerCount(m_workerCount, nodeCount, parallelNodeThreshold);
+	ParallelFor(declarations.size(), workers, [&](size_t i)
+	{
+		chunks[i + 1].Reserve(NodeCount(declarations[i]) * nodeSizeHint);
+		CompressNode(declarations[i], chunks[i + 1]);
+	});
+
 	Visitor visit;
+	visit.SetVersion(streamVersion);
+	visit.Reserve(headerSize + nodeCount * nodeSizeHint);
+
+	// Write marker and version to output stream to recognize the sequencer
+	const uint8_t version = versionFlag | static_cast<uint8_t>(streamVersion);
+	const uint32_t placeholder = 0;
+	visit.Write(&initMarker[0], sizeof(initMarker));
+	visit.Write(&version, sizeof(version));
+	visit.Write(reinterpret_cast<const uint8_t *>(&placeholder), sizeof(uint32_t));
+
+	// Concatenate the chunks, the offset of each declaration chunk is kept in the index.
+	std::vector<IndexEntry> index;
+	index.reserve(declarations.size());
+	visit.Append(chunks.front());
+	for (size_t i = 0; i < declarations.size(); ++i) {
+		index.push_back({ declarations[i]->Id(), visit.Size() });
+		visit.Append(chunks[i + 1]);
+	}
+
+	// Length of the node list, the declaration index follows.
+	visit.Patch(headerSize - sizeof(uint32_t), static_cast<uint32_t>(visit.Size() - headerSize));
+	WriteIndex(visit, index, HighestNodeId(root));
 
-	// Write marker to output stream to recognize the sequencer
-	m_outputCallback(&initMarker[0], static_cast<size_t>(sizeof(initMarker)));
-	CompressNode((*tree), visit, m_outputCallback);
+	// Hand the buffer over if the stream can take ownership.
+	if (m_bufferCallback) {
+		visit.WriteOutput(m_bufferCallback);
+		return;
+	}
+
+	visit.WriteOutput(m_outputCallback);
 }
 
-void AIIPX::UnpackAST(AST& tree)
+void AIIPX::UnpackAST(AST& tree, UniqueIdAllocator& allocator)
 {
 	// Initialize visitor with input stream
 	Visitor visit{ m_inputCallback };
@@ -453,11 +1148,59 @@ void AIIPX::UnpackAST(AST& tree)
 	// Read marker from input stream
 	m_inputCallback(&_initMarker[0], sizeof(initMarker));
 	if (memcmp(_initMarker, initMarker, sizeof(initMarker))) {
-		CryImplExcept(); //TODO
+		throw ASTFactory::InvalidStreamException{};
+	}
+
+	// Version 2 streams follow the marker with a version byte. In version 1
+	// streams the byte belongs to the first node and is returned to the visitor.
+	uint8_t version = 0;
+	m_inputCallback(&version, sizeof(version));
+	if (version & versionFlag) {
+		const int streamVersion = version & ~versionFlag;
+		if (streamVersion != AIIPX_V2 && streamVersion != AIIPX_V3) {
+			throw ASTFactory::InvalidStreamException{};
+		}
+		visit.SetVersion(streamVersion);
+	}
+	else {
+		visit.SetVersion(AIIPX_V1);
+		visit.Write(&version, sizeof(version));
+	}
+
+	m_declarationIndex.clear();
+	if (visit.Version() < AIIPX_V2) {
+		// Move resulting tree into AST
+		tree = std::move(UncompressNode(&visit, 0));
+		if ((*tree)) {
+			allocator.Advance(HighestNodeId((*tree)));
+		}
+		return;
+	}
+
+	// Version 2 streams state the length of the node list, followed by
+	// the declaration index which is needed to locate the chunks.
+	uint32_t length = 0;
+	m_inputCallback(reinterpret_cast<uint8_t *>(&length), sizeof(uint32_t));
+	if (length > maxNodeListSize) {
+		throw ASTFactory::InvalidStreamException{};
+	}
+
+	std::vector<uint8_t> nodes(length);
+	m_inputCallback(nodes.data(), nodes.size());
+	const int highestNodeId = ReadIndex(visit, m_declarationIndex, nodes.size());
+
+	// Version 2 streams do not state the highest identifier, the bodies are
+	// decoded in place so the identifiers can be taken from the tree.
+	if (visit.Version() < AIIPX_V3) {
+		tree = std::move(UncompressChunks(visit, nodes, m_declarationIndex, WorkerCount(m_workerCount, nodes.size(), parallelByteThreshold), false));
+		allocator.Advance(HighestNodeId((*tree)));
+		return;
 	}
 
-	// Move resulting tree into AST
-	tree = std::move(UncompressNode(&visit, m_inputCallback));
+	// Move resulting tree into AST. The identifiers in deferred sections are
+	// covered by the highest identifier, new nodes never collide with those.
+	tree = std::move(UncompressChunks(visit, nodes, m_declarationIndex, WorkerCount(m_workerCount, nodes.size(), parallelByteThreshold), m_lazyLoading));
+	allocator.Advance(highestNodeId);
 }
 
 } // namespace Emit
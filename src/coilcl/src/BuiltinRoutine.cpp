@@ -57,14 +57,10 @@ BUILTIN_ROUTINE_IMPL(sizeof)
 
 	// Emplace current builtin node with the just created integer literal node. Find
 	// the offset of the current node in the parent children list, and replace the child.
-	if (auto parent = builtinExpr->Parent().lock()) {
-		const auto parentChildren = parent->Children();
-
-		auto selfListItem = std::find_if(parentChildren.cbegin(), parentChildren.cend(), [=](const std::weak_ptr<ASTNode>& wPtr)
-		{
-			return wPtr.lock() == builtinExpr;
-		});
+	if (ASTNode *parent = builtinExpr->ParentNode()) {
+		const auto& parentChildren = parent->ChildNodes();
 
+		auto selfListItem = std::find(parentChildren.cbegin(), parentChildren.cend(), builtinExpr.get());
 		if (selfListItem != parentChildren.cend()) {
 			size_t idx = std::distance(parentChildren.cbegin(), selfListItem);
 			parent->Emplace(idx, std::move(literal));
@@ -0,0 +1,1429 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include "Sequencer.h"
+
+// Project includes.
+#include <CryCC/SubValue.h>
+#include <CryCC/Program/Casm.h>
+
+// Language includes.
+#include <initializer_list>
+#include <unordered_map>
+
+namespace CoilCl
+{
+namespace Emit
+{
+namespace Sequencer
+{
+
+using namespace CryCC::AST;
+using namespace CryCC::SubValue::Typedef;
+
+namespace Casm = CryCC::Program::Casm;
+
+using Casm::Opcode;
+using Casm::SlotKind;
+using Casm::Word;
+
+namespace
+{
+
+// Raised on any construct without a bytecode equivalent.
+struct UnsupportedConstruct
+{
+};
+
+[[noreturn]] inline void Unsupported()
+{
+	throw UnsupportedConstruct{};
+}
+
+// Name of the function which initializes the globals. The name
+// cannot collide with a source identifier.
+constexpr const char initializerName[] = ".init";
+
+// Upper bound on the frame size of a single function.
+constexpr const Word maxFrameSize = 1 << 20;
+
+// Storage class of a scalar type.
+SlotKind ScalarKind(const InternalBaseType& type)
+{
+	if (!type) { Unsupported(); }
+
+	switch (type->TypeId()) {
+	case TypeVariation::TYPEDEF:
+		return ScalarKind(std::static_pointer_cast<TypedefType>(type)->MarkType());
+
+	case TypeVariation::BUILTIN:
+		switch (std::static_pointer_cast<BuiltinType>(type)->TypeSpecifier()) {
+		case BuiltinType::Specifier::VOID_T:
+			return SlotKind::VOID;
+		case BuiltinType::Specifier::INT_T:
+			return SlotKind::INTEGER;
+		case BuiltinType::Specifier::DOUBLE_T:
+			return SlotKind::FLOAT;
+		default:
+			break;
+		}
+		break;
+
+	default:
+		break;
+	}
+
+	// Unsigned and long integers do not fit the signed 32 bit registers. Bool,
+	// char, short and float would need narrowing on every store, which has no
+	// instruction, so these are left to the tree walker as well.
+	Unsupported();
+}
+
+// Storage shape of a declaration.
+struct Shape
+{
+	SlotKind kind;
+	Word count;
+	bool isArray;
+};
+
+Shape ShapeOf(const TypeFacade& type)
+{
+	if (!type.HasValue() || type.IsPointer()) { Unsupported(); }
+
+	InternalBaseType base = type.BaseType();
+	while (base && base->TypeId() == TypeVariation::TYPEDEF) {
+		base = std::static_pointer_cast<TypedefType>(base)->MarkType();
+	}
+
+	// Only single dimension arrays of scalars map onto consecutive slots.
+	if (base && base->TypeId() == TypeVariation::ARRAY) {
+		const auto arrayType = std::static_pointer_cast<ArrayType>(base);
+		const SlotKind kind = ScalarKind(arrayType->Type());
+		if (!arrayType->Order() || arrayType->Order() > maxFrameSize || kind == SlotKind::VOID) {
+			Unsupported();
+		}
+		return Shape{ kind, static_cast<Word>(arrayType->Order()), true };
+	}
+
+	return Shape{ ScalarKind(base), 1, false };
+}
+
+// Builtin specifier of a literal value.
+BuiltinType::Specifier LiteralSpecifier(const Literal& literal)
+{
+	const auto type = literal.Value().Type();
+	const auto builtinType = type.DataType<BuiltinType>();
+	if (!builtinType || type.IsPointer()) { Unsupported(); }
+	return builtinType->TypeSpecifier();
+}
+
+// Value of an integer or character literal.
+int32_t IntegerValue(const Literal& literal)
+{
+	const auto& value = literal.Value();
+	switch (LiteralSpecifier(literal)) {
+	case BuiltinType::Specifier::INT_T:
+		return Util::ValueCastNative<int>(value);
+	case BuiltinType::Specifier::CHAR_T:
+		return Util::ValueCastNative<char>(value);
+	case BuiltinType::Specifier::SIGNED_CHAR_T:
+		return Util::ValueCastNative<signed char>(value);
+	case BuiltinType::Specifier::SHORT_T:
+		return Util::ValueCastNative<short>(value);
+	case BuiltinType::Specifier::BOOL_T:
+		return Util::ValueCastNative<bool>(value);
+	default:
+		break;
+	}
+
+	Unsupported();
+}
+
+// Value of a floating point literal. Single precision literals are not
+// lowered, arithmetic on these must be rounded to single precision.
+double RealValue(const Literal& literal)
+{
+	switch (LiteralSpecifier(literal)) {
+	case BuiltinType::Specifier::DOUBLE_T:
+		return Util::ValueCastNative<double>(literal.Value());
+	default:
+		break;
+	}
+
+	Unsupported();
+}
+
+// Signature of a function defined in the unit.
+struct Signature
+{
+	Word index;
+	SlotKind returnKind;
+	std::vector<SlotKind> params;
+};
+
+// Lower all declarations in the unit into a module.
+class UnitLowering final
+{
+	Casm::Module& m_module;
+	std::unordered_map<std::string, Signature> m_signatures;
+	std::unordered_map<std::string, SlotKind> m_externals;
+	std::unordered_map<std::string, std::pair<Word, SlotKind>> m_globals;
+
+public:
+	explicit UnitLowering(Casm::Module& module)
+		: m_module{ module }
+	{
+	}
+
+	void Lower(ASTNode& root);
+
+	inline Word Constant(Casm::Constant constant) { return m_module.AddConstant(std::move(constant)); }
+
+	const Signature *FindSignature(const std::string& name) const
+	{
+		const auto it = m_signatures.find(name);
+		return it != m_signatures.cend() ? &it->second : nullptr;
+	}
+
+	const std::pair<Word, SlotKind> *FindGlobal(const std::string& name) const
+	{
+		const auto it = m_globals.find(name);
+		return it != m_globals.cend() ? &it->second : nullptr;
+	}
+
+	// Return kind of a function outside the unit. Functions without
+	// a prototype are assumed to return an integer.
+	SlotKind ExternalReturnKind(const std::string& name) const
+	{
+		const auto it = m_externals.find(name);
+		return it != m_externals.cend() ? it->second : SlotKind::INTEGER;
+	}
+};
+
+// Lower a single function body into the register machine.
+//
+// Every named local is assigned a fixed slot in the frame for the
+// lifetime of its scope. Temporaries are allocated above the locals
+// and are released at the end of each statement, so the frame size
+// is the deepest slot use in the function. Expressions which name a
+// local operate on the slot directly, no copy is made.
+class FunctionLowering final
+{
+	struct Local
+	{
+		Word slot;
+		SlotKind kind;
+		Word count;
+	};
+
+	// Register holding an expression result.
+	struct Operand
+	{
+		Word reg;
+		SlotKind kind;
+	};
+
+	// Assignable storage.
+	struct LValue
+	{
+		enum { LOCAL, GLOBAL, ELEMENT } storage;
+		Word slot;
+		Word index;
+		Word count;
+		SlotKind kind;
+	};
+
+	// Pending jumps out of a loop or switch.
+	struct BranchScope
+	{
+		std::vector<size_t> breaks;
+		std::vector<size_t> continues;
+	};
+
+	// Jumps into the case labels of a switch.
+	struct SwitchScope
+	{
+		std::unordered_map<const ASTNode *, std::vector<size_t>> labels;
+	};
+
+	UnitLowering& m_unit;
+	Casm::Function& m_function;
+	std::vector<std::unordered_map<std::string, Local>> m_scopes;
+	std::vector<BranchScope> m_branches;
+	std::vector<SwitchScope> m_switches;
+	Word m_nextSlot{ 0 };
+
+public:
+	FunctionLowering(UnitLowering& unit, Casm::Function& function)
+		: m_unit{ unit }
+		, m_function{ function }
+	{
+		m_scopes.emplace_back();
+	}
+
+	// Lower the function declaration.
+	void LowerFunction(const FunctionDecl&, const Signature&);
+	// Lower the global initializers.
+	void LowerInitializer(const std::vector<const VarDecl *>&);
+
+private:
+	//
+	// Code emission.
+	//
+
+	inline size_t Position() const noexcept { return m_function.code.size(); }
+
+	void Emit(Opcode opcode, std::initializer_list<Word> operands = {})
+	{
+		m_function.code.push_back(static_cast<Word>(opcode));
+		m_function.code.insert(m_function.code.end(), operands);
+	}
+
+	// Emit jump with unresolved target, the position is used to patch the jump.
+	size_t EmitJump(Opcode opcode, Word reg = 0)
+	{
+		const size_t position = Position();
+		if (opcode == Opcode::JMP) {
+			Emit(opcode, { 0 });
+		}
+		else {
+			Emit(opcode, { reg, 0 });
+		}
+		return position;
+	}
+
+	// Emit jump to known target.
+	void EmitJumpTo(Opcode opcode, size_t target, Word reg = 0)
+	{
+		PatchJump(EmitJump(opcode, reg), target);
+	}
+
+	void PatchJump(size_t position, size_t target)
+	{
+		const size_t operand = m_function.code[position] == static_cast<Word>(Opcode::JMP) ? 1 : 2;
+		m_function.code[position + operand] = static_cast<Word>(static_cast<int32_t>(target) - static_cast<int32_t>(position));
+	}
+
+	void PatchJumps(const std::vector<size_t>& positions, size_t target)
+	{
+		for (const size_t position : positions) {
+			PatchJump(position, target);
+		}
+	}
+
+	//
+	// Frame management.
+	//
+
+	Word Allocate(Word count)
+	{
+		if (count > maxFrameSize - m_nextSlot) { Unsupported(); }
+
+		const Word slot = m_nextSlot;
+		m_nextSlot += count;
+		m_function.frameSize = std::max(m_function.frameSize, m_nextSlot);
+		return slot;
+	}
+
+	inline Word Temporary() { return Allocate(1); }
+
+	inline Word Target(int hint) { return hint < 0 ? Temporary() : static_cast<Word>(hint); }
+
+	// Declare named storage in the innermost scope.
+	Word Declare(const std::string& name, const Shape& shape)
+	{
+		const Word slot = Allocate(shape.count);
+		m_scopes.back()[name] = Local{ slot, shape.kind, shape.count };
+		m_function.layout.push_back(Casm::SlotInfo{ name, shape.kind, slot, shape.count });
+		return slot;
+	}
+
+	const Local *FindLocal(const std::string& name) const
+	{
+		for (auto it = m_scopes.crbegin(); it != m_scopes.crend(); ++it) {
+			const auto local = it->find(name);
+			if (local != it->cend()) {
+				return &local->second;
+			}
+		}
+		return nullptr;
+	}
+
+	void PushScope() { m_scopes.emplace_back(); }
+
+	void PopScope(Word mark)
+	{
+		m_scopes.pop_back();
+		m_nextSlot = mark;
+	}
+
+	//
+	// Value conversion.
+	//
+
+	Word Convert(const Operand& operand, SlotKind kind)
+	{
+		if (operand.kind == SlotKind::VOID || kind == SlotKind::VOID) { Unsupported(); }
+		if (operand.kind == kind) { return operand.reg; }
+
+		const Word reg = Temporary();
+		Emit(kind == SlotKind::FLOAT ? Opcode::I2F : Opcode::F2I, { reg, operand.reg });
+		return reg;
+	}
+
+	void Move(Word dst, Word src)
+	{
+		if (dst != src) {
+			Emit(Opcode::MOV, { dst, src });
+		}
+	}
+
+	// Reduce the operand to an integer register which is zero on false.
+	Word Truth(const Operand& operand)
+	{
+		switch (operand.kind) {
+		case SlotKind::INTEGER:
+			return operand.reg;
+		case SlotKind::FLOAT: {
+			const Word zero = Temporary();
+			Emit(Opcode::LOADK, { zero, m_unit.Constant(0.0) });
+			Emit(Opcode::NEF, { zero, operand.reg, zero });
+			return zero;
+		}
+		default:
+			break;
+		}
+
+		Unsupported();
+	}
+
+	void LoadInteger(Word reg, int32_t value)
+	{
+		Emit(Opcode::LOADI, { reg, static_cast<Word>(value) });
+	}
+
+	void LoadZero(Word reg, SlotKind kind)
+	{
+		if (kind == SlotKind::FLOAT) {
+			Emit(Opcode::LOADK, { reg, m_unit.Constant(0.0) });
+		}
+		else {
+			LoadInteger(reg, 0);
+		}
+	}
+
+	//
+	// Expressions.
+	//
+
+	Operand LowerExpr(const ASTNode *node, int hint = -1);
+	Operand LowerBinary(const BinaryOperator&, int hint);
+	Operand LowerLogical(const BinaryOperator&, int hint);
+	Operand LowerUnary(const UnaryOperator&, int hint);
+	Operand LowerCompoundAssign(const CompoundAssignOperator&, int hint);
+	Operand LowerConditional(const ConditionalOperator&, int hint);
+	Operand LowerCall(const CallExpr&, int hint);
+	Operand Arithmetic(BinaryOperator::BinOperand, const Operand& lhs, const Operand& rhs, int hint);
+
+	// Lower the expression into the register, converted to the slot kind.
+	void LowerInto(const ASTNode *node, Word dst, SlotKind kind)
+	{
+		const Operand operand = LowerExpr(node, static_cast<int>(dst));
+		Move(dst, Convert(operand, kind));
+	}
+
+	// Lower the expression into a condition register.
+	Word Condition(const ASTNode *node)
+	{
+		return Truth(LowerExpr(node));
+	}
+
+	LValue LowerLValue(const ASTNode *node);
+	Word Load(const LValue&, int hint);
+	void Store(const LValue&, Word reg);
+
+	//
+	// Statements.
+	//
+
+	void LowerStatement(const ASTNode *node);
+	void LowerCompound(const CompoundStmt&);
+	void LowerDeclaration(const DeclStmt&);
+	void LowerVariable(const VarDecl&);
+	void LowerIf(const IfStmt&);
+	void LowerWhile(const WhileStmt&);
+	void LowerDo(const DoStmt&);
+	void LowerFor(const ForStmt&);
+	void LowerSwitch(const SwitchStmt&);
+	void LowerReturn(const ReturnStmt&);
+	void LowerBreak();
+	void LowerContinue();
+
+	// Lower the statement and release all temporaries afterwards.
+	void LowerTemporary(const ASTNode *node)
+	{
+		const Word mark = m_nextSlot;
+		LowerStatement(node);
+		m_nextSlot = mark;
+	}
+
+	// Fill the array slots with zero.
+	void ZeroFill(Word slot, const Shape& shape);
+};
+
+//
+// Expressions.
+//
+
+FunctionLowering::Operand FunctionLowering::LowerExpr(const ASTNode *node, int hint)
+{
+	if (!node) { Unsupported(); }
+
+	switch (node->Label()) {
+	case NodeID::INTEGER_LITERAL_ID:
+	case NodeID::CHARACTER_LITERAL_ID: {
+		const Word reg = Target(hint);
+		LoadInteger(reg, IntegerValue(*Util::Cast<Literal>(node)));
+		return { reg, SlotKind::INTEGER };
+	}
+	case NodeID::FLOAT_LITERAL_ID: {
+		const Word reg = Target(hint);
+		Emit(Opcode::LOADK, { reg, m_unit.Constant(RealValue(*Util::Cast<Literal>(node))) });
+		return { reg, SlotKind::FLOAT };
+	}
+
+	case NodeID::DECL_REF_EXPR_ID:
+	case NodeID::ARRAY_SUBSCRIPT_EXPR_ID: {
+		const LValue lvalue = LowerLValue(node);
+		return { Load(lvalue, hint), lvalue.kind };
+	}
+
+	case NodeID::PAREN_EXPR_ID:
+		return LowerExpr(Util::Cast<ParenExpr>(node)->Expression().get(), hint);
+	case NodeID::IMPLICIT_CONVERTION_EXPR_ID:
+	case NodeID::CAST_EXPR_ID: {
+		const auto castNode = Util::Cast<Expr>(node);
+		const Operand operand = node->Label() == NodeID::CAST_EXPR_ID
+			? LowerExpr(Util::Cast<CastExpr>(node)->Expression().get())
+			: LowerExpr(Util::Cast<ImplicitConvertionExpr>(node)->Expression().get());
+		if (!castNode->HasReturnType()) {
+			return operand;
+		}
+		const Shape shape = ShapeOf(castNode->ReturnType());
+		if (shape.isArray) { Unsupported(); }
+		return { Convert(operand, shape.kind), shape.kind };
+	}
+
+	case NodeID::BINARY_OPERATOR_ID:
+		return LowerBinary(*Util::Cast<BinaryOperator>(node), hint);
+	case NodeID::UNARY_OPERATOR_ID:
+		return LowerUnary(*Util::Cast<UnaryOperator>(node), hint);
+	case NodeID::COMPOUND_ASSIGN_OPERATOR_ID:
+		return LowerCompoundAssign(*Util::Cast<CompoundAssignOperator>(node), hint);
+	case NodeID::CONDITIONAL_OPERATOR_ID:
+		return LowerConditional(*Util::Cast<ConditionalOperator>(node), hint);
+	case NodeID::CALL_EXPR_ID:
+		return LowerCall(*Util::Cast<CallExpr>(node), hint);
+
+	default:
+		break;
+	}
+
+	Unsupported();
+}
+
+FunctionLowering::LValue FunctionLowering::LowerLValue(const ASTNode *node)
+{
+	switch (node->Label()) {
+	case NodeID::DECL_REF_EXPR_ID: {
+		const std::string identifier = Util::Cast<DeclRefExpr>(node)->Identifier();
+		if (const Local *local = FindLocal(identifier)) {
+			if (local->count != 1) { Unsupported(); }
+			return { LValue::LOCAL, local->slot, 0, 1, local->kind };
+		}
+		if (const auto global = m_unit.FindGlobal(identifier)) {
+			return { LValue::GLOBAL, global->first, 0, 1, global->second };
+		}
+		break;
+	}
+	case NodeID::ARRAY_SUBSCRIPT_EXPR_ID: {
+		const auto subscript = Util::Cast<ArraySubscriptExpr>(node);
+		const Local *local = FindLocal(subscript->ArrayDeclaration()->Identifier());
+		if (!local || local->count == 1) { break; }
+
+		const Operand index = LowerExpr(subscript->OffsetExpression().get());
+		if (index.kind != SlotKind::INTEGER) { Unsupported(); }
+		return { LValue::ELEMENT, local->slot, index.reg, local->count, local->kind };
+	}
+	case NodeID::PAREN_EXPR_ID:
+		return LowerLValue(Util::Cast<ParenExpr>(node)->Expression().get());
+	default:
+		break;
+	}
+
+	Unsupported();
+}
+
+Word FunctionLowering::Load(const LValue& lvalue, int hint)
+{
+	switch (lvalue.storage) {
+	case LValue::LOCAL:
+		return lvalue.slot;
+	case LValue::GLOBAL: {
+		const Word reg = Target(hint);
+		Emit(Opcode::LOADG, { reg, lvalue.slot });
+		return reg;
+	}
+	case LValue::ELEMENT: {
+		const Word reg = Target(hint);
+		Emit(Opcode::LOADX, { reg, lvalue.slot, lvalue.index, lvalue.count });
+		return reg;
+	}
+	}
+
+	Unsupported();
+}
+
+void FunctionLowering::Store(const LValue& lvalue, Word reg)
+{
+	switch (lvalue.storage) {
+	case LValue::LOCAL:
+		Move(lvalue.slot, reg);
+		break;
+	case LValue::GLOBAL:
+		Emit(Opcode::STOREG, { lvalue.slot, reg });
+		break;
+	case LValue::ELEMENT:
+		Emit(Opcode::STOREX, { lvalue.slot, lvalue.index, reg, lvalue.count });
+		break;
+	}
+}
+
+FunctionLowering::Operand FunctionLowering::Arithmetic(BinaryOperator::BinOperand operand, const Operand& lhs, const Operand& rhs, int hint)
+{
+	using BinOperand = BinaryOperator::BinOperand;
+
+	if (lhs.kind == SlotKind::VOID || rhs.kind == SlotKind::VOID) { Unsupported(); }
+
+	// Operands are promoted to the widest kind.
+	const SlotKind kind = lhs.kind == SlotKind::FLOAT || rhs.kind == SlotKind::FLOAT
+		? SlotKind::FLOAT
+		: SlotKind::INTEGER;
+	const bool isFloat = kind == SlotKind::FLOAT;
+
+	Opcode opcode;
+	bool isCompare = false;
+	switch (operand) {
+	case BinOperand::PLUS: opcode = isFloat ? Opcode::ADDF : Opcode::ADDI; break;
+	case BinOperand::MINUS: opcode = isFloat ? Opcode::SUBF : Opcode::SUBI; break;
+	case BinOperand::MUL: opcode = isFloat ? Opcode::MULF : Opcode::MULI; break;
+	case BinOperand::DIV: opcode = isFloat ? Opcode::DIVF : Opcode::DIVI; break;
+	case BinOperand::EQ: opcode = isFloat ? Opcode::EQF : Opcode::EQI; isCompare = true; break;
+	case BinOperand::NEQ: opcode = isFloat ? Opcode::NEF : Opcode::NEI; isCompare = true; break;
+	case BinOperand::LT: opcode = isFloat ? Opcode::LTF : Opcode::LTI; isCompare = true; break;
+	case BinOperand::GT: opcode = isFloat ? Opcode::GTF : Opcode::GTI; isCompare = true; break;
+	case BinOperand::LE: opcode = isFloat ? Opcode::LEF : Opcode::LEI; isCompare = true; break;
+	case BinOperand::GE: opcode = isFloat ? Opcode::GEF : Opcode::GEI; isCompare = true; break;
+
+	case BinOperand::MOD: opcode = Opcode::MODI; break;
+	case BinOperand::XOR: opcode = Opcode::XORI; break;
+	case BinOperand::OR: opcode = Opcode::ORI; break;
+	case BinOperand::AND: opcode = Opcode::ANDI; break;
+	case BinOperand::SLEFT: opcode = Opcode::SHLI; break;
+	case BinOperand::SRIGHT: opcode = Opcode::SHRI; break;
+
+	default:
+		Unsupported();
+	}
+
+	// Integer only operators.
+	if (isFloat && (opcode == Opcode::MODI || opcode == Opcode::XORI || opcode == Opcode::ORI
+		|| opcode == Opcode::ANDI || opcode == Opcode::SHLI || opcode == Opcode::SHRI)) {
+		Unsupported();
+	}
+
+	const Word a = Convert(lhs, kind);
+	const Word b = Convert(rhs, kind);
+	const Word reg = Target(hint);
+	Emit(opcode, { reg, a, b });
+	return { reg, isCompare ? SlotKind::INTEGER : kind };
+}
+
+FunctionLowering::Operand FunctionLowering::LowerBinary(const BinaryOperator& node, int hint)
+{
+	using BinOperand = BinaryOperator::BinOperand;
+
+	switch (node.Operand()) {
+	case BinOperand::ASSGN: {
+		const LValue lvalue = LowerLValue(node.LHS().get());
+		if (lvalue.storage == LValue::LOCAL) {
+			LowerInto(node.RHS().get(), lvalue.slot, lvalue.kind);
+			return { lvalue.slot, lvalue.kind };
+		}
+
+		const Word reg = Convert(LowerExpr(node.RHS().get()), lvalue.kind);
+		Store(lvalue, reg);
+		return { reg, lvalue.kind };
+	}
+
+	case BinOperand::LAND:
+	case BinOperand::LOR:
+		return LowerLogical(node, hint);
+
+	default:
+		break;
+	}
+
+	// Add and subtract with an integer literal take an immediate operand.
+	const ASTNode *rhsNode = node.RHS().get();
+	if ((node.Operand() == BinOperand::PLUS || node.Operand() == BinOperand::MINUS)
+		&& rhsNode && rhsNode->Label() == NodeID::INTEGER_LITERAL_ID) {
+		const Operand lhs = LowerExpr(node.LHS().get());
+		if (lhs.kind == SlotKind::INTEGER) {
+			const int32_t value = IntegerValue(*Util::Cast<Literal>(rhsNode));
+			const Word reg = Target(hint);
+			Emit(Opcode::ADDIK, { reg, lhs.reg, static_cast<Word>(node.Operand() == BinOperand::PLUS ? value : 0 - value) });
+			return { reg, SlotKind::INTEGER };
+		}
+
+		const Operand rhs = LowerExpr(rhsNode);
+		return Arithmetic(node.Operand(), lhs, rhs, hint);
+	}
+
+	const Operand lhs = LowerExpr(node.LHS().get());
+	const Operand rhs = LowerExpr(rhsNode);
+	return Arithmetic(node.Operand(), lhs, rhs, hint);
+}
+
+// Logical operators evaluate the right side only if the left side does
+// not decide the result. The result is written last, so the target may
+// be an operand of the expression.
+FunctionLowering::Operand FunctionLowering::LowerLogical(const BinaryOperator& node, int hint)
+{
+	const bool isAnd = node.Operand() == BinaryOperator::BinOperand::LAND;
+	const Opcode shortCircuit = isAnd ? Opcode::JZ : Opcode::JNZ;
+
+	const size_t lhsJump = EmitJump(shortCircuit, Condition(node.LHS().get()));
+	const size_t rhsJump = EmitJump(shortCircuit, Condition(node.RHS().get()));
+
+	const Word reg = Target(hint);
+	LoadInteger(reg, isAnd ? 1 : 0);
+	const size_t endJump = EmitJump(Opcode::JMP);
+	PatchJump(lhsJump, Position());
+	PatchJump(rhsJump, Position());
+	LoadInteger(reg, isAnd ? 0 : 1);
+	PatchJump(endJump, Position());
+
+	return { reg, SlotKind::INTEGER };
+}
+
+FunctionLowering::Operand FunctionLowering::LowerUnary(const UnaryOperator& node, int hint)
+{
+	const ASTNode *expression = node.Expression().get();
+
+	switch (node.Operand()) {
+	case UnaryOperator::INC:
+	case UnaryOperator::DEC: {
+		const LValue lvalue = LowerLValue(expression);
+		const int32_t step = node.Operand() == UnaryOperator::INC ? 1 : -1;
+		const Word value = Load(lvalue, -1);
+
+		// Postfix operators yield the value before the update.
+		Word result = value;
+		if (node.OperationSide() == UnaryOperator::POSTFIX) {
+			result = Target(hint);
+			Move(result, value);
+		}
+
+		// Global and element values are loaded into a temporary first.
+		const Word updated = lvalue.storage == LValue::LOCAL ? lvalue.slot : value;
+		if (lvalue.kind == SlotKind::FLOAT) {
+			const Word one = Temporary();
+			Emit(Opcode::LOADK, { one, m_unit.Constant(static_cast<double>(step)) });
+			Emit(Opcode::ADDF, { updated, value, one });
+		}
+		else {
+			Emit(Opcode::ADDIK, { updated, value, static_cast<Word>(step) });
+		}
+		Store(lvalue, updated);
+
+		return { result, lvalue.kind };
+	}
+
+	case UnaryOperator::INTPOS:
+		return LowerExpr(expression, hint);
+
+	case UnaryOperator::INTNEG: {
+		const Operand operand = LowerExpr(expression);
+		const Word reg = Target(hint);
+		if (operand.kind == SlotKind::FLOAT) {
+			Emit(Opcode::NEGF, { reg, operand.reg });
+		}
+		else if (operand.kind == SlotKind::INTEGER) {
+			Emit(Opcode::NEGI, { reg, operand.reg });
+		}
+		else {
+			Unsupported();
+		}
+		return { reg, operand.kind };
+	}
+
+	case UnaryOperator::BITNOT: {
+		const Operand operand = LowerExpr(expression);
+		if (operand.kind != SlotKind::INTEGER) { Unsupported(); }
+		const Word reg = Target(hint);
+		Emit(Opcode::BNOT, { reg, operand.reg });
+		return { reg, SlotKind::INTEGER };
+	}
+
+	case UnaryOperator::BOOLNOT: {
+		const Word condition = Condition(expression);
+		const Word reg = Target(hint);
+		Emit(Opcode::NOT, { reg, condition });
+		return { reg, SlotKind::INTEGER };
+	}
+
+	default:
+		break;
+	}
+
+	// Pointer operators have no bytecode equivalent.
+	Unsupported();
+}
+
+FunctionLowering::Operand FunctionLowering::LowerCompoundAssign(const CompoundAssignOperator& node, int hint)
+{
+	using BinOperand = BinaryOperator::BinOperand;
+
+	BinOperand operand;
+	switch (node.Operand()) {
+	case CompoundAssignOperator::MUL: operand = BinOperand::MUL; break;
+	case CompoundAssignOperator::DIV: operand = BinOperand::DIV; break;
+	case CompoundAssignOperator::MOD: operand = BinOperand::MOD; break;
+	case CompoundAssignOperator::ADD: operand = BinOperand::PLUS; break;
+	case CompoundAssignOperator::SUB: operand = BinOperand::MINUS; break;
+	case CompoundAssignOperator::LEFT: operand = BinOperand::SLEFT; break;
+	case CompoundAssignOperator::RIGHT: operand = BinOperand::SRIGHT; break;
+	case CompoundAssignOperator::AND: operand = BinOperand::AND; break;
+	case CompoundAssignOperator::XOR: operand = BinOperand::XOR; break;
+	case CompoundAssignOperator::OR: operand = BinOperand::OR; break;
+	default:
+		Unsupported();
+	}
+
+	CRY_UNUSED(hint);
+
+	const LValue lvalue = LowerLValue(node.Identifier().get());
+	const Operand current{ Load(lvalue, -1), lvalue.kind };
+	const Operand rhs = LowerExpr(node.Expression().get());
+
+	// The result is computed in place for locals, unless the result
+	// must be converted back into the kind of the local.
+	const int target = lvalue.storage == LValue::LOCAL && rhs.kind == lvalue.kind
+		? static_cast<int>(lvalue.slot)
+		: -1;
+	const Operand result = Arithmetic(operand, current, rhs, target);
+	const Word reg = Convert(result, lvalue.kind);
+	Store(lvalue, reg);
+
+	return { reg, lvalue.kind };
+}
+
+FunctionLowering::Operand FunctionLowering::LowerConditional(const ConditionalOperator& node, int hint)
+{
+	const Word reg = Target(hint);
+	const size_t altJump = EmitJump(Opcode::JZ, Condition(node.Expression().get()));
+
+	// The branches must agree on the kind, the target is not
+	// known to be either before both branches are lowered.
+	const Operand truth = LowerExpr(node.TruthStatement().get());
+	Move(reg, truth.reg);
+	const size_t endJump = EmitJump(Opcode::JMP);
+	PatchJump(altJump, Position());
+	const Operand alt = LowerExpr(node.AltStatement().get());
+	Move(reg, alt.reg);
+	PatchJump(endJump, Position());
+
+	if (truth.kind != alt.kind || truth.kind == SlotKind::VOID) { Unsupported(); }
+	return { reg, truth.kind };
+}
+
+FunctionLowering::Operand FunctionLowering::LowerCall(const CallExpr& node, int hint)
+{
+	if (node.Label() != NodeID::CALL_EXPR_ID) { Unsupported(); }
+
+	const std::string identifier = node.FunctionReference()->Identifier();
+	std::vector<ASTNode *> arguments;
+	if (node.HasArguments()) {
+		arguments = node.ArgumentStatement()->ChildNodes();
+	}
+
+	// Call into a function in this unit.
+	if (const Signature *signature = m_unit.FindSignature(identifier)) {
+		if (arguments.size() != signature->params.size()) { Unsupported(); }
+
+		std::vector<Word> operands{ 0, signature->index, static_cast<Word>(arguments.size()) };
+		for (size_t i = 0; i < arguments.size(); ++i) {
+			operands.push_back(Convert(LowerExpr(arguments[i]), signature->params[i]));
+		}
+
+		const Word reg = Target(hint);
+		operands[0] = reg;
+		m_function.code.push_back(static_cast<Word>(Opcode::CALL));
+		m_function.code.insert(m_function.code.end(), operands.cbegin(), operands.cend());
+		return { reg, signature->returnKind };
+	}
+
+	// Call into an external routine. Constant strings are passed by reference
+	// into the constant pool, all other arguments are passed by value.
+	std::vector<Word> operands{ 0, m_unit.Constant(identifier), static_cast<Word>(arguments.size()) };
+	for (const ASTNode *argument : arguments) {
+		if (argument && argument->Label() == NodeID::STRING_LITERAL_ID) {
+			const auto literal = Util::Cast<StringLiteral>(argument);
+			operands.push_back(static_cast<Word>(Casm::ArgKind::STRING));
+			operands.push_back(m_unit.Constant(Util::ValueCastString(literal->Value())));
+			continue;
+		}
+
+		const Operand operand = LowerExpr(argument);
+		if (operand.kind == SlotKind::VOID) { Unsupported(); }
+		operands.push_back(static_cast<Word>(operand.kind == SlotKind::FLOAT ? Casm::ArgKind::FLOAT : Casm::ArgKind::INTEGER));
+		operands.push_back(operand.reg);
+	}
+
+	const Word reg = Target(hint);
+	operands[0] = reg;
+	m_function.code.push_back(static_cast<Word>(Opcode::CALLX));
+	m_function.code.insert(m_function.code.end(), operands.cbegin(), operands.cend());
+	return { reg, m_unit.ExternalReturnKind(identifier) };
+}
+
+//
+// Statements.
+//
+
+void FunctionLowering::LowerStatement(const ASTNode *node)
+{
+	if (!node) { return; }
+
+	switch (node->Label()) {
+	case NodeID::COMPOUND_STMT_ID:
+		LowerCompound(*Util::Cast<CompoundStmt>(node));
+		break;
+	// Declarations are only lowered at block level, the slot would
+	// otherwise be released with the temporaries of the statement.
+	case NodeID::DECL_STMT_ID:
+		Unsupported();
+	case NodeID::IF_STMT_ID:
+		LowerIf(*Util::Cast<IfStmt>(node));
+		break;
+	case NodeID::WHILE_STMT_ID:
+		LowerWhile(*Util::Cast<WhileStmt>(node));
+		break;
+	case NodeID::DO_STMT_ID:
+		LowerDo(*Util::Cast<DoStmt>(node));
+		break;
+	case NodeID::FOR_STMT_ID:
+		LowerFor(*Util::Cast<ForStmt>(node));
+		break;
+	case NodeID::SWITCH_STMT_ID:
+		LowerSwitch(*Util::Cast<SwitchStmt>(node));
+		break;
+	case NodeID::RETURN_STMT_ID:
+		LowerReturn(*Util::Cast<ReturnStmt>(node));
+		break;
+	case NodeID::BREAK_STMT_ID:
+		LowerBreak();
+		break;
+	case NodeID::CONTINUE_STMT_ID:
+		LowerContinue();
+		break;
+
+	// Case labels bind the pending jumps of the enclosing switch.
+	case NodeID::CASE_STMT_ID:
+	case NodeID::DEFAULT_STMT_ID: {
+		if (m_switches.empty()) { Unsupported(); }
+		auto& labels = m_switches.back().labels;
+		const auto it = labels.find(node);
+		if (it == labels.end()) { Unsupported(); }
+		PatchJumps(it->second, Position());
+		LowerStatement(node->Label() == NodeID::CASE_STMT_ID
+			? Util::Cast<CaseStmt>(node)->Expression().get()
+			: Util::Cast<DefaultStmt>(node)->Expression().get());
+		break;
+	}
+
+	// Anything else must be an expression evaluated for its side effects.
+	default:
+		LowerExpr(node);
+		break;
+	}
+}
+
+void FunctionLowering::LowerCompound(const CompoundStmt& node)
+{
+	const Word mark = m_nextSlot;
+	PushScope();
+	for (const ASTNode *child : node.ChildNodes()) {
+		if (child && child->Label() == NodeID::DECL_STMT_ID) {
+			LowerDeclaration(*Util::Cast<DeclStmt>(child));
+			continue;
+		}
+		LowerTemporary(child);
+	}
+	PopScope(mark);
+}
+
+void FunctionLowering::LowerDeclaration(const DeclStmt& node)
+{
+	for (const ASTNode *child : node.ChildNodes()) {
+		if (!child || child->Label() != NodeID::VAR_DECL_ID) { Unsupported(); }
+		LowerVariable(*Util::Cast<VarDecl>(child));
+	}
+}
+
+void FunctionLowering::ZeroFill(Word slot, const Shape& shape)
+{
+	const Word mark = m_nextSlot;
+	const Word index = Temporary();
+	const Word zero = Temporary();
+	const Word limit = Temporary();
+	const Word test = Temporary();
+	LoadInteger(index, 0);
+	LoadZero(zero, shape.kind);
+	LoadInteger(limit, static_cast<int32_t>(shape.count));
+
+	const size_t top = Position();
+	Emit(Opcode::STOREX, { slot, index, zero, shape.count });
+	Emit(Opcode::ADDIK, { index, index, 1 });
+	Emit(Opcode::LTI, { test, index, limit });
+	EmitJumpTo(Opcode::JNZ, top, test);
+	m_nextSlot = mark;
+}
+
+void FunctionLowering::LowerVariable(const VarDecl& node)
+{
+	if (Util::IsStatic(node.ReturnType().BaseType())) { Unsupported(); }
+
+	const Shape shape = ShapeOf(node.ReturnType());
+	const Word slot = Allocate(shape.count);
+	const Word mark = m_nextSlot;
+
+	if (shape.isArray) {
+		const ASTNode *initializer = node.Expression().get();
+		if (!initializer) {
+			ZeroFill(slot, shape);
+		}
+		else if (initializer->Label() == NodeID::INIT_LIST_EXPR_ID) {
+			const auto items = Util::Cast<InitListExpr>(initializer)->List();
+			if (items.size() > shape.count) { Unsupported(); }
+			if (items.size() < shape.count) {
+				ZeroFill(slot, shape);
+			}
+			for (size_t i = 0; i < items.size(); ++i) {
+				LowerInto(items[i].get(), slot + static_cast<Word>(i), shape.kind);
+			}
+		}
+		else if (initializer->Label() == NodeID::STRING_LITERAL_ID && shape.kind == SlotKind::INTEGER) {
+			const std::string str = Util::ValueCastString(Util::Cast<StringLiteral>(initializer)->Value());
+			if (str.size() > shape.count) { Unsupported(); }
+			ZeroFill(slot, shape);
+			for (size_t i = 0; i < str.size(); ++i) {
+				LoadInteger(slot + static_cast<Word>(i), str[i]);
+			}
+		}
+		else {
+			Unsupported();
+		}
+	}
+	else if (node.HasExpression()) {
+		LowerInto(node.Expression().get(), slot, shape.kind);
+	}
+
+	m_nextSlot = mark;
+
+	// The name is visible once the declarator is complete.
+	m_scopes.back()[node.Identifier()] = Local{ slot, shape.kind, shape.count };
+	m_function.layout.push_back(Casm::SlotInfo{ node.Identifier(), shape.kind, slot, shape.count });
+}
+
+void FunctionLowering::LowerIf(const IfStmt& node)
+{
+	const Word mark = m_nextSlot;
+	const size_t altJump = EmitJump(Opcode::JZ, Condition(node.Expression().get()));
+	m_nextSlot = mark;
+
+	LowerTemporary(node.TruthCompound().get());
+	if (!node.HasAltCompound()) {
+		PatchJump(altJump, Position());
+		return;
+	}
+
+	const size_t endJump = EmitJump(Opcode::JMP);
+	PatchJump(altJump, Position());
+	LowerTemporary(node.AltCompound().get());
+	PatchJump(endJump, Position());
+}
+
+void FunctionLowering::LowerWhile(const WhileStmt& node)
+{
+	const Word mark = m_nextSlot;
+	const size_t top = Position();
+	const size_t exitJump = EmitJump(Opcode::JZ, Condition(node.Expression().get()));
+	m_nextSlot = mark;
+
+	m_branches.push_back(BranchScope{});
+	LowerTemporary(node.BodyExpression().get());
+	EmitJumpTo(Opcode::JMP, top);
+
+	PatchJump(exitJump, Position());
+	PatchJumps(m_branches.back().breaks, Position());
+	PatchJumps(m_branches.back().continues, top);
+	m_branches.pop_back();
+}
+
+void FunctionLowering::LowerDo(const DoStmt& node)
+{
+	const size_t top = Position();
+
+	m_branches.push_back(BranchScope{});
+	LowerTemporary(node.BodyExpression().get());
+
+	const Word mark = m_nextSlot;
+	const size_t next = Position();
+	EmitJumpTo(Opcode::JNZ, top, Condition(node.Expression().get()));
+	m_nextSlot = mark;
+
+	PatchJumps(m_branches.back().breaks, Position());
+	PatchJumps(m_branches.back().continues, next);
+	m_branches.pop_back();
+}
+
+void FunctionLowering::LowerFor(const ForStmt& node)
+{
+	const Word mark = m_nextSlot;
+	PushScope();
+
+	if (const ASTNode *init = node.Declaration().get()) {
+		if (init->Label() == NodeID::DECL_STMT_ID) {
+			LowerDeclaration(*Util::Cast<DeclStmt>(init));
+		}
+		else {
+			LowerTemporary(init);
+		}
+	}
+
+	const size_t top = Position();
+	size_t exitJump = 0;
+	const bool hasCondition = node.Expression() != nullptr;
+	if (hasCondition) {
+		const Word conditionMark = m_nextSlot;
+		exitJump = EmitJump(Opcode::JZ, Condition(node.Expression().get()));
+		m_nextSlot = conditionMark;
+	}
+
+	m_branches.push_back(BranchScope{});
+	LowerTemporary(node.BodyExpression().get());
+
+	const size_t next = Position();
+	LowerTemporary(node.FinishStatement().get());
+	EmitJumpTo(Opcode::JMP, top);
+
+	if (hasCondition) {
+		PatchJump(exitJump, Position());
+	}
+	PatchJumps(m_branches.back().breaks, Position());
+	PatchJumps(m_branches.back().continues, next);
+	m_branches.pop_back();
+
+	PopScope(mark);
+}
+
+// The switch is lowered as a compare chain on the case labels at the
+// top level of the switch body, followed by the body itself. Case
+// labels nested deeper into the body are not supported.
+void FunctionLowering::LowerSwitch(const SwitchStmt& node)
+{
+	const ASTNode *body = node.BodyExpression().get();
+	if (!body || body->Label() != NodeID::COMPOUND_STMT_ID) { Unsupported(); }
+
+	const Word mark = m_nextSlot;
+	const Operand selector = LowerExpr(node.Expression().get());
+	if (selector.kind != SlotKind::INTEGER) { Unsupported(); }
+
+	// Keep the selector for the duration of the switch.
+	const Word value = Temporary();
+	Move(value, selector.reg);
+
+	SwitchScope scope;
+	const ASTNode *defaultLabel = nullptr;
+	const Word test = Temporary();
+
+	for (const ASTNode *child : body->ChildNodes()) {
+		// Consecutive labels are nested into each other.
+		for (const ASTNode *label = child; label;) {
+			if (label->Label() == NodeID::CASE_STMT_ID) {
+				const auto caseNode = Util::Cast<CaseStmt>(label);
+				const ASTNode *identifier = caseNode->Identifier().get();
+				if (!identifier || (identifier->Label() != NodeID::INTEGER_LITERAL_ID
+					&& identifier->Label() != NodeID::CHARACTER_LITERAL_ID)) {
+					Unsupported();
+				}
+
+				LoadInteger(test, IntegerValue(*Util::Cast<Literal>(identifier)));
+				Emit(Opcode::EQI, { test, value, test });
+				scope.labels[label].push_back(EmitJump(Opcode::JNZ, test));
+				label = caseNode->Expression().get();
+			}
+			else if (label->Label() == NodeID::DEFAULT_STMT_ID) {
+				if (defaultLabel) { Unsupported(); }
+				defaultLabel = label;
+				scope.labels[label];
+				label = Util::Cast<DefaultStmt>(label)->Expression().get();
+			}
+			else {
+				break;
+			}
+		}
+	}
+
+	const size_t defaultJump = EmitJump(Opcode::JMP);
+	if (defaultLabel) {
+		scope.labels[defaultLabel].push_back(defaultJump);
+	}
+
+	m_switches.push_back(std::move(scope));
+	m_branches.push_back(BranchScope{});
+	LowerStatement(body);
+
+	if (!defaultLabel) {
+		PatchJump(defaultJump, Position());
+	}
+	PatchJumps(m_branches.back().breaks, Position());
+
+	// Continue statements belong to the enclosing loop.
+	auto continues = std::move(m_branches.back().continues);
+	m_branches.pop_back();
+	m_switches.pop_back();
+	if (!continues.empty()) {
+		if (m_branches.empty()) { Unsupported(); }
+		auto& outer = m_branches.back().continues;
+		outer.insert(outer.end(), continues.cbegin(), continues.cend());
+	}
+
+	m_nextSlot = mark;
+}
+
+void FunctionLowering::LowerReturn(const ReturnStmt& node)
+{
+	if (!node.HasExpression()) {
+		Emit(Opcode::RETV);
+		return;
+	}
+
+	const Operand operand = LowerExpr(node.Expression().get());
+	Emit(Opcode::RET, { Convert(operand, m_function.returnKind) });
+}
+
+void FunctionLowering::LowerBreak()
+{
+	if (m_branches.empty()) { Unsupported(); }
+	m_branches.back().breaks.push_back(EmitJump(Opcode::JMP));
+}
+
+void FunctionLowering::LowerContinue()
+{
+	// Switch scopes forward the continue to the enclosing loop.
+	if (m_branches.empty()) { Unsupported(); }
+	m_branches.back().continues.push_back(EmitJump(Opcode::JMP));
+}
+
+void FunctionLowering::LowerFunction(const FunctionDecl& node, const Signature& signature)
+{
+	// Parameters take the first slots in order of declaration.
+	if (node.HasParameters()) {
+		size_t i = 0;
+		for (const ASTNode *child : node.ParameterStatement()->ChildNodes()) {
+			// A single void parameter has no slot.
+			if (i == signature.params.size()) { break; }
+			const auto param = Util::Cast<ParamDecl>(child);
+			Declare(param->Identifier(), Shape{ signature.params[i++], 1, false });
+		}
+	}
+
+	LowerStatement(node.FunctionCompound().get());
+
+	// Falling off the end returns zero, as main does.
+	if (m_function.returnKind == SlotKind::VOID) {
+		Emit(Opcode::RETV);
+	}
+	else {
+		const Word reg = Temporary();
+		LoadZero(reg, m_function.returnKind);
+		Emit(Opcode::RET, { reg });
+	}
+}
+
+void FunctionLowering::LowerInitializer(const std::vector<const VarDecl *>& globals)
+{
+	for (const VarDecl *node : globals) {
+		const auto global = m_unit.FindGlobal(node->Identifier());
+		const Word mark = m_nextSlot;
+		const Word reg = Convert(LowerExpr(node->Expression().get()), global->second);
+		Emit(Opcode::STOREG, { global->first, reg });
+		m_nextSlot = mark;
+	}
+
+	Emit(Opcode::RETV);
+}
+
+// Parameter kinds of the function, variadic functions are not supported.
+std::vector<SlotKind> ParameterKinds(const FunctionDecl& node)
+{
+	std::vector<SlotKind> params;
+	if (!node.HasParameters()) { return params; }
+
+	for (const ASTNode *child : node.ParameterStatement()->ChildNodes()) {
+		if (!child || child->Label() != NodeID::PARAM_DECL_ID) { Unsupported(); }
+		const auto param = Util::Cast<ParamDecl>(child);
+		const Shape shape = ShapeOf(param->ReturnType());
+		if (shape.isArray || shape.kind == SlotKind::VOID) {
+			// A single void parameter is an empty parameter list.
+			if (shape.kind == SlotKind::VOID && param->Identifier().empty() && params.empty()) {
+				continue;
+			}
+			Unsupported();
+		}
+		params.push_back(shape.kind);
+	}
+
+	return params;
+}
+
+void UnitLowering::Lower(ASTNode& root)
+{
+	std::vector<FunctionDecl *> functions;
+	std::vector<const VarDecl *> initializers;
+
+	// Register all signatures and globals first, functions may
+	// be called before they are defined.
+	for (ASTNode *child : root.ChildNodes()) {
+		if (!child) { continue; }
+
+		switch (child->Label()) {
+		case NodeID::FUNCTION_DECL_ID: {
+			const auto node = Util::Cast<FunctionDecl>(child);
+			if (node->HasReturnType() && node->ReturnType().IsPointer()) { Unsupported(); }
+			const SlotKind returnKind = node->HasReturnType()
+				? ScalarKind(node->ReturnType().BaseType())
+				: SlotKind::INTEGER;
+
+			if (node->IsPrototypeDefinition()) {
+				m_externals.emplace(node->Identifier(), returnKind);
+				break;
+			}
+
+			Casm::Function function;
+			function.name = node->Identifier();
+			function.returnKind = returnKind;
+
+			Signature signature{ 0, returnKind, ParameterKinds(*node) };
+			function.paramCount = static_cast<Word>(signature.params.size());
+			signature.index = m_module.AddFunction(std::move(function));
+			m_signatures.emplace(node->Identifier(), std::move(signature));
+			functions.push_back(node);
+			break;
+		}
+		case NodeID::DECL_STMT_ID:
+		case NodeID::VAR_DECL_ID: {
+			std::vector<const ASTNode *> declarations;
+			if (child->Label() == NodeID::DECL_STMT_ID) {
+				declarations.assign(child->ChildNodes().cbegin(), child->ChildNodes().cend());
+			}
+			else {
+				declarations.push_back(child);
+			}
+
+			for (const ASTNode *declaration : declarations) {
+				if (!declaration || declaration->Label() != NodeID::VAR_DECL_ID) { Unsupported(); }
+				const auto node = Util::Cast<VarDecl>(declaration);
+				const Shape shape = ShapeOf(node->ReturnType());
+				if (shape.isArray || shape.kind == SlotKind::VOID) { Unsupported(); }
+
+				const Word slot = m_module.AddGlobal(node->Identifier(), shape.kind);
+				m_globals[node->Identifier()] = { slot, shape.kind };
+				if (node->HasExpression()) {
+					initializers.push_back(node);
+				}
+			}
+			break;
+		}
+
+		// Type declarations do not emit any code.
+		case NodeID::TYPEDEF_DECL_ID:
+		case NodeID::RECORD_DECL_ID:
+		case NodeID::ENUM_DECL_ID:
+			break;
+
+		default:
+			Unsupported();
+		}
+	}
+
+	// Globals without initializer start out as zero.
+	if (!initializers.empty()) {
+		Casm::Function function;
+		function.name = initializerName;
+		const Word index = m_module.AddFunction(std::move(function));
+		m_module.SetInitializer(static_cast<int>(index));
+
+		auto& initializer = m_module.Functions()[index];
+		FunctionLowering{ *this, initializer }.LowerInitializer(initializers);
+	}
+
+	// Deferred function bodies are loaded when lowered.
+	for (FunctionDecl *node : functions) {
+		node->LoadCompound();
+		const Signature& signature = m_signatures.at(node->Identifier());
+		auto& function = m_module.Functions()[signature.index];
+		FunctionLowering{ *this, function }.LowerFunction(*node, signature);
+	}
+}
+
+} // namespace
+
+void CASM::LowerAST(AST tree)
+{
+	ASTNode *root = (*tree);
+	if (!root) { return; }
+
+	Casm::Module module;
+	try {
+		UnitLowering{ module }.Lower(*root);
+	}
+	// The program is left to the tree walker.
+	catch (const UnsupportedConstruct&) {
+		return;
+	}
+
+	Cry::ByteArray buffer;
+	Casm::Module::Serialize(module, buffer);
+
+	// Hand the buffer over if the stream can take ownership.
+	if (m_bufferCallback) {
+		m_bufferCallback(std::move(static_cast<std::vector<uint8_t>&>(buffer)));
+		return;
+	}
+
+	m_outputCallback(buffer.data(), buffer.size());
+}
+
+} // namespace Sequencer
+} // namespace Emit
+} // namespace CoilCl
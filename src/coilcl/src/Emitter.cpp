@@ -33,9 +33,9 @@ AST Emitter::Strategy(ModuleInterface::ModulePerm permission)
 {
 	switch (permission)
 	{
+	// Every read only module receives the tree.
 	case ModuleInterface::ReadOnly:
-		//TODO: mark ReadOnly
-		return std::move(m_ast);
+		return m_ast;
 
 	case ModuleInterface::AppendData:
 	case ModuleInterface::CopyOnWrite:
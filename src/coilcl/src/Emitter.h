@@ -17,6 +17,8 @@
 #include <CryCC/AST.h>
 
 #include <vector>
+#include <iterator>
+#include <type_traits>
 
 namespace CoilCl
 {
@@ -67,6 +69,18 @@ class Module : public ModuleInterface
 		}
 	}
 
+	// Write buffer to all registered streams. The last stream takes the buffer.
+	void RelayOutput(std::vector<uint8_t>&& buffer)
+	{
+		if (m_streamOut.empty()) { return; }
+
+		const auto last = std::prev(m_streamOut.end());
+		for (auto it = m_streamOut.begin(); it != last; ++it) {
+			(*it)->Write(buffer.data(), buffer.size());
+		}
+		(*last)->Write(std::move(buffer));
+	}
+
 	// Read input from stream.
 	void RelayInput(uint8_t *data, size_t sz)
 	{
@@ -109,7 +123,18 @@ public:
 			this->RelayInput(data, sz);
 		};
 
-		m_sequencer = std::make_shared<SequenceType>(std::move(out), std::move(in));
+		const auto buffer = [this](std::vector<uint8_t>&& data)
+		{
+			this->RelayOutput(std::move(data));
+		};
+
+		// Pass the buffer callback if the sequencer can take it.
+		if constexpr (std::is_constructible_v<SequenceType, decltype(out), decltype(in), decltype(buffer)>) {
+			m_sequencer = std::make_shared<SequenceType>(std::move(out), std::move(in), std::move(buffer));
+		}
+		else {
+			m_sequencer = std::make_shared<SequenceType>(std::move(out), std::move(in));
+		}
 	}
 
 	~Module()
@@ -43,6 +43,9 @@ struct OutputStream
 	virtual void WriteDone() {}
 	// Write a datachunck 'vector' of size 'sz'.
 	virtual void Write(uint8_t *vector, size_t sz) = 0;
+	// Write an entire buffer. Streams which can take ownership of the
+	// buffer should override this method to avoid the copy.
+	virtual void Write(std::vector<uint8_t>&& buffer) { Write(buffer.data(), buffer.size()); }
 };
 
 // Interact with the console. All output is written to the
@@ -54,6 +57,8 @@ class Console
 	: public OutputStream
 {
 public:
+	using OutputStream::Write;
+
 	// Write data stream to console output.
 	virtual void Write(uint8_t *vector, size_t sz)
 	{
@@ -72,6 +77,8 @@ class File
 {
 	//FUTURE: write content to disk in a frontend provided file.
 public:
+	using OutputStream::Write;
+
 	virtual void Write(uint8_t *vector, size_t sz)
 	{
 		CRY_UNUSED(vector);
@@ -157,10 +164,13 @@ public:
 	// Check if stream is depleted.
 	inline bool IsEoS() const noexcept { return m_readOffset == m_block->size(); }
 
-	// Lock the memory block from buffer alteration.
+	// Lock the memory block from buffer alteration. Shrinking reallocates
+	// the block, so only release the capacity if the slack is substantial.
 	virtual void WriteDone() override
 	{
-		Shrink();
+		if (m_block->capacity() - m_block->size() > m_block->size() / 4) {
+			Shrink();
+		}
 		m_acl = AccessControl::READ_ONLY;
 	}
 
@@ -178,6 +188,22 @@ public:
 		}
 	}
 
+	// Take over the buffer if the memory block is empty, otherwise
+	// append the buffer to the memory block.
+	virtual void Write(std::vector<uint8_t>&& buffer) override
+	{
+		if (m_acl != AccessControl::READ_WRITE) {
+			CryImplExcept(); //TODO
+		}
+
+		if (!m_block->empty()) {
+			Write(buffer.data(), buffer.size());
+			return;
+		}
+
+		m_block->swap(buffer);
+	}
+
 	// Read data stream from memory block.
 	virtual void Read(uint8_t *vector, size_t sz) override
 	{
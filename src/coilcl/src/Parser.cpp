@@ -716,7 +716,7 @@ bool Parser::AssignmentOperator()
 	}
 	case TK_MUL_ASSIGN:
 	{
-		auto resv = Util::NodeCast<DeclRefExpr>(m_elementDescentPipe.next());
+		auto resv = m_elementDescentPipe.next();
 		auto comOp = Util::MakeASTNode<CompoundAssignOperator>(CompoundAssignOperator::CompoundAssignOperand::MUL, resv);
 		comOp->SetLocation(CurrentLocation());
 		m_elementDescentPipe.pop();
@@ -731,7 +731,7 @@ bool Parser::AssignmentOperator()
 	}
 	case TK_DIV_ASSIGN:
 	{
-		auto resv = Util::NodeCast<DeclRefExpr>(m_elementDescentPipe.next());
+		auto resv = m_elementDescentPipe.next();
 		auto comOp = Util::MakeASTNode<CompoundAssignOperator>(CompoundAssignOperator::CompoundAssignOperand::DIV, resv);
 		comOp->SetLocation(CurrentLocation());
 		m_elementDescentPipe.pop();
@@ -746,7 +746,7 @@ bool Parser::AssignmentOperator()
 	}
 	case TK_MOD_ASSIGN:
 	{
-		auto resv = Util::NodeCast<DeclRefExpr>(m_elementDescentPipe.next());
+		auto resv = m_elementDescentPipe.next();
 		auto comOp = Util::MakeASTNode<CompoundAssignOperator>(CompoundAssignOperator::CompoundAssignOperand::MOD, resv);
 		comOp->SetLocation(CurrentLocation());
 		m_elementDescentPipe.pop();
@@ -761,7 +761,7 @@ bool Parser::AssignmentOperator()
 	}
 	case TK_ADD_ASSIGN:
 	{
-		auto resv = Util::NodeCast<DeclRefExpr>(m_elementDescentPipe.next());
+		auto resv = m_elementDescentPipe.next();
 		auto comOp = Util::MakeASTNode<CompoundAssignOperator>(CompoundAssignOperator::CompoundAssignOperand::ADD, resv);
 		comOp->SetLocation(CurrentLocation());
 		m_elementDescentPipe.pop();
@@ -776,7 +776,7 @@ bool Parser::AssignmentOperator()
 	}
 	case TK_SUB_ASSIGN:
 	{
-		auto resv = Util::NodeCast<DeclRefExpr>(m_elementDescentPipe.next());
+		auto resv = m_elementDescentPipe.next();
 		auto comOp = Util::MakeASTNode<CompoundAssignOperator>(CompoundAssignOperator::CompoundAssignOperand::SUB, resv);
 		comOp->SetLocation(CurrentLocation());
 		m_elementDescentPipe.pop();
@@ -791,7 +791,7 @@ bool Parser::AssignmentOperator()
 	}
 	case TK_LEFT_ASSIGN:
 	{
-		auto resv = Util::NodeCast<DeclRefExpr>(m_elementDescentPipe.next());
+		auto resv = m_elementDescentPipe.next();
 		auto comOp = Util::MakeASTNode<CompoundAssignOperator>(CompoundAssignOperator::CompoundAssignOperand::LEFT, resv);
 		comOp->SetLocation(CurrentLocation());
 		m_elementDescentPipe.pop();
@@ -807,7 +807,7 @@ bool Parser::AssignmentOperator()
 	}
 	case TK_RIGHT_ASSIGN:
 	{
-		auto resv = Util::NodeCast<DeclRefExpr>(m_elementDescentPipe.next());
+		auto resv = m_elementDescentPipe.next();
 		auto comOp = Util::MakeASTNode<CompoundAssignOperator>(CompoundAssignOperator::CompoundAssignOperand::RIGHT, resv);
 		comOp->SetLocation(CurrentLocation());
 		m_elementDescentPipe.pop();
@@ -822,7 +822,7 @@ bool Parser::AssignmentOperator()
 	}
 	case TK_AND_ASSIGN:
 	{
-		auto resv = Util::NodeCast<DeclRefExpr>(m_elementDescentPipe.next());
+		auto resv = m_elementDescentPipe.next();
 		auto comOp = Util::MakeASTNode<CompoundAssignOperator>(CompoundAssignOperator::CompoundAssignOperand::AND, resv);
 		comOp->SetLocation(CurrentLocation());
 		m_elementDescentPipe.pop();
@@ -837,7 +837,7 @@ bool Parser::AssignmentOperator()
 	}
 	case TK_XOR_ASSIGN:
 	{
-		auto resv = Util::NodeCast<DeclRefExpr>(m_elementDescentPipe.next());
+		auto resv = m_elementDescentPipe.next();
 		auto comOp = Util::MakeASTNode<CompoundAssignOperator>(CompoundAssignOperator::CompoundAssignOperand::XOR, resv);
 		comOp->SetLocation(CurrentLocation());
 		m_elementDescentPipe.pop();
@@ -852,7 +852,7 @@ bool Parser::AssignmentOperator()
 	}
 	case TK_OR_ASSIGN:
 	{
-		auto resv = Util::NodeCast<DeclRefExpr>(m_elementDescentPipe.next());
+		auto resv = m_elementDescentPipe.next();
 		auto comOp = Util::MakeASTNode<CompoundAssignOperator>(CompoundAssignOperator::CompoundAssignOperand::OR, resv);
 		comOp->SetLocation(CurrentLocation());
 		m_elementDescentPipe.pop();
@@ -12,11 +12,17 @@
 
 // Project includes.
 #include <CryCC/AST.h>
+#include <CryCC/SubValue/TypeInterner.h>
+#include <CryCC/SubValue/TypeLayout.h>
+#include <CryCC/SubValue/TypedefType.h>
 
 #include <Cry/Algorithm.h>
 
 #include <boost/format.hpp>
 
+#include <algorithm>
+#include <unordered_map>
+
 #define PTR_NATIVE(p) (*(p).get())
 
 // Global definitions occupy index 0 in the definitions list.
@@ -183,6 +189,7 @@ Semer& Semer::PreliminaryAssert()
 	StaticResolve();
 	BindPrototype();
 	DeduceTypes();
+	InternTypes();
 
 	//
 	// Verify tree.
@@ -225,18 +232,38 @@ void Semer::StaticResolve()
 	this->CompletePhase(ConditionTracker::STATIC_RESOLVED);
 }
 
-void Semer::FuncToSymbol(std::function<void(const std::string, const ASTNodeType& node)> insert)
+namespace
 {
-	Compare::Equal<FunctionDecl> eqOp;
-	MatchIf(m_ast.begin(), m_ast.end(), eqOp, [&insert](AST::AST::iterator itr)
+
+// Collect all function definitions which should be exposed as symbol.
+class FunctionSymbolWalker final : public NodeVisitor<FunctionSymbolWalker>
+{
+	using CallbackType = std::function<void(const std::string, const ASTNodeType& node)>;
+
+	CallbackType& m_insert;
+
+public:
+	FunctionSymbolWalker(CallbackType& insert)
+		: m_insert{ insert }
+	{
+	}
+
+	bool Visit(FunctionDecl *func)
 	{
-		auto func = Util::NodeCast<FunctionDecl>(itr.shared_ptr());
 		if (func->ReturnType()->IsInline() || func->IsPrototypeDefinition()) {
-			return;
+			return true;
 		}
 
-		insert(func->Identifier(), func);
-	});
+		m_insert(func->Identifier(), func->PolySelf());
+		return true;
+	}
+};
+
+} // namespace
+
+void Semer::FuncToSymbol(std::function<void(const std::string, const ASTNodeType& node)> insert)
+{
+	FunctionSymbolWalker{ insert }.Traverse(&m_ast.Front());
 }
 
 // Extract identifiers from declarations and stash them per scoped block.
@@ -380,13 +407,13 @@ void Semer::DeduceTypes()
 			return;
 		}
 
-		auto parameters = func->ParameterStatement()->Children();
+		const auto& parameters = func->ParameterStatement()->ChildNodes();
 		for (auto it = parameters.begin(); it != parameters.end(); ++it) {
-			if (auto child = it->lock()) {
-				if (eqVaria(PTR_NATIVE(child)) && it != parameters.end() - 1) {
+			if (ASTNode *child = (*it)) {
+				if (eqVaria(*child) && it != parameters.end() - 1) {
 					throw SemanticException{ "no argument expected after '...'", 0, 0 };
 				}
-				paramTypeList.push_back(Util::NodeCast<Returnable>(child)->ReturnType());
+				paramTypeList.push_back(dynamic_cast<Returnable *>(child)->ReturnType());
 			}
 		}
 
@@ -454,11 +481,11 @@ void Semer::DeduceTypes()
 	MatchIf(m_ast.begin(), m_ast.end(), enumOp, [](AST::AST::iterator itr)
 	{
 		auto enumDecl = Util::NodeCast<EnumConstantDecl>(itr.shared_ptr());
-		if (!enumDecl->Children().empty() && !enumDecl->HasReturnType()) {
-			auto decl = enumDecl->Children().front().lock();
+		if (enumDecl->ChildrenCount() > 0 && !enumDecl->HasReturnType()) {
+			ASTNode *decl = enumDecl->ChildNode(0);
 			if (!decl) { return; }
 
-			auto rdecl = Util::NodeCast<Returnable>(decl);
+			auto rdecl = dynamic_cast<Returnable *>(decl);
 			if (!rdecl->HasReturnType()) {
 				throw SemanticException{ "initializer must be integer constant expression", 0, 0 };
 			}
@@ -561,6 +588,97 @@ void Semer::DeduceTypes()
 			}
 		});
 	});
+
+	// Resolve the member field to a position in the record type. The record
+	// value is indexed by field at runtime, the field name is no longer used.
+	// The record layout is computed once per record type.
+	std::unordered_map<const CryTypedef::AbstractType *, std::shared_ptr<const CryCC::SubValue::Valuedef::TypeLayout>> layoutCache;
+	Compare::Equal<MemberExpr> eqMember;
+	MatchIf(m_ast.begin(), m_ast.end(), eqMember, [&layoutCache](AST::AST::iterator itr)
+	{
+		auto member = Util::NodeCast<MemberExpr>(itr.shared_ptr());
+		if (member->IsResolved()) { return; }
+
+		const auto recordRef = member->RecordRef();
+		if (!recordRef->IsResolved() || !recordRef->HasReturnType()) {
+			throw SemanticException{ "member reference base type is not a structure or union", 0, 0 };
+		}
+
+		// The record can be named by one or more typedefs.
+		auto baseType = recordRef->ReturnType().BaseType();
+		while (baseType && baseType->TypeId() == CryTypedef::TypeVariation::TYPEDEF) {
+			baseType = std::static_pointer_cast<CryTypedef::TypedefType>(baseType)->MarkType();
+		}
+
+		const auto recordType = std::dynamic_pointer_cast<CryTypedef::RecordType>(baseType);
+		if (!recordType) {
+			throw SemanticException{ "member reference base type is not a structure or union", 0, 0 };
+		}
+
+		const auto fields = recordType->Fields();
+		const auto it = std::find_if(fields.cbegin(), fields.cend(), [&member](const auto& field)
+		{
+			return field.Name() == member->FieldName();
+		});
+		if (it == fields.cend()) {
+			boost::format semfmt{ "no member named '%1%' in '%2%'" };
+			semfmt % member->FieldName() % recordType->Name();
+			throw SemanticException{ semfmt.str().c_str(), 0, 0 };
+		}
+
+		const size_t index = static_cast<size_t>(std::distance(fields.cbegin(), it));
+		auto layoutIt = layoutCache.find(recordType.get());
+		if (layoutIt == layoutCache.end()) {
+			layoutIt = layoutCache.emplace(recordType.get(), CryCC::SubValue::Valuedef::TypeLayout::Make(recordType)).first;
+		}
+
+		// Records which cannot be laid out in a flat buffer have no field offset.
+		if (layoutIt->second) {
+			member->Resolve(index, layoutIt->second->FieldOffset(index));
+		}
+		else {
+			member->Resolve(index);
+		}
+
+		if (!member->HasReturnType()) {
+			member->SetReturnType(CryTypedef::TypeFacade{ it->Type() });
+		}
+	});
+}
+
+// Replace all types in the tree by the canonical type from the interner bound
+// to this thread. The types are final once deduced, from here on structurally
+// equal types share a single instance and compare by pointer. Without a bound
+// interner the types are left as is.
+void Semer::InternTypes()
+{
+	auto *internerPtr = CryCC::SubValue::Typedef::TypeInterner::Current();
+	if (!internerPtr) { return; }
+
+	auto& interner = (*internerPtr);
+
+	Compare::Derived<Returnable> drvRet;
+	MatchIf(m_ast.begin(), m_ast.end(), drvRet, [&interner](AST::AST::iterator itr)
+	{
+		auto retType = Util::NodeCast<Returnable>(itr.shared_ptr());
+		if (retType->HasReturnType()) {
+			retType->UpdateReturnType() = interner.Intern(retType->ReturnType());
+		}
+	});
+
+	Compare::Equal<FunctionDecl> eqOp;
+	MatchIf(m_ast.begin(), m_ast.end(), eqOp, [&interner](AST::AST::iterator itr)
+	{
+		auto func = Util::NodeCast<FunctionDecl>(itr.shared_ptr());
+		if (!func->HasSignature()) { return; }
+
+		std::vector<CryCC::SubValue::Typedef::TypeFacade> signature;
+		signature.reserve(func->Signature().size());
+		for (const auto& type : func->Signature()) {
+			signature.push_back(interner.Intern(type));
+		}
+		func->SetSignature(std::move(signature));
+	});
 }
 
 // Check if all datatypes are convertible and inject type conversions in the tree
@@ -595,7 +713,7 @@ void Semer::CheckDataType()
 	MatchIf(m_ast.begin(), m_ast.end(), eqCallOp, [](AST::AST::iterator itr)
 	{
 		auto call = Util::NodeCast<CallExpr>(itr.shared_ptr());
-		auto func = std::dynamic_pointer_cast<FunctionDecl>(call->FuncDeclRef()->Reference());
+		auto func = Util::NodeCast<FunctionDecl>(call->FuncDeclRef()->Reference());
 		assert(call->FuncDeclRef()->IsResolved());
 
 		// Early exit.
@@ -603,9 +721,9 @@ void Semer::CheckDataType()
 			return;
 		}
 
-		auto arguments = call->HasArguments()
-			? call->ArgumentStatement()->Children()
-			: std::vector<std::weak_ptr<ASTNode>>{};
+		const size_t argumentCount = call->HasArguments()
+			? call->ArgumentStatement()->ChildrenCount()
+			: 0;
 
 		// Make an exception for variadic argument.
 		bool canHaveTooMany = true;
@@ -614,10 +732,10 @@ void Semer::CheckDataType()
 		}
 
 		// If argument size is off, throw exception.
-		if (func->Signature().size() > arguments.size()) {
+		if (func->Signature().size() > argumentCount) {
 			throw SemanticException{ "too few arguments to function call, expected at least 0, have 0", 0, 0 };
 		}
-		else if (func->Signature().size() < arguments.size() && canHaveTooMany) {
+		else if (func->Signature().size() < argumentCount && canHaveTooMany) {
 			throw SemanticException{ "too many arguments to function call, expected 0, have 0", 0, 0 };
 		}
 	});
@@ -645,9 +763,9 @@ void Semer::CheckDataType()
 	{
 		auto decl = Util::NodeCast<VarDecl>(itr.shared_ptr());
 
-		for (const auto& wInitializer : decl->Children()) {
-			if (auto initializer = wInitializer.lock()) {
-				IsConversionRequired(decl, initializer);
+		for (ASTNode *initializer : decl->ChildNodes()) {
+			if (initializer) {
+				IsConversionRequired(decl, initializer->PolySelf());
 			}
 		}
 	});
@@ -665,14 +783,12 @@ void Semer::CheckDataType()
 
 		auto opr = Util::NodeCast<BinaryOperator>(itr.shared_ptr());
 
-		auto intializerLHS = opr->Children().front().lock();
-		if (intializerLHS) {
-			IsConversionRequired<OperatorLHS>(opr, intializerLHS);
+		if (ASTNode *intializerLHS = opr->ChildNodes().front()) {
+			IsConversionRequired<OperatorLHS>(opr, intializerLHS->PolySelf());
 		}
 
-		auto intializerRHS = opr->Children().back().lock();
-		if (intializerRHS) {
-			IsConversionRequired<OperatorRHS>(opr, intializerRHS);
+		if (ASTNode *intializerRHS = opr->ChildNodes().back()) {
+			IsConversionRequired<OperatorRHS>(opr, intializerRHS->PolySelf());
 		}
 	});
 
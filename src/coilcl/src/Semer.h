@@ -93,6 +93,7 @@ private:
 	void ResolveIdentifier();
 	void BindPrototype();
 	void DeduceTypes();
+	void InternTypes();
 	void CheckDataType();
 	void IllFormedConstruction();
 	void FuncToSymbol(std::function<void(const std::string, const CryCC::AST::ASTNodeType& node)>);
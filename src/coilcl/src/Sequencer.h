@@ -17,6 +17,10 @@
 // Framework includes.
 #include <Cry/Except.h>
 
+// Language includes.
+#include <vector>
+#include <functional>
+
 //TODO:
 // - Split into separate units.
 
@@ -49,6 +53,14 @@ struct Interface
 
 class CASM : public Interface
 {
+	using IOCallback = std::function<void(uint8_t *data, size_t sz)>;
+	using BufferCallback = std::function<void(std::vector<uint8_t>&&)>;
+
+	// Input/Output stream callbacks.
+	IOCallback m_outputCallback;
+	IOCallback m_inputCallback;
+	BufferCallback m_bufferCallback;
+
 public:
 	class ResultSection : public AbstractResultSection<result_section_tag::CASM>
 	{
@@ -62,19 +74,42 @@ public:
 	};
 
 public:
-	virtual void Execute(CryCC::AST::AST)
+	CASM(IOCallback outputCallback, IOCallback inputCallback)
+		: m_outputCallback{ outputCallback }
+		, m_inputCallback{ inputCallback }
+	{
+	}
+
+	// Initialize with a buffer callback. The module is handed to the
+	// buffer callback at once, instead of being copied into the output callback.
+	CASM(IOCallback outputCallback, IOCallback inputCallback, BufferCallback bufferCallback)
+		: m_outputCallback{ outputCallback }
+		, m_inputCallback{ inputCallback }
+		, m_bufferCallback{ bufferCallback }
+	{
+	}
+
+	// Implement interface.
+	virtual void Execute(CryCC::AST::AST tree)
 	{
-		throw Cry::Except::NotImplementedException{ "CASM::Execute" };
+		LowerAST(tree);
 	}
+
+	// Lower the tree into a bytecode module and write the module to the
+	// output stream. Nothing is written if the tree contains constructs
+	// the bytecode cannot express, the tree walker then runs the program.
+	void LowerAST(CryCC::AST::AST);
 };
 
 class AIIPX : public Interface
 {
 	using IOCallback = std::function<void(uint8_t *data, size_t sz)>;
+	using BufferCallback = std::function<void(std::vector<uint8_t>&&)>;
 
 	// Input/Output stream callbacks.
 	IOCallback m_outputCallback;
 	IOCallback m_inputCallback;
+	BufferCallback m_bufferCallback;
 
 public:
 	class ResultSection : public AbstractResultSection<result_section_tag::AIIPX>
@@ -88,6 +123,24 @@ public:
 		inline value_type& Data() noexcept { return m_content; }
 	};
 
+public:
+	// Top level declaration in the stream index.
+	struct IndexEntry
+	{
+		int nodeId;
+		size_t offset;
+	};
+
+private:
+	// Declaration index of the last unpacked stream.
+	std::vector<IndexEntry> m_declarationIndex;
+	// Keep function bodies in the stream until first use.
+	bool m_lazyLoading{ false };
+	// Number of threads to pack and unpack the tree.
+	size_t m_workerCount{ 0 };
+	// Stream format version to write.
+	int m_streamVersion{ 0 };
+
 public:
 	AIIPX(IOCallback outputCallback, IOCallback inputCallback)
 		: m_outputCallback{ outputCallback }
@@ -95,6 +148,15 @@ public:
 	{
 	}
 
+	// Initialize with a buffer callback. The packed output is handed to the
+	// buffer callback at once, instead of being copied into the output callback.
+	AIIPX(IOCallback outputCallback, IOCallback inputCallback, BufferCallback bufferCallback)
+		: m_outputCallback{ outputCallback }
+		, m_inputCallback{ inputCallback }
+		, m_bufferCallback{ bufferCallback }
+	{
+	}
+
 	// Implement interface.
 	virtual void Execute(CryCC::AST::AST tree)
 	{
@@ -103,8 +165,28 @@ public:
 
 	// Convert tree into output stream.
 	void PackAST(CryCC::AST::AST);
-	// Convert input stream into tree.
-	void UnpackAST(CryCC::AST::AST&);
+	// Convert input stream into tree. The node identifiers are restored
+	// from the stream and taken from the identifier allocator. Corrupt or
+	// unsupported streams throw an invalid stream exception.
+	void UnpackAST(CryCC::AST::AST&, CryCC::AST::UniqueIdAllocator&);
+
+	// In lazy mode the function bodies of a version 2 stream are retained
+	// as raw sections, and are only unpacked when the body is requested.
+	inline void SetLazyLoading(bool lazy) noexcept { m_lazyLoading = lazy; }
+	inline bool IsLazyLoading() const noexcept { return m_lazyLoading; }
+
+	// Set the number of threads used to pack and unpack top level declarations.
+	// Zero selects the hardware concurrency for large trees, one disables threading.
+	inline void SetWorkerCount(size_t count) noexcept { m_workerCount = count; }
+
+	// Set the stream format version to write, zero selects the current
+	// version. Older versions can be read by older releases. Version 1 streams
+	// have no declaration index, no sections and no resolved members.
+	inline void SetStreamVersion(int version) noexcept { m_streamVersion = version; }
+
+	// Stream offsets of the top level declarations, by node id. The index
+	// is only available after a version 2 stream was unpacked.
+	inline const std::vector<IndexEntry>& DeclarationIndex() const noexcept { return m_declarationIndex; }
 };
 
 } // namespace Sequencer
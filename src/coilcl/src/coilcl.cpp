@@ -65,6 +65,7 @@ class Compiler final
 	std::function<std::shared_ptr<metainfo_t>()> metaHandler;
 	std::function<void(const std::string&, bool)> errorHandler;
 	void *backreferencePointer{ nullptr };
+	bool emitBytecode{ false };
 
 	template<typename StructAccessor>
 	class StageOptions final
@@ -161,6 +162,13 @@ public:
 		return (*this);
 	}
 
+	// Lower the program into bytecode next to the program tree.
+	Compiler& SetBytecodeEmission(bool emit)
+	{
+		emitBytecode = emit;
+		return (*this);
+	}
+
 	std::shared_ptr<Compiler> Object()
 	{
 		return shared_from_this();
@@ -186,6 +194,12 @@ public:
 		// Clear all warnings for this session.
 		g_warningQueue.Clear();
 
+		// All nodes created in this session take their identifier from the program.
+		AST::UniqueIdAllocator::Scope idScope{ program->IdAllocator() };
+
+		// All types in this session are interned in the program type table.
+		CryCC::SubValue::Typedef::TypeInterner::Scope typeScope{ program->Interner() };
+
 		try {
 			// Create a condition tracker on the program condition to record the 
 			// different program phases. The compiler stages move the tracker into
@@ -258,21 +272,33 @@ public:
 			auto memoryStream = Emit::Stream::MakeStream<Emit::Stream::MemoryBlock>(aiipxResult.Data());
 			AIIPXModule.AddStream(memoryStream);
 
+			// The bytecode sequencer lowers the program into a register machine
+			// format. If the program cannot be lowered the section is left empty.
+			Emit::Module<Emit::Sequencer::CASM> CASMModule;
+			if (compiler->emitBytecode) {
+				Program::ResultInterface& casmResult = program->ResultSectionSlot<Emit::Sequencer::CASM::ResultSection, Emit::Sequencer::CASM::ResultSection::slot_tag>();
+				auto casmStream = Emit::Stream::MakeStream<Emit::Stream::MemoryBlock>(casmResult.Data());
+				CASMModule.AddStream(casmStream);
+			}
+
 			// Run the emitting sequence.
-			Emit::Emitter{ profile, std::move(program->Ast()), tracker }
-				.MoveStage()
-				.AddModule(AIIPXModule)
-				.Process();
+			Emit::Emitter emitter{ profile, std::move(program->Ast()), tracker };
+			emitter.MoveStage().AddModule(AIIPXModule);
+			if (compiler->emitBytecode) {
+				emitter.AddModule(CASMModule);
+			}
+			emitter.Process();
 
 #ifdef CRY_DEBUG_TESTING
 			AST::AST tree;
+			ProgramPtr recoveredProgram = std::make_unique<Program>();
 			auto treeBlock = memoryStream->DeepCopy();
 			Emit::Sequencer::AIIPX{
 				[](uint8_t *data, size_t sz) { CRY_UNUSED(data); CRY_UNUSED(sz); },
 				[&treeBlock](uint8_t *data, size_t sz) { treeBlock->Read(data, sz); }
-			}.UnpackAST(tree);
+			}.UnpackAST(tree, recoveredProgram->IdAllocator());
 
-			ProgramPtr recoveredProgram = std::make_unique<Program>(CAPTURE(tree));
+			Program::Bind(recoveredProgram, std::move(tree));
 			recoveredProgram->AstPassthrough()->Print<CoilCl::AST::ASTNode::Traverse::STAGE_FIRST>();
 #endif
 
@@ -364,7 +390,7 @@ COILCLAPI void Compile(compiler_info_t *cl_info) NOTHROW
 	}).SetErrorHandler([&cl_info](const std::string& message, bool isFatal)
 	{
 		cl_info->error_handler(cl_info->user_data, message.c_str(), isFatal);
-	}).Object();
+	}).SetBytecodeEmission(cl_info->code_opt.emit_bytecode).Object();
 
 	// Store pointer to original object.
 	coilcl->CaptureBackRefPtr(cl_info);
@@ -387,6 +413,11 @@ COILCLAPI void Compile(compiler_info_t *cl_info) NOTHROW
 	if (program->HasSymbols()) {
 		program->StaticSymbolTable().Print();
 	}
+	{
+		const auto& interner = program->Interner();
+		EventLog::Log(EventLevel::Level::Hint, "Program: " + std::to_string(interner.Size()) + " unique types, "
+			+ std::to_string(interner.HitCount()) + " shared, " + std::to_string(interner.BytesSaved()) + " bytes saved");
+	}
 #endif // CRY_DEBUG_TRACE
 
 	// Pass program to frontend.
@@ -442,6 +473,69 @@ COILCLAPI void GetResultSection(result_t *result_inquery) NOTHROW
 	}
 }
 
+// [ API ENTRY ]
+// Restore a program from a resultset section.
+COILCLAPI void LoadResultSection(result_t *result_inquery) NOTHROW
+{
+	using namespace CryCC::Program;
+	using namespace CryCC::AST;
+
+	assert(result_inquery);
+
+	CHECK_API_VERSION(result_inquery, COILCLAPIVER);
+
+	assert(!result_inquery->program.program_ptr);
+
+	//FUTURE: Restore from bytecode sections.
+	if (result_inquery->tag != result_section_tag::AIIPX) {
+		return;
+	}
+
+	try
+	{
+		const datachunk_t& content = result_inquery->content;
+		size_t offset = 0;
+
+		// Data beyond the section reads as zero, which marks the end of the stream.
+		CoilCl::Emit::Sequencer::AIIPX sequencer{ nullptr, [&content, &offset](uint8_t *data, size_t sz)
+		{
+			const size_t avail = std::min<size_t>(sz, content.size - offset);
+			CRY_MEMCPY(data, sz, content.ptr + offset, avail);
+			std::fill_n(data + avail, sz - avail, 0);
+			offset += avail;
+		} };
+		sequencer.SetLazyLoading(true);
+
+		CoilCl::Compiler::ProgramPtr program = std::make_unique<Program>();
+		AST tree;
+		sequencer.UnpackAST(tree, program->IdAllocator());
+		if (!(*tree)) { return; }
+		Program::Bind(program, std::move(tree));
+
+		// Function definitions are top level declarations. The symbols were
+		// checked when the program was compiled.
+		for (ASTNode *node : program->AstPassthrough()->ChildNodes()) {
+			if (!node || node->Label() != NodeID::FUNCTION_DECL_ID) { continue; }
+
+			auto func = static_cast<FunctionDecl *>(node);
+			if (func->ReturnType()->IsInline() || func->IsPrototypeDefinition()) { continue; }
+
+			program->SymbolTable() << SymbolMap::symbol_type{ func->Identifier(), node->PolySelf() };
+		}
+
+		ConditionTracker::Tracker{ program->Condition() }.Jump(ConditionTracker::ASSERTION_PASSED);
+		program->Lock();
+
+		InterOpHelper::AssimilateProgram(&result_inquery->program, std::move(program));
+	}
+	catch (const ASTFactory::InvalidStreamException&)
+	{
+	}
+	catch (const std::exception&)
+	{
+	}
+}
+
 // [ API ENTRY ]
 // Get library information.
 COILCLAPI void GetLibraryInfo(library_info_t *info) NOTHROW
@@ -0,0 +1,298 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include "../src/Sequencer.h"
+
+#include <Cry/Cry.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+
+//
+// Key         : AIIPX
+// Test        : AIIPX sequencer unit test
+// Type        : unit
+// Description : Pack and unpack program trees in every supported stream
+//               version. Streams written by older releases must remain
+//               readable.
+//
+
+using namespace CryCC::AST;
+
+namespace
+{
+
+// Source with a member expression, the resolved member fields are only
+// part of the newer stream versions.
+const std::string recordSource = ""
+	"struct point {\n"
+	"	int x;\n"
+	"	int y;\n"
+	"};\n"
+	"int sum(int a, int b) {\n"
+	"	return a + b;\n"
+	"}\n"
+	"int main() {\n"
+	"	struct point p;\n"
+	"	p.x = 3;\n"
+	"	p.y = 4;\n"
+	"	return sum(p.x, p.y);\n"
+	"}\n";
+
+class Compilation
+{
+	std::string m_source;
+	std::string m_error;
+	std::unique_ptr<CryCC::Program::Program> m_program;
+	bool m_done{ false };
+
+	// Read the source in one go.
+	static datachunk_t *GetSource(void *user_data)
+	{
+		Compilation *compilation = static_cast<Compilation *>(user_data);
+		if (compilation->m_done) {
+			return nullptr;
+		}
+
+		datachunk_t *buffer = (datachunk_t*)malloc(sizeof(datachunk_t));
+		buffer->size = static_cast<unsigned int>(compilation->m_source.size());
+		buffer->ptr = compilation->m_source.data();
+		buffer->unmanaged_res = 0;
+		compilation->m_done = true;
+		return buffer;
+	}
+
+	static int Load(void *user_data, const char *source)
+	{
+		CRY_UNUSED(user_data);
+		CRY_UNUSED(source);
+		return 0;
+	}
+
+	static metainfo_t *SourceInfo(void *user_data)
+	{
+		CRY_UNUSED(user_data);
+		metainfo_t *meta_info = (metainfo_t*)malloc(sizeof(metainfo_t));
+
+		std::string meta = "test";
+		CRY_MEMZERO(meta_info->name, sizeof(meta_info->name));
+		std::copy(meta.begin(), meta.end(), meta_info->name);
+		meta_info->size = static_cast<unsigned int>(meta.size());
+		return meta_info;
+	}
+
+	// The compiler cannot be unwound from the handler, the error is kept instead.
+	static void ErrorHandler(void *user_data, const char *message, int fatal)
+	{
+		CRY_UNUSED(fatal);
+		static_cast<Compilation *>(user_data)->m_error = message;
+	}
+
+public:
+	explicit Compilation(const std::string& source)
+		: m_source{ source }
+	{
+		compiler_info_t info;
+		info.api_ref = COILCLAPIVER;
+		info.code_opt = {};
+		info.code_opt.standard = cil_standard::cil;
+		info.code_opt.optimization = optimization::NONE;
+		info.streamReaderVPtr = &Compilation::GetSource;
+		info.loadStreamRequestVPtr = &Compilation::Load;
+		info.streamMetaVPtr = &Compilation::SourceInfo;
+		info.error_handler = &Compilation::ErrorHandler;
+		info.program.program_ptr = nullptr;
+		info.user_data = this;
+		::Compile(&info);
+		m_program.reset(static_cast<CryCC::Program::Program *>(info.program.program_ptr));
+
+		BOOST_REQUIRE_MESSAGE(m_error.empty(), m_error);
+		BOOST_REQUIRE(m_program);
+	}
+
+	// Stream emitted by the compiler.
+	std::vector<uint8_t> Stream()
+	{
+		result_t result;
+		result.api_ref = COILCLAPIVER;
+		result.tag = result_section_tag::AIIPX;
+		result.program.program_ptr = m_program.get();
+		::GetResultSection(&result);
+
+		const uint8_t *data = reinterpret_cast<const uint8_t *>(result.content.ptr);
+		return { data, data + result.content.size };
+	}
+};
+
+// Read from the stream, data beyond the end of the stream reads as zero.
+std::function<void(uint8_t *, size_t)> StreamReader(const std::vector<uint8_t>& stream)
+{
+	return [&stream, offset = size_t{ 0 }](uint8_t *data, size_t sz) mutable
+	{
+		const size_t avail = std::min(sz, stream.size() - offset);
+		std::copy_n(stream.data() + offset, avail, data);
+		std::fill_n(data + avail, sz - avail, 0);
+		offset += avail;
+	};
+}
+
+AST Unpack(const std::vector<uint8_t>& stream, size_t workers = 0)
+{
+	AST tree;
+	UniqueIdAllocator allocator;
+	CoilCl::Emit::Sequencer::AIIPX sequencer{ nullptr, StreamReader(stream) };
+	sequencer.SetWorkerCount(workers);
+	sequencer.UnpackAST(tree, allocator);
+	return tree;
+}
+
+std::vector<uint8_t> Pack(AST tree, int version = 0, size_t workers = 0)
+{
+	std::vector<uint8_t> stream;
+	CoilCl::Emit::Sequencer::AIIPX sequencer{ [&stream](uint8_t *data, size_t sz) { stream.insert(stream.end(), data, data + sz); }, nullptr };
+	sequencer.SetStreamVersion(version);
+	sequencer.SetWorkerCount(workers);
+	sequencer.PackAST(tree);
+	return stream;
+}
+
+void CollectMembers(ASTNode *node, std::vector<MemberExpr *>& members)
+{
+	if (node->Label() == NodeID::MEMBER_EXPR_ID) {
+		members.push_back(static_cast<MemberExpr *>(node));
+	}
+	for (ASTNode *child : node->ChildNodes()) {
+		if (child) {
+			CollectMembers(child, members);
+		}
+	}
+}
+
+std::vector<MemberExpr *> Members(AST& tree)
+{
+	std::vector<MemberExpr *> members;
+	CollectMembers((*tree), members);
+	return members;
+}
+
+// Stream version byte following the marker, version 1 streams have none.
+constexpr size_t versionOffset = 4;
+constexpr uint8_t versionFlag = 0x80;
+
+} // namespace
+
+BOOST_AUTO_TEST_SUITE(Sequencer)
+
+BOOST_AUTO_TEST_CASE(AIIPXRoundTrip)
+{
+	Compilation compilation{ recordSource };
+	const auto stream = compilation.Stream();
+	BOOST_REQUIRE_GT(stream.size(), versionOffset);
+	BOOST_REQUIRE_EQUAL(versionFlag | 3, stream[versionOffset]);
+
+	AST tree = Unpack(stream);
+	BOOST_REQUIRE((*tree));
+
+	const auto members = Members(tree);
+	BOOST_REQUIRE_EQUAL(4U, members.size());
+	for (MemberExpr *member : members) {
+		BOOST_REQUIRE(member->IsResolved());
+	}
+
+	const auto repacked = Pack(tree);
+	BOOST_REQUIRE(stream == repacked);
+}
+
+BOOST_AUTO_TEST_CASE(AIIPXVersion2)
+{
+	Compilation compilation{ recordSource };
+	AST tree = Unpack(compilation.Stream());
+
+	const auto stream = Pack(tree, 2);
+	BOOST_REQUIRE_EQUAL(versionFlag | 2, stream[versionOffset]);
+
+	AST restored = Unpack(stream);
+	const auto members = Members(restored);
+	BOOST_REQUIRE_EQUAL(4U, members.size());
+	BOOST_REQUIRE(members.front()->IsResolved());
+	BOOST_REQUIRE_EQUAL(members.front()->FieldIndex(), Members(tree).front()->FieldIndex());
+
+	BOOST_REQUIRE(Pack(restored, 2) == stream);
+}
+
+BOOST_AUTO_TEST_CASE(AIIPXVersion1)
+{
+	Compilation compilation{ recordSource };
+	AST tree = Unpack(compilation.Stream());
+
+	// Version 1 streams have no version byte, nor resolved member fields.
+	const auto stream = Pack(tree, 1);
+	BOOST_REQUIRE_EQUAL(0, stream[versionOffset] & versionFlag);
+
+	AST restored = Unpack(stream);
+	BOOST_REQUIRE((*restored));
+
+	const auto members = Members(restored);
+	BOOST_REQUIRE_EQUAL(4U, members.size());
+	for (MemberExpr *member : members) {
+		BOOST_REQUIRE(!member->IsResolved());
+	}
+	BOOST_REQUIRE_EQUAL("x", members.front()->FieldName());
+
+	BOOST_REQUIRE(Pack(restored, 1) == stream);
+}
+
+// Chunks packed and unpacked on several threads give the same stream and
+// the same tree as a single thread.
+BOOST_AUTO_TEST_CASE(AIIPXWorkers)
+{
+	std::string source = recordSource;
+	for (int i = 0; i < 16; ++i) {
+		source += ""
+			"int func" + std::to_string(i) + "(int n) {\n"
+			"	struct point p;\n"
+			"	p.x = n;\n"
+			"	return p.x * " + std::to_string(i) + ";\n"
+			"}\n";
+	}
+
+	Compilation compilation{ source };
+	const auto stream = compilation.Stream();
+
+	AST single = Unpack(stream, 1);
+	AST parallel = Unpack(stream, 4);
+	BOOST_REQUIRE_EQUAL(single->ChildrenCount(), parallel->ChildrenCount());
+
+	const auto members = Members(single);
+	const auto parallelMembers = Members(parallel);
+	BOOST_REQUIRE_EQUAL(members.size(), parallelMembers.size());
+	for (size_t i = 0; i < members.size(); ++i) {
+		BOOST_REQUIRE_EQUAL(members[i]->Id(), parallelMembers[i]->Id());
+		BOOST_REQUIRE_EQUAL(members[i]->FieldIndex(), parallelMembers[i]->FieldIndex());
+	}
+
+	const auto singleStream = Pack(single, 0, 1);
+	BOOST_REQUIRE(singleStream == stream);
+	BOOST_REQUIRE(Pack(parallel, 0, 4) == singleStream);
+	BOOST_REQUIRE(Pack(single, 0, 4) == singleStream);
+}
+
+BOOST_AUTO_TEST_CASE(AIIPXUnsupportedVersion)
+{
+	Compilation compilation{ recordSource };
+	AST tree = Unpack(compilation.Stream());
+
+	BOOST_REQUIRE_THROW(Pack(tree, 4), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
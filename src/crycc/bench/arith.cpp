@@ -0,0 +1,79 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+#include <CryCC/SubValue.h>
+
+#include <Cry/Benchmark.h>
+
+//
+// Key         : Arith
+// Description : Measure the cost of a single arithmetic operation on
+//               builtin values, both on the value category directly
+//               and through the value interface.
+//
+
+using namespace CryCC::SubValue::Valuedef;
+
+CRY_BENCHMARK(BuiltinAddIntInt)
+{
+	BuiltinValue lhs{ 1 };
+	const BuiltinValue rhs{ 3 };
+	for (size_t i = 0; i < iterations; ++i) {
+		lhs = lhs + rhs;
+	}
+	Cry::Benchmark::DoNotOptimize(lhs);
+}
+
+CRY_BENCHMARK(BuiltinAddDoubleDouble)
+{
+	BuiltinValue lhs{ 1.0 };
+	const BuiltinValue rhs{ 0.5 };
+	for (size_t i = 0; i < iterations; ++i) {
+		lhs = lhs + rhs;
+	}
+	Cry::Benchmark::DoNotOptimize(lhs);
+}
+
+CRY_BENCHMARK(BuiltinMulLongChar)
+{
+	BuiltinValue lhs{ 1L };
+	const BuiltinValue rhs{ static_cast<char>(1) };
+	for (size_t i = 0; i < iterations; ++i) {
+		lhs = lhs * rhs;
+	}
+	Cry::Benchmark::DoNotOptimize(lhs);
+}
+
+CRY_BENCHMARK(BuiltinAddFloatInt)
+{
+	const BuiltinValue lhs{ 1.0f };
+	const BuiltinValue rhs{ 3 };
+	for (size_t i = 0; i < iterations; ++i) {
+		auto result = lhs + rhs;
+		Cry::Benchmark::DoNotOptimize(result);
+	}
+}
+
+CRY_BENCHMARK(ValueAddIntInt)
+{
+	const auto lhs = Util::MakeInt(1);
+	const auto rhs = Util::MakeInt(3);
+	for (size_t i = 0; i < iterations; ++i) {
+		auto result = lhs + rhs;
+		Cry::Benchmark::DoNotOptimize(result);
+	}
+}
+
+CRY_BENCHMARK(ValueAddDoubleDouble)
+{
+	const auto lhs = Util::MakeDouble(1.0);
+	const auto rhs = Util::MakeDouble(0.5);
+	for (size_t i = 0; i < iterations; ++i) {
+		auto result = lhs + rhs;
+		Cry::Benchmark::DoNotOptimize(result);
+	}
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include <CryCC/SubValue.h>
+
+#include <Cry/Benchmark.h>
+
+//
+// Key         : Array
+// Description : Compare reading and writing a record field through the
+//               element value against the field access in place on an
+//               array of records.
+//
+
+using namespace CryCC::SubValue::Valuedef;
+using namespace CryCC::SubValue::Typedef;
+
+namespace
+{
+
+constexpr size_t elementCount = 64;
+
+// Array of records with a few scalar fields.
+Value MakeRecordArray()
+{
+	auto recordType = std::make_shared<RecordType>("point");
+	recordType->AddField("x", Util::MakeBuiltinType(BuiltinType::Specifier::INT_T));
+	recordType->AddField("y", Util::MakeBuiltinType(BuiltinType::Specifier::INT_T));
+	recordType->AddField("weight", Util::MakeBuiltinType(BuiltinType::Specifier::DOUBLE_T));
+
+	return Value{ Util::MakeArrayType(elementCount, recordType), ArrayValue{} };
+}
+
+} // namespace
+
+CRY_BENCHMARK(ArrayRecordFieldByElement)
+{
+	auto value = MakeRecordArray();
+	auto& array = value.As<ArrayValue>()->NativeValue();
+	for (size_t i = 0; i < iterations; ++i) {
+		for (size_t offset = 0; offset < elementCount; ++offset) {
+			auto element = array.ElementValue(offset);
+			const int x = Util::ValueCastNative<int>(element.Member<RecordValue>(0));
+			element.Member<RecordValue>(1) = Util::MakeInt(x + 1);
+			array.AssignElement(offset, element);
+		}
+	}
+	Cry::Benchmark::DoNotOptimize(array);
+}
+
+CRY_BENCHMARK(ArrayRecordFieldInPlace)
+{
+	auto value = MakeRecordArray();
+	auto& array = value.As<ArrayValue>()->NativeValue();
+	for (size_t i = 0; i < iterations; ++i) {
+		for (size_t offset = 0; offset < elementCount; ++offset) {
+			const int x = Util::ValueCastNative<int>(array.ElementField(offset, 0));
+			array.AssignElementField(offset, 1, Util::MakeInt(x + 1));
+		}
+	}
+	Cry::Benchmark::DoNotOptimize(array);
+}
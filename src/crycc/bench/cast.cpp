@@ -0,0 +1,118 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include <CryCC/AST.h>
+#include <CryCC/SubValue.h>
+
+#include <Cry/Benchmark.h>
+
+#include <vector>
+
+//
+// Key         : Cast
+// Description : Compare the runtime type information casts against
+//               the label and value category identifier casts.
+//
+
+using namespace CryCC::AST;
+
+namespace
+{
+
+// Mixed set of nodes as found in a typical function body.
+std::vector<ASTNodeType> MakeNodeList()
+{
+	std::vector<ASTNodeType> list;
+	for (int i = 0; i < 64; ++i) {
+		list.push_back(Util::MakeASTNode<BreakStmt>());
+		list.push_back(Util::MakeASTNode<CompoundStmt>());
+		list.push_back(Util::MakeASTNode<ReturnStmt>());
+		list.push_back(Util::MakeASTNode<VariadicDecl>());
+	}
+	return list;
+}
+
+} // namespace
+
+CRY_BENCHMARK(NodeDynamicPointerCast)
+{
+	const auto list = MakeNodeList();
+	size_t count = 0;
+	for (size_t i = 0; i < iterations; ++i) {
+		for (const auto& node : list) {
+			count += std::dynamic_pointer_cast<Stmt>(node) != nullptr;
+			count += std::dynamic_pointer_cast<CompoundStmt>(node) != nullptr;
+		}
+	}
+	Cry::Benchmark::DoNotOptimize(count);
+}
+
+CRY_BENCHMARK(NodeDynCast)
+{
+	const auto list = MakeNodeList();
+	size_t count = 0;
+	for (size_t i = 0; i < iterations; ++i) {
+		for (const auto& node : list) {
+			count += Util::DynCast<Stmt>(node) != nullptr;
+			count += Util::DynCast<CompoundStmt>(node) != nullptr;
+		}
+	}
+	Cry::Benchmark::DoNotOptimize(count);
+}
+
+CRY_BENCHMARK(NodeRawDynamicCast)
+{
+	const auto list = MakeNodeList();
+	size_t count = 0;
+	for (size_t i = 0; i < iterations; ++i) {
+		for (const auto& node : list) {
+			count += dynamic_cast<Decl*>(node.get()) != nullptr;
+		}
+	}
+	Cry::Benchmark::DoNotOptimize(count);
+}
+
+CRY_BENCHMARK(NodeRawIsa)
+{
+	const auto list = MakeNodeList();
+	size_t count = 0;
+	for (size_t i = 0; i < iterations; ++i) {
+		for (const auto& node : list) {
+			count += Util::Isa<Decl>(node.get());
+		}
+	}
+	Cry::Benchmark::DoNotOptimize(count);
+}
+
+CRY_BENCHMARK(ValueCategoryAs)
+{
+	using namespace CryCC::SubValue::Valuedef;
+	using namespace CryCC::SubValue::Typedef;
+
+	const auto value = Util::MakeInt(12);
+	size_t count = 0;
+	for (size_t i = 0; i < iterations; ++i) {
+		count += value.As<BuiltinValue>() != nullptr;
+		count += value.As<ArrayValue>() != nullptr;
+	}
+	Cry::Benchmark::DoNotOptimize(count);
+}
+
+CRY_BENCHMARK(ValueCategoryIsa)
+{
+	using namespace CryCC::SubValue::Valuedef;
+	using namespace CryCC::SubValue::Typedef;
+
+	const auto value = Util::MakeInt(12);
+	size_t count = 0;
+	for (size_t i = 0; i < iterations; ++i) {
+		count += Util::Isa<BuiltinValue>(value);
+		count += Util::Isa<ArrayValue>(value);
+	}
+	Cry::Benchmark::DoNotOptimize(count);
+}
@@ -26,7 +26,10 @@
 #include <CryCC/AST/ASTNode.h>
 #include <CryCC/AST/ASTTrait.h>
 #include <CryCC/AST/AST.h>
+#include <CryCC/AST/FlatTree.h>
+#include <CryCC/AST/NodeVisitor.h>
 #include <CryCC/AST/Factory.h>
+#include <CryCC/AST/ASTCast.h>
 #include <CryCC/AST/ASTHelper.h>
 
 #endif // CRYCC_AST_H_
@@ -20,7 +20,8 @@ class ForwardItemTree
 protected:
 	ForwardItemTree() = default;
 
-	static void ForwardInternalTree(ASTNodeType& node);
+	// Next node in depth first order, or nullptr past the last node.
+	static ASTNode *ForwardInternalTree(ASTNode *node);
 };
 
 // The AST class provides a wrapper around the tree and the tree
@@ -44,7 +45,9 @@ public: // Member types
 public:
 	class Iterator : private ForwardItemTree
 	{
-		ASTNodeType cNode;
+		// The iterator holds a reference on the current node, the
+		// node may be replaced in the tree while it is visited.
+		IntrusivePtr<ASTNode> cNode;
 
 	private:
 		using _MyTy = Iterator;
@@ -57,13 +60,13 @@ public:
 		using iterator_category = std::forward_iterator_tag;
 
 		// Constructors
-		Iterator() : cNode{ nullptr } {}
-		Iterator(const ASTNodeType& node) : cNode{ node } {}
+		Iterator() = default;
+		Iterator(const ASTNodeType& node) : cNode{ node.get() } {}
 		Iterator(const Iterator&) = default;
 
 		_MyTy& operator++()
 		{
-			ForwardItemTree::ForwardInternalTree(std::ref(cNode));
+			cNode = ForwardItemTree::ForwardInternalTree(cNode.get());
 			return (*this);
 		}
 
@@ -78,22 +81,25 @@ public:
 		reference operator*() { return *(cNode.get()); }
 		pointer operator->() { return cNode.get(); }
 
-		auto shared_ptr() -> decltype(cNode) const
+		// Shared pointer handle on the current node.
+		ASTNodeType shared_ptr() const
 		{
-			return cNode;
+			return cNode ? cNode->PolySelf() : nullptr;
 		}
 
-		bool operator==(const Iterator &other) const { return cNode == other.cNode; }
-		bool operator!=(const Iterator &other) const { return cNode != other.cNode; }
-		bool operator<(const Iterator& other) const { return cNode < other.cNode; }
-		bool operator>(const Iterator& other) const { return cNode > other.cNode; }
-		bool operator<=(const Iterator& other) const { return cNode <= other.cNode; }
-		bool operator>=(const Iterator& other) const { return cNode >= other.cNode; }
+		bool operator==(const Iterator &other) const { return cNode.get() == other.cNode.get(); }
+		bool operator!=(const Iterator &other) const { return cNode.get() != other.cNode.get(); }
+		bool operator<(const Iterator& other) const { return cNode.get() < other.cNode.get(); }
+		bool operator>(const Iterator& other) const { return cNode.get() > other.cNode.get(); }
+		bool operator<=(const Iterator& other) const { return cNode.get() <= other.cNode.get(); }
+		bool operator>=(const Iterator& other) const { return cNode.get() >= other.cNode.get(); }
 	};
 
 	class ConstIterator : private ForwardItemTree
 	{
-		ASTNodeType cNode;
+		// The iterator holds a reference on the current node, the
+		// node may be replaced in the tree while it is visited.
+		IntrusivePtr<ASTNode> cNode;
 
 	private:
 		using _MyTy = ConstIterator;
@@ -106,13 +112,13 @@ public:
 		using iterator_category = std::forward_iterator_tag;
 
 		// Constructors
-		ConstIterator() : cNode{ nullptr } {}
-		ConstIterator(const ASTNodeType& node) : cNode{ node } {}
+		ConstIterator() = default;
+		ConstIterator(const ASTNodeType& node) : cNode{ node.get() } {}
 		ConstIterator(const ConstIterator&) = default;
 
 		const _MyTy& operator++()
 		{
-			ForwardItemTree::ForwardInternalTree(std::ref(cNode));
+			cNode = ForwardItemTree::ForwardInternalTree(cNode.get());
 			return (*this);
 		}
 
@@ -127,17 +133,18 @@ public:
 		reference operator*() { return *(cNode.get()); }
 		pointer operator->() { return cNode.get(); }
 
-		auto shared_ptr() -> decltype(cNode) const
+		// Shared pointer handle on the current node.
+		ASTNodeType shared_ptr() const
 		{
-			return cNode;
+			return cNode ? cNode->PolySelf() : nullptr;
 		}
 
-		bool operator==(const ConstIterator &other) const { return cNode == other.cNode; }
-		bool operator!=(const ConstIterator &other) const { return cNode != other.cNode; }
-		bool operator<(const ConstIterator& other) const { return cNode < other.cNode; }
-		bool operator>(const ConstIterator& other) const { return cNode > other.cNode; }
-		bool operator<=(const ConstIterator& other) const { return cNode <= other.cNode; }
-		bool operator>=(const ConstIterator& other) const { return cNode >= other.cNode; }
+		bool operator==(const ConstIterator &other) const { return cNode.get() == other.cNode.get(); }
+		bool operator!=(const ConstIterator &other) const { return cNode.get() != other.cNode.get(); }
+		bool operator<(const ConstIterator& other) const { return cNode.get() < other.cNode.get(); }
+		bool operator>(const ConstIterator& other) const { return cNode.get() > other.cNode.get(); }
+		bool operator<=(const ConstIterator& other) const { return cNode.get() <= other.cNode.get(); }
+		bool operator>=(const ConstIterator& other) const { return cNode.get() >= other.cNode.get(); }
 	};
 
 	//FUTURE: BidirectionalIterator
@@ -0,0 +1,125 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+#include <CryCC/AST/ASTNode.h>
+
+#include <memory>
+#include <cassert>
+#include <type_traits>
+
+namespace CryCC
+{
+namespace AST
+{
+
+// Test if the node label belongs to the node type. The default
+// compares the label against the node type identifier, which is
+// correct for all leaf nodes. Node types with derived node types
+// accept the range of identifiers of their derived node types.
+template<typename NodeType>
+struct ClassOf
+{
+	static constexpr bool Test(NodeID id) noexcept { return id == NodeType::nodeId; }
+};
+
+#define CLASSOF_RANGE(n,f,l) \
+	template<> \
+	struct ClassOf<n> \
+	{ \
+		static constexpr bool Test(NodeID id) noexcept { return id >= NodeID::f && id <= NodeID::l; } \
+	}
+
+template<>
+struct ClassOf<ASTNode>
+{
+	static constexpr bool Test(NodeID) noexcept { return true; }
+};
+
+CLASSOF_RANGE(Operator, OPERATOR_ID, COMPOUND_ASSIGN_OPERATOR_ID);
+CLASSOF_RANGE(Literal, LITERAL_ID, FLOAT_LITERAL_ID);
+CLASSOF_RANGE(Decl, DECL_ID, TRANSLATION_UNIT_DECL_ID);
+CLASSOF_RANGE(Expr, EXPR_ID, MEMBER_EXPR_ID);
+CLASSOF_RANGE(ResolveRefExpr, RESOLVE_REF_EXPR_ID, DECL_REF_EXPR_ID);
+CLASSOF_RANGE(CallExpr, CALL_EXPR_ID, BUILTIN_EXPR_ID);
+CLASSOF_RANGE(Stmt, STMT_ID, COMPOUND_STMT_ID);
+
+#undef CLASSOF_RANGE
+
+} // namespace AST
+} // namespace CryCC
+
+namespace Util
+{
+
+using namespace CryCC::AST;
+
+// The node casts rely on the node label instead of runtime type
+// information. The label is a single virtual call, which is far
+// cheaper than a dynamic_cast across the node hierarchy. Interface
+// types such as Returnable have no label and must go via NodeCast.
+
+// Test if the node is of node type or any of its derived node types.
+template<typename NodeType>
+inline bool Isa(const ASTNode& node) noexcept
+{
+	static_assert(std::is_base_of<ASTNode, NodeType>::value, "node type must derive from ASTNode");
+	return ClassOf<NodeType>::Test(node.Label());
+}
+template<typename NodeType>
+inline bool Isa(const ASTNode *node) noexcept
+{
+	assert(node);
+	return Isa<NodeType>(*node);
+}
+template<typename NodeType, typename SourceType>
+inline bool Isa(const std::shared_ptr<SourceType>& node) noexcept
+{
+	return Isa<NodeType>(node.get());
+}
+
+// Cast the node into the node type. The node must be of node type.
+template<typename NodeType>
+inline NodeType *Cast(ASTNode *node) noexcept
+{
+	assert(Isa<NodeType>(node));
+	return static_cast<NodeType *>(node);
+}
+template<typename NodeType>
+inline const NodeType *Cast(const ASTNode *node) noexcept
+{
+	assert(Isa<NodeType>(node));
+	return static_cast<const NodeType *>(node);
+}
+template<typename NodeType, typename SourceType>
+inline std::shared_ptr<NodeType> Cast(const std::shared_ptr<SourceType>& node) noexcept
+{
+	assert(Isa<NodeType>(node));
+	return std::static_pointer_cast<NodeType>(node);
+}
+
+// Cast the node into the node type if the node is of node type,
+// otherwise return a nullptr. A nullptr node is passed through.
+template<typename NodeType>
+inline NodeType *DynCast(ASTNode *node) noexcept
+{
+	return node && Isa<NodeType>(node) ? static_cast<NodeType *>(node) : nullptr;
+}
+template<typename NodeType>
+inline const NodeType *DynCast(const ASTNode *node) noexcept
+{
+	return node && Isa<NodeType>(node) ? static_cast<const NodeType *>(node) : nullptr;
+}
+template<typename NodeType, typename SourceType>
+inline std::shared_ptr<NodeType> DynCast(const std::shared_ptr<SourceType>& node) noexcept
+{
+	return node && Isa<NodeType>(node) ? std::static_pointer_cast<NodeType>(node) : nullptr;
+}
+
+} // namespace Util
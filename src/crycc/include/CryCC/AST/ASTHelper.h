@@ -10,6 +10,7 @@
 
 #include <CryCC/AST/ASTNode.h>
 #include <CryCC/AST/ASTTrait.h>
+#include <CryCC/AST/ASTCast.h>
 
 namespace CryCC
 {
@@ -24,7 +25,12 @@ struct Equal
 {
 	bool operator()(BaseType& item)
 	{
-		return typeid(item) == typeid(NodeType);
+		if constexpr (std::is_base_of<ASTNode, BaseType>::value) {
+			return item.Label() == NodeType::nodeId;
+		}
+		else {
+			return typeid(item) == typeid(NodeType);
+		}
 	}
 };
 
@@ -33,7 +39,12 @@ struct Derived
 {
 	bool operator()(BaseType& item)
 	{
-		return dynamic_cast<NodeType*>(&item) != nullptr;
+		if constexpr (std::is_base_of<ASTNode, BaseType>::value && std::is_base_of<ASTNode, NodeType>::value) {
+			return ClassOf<NodeType>::Test(item.Label());
+		}
+		else {
+			return dynamic_cast<NodeType*>(&item) != nullptr;
+		}
 	}
 };
 
@@ -93,12 +104,10 @@ template<typename NodeType, typename = typename std::enable_if<IsASTNode<NodeTyp
 std::shared_ptr<NodeType> Closest(const std::shared_ptr<ASTNode>& node)
 {
 	Compare::Equal<NodeType> eqOp;
-	if (const ASTNodeType parent = node->Parent().lock()) {
-		if (!eqOp(*parent.get())) {
-			return Closest<NodeType>(parent);
+	for (ASTNode *parent = node->ParentNode(); parent; parent = parent->ParentNode()) {
+		if (eqOp(*parent)) {
+			return Util::NodeCast<NodeType>(parent->PolySelf());
 		}
-
-		return Util::NodeCast<NodeType>(parent);
 	}
 
 	return nullptr;
@@ -117,7 +126,7 @@ using namespace CryCC::AST;
 template<typename NodeType, typename... ArgTypes>
 inline auto MakeASTNode(ArgTypes&&... args)
 {
-	auto ptr = std::make_shared<NodeType>(std::forward<ArgTypes>(args)...);
+	auto ptr = MakeNodeHandle(new NodeType(std::forward<ArgTypes>(args)...));
 	ptr->UpdateDelegate();
 	return ptr;
 }
@@ -168,7 +177,12 @@ template<typename NodeType, typename = typename std::enable_if<std::is_base_of<A
 template<typename CastNode>
 auto NodeCast(const std::shared_ptr<ASTNode>& node)
 {
-	return std::dynamic_pointer_cast<CastNode>(node);
+	if constexpr (std::is_base_of<ASTNode, CastNode>::value) {
+		return DynCast<CastNode>(node);
+	}
+	else {
+		return std::dynamic_pointer_cast<CastNode>(node);
+	}
 }
 template<typename CastNode>
 auto NodeCast(const std::weak_ptr<ASTNode>& node)
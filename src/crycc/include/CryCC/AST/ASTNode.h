@@ -31,6 +31,9 @@
 #include <vector>
 #include <memory>
 #include <sstream>
+#include <functional>
+#include <mutex>
+#include <atomic>
 
 #define PRINT_NODE(n) \
 	virtual const std::string NodeName() const \
@@ -54,7 +57,9 @@
 	m_state.Bump((*this));
 
 #define NODE_ID(i) \
-	static const NodeID nodeId = i;
+public: \
+	static const NodeID nodeId = i; \
+private:
 
 #define LABEL() \
 	virtual NodeID Label() const noexcept override { return nodeId; }
@@ -82,13 +87,45 @@ constexpr std::string RemoveClassFromName(ClassName *_name)
 	return className.substr(pos + 1);
 }
 
+namespace CryCC
+{
+namespace AST
+{
+
+// Shared pointer handle on a node. The node is owned by its intrusive
+// reference count, the handle holds one reference for as long as any
+// copy of the handle is alive.
+template<typename Node>
+std::shared_ptr<Node> MakeNodeHandle(Node *node)
+{
+	node->AddRef();
+	return std::shared_ptr<Node>{ node, &ReleaseIntrusive<Node> };
+}
+
+// Lock on the creation of node handles. The handle is published in the
+// node, concurrent callers must not create a second handle.
+inline std::mutex& NodeHandleLock()
+{
+	static std::mutex lock;
+	return lock;
+}
+
+} // namespace AST
+} // namespace CryCC
+
 template<typename Node, typename BaseNode = CryCC::AST::ASTNode>
 class SelfReference : public std::enable_shared_from_this<Node>
 {
 protected:
+	// Share the existing handle if any, the node can outlive its
+	// handles as long as a parent lists the node.
 	std::shared_ptr<BaseNode> GetSharedSelf()
 	{
-		return this->shared_from_this();
+		std::lock_guard<std::mutex> lock{ CryCC::AST::NodeHandleLock() };
+		if (auto self = this->weak_from_this().lock()) {
+			return self;
+		}
+		return CryCC::AST::MakeNodeHandle(static_cast<Node *>(this));
 	}
 };
 
@@ -113,6 +150,7 @@ class ASTNode
 	, public VisitorInterface
 	, public ModifierInterface
 	, public UserDataAbstract
+	, public IntrusiveRefCount
 	, virtual public Serializable
 {
 	NODE_ID(NodeID::AST_NODE_ID);
@@ -120,6 +158,8 @@ class ASTNode
 public:
 	ASTNode() = default;
 	ASTNode(SourceLocation::value_type, SourceLocation::value_type);
+	ASTNode(const ASTNode&);
+	virtual ~ASTNode();
 
 	// Equality test.
 	bool operator==(const ASTNode&) const noexcept;
@@ -172,30 +212,47 @@ public:
 	// Node relations.
 	//
 
+	// Child node at offset.
+	inline ASTNode *ChildNode(size_t idx) const noexcept { return children[idx]; }
+	// Parent node, or nullptr on the root node.
+	inline ASTNode *ParentNode() const noexcept { return m_parent; }
+	// Child node list. Each slot holds a reference on the node.
+	inline const std::vector<ASTNode *>& ChildNodes() const noexcept { return children; }
+
 	//TODO: friend
 	// Forward the random access operator on the child node list.
 	std::weak_ptr<ASTNode> operator[](int idx)
 	{
-		return children[idx];
+		return At(idx);
 	}
 
 	//TODO: friend
-	// Forward the random access operator on the child node list.
+	// Shared pointer on child node, use ChildNode() where possible.
 	std::weak_ptr<ASTNode> At(int idx)
 	{
-		return children[idx];
+		ASTNode *node = children[idx];
+		if (!node) { return {}; }
+		return node->PolySelf();
 	}
 
 	//TODO: friend
+	// Shared pointer on parent node, use ParentNode() where possible.
 	std::weak_ptr<ASTNode> Parent()
 	{
-		return m_parent;
+		if (!m_parent) { return {}; }
+		return m_parent->PolySelf();
 	}
 
 	//TODO: friend
-	const std::vector<std::weak_ptr<ASTNode>>& Children() const
+	// Shared pointer copy of the child node list, use ChildNodes() where possible.
+	std::vector<std::weak_ptr<ASTNode>> Children() const
 	{
-		return children;
+		std::vector<std::weak_ptr<ASTNode>> list;
+		list.reserve(children.size());
+		for (ASTNode *node : children) {
+			list.emplace_back(node ? node->PolySelf() : nullptr);
+		}
+		return list;
 	}
 
 	virtual NodeID Label() const noexcept { return nodeId; }
@@ -203,9 +260,9 @@ public:
 	//TODO: friend
 	void UpdateDelegate()
 	{
-		for (auto& wPtr : children) {
-			if (auto ptr = wPtr.lock()) {
-				ptr->SetParent(std::move(this->PolySelf()));
+		for (ASTNode *node : children) {
+			if (node) {
+				node->m_parent = this;
 			}
 		}
 	}
@@ -220,27 +277,16 @@ public:
 	virtual void Deserialize(Serializable::VisitorInterface& pack);
 
 protected:
-	virtual void AppendChild(const ASTNodeType& node)
-	{
-		children.push_back(node);
-	}
-
-	virtual void RemoveChild(size_t idx)
-	{
-		assert(idx < children.size());
-		children.erase(children.begin() + idx);
-	}
-
-	void SetParent(const ASTNodeType&& node)
-	{
-		m_parent = node;
-	}
+	// Append node to the child list and link this node as its parent.
+	virtual void AppendChild(const ASTNodeType& node);
+	// Remove node from the child list.
+	virtual void RemoveChild(size_t idx);
 
 protected:
 	SourceLocation m_location;
 	ASTState<ASTNode> m_state;
-	std::vector<std::weak_ptr<ASTNode>> children;
-	std::weak_ptr<ASTNode> m_parent;
+	std::vector<ASTNode *> children;
+	ASTNode *m_parent{ nullptr };
 };
 
 //
@@ -421,7 +467,7 @@ class CompoundAssignOperator
 {
 	NODE_ID(NodeID::COMPOUND_ASSIGN_OPERATOR_ID);
 	ASTNodeType m_body;
-	std::shared_ptr<DeclRefExpr> m_identifier;
+	ASTNodeType m_identifier; // Left hand side, a declaration reference or an array element.
 
 public:
 	enum CompoundAssignOperand
@@ -446,7 +492,10 @@ public:
 		Deserialize(pack);
 	}
 
-	CompoundAssignOperator(CompoundAssignOperand operand, const std::shared_ptr<DeclRefExpr>& node);
+	CompoundAssignOperator(CompoundAssignOperand operand, const ASTNodeType& node);
+
+	auto& Identifier() const noexcept { return m_identifier; }
+	auto& Expression() const noexcept { return m_body; }
 
 	CompoundAssignOperand Operand() const noexcept { return m_operand; };
 
@@ -684,6 +733,7 @@ class VarDecl
 {
 	NODE_ID(NodeID::VAR_DECL_ID);
 	ASTNodeType m_body;
+	int m_storageSlot{ -1 };
 
 public:
 	explicit VarDecl(Serializable::VisitorInterface& pack)
@@ -697,6 +747,13 @@ public:
 	bool HasExpression() const { return m_body != nullptr; }
 	auto& Expression() const { return m_body; }
 
+	// Test if the runtime assigned a storage slot to the variable.
+	inline bool HasStorageSlot() const noexcept { return m_storageSlot >= 0; }
+	// Storage slot in the frame of the declaring scope.
+	inline size_t StorageSlot() const noexcept { return static_cast<size_t>(m_storageSlot); }
+	// Assign the storage slot, the slot is not serialized.
+	inline void SetStorageSlot(size_t slot) noexcept { m_storageSlot = static_cast<int>(slot); }
+
 	void Emplace(size_t idx, const ASTNodeType&& node) override;
 
 	virtual void Serialize(Serializable::VisitorInterface& pack);
@@ -940,6 +997,9 @@ class FunctionDecl
 	std::shared_ptr<CompoundStmt> m_body;
 	std::weak_ptr<FunctionDecl> m_protoRef;
 	std::vector<Typedef::TypeFacade> m_signature;
+	std::function<std::shared_ptr<CompoundStmt>()> m_bodyLoader;
+	std::once_flag m_bodyLoaded;
+	std::atomic<bool> m_isDeferred{ false };
 
 	bool m_isPrototype = true;
 
@@ -957,8 +1017,15 @@ public:
 	FunctionDecl(const std::string& name, std::shared_ptr<CompoundStmt>& node);
 	FunctionDecl(const std::string& name, std::shared_ptr<Typedef::AbstractType> type);
 
+	using CompoundLoader = std::function<std::shared_ptr<CompoundStmt>()>;
+
 	// If function declaration has a body, its not a prototype
 	void SetCompound(const std::shared_ptr<CompoundStmt>& node);
+	// Defer the function body, the loader is invoked by LoadCompound.
+	void SetCompoundLoader(CompoundLoader&& loader);
+	// Load the deferred function body, if any. The loader runs once, and
+	// concurrent callers wait for the body to be attached.
+	const std::shared_ptr<CompoundStmt>& LoadCompound();
 	void SetSignature(std::vector<Typedef::TypeFacade>&& signature);
 	void SetParameterStatement(const std::shared_ptr<ParamStmt>& node);
 
@@ -969,7 +1036,9 @@ public:
 	bool IsPrototypeDefinition() const noexcept { return m_isPrototype; }
 	bool HasPrototypeDefinition() const noexcept { return !m_protoRef.expired(); }
 	auto PrototypeDefinition() const { return m_protoRef.lock(); }
-	auto& FunctionCompound() const { return m_body; }
+	bool HasDeferredCompound() const noexcept { return m_isDeferred.load(std::memory_order_acquire); }
+	// Function body, deferred bodies are empty until loaded.
+	auto& FunctionCompound() const noexcept { return m_body; }
 
 	// Bind function body to prototype definition
 	void BindPrototype(const std::shared_ptr<FunctionDecl>& node);
@@ -1067,6 +1136,8 @@ class DeclRefExpr
 {
 	NODE_ID(NodeID::DECL_REF_EXPR_ID);
 	std::weak_ptr<Decl> m_ref; //TODO: expand to AST::ASTNode
+	int m_bindDepth{ -1 };
+	int m_bindSlot{ -1 };
 
 public:
 	explicit DeclRefExpr(Serializable::VisitorInterface& pack)
@@ -1092,6 +1163,20 @@ public:
 
 	void Resolve(const ASTNodeType& ref);
 
+	// Test if the reference was bound to a storage slot.
+	inline bool IsBound() const noexcept { return m_bindSlot >= 0; }
+	// Number of frames between the reference and the declaring scope.
+	inline size_t BindingDepth() const noexcept { return static_cast<size_t>(m_bindDepth); }
+	// Storage slot in the frame of the declaring scope.
+	inline size_t BindingSlot() const noexcept { return static_cast<size_t>(m_bindSlot); }
+
+	// Bind the reference to a storage slot, the binding is not serialized.
+	inline void Bind(size_t depth, size_t slot) noexcept
+	{
+		m_bindDepth = static_cast<int>(depth);
+		m_bindSlot = static_cast<int>(slot);
+	}
+
 	// If reference resolves there is an return type
 	bool HasReturnType() const override;
 
@@ -1121,6 +1206,8 @@ class CallExpr
 	NODE_ID(NodeID::CALL_EXPR_ID);
 	std::shared_ptr<DeclRefExpr> m_funcRef;
 	std::shared_ptr<ArgumentStmt> m_args;
+	const void *m_callTarget{ nullptr };
+	unsigned int m_callTargetEpoch{ 0 };
 
 public:
 	explicit CallExpr(Serializable::VisitorInterface& pack)
@@ -1150,6 +1237,20 @@ public:
 	bool HasArguments() const noexcept { return m_args != nullptr; }
 	auto& ArgumentStatement() const { return m_args; }
 
+	// Call target cached by the executor, returns nullptr if the cache was
+	// set in another epoch. The cache is not serialized.
+	inline const void *CallTarget(unsigned int epoch) const noexcept
+	{
+		return m_callTargetEpoch == epoch ? m_callTarget : nullptr;
+	}
+
+	// Cache the resolved call target for the epoch.
+	inline void SetCallTarget(const void *target, unsigned int epoch) noexcept
+	{
+		m_callTarget = target;
+		m_callTargetEpoch = epoch;
+	}
+
 	//TODO: friend
 	auto FuncDeclRef() const
 	{
@@ -1262,6 +1363,8 @@ public:
 
 	ImplicitConvertionExpr(ASTNodeType& node, CryCC::SubValue::Conv::Cast::Tag convOp);
 
+	auto& Expression() const { return m_body; }
+
 	virtual void Serialize(Serializable::VisitorInterface& pack);
 	virtual void Deserialize(Serializable::VisitorInterface& pack);
 
@@ -1391,6 +1494,8 @@ class MemberExpr
 	NODE_ID(NodeID::MEMBER_EXPR_ID);
 	std::string m_name;
 	std::shared_ptr<DeclRefExpr> m_record;
+	int m_fieldIndex{ -1 };
+	int m_fieldOffset{ -1 };
 
 public:
 	enum MemberType
@@ -1411,6 +1516,20 @@ public:
 
 	std::shared_ptr<DeclRefExpr> RecordRef();
 
+	// Test if the field was resolved against the record type.
+	inline bool IsResolved() const noexcept { return m_fieldIndex >= 0; }
+	// Field index in the record.
+	inline size_t FieldIndex() const noexcept { return static_cast<size_t>(m_fieldIndex); }
+	// Test if the field has a byte offset, records which cannot be
+	// laid out in a flat buffer have no field offset.
+	inline bool HasFieldOffset() const noexcept { return m_fieldOffset >= 0; }
+	// Field byte offset from the start of the record, only valid if the field has an offset.
+	inline size_t FieldOffset() const noexcept { return static_cast<size_t>(m_fieldOffset); }
+
+	// Bind the field position in the record.
+	void Resolve(size_t index);
+	void Resolve(size_t index, size_t offset);
+
 	virtual void Serialize(Serializable::VisitorInterface& pack);
 	virtual void Deserialize(Serializable::VisitorInterface& pack);
 
@@ -1697,6 +1816,8 @@ public:
 
 	DefaultStmt(const ASTNodeType& body);
 
+	auto& Expression() const { return m_body; }
+
 	virtual void Serialize(Serializable::VisitorInterface& pack);
 	virtual void Deserialize(Serializable::VisitorInterface& pack);
 
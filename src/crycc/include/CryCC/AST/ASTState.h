@@ -69,13 +69,11 @@ public:
 	size_type size() const noexcept { return m_mementoList.size(); }
 	bool empty() const noexcept { return m_mementoList.empty(); }
 
+	// The snapshot is reference counted like any other node.
 	template<typename Type>
 	void Bump(Type objectCpyState)
 	{
-		std::unique_ptr<Type> origPtr{ new Type{ objectCpyState } };
-
-		auto ptrBase = Cry::StaticUniquePointerCast<BaseTy>(std::move(origPtr));
-		m_mementoList.push_back(std::move(ptrBase));
+		m_mementoList.push_back(MakeNodeHandle(new Type{ objectCpyState }));
 	}
 
 private:
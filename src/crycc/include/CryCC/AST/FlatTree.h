@@ -0,0 +1,192 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+#include <CryCC/AST/NodeId.h>
+
+#include <array>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <limits>
+#include <cstdint>
+#include <cassert>
+
+namespace CryCC
+{
+namespace AST
+{
+
+class ASTNode;
+
+// Frozen abstract syntax tree.
+//
+// Once the program is locked the tree will no longer change. The
+// flat tree is a read-only copy of the node relations stored as
+// a structure of arrays. Each node is assigned a dense index in
+// breadth first order so that all children of a node occupy a
+// contiguous range. The node label, parent index, first child
+// and child count are kept in separate arrays. The payload index
+// points into a side table per node kind, which in turn refers back
+// to the original node. Consumers walk the arrays instead of chasing
+// shared and weak pointers across the heap.
+class FlatTree final
+{
+public:
+	using index_type = uint32_t;
+	using size_type = std::size_t;
+
+	// Invalid node index.
+	static constexpr index_type npos = std::numeric_limits<index_type>::max();
+
+	// Lightweight handle on a frozen node. The handle is only valid
+	// for as long as the flat tree is alive.
+	class NodeHandle
+	{
+		const FlatTree *m_tree{ nullptr };
+		index_type m_index{ npos };
+
+	public:
+		NodeHandle() = default;
+		NodeHandle(const FlatTree *tree, index_type index)
+			: m_tree{ tree }
+			, m_index{ index }
+		{
+		}
+
+		// Node index in the flat tree.
+		inline index_type Index() const noexcept { return m_index; }
+		// Node label.
+		inline NodeID Label() const noexcept { return m_tree->m_label[m_index]; }
+		// Number of children.
+		inline size_type ChildrenCount() const noexcept { return m_tree->m_childCount[m_index]; }
+		// Index into the kind specific payload table.
+		inline index_type PayloadIndex() const noexcept { return m_tree->m_payload[m_index]; }
+
+		// Parent node, or an invalid handle on the root.
+		NodeHandle Parent() const noexcept
+		{
+			return NodeHandle{ m_tree, m_tree->m_parent[m_index] };
+		}
+
+		// Child at offset.
+		NodeHandle Child(size_type idx) const noexcept
+		{
+			assert(idx < ChildrenCount());
+			return NodeHandle{ m_tree, m_tree->m_firstChild[m_index] + static_cast<index_type>(idx) };
+		}
+
+		// Next node on the same level with the same parent.
+		NodeHandle NextSibling() const noexcept
+		{
+			const index_type parent = m_tree->m_parent[m_index];
+			if (parent == npos) { return {}; }
+			if (m_index + 1 < m_tree->m_firstChild[parent] + m_tree->m_childCount[parent]) {
+				return NodeHandle{ m_tree, m_index + 1 };
+			}
+			return {};
+		}
+
+		// Original tree node.
+		inline ASTNode *Node() const noexcept { return m_tree->m_kindTable[KindOffset(Label())][PayloadIndex()]; }
+
+		// Cast the original tree node into the node type.
+		template<typename NodeType>
+		inline NodeType *As() const noexcept { return static_cast<NodeType *>(Node()); }
+
+		// Check if handle points to a node.
+		inline operator bool() const noexcept { return m_tree && m_index != npos; }
+
+		bool operator==(const NodeHandle& other) const noexcept { return m_tree == other.m_tree && m_index == other.m_index; }
+		bool operator!=(const NodeHandle& other) const noexcept { return !operator==(other); }
+	};
+
+public:
+	FlatTree() = default;
+	FlatTree(const FlatTree&) = delete;
+	FlatTree(FlatTree&&) = default;
+
+	FlatTree& operator=(const FlatTree&) = delete;
+	FlatTree& operator=(FlatTree&&) = default;
+
+	// Convert the tree into the flat representation. Deferred function
+	// bodies are left out, these are frozen when the body is requested.
+	// The tree must not be altered as long as the flat tree is in use.
+	static FlatTree Freeze(ASTNode *root);
+
+	// Body of the function node, or an invalid handle if the function has no
+	// body. A deferred body is loaded and frozen into a flat tree of its own
+	// on first request.
+	NodeHandle FunctionBody(NodeHandle function) const;
+
+	// Root node handle.
+	inline NodeHandle Root() const noexcept { return Size() ? NodeHandle{ this, 0 } : NodeHandle{}; }
+	// Node handle at index.
+	inline NodeHandle operator[](index_type idx) const noexcept { return NodeHandle{ this, idx }; }
+
+	// Number of nodes in the tree.
+	inline size_type Size() const noexcept { return m_label.size(); }
+	// Test if tree holds any nodes.
+	inline bool Empty() const noexcept { return m_label.empty(); }
+
+	// Number of nodes of a single kind.
+	inline size_type KindCount(NodeID id) const noexcept { return m_kindTable[KindOffset(id)].size(); }
+
+	// Call the callback on every node of kind in tree order.
+	template<typename CallbackType>
+	void ForEach(NodeID id, CallbackType&& callback) const
+	{
+		for (index_type idx : m_kindIndex[KindOffset(id)]) {
+			callback(NodeHandle{ this, idx });
+		}
+	}
+
+	// Call the callback on every node in breadth first order.
+	template<typename CallbackType>
+	void ForEach(CallbackType&& callback) const
+	{
+		for (index_type idx = 0; idx < static_cast<index_type>(Size()); ++idx) {
+			callback(NodeHandle{ this, idx });
+		}
+	}
+
+private:
+	static constexpr size_type kindTableSize = static_cast<size_type>(NodeID::COMPOUND_STMT_ID) + 1;
+
+	static inline size_type KindOffset(NodeID id) noexcept
+	{
+		assert(static_cast<size_type>(id) < kindTableSize);
+		return static_cast<size_type>(id);
+	}
+
+	// Function body which was deferred when the tree was frozen.
+	struct DeferredBody
+	{
+		std::once_flag frozen;
+		std::unique_ptr<FlatTree> tree;
+	};
+
+private:
+	std::vector<NodeID> m_label;
+	std::vector<index_type> m_parent;
+	std::vector<index_type> m_firstChild;
+	std::vector<index_type> m_childCount;
+	std::vector<index_type> m_payload;
+
+	// Typed side tables, one for each node kind.
+	std::array<std::vector<ASTNode *>, kindTableSize> m_kindTable;
+	std::array<std::vector<index_type>, kindTableSize> m_kindIndex;
+
+	// Functions with a deferred body in index order.
+	std::vector<index_type> m_deferredIndex;
+	std::vector<std::unique_ptr<DeferredBody>> m_deferredBody;
+};
+
+} // namespace AST
+} // namespace CryCC
@@ -0,0 +1,203 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+#include <CryCC/AST/ASTNode.h>
+#include <CryCC/AST/FlatTree.h>
+
+#include <array>
+#include <utility>
+#include <cstddef>
+#include <cassert>
+#include <type_traits>
+
+namespace CryCC
+{
+namespace AST
+{
+
+// Map the node identifier onto the node type. Identifiers without
+// a node type resolve to the generic node.
+template<NodeID Id>
+struct NodeTypeOf
+{
+	using type = ASTNode;
+};
+
+#define NODE_TYPE_OF(i,n) \
+	template<> \
+	struct NodeTypeOf<NodeID::i> \
+	{ \
+		using type = n; \
+	}
+
+NODE_TYPE_OF(OPERATOR_ID, Operator);
+NODE_TYPE_OF(BINARY_OPERATOR_ID, BinaryOperator);
+NODE_TYPE_OF(CONDITIONAL_OPERATOR_ID, ConditionalOperator);
+NODE_TYPE_OF(UNARY_OPERATOR_ID, UnaryOperator);
+NODE_TYPE_OF(COMPOUND_ASSIGN_OPERATOR_ID, CompoundAssignOperator);
+NODE_TYPE_OF(LITERAL_ID, Literal);
+NODE_TYPE_OF(CHARACTER_LITERAL_ID, CharacterLiteral);
+NODE_TYPE_OF(STRING_LITERAL_ID, StringLiteral);
+NODE_TYPE_OF(INTEGER_LITERAL_ID, IntegerLiteral);
+NODE_TYPE_OF(FLOAT_LITERAL_ID, FloatingLiteral);
+NODE_TYPE_OF(DECL_ID, Decl);
+NODE_TYPE_OF(VAR_DECL_ID, VarDecl);
+NODE_TYPE_OF(PARAM_DECL_ID, ParamDecl);
+NODE_TYPE_OF(VARIADIC_DECL_ID, VariadicDecl);
+NODE_TYPE_OF(TYPEDEF_DECL_ID, TypedefDecl);
+NODE_TYPE_OF(FIELD_DECL_ID, FieldDecl);
+NODE_TYPE_OF(RECORD_DECL_ID, RecordDecl);
+NODE_TYPE_OF(ENUM_CONSTANT_DECL_ID, EnumConstantDecl);
+NODE_TYPE_OF(ENUM_DECL_ID, EnumDecl);
+NODE_TYPE_OF(FUNCTION_DECL_ID, FunctionDecl);
+NODE_TYPE_OF(TRANSLATION_UNIT_DECL_ID, TranslationUnitDecl);
+NODE_TYPE_OF(EXPR_ID, Expr);
+NODE_TYPE_OF(RESOLVE_REF_EXPR_ID, ResolveRefExpr);
+NODE_TYPE_OF(DECL_REF_EXPR_ID, DeclRefExpr);
+NODE_TYPE_OF(CALL_EXPR_ID, CallExpr);
+NODE_TYPE_OF(BUILTIN_EXPR_ID, BuiltinExpr);
+NODE_TYPE_OF(CAST_EXPR_ID, CastExpr);
+NODE_TYPE_OF(IMPLICIT_CONVERTION_EXPR_ID, ImplicitConvertionExpr);
+NODE_TYPE_OF(PAREN_EXPR_ID, ParenExpr);
+NODE_TYPE_OF(INIT_LIST_EXPR_ID, InitListExpr);
+NODE_TYPE_OF(COMPOUND_LITERAL_EXPR_ID, CompoundLiteralExpr);
+NODE_TYPE_OF(ARRAY_SUBSCRIPT_EXPR_ID, ArraySubscriptExpr);
+NODE_TYPE_OF(MEMBER_EXPR_ID, MemberExpr);
+NODE_TYPE_OF(STMT_ID, Stmt);
+NODE_TYPE_OF(CONTINUE_STMT_ID, ContinueStmt);
+NODE_TYPE_OF(RETURN_STMT_ID, ReturnStmt);
+NODE_TYPE_OF(IF_STMT_ID, IfStmt);
+NODE_TYPE_OF(SWITCH_STMT_ID, SwitchStmt);
+NODE_TYPE_OF(WHILE_STMT_ID, WhileStmt);
+NODE_TYPE_OF(DO_STMT_ID, DoStmt);
+NODE_TYPE_OF(FOR_STMT_ID, ForStmt);
+NODE_TYPE_OF(BREAK_STMT_ID, BreakStmt);
+NODE_TYPE_OF(DEFAULT_STMT_ID, DefaultStmt);
+NODE_TYPE_OF(CASE_STMT_ID, CaseStmt);
+NODE_TYPE_OF(DECL_STMT_ID, DeclStmt);
+NODE_TYPE_OF(ARGUMENT_STMT_ID, ArgumentStmt);
+NODE_TYPE_OF(PARAM_STMT_ID, ParamStmt);
+NODE_TYPE_OF(LABEL_STMT_ID, LabelStmt);
+NODE_TYPE_OF(GOTO_STMT_ID, GotoStmt);
+NODE_TYPE_OF(COMPOUND_STMT_ID, CompoundStmt);
+
+#undef NODE_TYPE_OF
+
+// Generic tree walker.
+//
+// The derived pass implements Visit() for every node type it is
+// interested in. The most specific overload is selected at compile
+// time, so Visit(Decl *) receives every declaration unless a more
+// specific overload is present. Node types without a matching handler
+// are passed to the generic Visit(ASTNode *). Each node is dispatched
+// through a static table of member function pointers indexed by the
+// node label, there are no virtual calls on the pass itself.
+//
+// PreVisit() is called before and PostVisit() after the children of
+// a node are walked. Any handler returning false stops the walk.
+template<typename Derived>
+class NodeVisitor
+{
+	using dispatch_type = bool(NodeVisitor::*)(ASTNode *);
+
+	static constexpr size_t dispatchTableSize = static_cast<size_t>(NodeID::COMPOUND_STMT_ID) + 1;
+
+	template<typename NodeType, typename = void>
+	struct HasVisit : std::false_type {};
+
+	template<typename NodeType>
+	struct HasVisit<NodeType, std::void_t<decltype(std::declval<Derived&>().Visit(std::declval<NodeType *>()))>>
+		: std::true_type
+	{
+	};
+
+	template<size_t Idx>
+	bool DispatchAs(ASTNode *node)
+	{
+		using NodeType = typename NodeTypeOf<static_cast<NodeID>(Idx)>::type;
+		if constexpr (HasVisit<NodeType>::value) {
+			return Self().Visit(static_cast<NodeType *>(node));
+		}
+		else {
+			return NodeVisitor::Visit(node);
+		}
+	}
+
+	template<size_t... Idx>
+	static constexpr std::array<dispatch_type, dispatchTableSize> MakeDispatchTable(std::index_sequence<Idx...>)
+	{
+		return { { &NodeVisitor::DispatchAs<Idx>... } };
+	}
+
+	static constexpr std::array<dispatch_type, dispatchTableSize> s_dispatchTable
+		= MakeDispatchTable(std::make_index_sequence<dispatchTableSize>{});
+
+	inline Derived& Self() noexcept { return static_cast<Derived&>(*this); }
+
+public:
+	//
+	// Default handlers, shadowed by the derived pass.
+	//
+
+	// Called before the node is dispatched.
+	bool PreVisit(ASTNode *) { return true; }
+	// Called on any node without a more specific handler.
+	bool Visit(ASTNode *) { return true; }
+	// Called after all children of the node are walked.
+	bool PostVisit(ASTNode *) { return true; }
+
+	// Dispatch the node to the handler of the node type.
+	bool Dispatch(ASTNode *node, NodeID label)
+	{
+		const size_t offset = static_cast<size_t>(label);
+		assert(offset < dispatchTableSize);
+		return (this->*s_dispatchTable[offset])(node);
+	}
+
+	// Dispatch the node to the handler of the node type.
+	inline bool Dispatch(ASTNode *node) { return Dispatch(node, node->Label()); }
+
+	// Walk the tree in depth first order. Returns false if the walk
+	// was stopped by any of the handlers.
+	bool Traverse(ASTNode *node)
+	{
+		if (!node) { return true; }
+
+		if (!Self().PreVisit(node)) { return false; }
+		if (!Dispatch(node)) { return false; }
+		for (ASTNode *child : node->ChildNodes()) {
+			if (!Traverse(child)) { return false; }
+		}
+
+		return Self().PostVisit(node);
+	}
+
+	// Walk the frozen tree in depth first order. The node label is read
+	// from the flat tree rather than queried from the node.
+	bool Traverse(FlatTree::NodeHandle handle)
+	{
+		if (!handle) { return true; }
+
+		ASTNode *node = handle.Node();
+		if (!Self().PreVisit(node)) { return false; }
+		if (!Dispatch(node, handle.Label())) { return false; }
+		for (size_t i = 0; i < handle.ChildrenCount(); ++i) {
+			if (!Traverse(handle.Child(i))) { return false; }
+		}
+
+		return Self().PostVisit(node);
+	}
+
+	// Walk the frozen tree from the root.
+	inline bool Traverse(const FlatTree& tree) { return Traverse(tree.Root()); }
+};
+
+} // namespace AST
+} // namespace CryCC
@@ -8,6 +8,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <utility>
+
 //TODO: move into Cry::
 namespace CryCC
 {
@@ -31,6 +34,83 @@ private:
 	int m_useCount = 0;
 };
 
+// Intrusive reference counter. The counter lives inside the object and
+// is atomic, trees are shared between the worker threads which pack and
+// run programs.
+class IntrusiveRefCount
+{
+public:
+	// Check if object is referenced.
+	bool HasRef() const noexcept { return m_refCount.load(std::memory_order_acquire) > 0; }
+	// Get the number of references on this object.
+	int RefCountValue() const noexcept { return m_refCount.load(std::memory_order_acquire); }
+	// Increase reference count.
+	void AddRef() noexcept { m_refCount.fetch_add(1, std::memory_order_relaxed); }
+	// Decrease reference count, returns true if this was the last reference.
+	bool ReleaseRef() noexcept { return m_refCount.fetch_sub(1, std::memory_order_acq_rel) == 1; }
+
+protected:
+	IntrusiveRefCount() = default;
+	// References are never copied along with the object.
+	IntrusiveRefCount(const IntrusiveRefCount&) noexcept {}
+	IntrusiveRefCount& operator=(const IntrusiveRefCount&) noexcept { return (*this); }
+
+private:
+	std::atomic<int> m_refCount{ 0 };
+};
+
+// Release a reference on the object, the object is destroyed
+// along with the last reference.
+template<typename Type>
+inline void ReleaseIntrusive(Type *object) noexcept
+{
+	if (object->ReleaseRef()) {
+		delete object;
+	}
+}
+
+// Pointer holding a reference on an intrusively counted object.
+template<typename Type>
+class IntrusivePtr
+{
+public:
+	IntrusivePtr() = default;
+	IntrusivePtr(Type *object) noexcept
+		: m_object{ object }
+	{
+		if (m_object) { m_object->AddRef(); }
+	}
+	IntrusivePtr(const IntrusivePtr& other) noexcept
+		: IntrusivePtr{ other.m_object }
+	{
+	}
+	IntrusivePtr(IntrusivePtr&& other) noexcept
+		: m_object{ other.m_object }
+	{
+		other.m_object = nullptr;
+	}
+	~IntrusivePtr()
+	{
+		if (m_object) { ReleaseIntrusive(m_object); }
+	}
+
+	// The new object is referenced before the old object is released,
+	// the old object may own the new object.
+	IntrusivePtr& operator=(IntrusivePtr other) noexcept
+	{
+		std::swap(m_object, other.m_object);
+		return (*this);
+	}
+
+	inline Type *get() const noexcept { return m_object; }
+	inline Type *operator->() const noexcept { return m_object; }
+	inline Type& operator*() const noexcept { return (*m_object); }
+	inline explicit operator bool() const noexcept { return m_object != nullptr; }
+
+private:
+	Type *m_object{ nullptr };
+};
+
 } // namespace AST
 } // namespace CryCC
 
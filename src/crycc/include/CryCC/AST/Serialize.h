@@ -25,6 +25,15 @@ class ASTNode;
 
 struct Serializable
 {
+	// Node layout versions. The resolved member fields were added in
+	// the second layout.
+	enum : int
+	{
+		NODE_LAYOUT_V1 = 1,
+		NODE_LAYOUT_V2 = 2,
+		NODE_LAYOUT_CURRENT = NODE_LAYOUT_V2,
+	};
+
 	struct ChildGroupInterface
 	{
 		virtual void SaveNode(std::shared_ptr<ASTNode>&) = 0;
@@ -66,6 +75,9 @@ struct Serializable
 		virtual void SetId(IdType) {}
 		// Retrieve the first commited node identifier.
 		virtual NodeID GetNodeId() = 0;
+		// Node layout of the stream. Nodes only write and read the fields
+		// which are part of the layout. This method is optional.
+		virtual int LayoutVersion() const noexcept { return NODE_LAYOUT_CURRENT; }
 		// Invoke registered callbacks by the node construction helper.
 		virtual void FireDependencies(std::shared_ptr<ASTNode>&) = 0;
 
@@ -8,6 +8,10 @@
 
 #pragma once
 
+#include <cstddef>
+#include <cassert>
+#include <algorithm>
+
 #define DEFAULT_UNIQUE_CTR 100
 
 namespace CryCC
@@ -15,6 +19,60 @@ namespace CryCC
 namespace AST
 {
 
+// Dense identifier allocator.
+//
+// Each tree owns an allocator so that node identifiers no longer depend
+// on the process history, and trees can be built on multiple threads at
+// once. Identifiers are handed out consecutively from the base value and
+// can be converted into an index for side tables. The allocator itself is
+// not synchronized, instead it is bound to a single thread with a scope.
+class UniqueIdAllocator final
+{
+public:
+	using value_type = int;
+
+	explicit UniqueIdAllocator(value_type base = DEFAULT_UNIQUE_CTR) noexcept
+		: m_base{ base }
+		, m_counter{ base }
+	{
+	}
+
+	// Allocate the next identifier.
+	inline value_type Next() noexcept { return ++m_counter; }
+	// Take all identifiers up to the identifier as handed out. Used when
+	// nodes are restored with the identifiers they were serialized with.
+	inline void Advance(value_type id) noexcept { m_counter = std::max(m_counter, id); }
+	// Number of identifiers handed out.
+	inline size_t Count() const noexcept { return static_cast<size_t>(m_counter - m_base); }
+	// Convert identifier into dense index.
+	inline size_t Index(value_type id) const noexcept
+	{
+		assert(id > m_base && id <= m_counter);
+		return static_cast<size_t>(id - m_base - 1);
+	}
+
+	// Get the allocator bound to the calling thread. If no allocator
+	// was bound, a thread local default allocator is returned.
+	static UniqueIdAllocator& Current() noexcept;
+
+	// Bind the allocator to the calling thread for the lifetime of the scope.
+	class Scope final
+	{
+		UniqueIdAllocator *m_previous;
+
+	public:
+		explicit Scope(UniqueIdAllocator&) noexcept;
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+private:
+	value_type m_base;
+	value_type m_counter;
+};
+
 class UniqueObj
 {
 public:
@@ -25,9 +83,16 @@ private:
 	mutable UniqueType m_id;
 
 public:
+	// Take identifier from the allocator bound to this thread.
 	inline UniqueObj()
+		: m_id{ UniqueIdAllocator::Current().Next() }
+	{
+	}
+
+	// Take identifier from the allocator.
+	explicit UniqueObj(UniqueIdAllocator& allocator)
+		: m_id{ allocator.Next() }
 	{
-		m_id = ++s_id;
 	}
 
 	// Get the reference to the identifier.
@@ -43,9 +108,6 @@ public:
 	bool operator> (const UniqueObj&) const noexcept;
 	bool operator<=(const UniqueObj&) const noexcept;
 	bool operator>=(const UniqueObj&) const noexcept;
-
-private:
-	static int s_id;
 };
 
 } // namespace AST
@@ -0,0 +1,206 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+// Framework includes.
+#include <Cry/Cry.h>
+#include <Cry/Serialize.h>
+
+// Language includes.
+#include <string>
+#include <vector>
+#include <variant>
+
+namespace CryCC::Program::Casm
+{
+
+using Word = Cry::Word;
+
+// Instruction set of the register machine.
+//
+// An instruction is an opcode word followed by a fixed number of
+// operand words. Register operands are slot indices in the frame
+// of the executing function, the registers below the frame size
+// hold the parameters, locals and temporaries. Jump operands are
+// signed offsets relative to the start of the jump instruction.
+// Integers are 32 bit wide and wrap on overflow.
+enum class Opcode : Word
+{
+	NOP,		// -
+	LOADK,		// r(a) = k(b)
+	LOADI,		// r(a) = int(b)
+	MOV,		// r(a) = r(b)
+	LOADG,		// r(a) = g(b)
+	STOREG,		// g(a) = r(b)
+	LOADX,		// r(a) = r(b + r(c)), r(c) below d
+	STOREX,		// r(a + r(b)) = r(c), r(b) below d
+
+	ADDI,		// r(a) = r(b) + r(c)
+	SUBI,		// r(a) = r(b) - r(c)
+	MULI,		// r(a) = r(b) * r(c)
+	DIVI,		// r(a) = r(b) / r(c)
+	MODI,		// r(a) = r(b) % r(c)
+	ANDI,		// r(a) = r(b) & r(c)
+	ORI,		// r(a) = r(b) | r(c)
+	XORI,		// r(a) = r(b) ^ r(c)
+	SHLI,		// r(a) = r(b) << r(c)
+	SHRI,		// r(a) = r(b) >> r(c)
+	EQI,		// r(a) = r(b) == r(c)
+	NEI,		// r(a) = r(b) != r(c)
+	LTI,		// r(a) = r(b) < r(c)
+	LEI,		// r(a) = r(b) <= r(c)
+	GTI,		// r(a) = r(b) > r(c)
+	GEI,		// r(a) = r(b) >= r(c)
+	ADDIK,		// r(a) = r(b) + int(c)
+
+	ADDF,		// r(a) = r(b) + r(c)
+	SUBF,		// r(a) = r(b) - r(c)
+	MULF,		// r(a) = r(b) * r(c)
+	DIVF,		// r(a) = r(b) / r(c)
+	EQF,		// r(a) = r(b) == r(c)
+	NEF,		// r(a) = r(b) != r(c)
+	LTF,		// r(a) = r(b) < r(c)
+	LEF,		// r(a) = r(b) <= r(c)
+	GTF,		// r(a) = r(b) > r(c)
+	GEF,		// r(a) = r(b) >= r(c)
+
+	NEGI,		// r(a) = -r(b)
+	NEGF,		// r(a) = -r(b)
+	NOT,		// r(a) = !r(b)
+	BNOT,		// r(a) = ~r(b)
+	I2F,		// r(a) = double(r(b))
+	F2I,		// r(a) = int(r(b))
+
+	JMP,		// pc += a
+	JZ,			// if (!r(a)) pc += b
+	JNZ,		// if (r(a)) pc += b
+
+	CALL,		// r(a) = f(b)(r(d0), ..., r(dc))
+	CALLX,		// r(a) = k(b)((e0, d0), ..., (ec, dc)), e is the argument kind
+	RET,		// return r(a)
+	RETV,		// return
+
+	COUNT,
+};
+
+// Storage class of a slot.
+enum class SlotKind : Cry::Byte
+{
+	VOID,
+	INTEGER,
+	FLOAT,
+};
+
+// Argument kind of an external call. Constant strings are passed
+// as a constant pool index rather than a register.
+enum class ArgKind : Word
+{
+	INTEGER,
+	FLOAT,
+	STRING,
+};
+
+// Frame register. The interpretation of the slot depends on
+// the instruction which accesses it.
+union Slot
+{
+	int32_t i;
+	double f;
+};
+
+// Constant pool entry.
+using Constant = std::variant<int32_t, double, std::string>;
+
+// Named storage in a frame or in the global area. Arrays occupy
+// consecutive slots starting at the first slot.
+struct SlotInfo
+{
+	std::string name;
+	SlotKind kind;
+	Word slot;
+	Word count;
+};
+
+// Function in the module. The parameters occupy the first slots
+// of the frame in order of declaration.
+struct Function
+{
+	std::string name;
+	SlotKind returnKind{ SlotKind::VOID };
+	Word paramCount{ 0 };
+	Word frameSize{ 0 };
+	std::vector<SlotInfo> layout;
+	std::vector<Word> code;
+};
+
+// Number of words taken by the instruction at the start of the code
+// range, including the opcode. Zero is returned if the instruction
+// is incomplete or the opcode is unknown.
+size_t InstructionLength(const Word *code, size_t available) noexcept;
+
+// Bytecode module.
+//
+// The module is the result of lowering a locked program tree into a
+// register based instruction stream. All literals are stored once in
+// the constant pool, global variables are kept in a separate area and
+// are initialized by the initializer function before the entry point
+// is called. A module is verified when it is read from a stream, any
+// slot, constant, function and jump target is within bounds of the
+// module. The runtime may therefore omit these checks.
+class Module final
+{
+public:
+	static constexpr const int npos = -1;
+
+	// Add constant to the pool, equal constants share an index.
+	Word AddConstant(Constant);
+	// Add global to the global area and return the global index.
+	Word AddGlobal(const std::string& name, SlotKind kind, Word count = 1);
+	// Add function to the module and return the function index.
+	Word AddFunction(Function&&);
+	// Set the function called before any other function.
+	inline void SetInitializer(int function) noexcept { m_initializer = function; }
+
+	// Constant pool.
+	inline const std::vector<Constant>& Constants() const noexcept { return m_constants; }
+	// Global area layout.
+	inline const std::vector<SlotInfo>& Globals() const noexcept { return m_globals; }
+	// Number of slots in the global area.
+	inline Word GlobalSize() const noexcept { return m_globalSize; }
+	// All functions in the module.
+	inline const std::vector<Function>& Functions() const noexcept { return m_functions; }
+	inline std::vector<Function>& Functions() noexcept { return m_functions; }
+	// Initializer function index, or npos if there are no global initializers.
+	inline int Initializer() const noexcept { return m_initializer; }
+
+	// Find function index by name, or npos if not found.
+	int FindFunction(const std::string&) const noexcept;
+	// Find global index by name, or npos if not found.
+	int FindGlobal(const std::string&) const noexcept;
+
+	// Test if the module has no functions.
+	inline bool Empty() const noexcept { return m_functions.empty(); }
+
+	// Check all references in the module, throws on any violation.
+	void Verify() const;
+
+	// Convert module into data stream.
+	static void Serialize(const Module&, Cry::ByteArray&);
+	// Convert data stream into module.
+	static void Deserialize(Module&, Cry::ByteArray&);
+
+private:
+	std::vector<Constant> m_constants;
+	std::vector<SlotInfo> m_globals;
+	std::vector<Function> m_functions;
+	Word m_globalSize{ 0 };
+	int m_initializer{ npos };
+};
+
+} // namespace CryCC::Program::Casm
@@ -9,6 +9,8 @@
 #pragma once
 
 #include <CryCC/AST/AST.h>
+#include <CryCC/AST/FlatTree.h>
+#include <CryCC/SubValue/TypeInterner.h>
 
 #include <CryCC/Program/ConditionTracker.h>
 #include <CryCC/Program/Stage.h>
@@ -76,6 +78,16 @@ public:
 	//TODO: think of something else, this is super ugly
 	// Access internal AST tree indirect.
 	inline AST::ASTNode *AstPassthrough() const { return m_ast->operator->(); }
+	// Get reference to the frozen tree, only available after lock. The
+	// tree is frozen on first use.
+	const AST::FlatTree& FlatAst();
+
+	// Node identifier allocator owned by this program. Bind the allocator
+	// to the thread with an allocator scope before creating nodes.
+	inline AST::UniqueIdAllocator& IdAllocator() noexcept { return m_idAllocator; }
+	// Type interner owned by this program. Bind the interner to the
+	// thread with an interner scope before the types are interned.
+	inline SubValue::Typedef::TypeInterner& Interner() noexcept { return m_typeInterner; }
 
 	//
 	// Symbol operations.
@@ -126,6 +138,24 @@ public:
 		m_resultSet.erase(Slot);
 	}
 
+	// Query a resultset without allocating the slot. Returns nullptr
+	// when the slot is unallocated.
+	template<ResultInterface::slot_type Slot>
+	ResultInterface *ResultSection() noexcept
+	{
+		const auto& it = m_resultSet.find(Slot);
+		if (it == m_resultSet.end()) { return nullptr; }
+		return it->second.get();
+	}
+
+	// Test if the slot holds a resultset with content.
+	template<ResultInterface::slot_type Slot>
+	bool HasResultSection() const
+	{
+		const auto& it = m_resultSet.find(Slot);
+		return it != m_resultSet.end() && it->second->Size() > 0;
+	}
+
 	// Retieve program condition.
 	inline const ConditionTracker& Condition() const { return m_treeCondition; }
 	// Test if a tree is set.
@@ -158,6 +188,9 @@ private:
 private:
 	SymbolMap m_symbols;
 	std::unique_ptr<AST::AST> m_ast{ nullptr }; //TODO: Point to an ASTNode directly
+	std::unique_ptr<AST::FlatTree> m_flatAst;
+	AST::UniqueIdAllocator m_idAllocator;
+	SubValue::Typedef::TypeInterner m_typeInterner;
 	std::map<ResultInterface::slot_type, std::unique_ptr<ResultInterface>> m_resultSet;
 };
 
@@ -28,6 +28,8 @@
 #include <CryCC/SubValue/ArrayType.h>
 #include <CryCC/SubValue/VariantType.h>
 #include <CryCC/SubValue/TypeFacade.h>
+#include <CryCC/SubValue/TypeInterner.h>
+#include <CryCC/SubValue/TypeLayout.h>
 
 #include <CryCC/SubValue/Valuedef.h>
 #include <CryCC/SubValue/OffsetValue.h>
@@ -35,6 +37,7 @@
 #include <CryCC/SubValue/ReferenceValue.h>
 #include <CryCC/SubValue/PointerValue.h>
 #include <CryCC/SubValue/BuiltinValue.h>
+#include <CryCC/SubValue/CompositeArray.h>
 #include <CryCC/SubValue/ArrayValue.h>
 #include <CryCC/SubValue/RecordValue.h>
 
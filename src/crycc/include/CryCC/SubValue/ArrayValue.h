@@ -12,6 +12,7 @@
 #include <CryCC/SubValue/ValueContract.h>
 #include <CryCC/SubValue/ArrayType.h>
 #include <CryCC/SubValue/Valuedef.h>
+#include <CryCC/SubValue/CompositeArray.h>
 
 // Framework includes.
 #include <Cry/Cry.h>
@@ -42,14 +43,16 @@ class ArrayValue : public AbstractValue<ArrayValue>, public IterableContract
 		, std::vector<Cry::FloatType::storage_type>
 		, std::vector<Cry::DoubleType::storage_type>
 		, std::vector<Cry::LongDoubleType::storage_type>
-		, std::vector<Value>>;
+		, std::vector<Value>
+		, CompositeArray>;
 	using ValueVariant = ArrayTypeList::template_apply<boost::variant>;
 
 	ValueVariant m_value;
 
 	struct PackerVisitor;
 
-	friend struct ArrayAccess; //TODO: Still?
+	// Element conversion for contiguous storage.
+	friend struct ArrayAccess;
 
 	void ConstructFromType();
 
@@ -78,6 +81,9 @@ public:
 	// Unique value identifier.
 	inline constexpr static const int value_category_identifier = 11;
 
+	// Create array value without elements, the element storage
+	// is allocated from the type on value initialization.
+	ArrayValue() = default;
 	ArrayValue(const ArrayValue&) = default;
 	ArrayValue(ArrayValue&&) = default;
 
@@ -140,7 +146,7 @@ public:
 	}
 
 	// Get the value at offset.
-	template<typename PrimitiveType>
+	template<typename PrimitiveType, typename = typename std::enable_if_t<Cry::IsPrimitiveType_v<PrimitiveType>>>
 	auto At(offset_type offset) const
 	{
 		try {
@@ -155,8 +161,14 @@ public:
 		}
 	}
 
+	// Get the element at offset as value, this works on every element storage.
+	Value At(offset_type offset) const
+	{
+		return ElementValue<true>(offset);
+	}
+
 	// Emplace value at offset.
-	template<typename PrimitiveType>
+	template<typename PrimitiveType, typename = typename std::enable_if_t<Cry::IsPrimitiveType_v<std::decay_t<PrimitiveType>>>>
 	void Emplace(offset_type offset, PrimitiveType&& value)
 	{
 		try {
@@ -171,6 +183,80 @@ public:
 		}
 	}
 
+	// Emplace value at offset, this works on every element storage.
+	void Emplace(offset_type offset, const Value& value)
+	{
+		AssignElement<true>(offset, value);
+	}
+
+	// Read the element at offset as value. The element is taken from
+	// the typed storage directly, the element list is not copied.
+	template<bool BoundsCheck = true>
+	Value ElementValue(offset_type offset) const;
+
+	// Assign value to the element at offset. The value is converted
+	// to the element type and stored in place.
+	template<bool BoundsCheck = true>
+	void AssignElement(offset_type offset, const Value&);
+
+	// Read the field at index of the element at offset. The field is read
+	// from the contiguous storage in place, no value is created for the
+	// element. Contiguous storage is always bounds checked.
+	Value ElementField(offset_type offset, size_t idx) const;
+
+	// Assign value to the field at index of the element at offset. The
+	// value is converted to the field type and stored in place.
+	void AssignElementField(offset_type offset, size_t idx, const Value&);
+
+	// Replace the element at offset by the result of the operation on the
+	// element. The element is passed from the typed storage and the result
+	// is stored in place, no value is created for the element.
+	template<bool BoundsCheck = true, typename Operation>
+	void AlterElement(offset_type offset, Operation&& op)
+	{
+		boost::apply_visitor([offset, &op](auto& elementList)
+		{
+			using ContainerType = std::decay_t<decltype(elementList)>;
+
+			if constexpr (std::is_same_v<ContainerType, std::vector<Value>> || std::is_same_v<ContainerType, CompositeArray>) {
+				throw InvalidValueArithmeticException{};
+			}
+			else {
+				if constexpr (BoundsCheck) {
+					if (offset >= elementList.size()) {
+						throw OutOfBoundsException{};
+					}
+				}
+
+				using element_type = typename ContainerType::value_type;
+				elementList[offset] = static_cast<element_type>(op(static_cast<element_type>(elementList[offset])));
+			}
+		}, m_value);
+	}
+
+	// Get the element view at offset. Only arrays of records and nested
+	// arrays are stored contiguously and can be accessed by view.
+	ConstElementView Element(offset_type offset) const
+	{
+		try {
+			return boost::strict_get<CompositeArray>(m_value).Element(offset);
+		}
+		catch (const boost::bad_get&) {
+			throw InvalidTypeCastException{};
+		}
+	}
+
+	// Get the element view at offset.
+	ElementView Element(offset_type offset)
+	{
+		try {
+			return boost::strict_get<CompositeArray>(m_value).Element(offset);
+		}
+		catch (const boost::bad_get&) {
+			throw InvalidTypeCastException{};
+		}
+	}
+
 	//
 	// Implement value category contract.
 	//
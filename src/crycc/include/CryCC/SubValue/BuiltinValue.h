@@ -45,6 +45,7 @@ class BuiltinValue : public AbstractValue<BuiltinValue>
 	ValueVariant m_value;
 
 	struct PackerVisitor;
+	struct ArithDispatch;
 
 	template<typename Type>
 	constexpr auto InitialConversion(Type value)
@@ -105,6 +106,13 @@ public:
 		}
 	}
 
+	// Convert the value into the primitive type, regardless of the stored type.
+	template<typename ReturnType>
+	ReturnType ConvertTo() const
+	{
+		return boost::apply_visitor([](auto value) { return static_cast<ReturnType>(value); }, m_value);
+	}
+
 	//
 	// Implement value category contract.
 	//
@@ -0,0 +1,190 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+// Project includes.
+#include <CryCC/SubValue/TypeLayout.h>
+#include <CryCC/SubValue/ValueContract.h>
+
+// Framework includes.
+#include <Cry/Types.h>
+
+// Language includes.
+#include <cstring>
+#include <memory>
+#include <vector>
+#include <type_traits>
+
+namespace CryCC::SubValue::Valuedef
+{
+
+// View on a single object in a flat buffer.
+//
+// The view does not own any memory and is only valid for as long
+// as the underlaying storage is neither resized nor destroyed. Scalar
+// fields are read and written with memcpy so the buffer does not have
+// to honor the alignment of the field type.
+template<typename PointerType>
+class BasicElementView
+{
+	PointerType m_data;
+	const TypeLayout *m_layout;
+
+	static constexpr bool is_mutable = !std::is_const_v<std::remove_pointer_t<PointerType>>;
+
+	template<typename Type>
+	inline void CheckScalarField(const TypeLayout& field) const
+	{
+		static_assert(std::is_arithmetic_v<Type>, "field type must be arithmetic");
+		if (!field.IsScalar() || field.Size() != sizeof(Type)) {
+			throw InvalidTypeCastException{};
+		}
+	}
+
+public:
+	BasicElementView(PointerType data, const TypeLayout& layout) noexcept
+		: m_data{ data }
+		, m_layout{ std::addressof(layout) }
+	{
+	}
+
+	// Convert mutable view to read only view.
+	template<typename OtherPointerType, typename = std::enable_if_t<std::is_convertible_v<OtherPointerType, PointerType>>>
+	BasicElementView(const BasicElementView<OtherPointerType>& other) noexcept
+		: m_data{ other.Data() }
+		, m_layout{ std::addressof(other.Layout()) }
+	{
+	}
+
+	// Object layout.
+	inline const TypeLayout& Layout() const noexcept { return (*m_layout); }
+	// Raw pointer to the start of the object.
+	inline PointerType Data() const noexcept { return m_data; }
+	// Number of fields or array elements.
+	inline size_t FieldCount() const noexcept { return m_layout->FieldCount(); }
+
+	// Read scalar field at index.
+	template<typename Type>
+	Type Field(size_t idx) const
+	{
+		const auto& field = m_layout->FieldLayout(idx);
+		CheckScalarField<Type>(field);
+
+		Type value;
+		std::memcpy(std::addressof(value), m_data + m_layout->FieldOffset(idx), sizeof(Type));
+		return value;
+	}
+
+	// Write scalar field at index.
+	template<typename Type, bool IsMutable = is_mutable, typename = std::enable_if_t<IsMutable>>
+	void SetField(size_t idx, Type value) const
+	{
+		const auto& field = m_layout->FieldLayout(idx);
+		CheckScalarField<Type>(field);
+
+		std::memcpy(m_data + m_layout->FieldOffset(idx), std::addressof(value), sizeof(Type));
+	}
+
+	// View on nested record or array field at index.
+	BasicElementView Member(size_t idx) const
+	{
+		const auto& field = m_layout->FieldLayout(idx);
+		if (field.IsScalar()) {
+			throw InvalidTypeCastException{};
+		}
+
+		return BasicElementView{ m_data + m_layout->FieldOffset(idx), field };
+	}
+};
+
+using ElementView = BasicElementView<Cry::Byte *>;
+using ConstElementView = BasicElementView<const Cry::Byte *>;
+
+// Contiguous array storage.
+//
+// Arrays of records and nested arrays store all elements in a single
+// byte buffer. The element layout is derived from the array element
+// type and shared between all copies of the array. Elements are accessed
+// through views, which avoids a value object per element.
+class CompositeArray final
+{
+	std::shared_ptr<const TypeLayout> m_layout;
+	std::vector<Cry::Byte> m_buffer;
+	size_t m_elementCount{ 0 };
+
+public:
+	using size_type = size_t;
+
+	CompositeArray() = default;
+
+	// Allocate zero initialized storage for the elements.
+	CompositeArray(std::shared_ptr<const TypeLayout> layout, size_type elementCount)
+		: m_layout{ std::move(layout) }
+		, m_buffer(m_layout->Size() * elementCount)
+		, m_elementCount{ elementCount }
+	{
+	}
+
+	// Take over raw element data without a layout. The layout must
+	// be bound before any element is accessed.
+	CompositeArray(std::vector<Cry::Byte>&& buffer, size_type elementCount)
+		: m_buffer{ std::move(buffer) }
+		, m_elementCount{ elementCount }
+	{
+	}
+
+	// Attach the element layout. The buffer must match the layout.
+	void BindLayout(std::shared_ptr<const TypeLayout> layout)
+	{
+		if (layout->Size() * m_elementCount != m_buffer.size()) {
+			throw InvalidTypeCastException{};
+		}
+		m_layout = std::move(layout);
+	}
+
+	// Test if the element layout is known.
+	inline bool HasLayout() const noexcept { return m_layout != nullptr; }
+	// Element layout.
+	inline const TypeLayout& Layout() const noexcept { return (*m_layout); }
+
+	// Number of elements.
+	inline size_type Size() const noexcept { return m_elementCount; }
+	// Size of the element storage in bytes.
+	inline size_type ByteSize() const noexcept { return m_buffer.size(); }
+	// Raw element storage.
+	inline const Cry::Byte *Data() const noexcept { return m_buffer.data(); }
+	inline Cry::Byte *Data() noexcept { return m_buffer.data(); }
+
+	// Get the element view at offset.
+	ElementView Element(size_type offset)
+	{
+		if (!HasLayout() || offset >= m_elementCount) {
+			throw OutOfBoundsException{};
+		}
+		return ElementView{ m_buffer.data() + offset * m_layout->Size(), (*m_layout) };
+	}
+
+	// Get the element view at offset.
+	ConstElementView Element(size_type offset) const
+	{
+		if (!HasLayout() || offset >= m_elementCount) {
+			throw OutOfBoundsException{};
+		}
+		return ConstElementView{ m_buffer.data() + offset * m_layout->Size(), (*m_layout) };
+	}
+
+	// Compare element data, the layout is part of the value type.
+	bool operator==(const CompositeArray& other) const
+	{
+		return m_elementCount == other.m_elementCount
+			&& m_buffer == other.m_buffer;
+	}
+};
+
+} // namespace CryCC::SubValue::Valuedef
@@ -17,7 +17,6 @@
 #include <Cry/Cry.h>
 
 // Language includes.
-#include <map>
 #include <vector>
 #include <memory>
 #include <ostream>
@@ -32,12 +31,11 @@ namespace CryCC::SubValue::Valuedef
 class Value;
 
 //FUTURE: initialize all fields in one go.
-// Pointer to the value since value is not yet defined. The fields are kept in
-// a vector since the order of fields is important.
+// The fields are kept in a vector since the order of fields is important,
+// the field value is found by the field index of the record type.
 class RecordValue : public AbstractValue<RecordValue>, public IterableContract
 {
-	//std::vector<std::pair<std::string, std::shared_ptr<Value>>> m_fields; //TODO: only use offsets
-	std::map<offset_type, Value> m_fields2; //TODO: std::vector would do
+	std::vector<Value> m_fields;
 
 	bool Compare(const RecordValue&) const;
 	void ConstructFromType();
@@ -57,7 +55,7 @@ public:
 public:
 	using typdef_type = Typedef::RecordType;
 	using value_category = ValueCategory::Plural;
-	using value_Type = typename decltype(m_fields2)::mapped_type;
+	using value_Type = typename decltype(m_fields)::value_type;
 
 	// Expose the value variants that this category can process.
 	inline constexpr static const int value_variant_order = 0;
@@ -75,7 +73,8 @@ public:
 
 	// Add field to record.
 	//void AddField(std::pair<std::string, std::shared_ptr<Value>>&&); //TODO: replace with next line.
-	// Add field to record.
+	// Add field to record. Fields are added in order of the field index,
+	// an existing field is replaced.
 	void AddField(int, value_Type&&);
 
 	// Add field to record directly. Although this method can benefit
@@ -101,7 +100,7 @@ public:
 	// Implement iterable contract.
 	//
 
-	size_type Size() const { return m_fields2.size(); }
+	size_type Size() const { return m_fields.size(); }
 
 	// TODO: OBSOLETE
 	// Get the value at offset.
@@ -119,6 +118,9 @@ public:
 	// Emplace value at offset.
 	void Emplace(offset_type offset, value_Type&& value);
 
+	// Get the field value at offset for in place modification.
+	value_Type& Member(offset_type offset);
+
 	//
 	// Implement value category contract.
 	//
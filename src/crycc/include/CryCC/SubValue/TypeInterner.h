@@ -0,0 +1,89 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+// Project includes.
+#include <CryCC/SubValue/Typedef.h>
+#include <CryCC/SubValue/TypeFacade.h>
+
+// Language includes.
+#include <string>
+#include <unordered_map>
+
+namespace CryCC::SubValue::Typedef
+{
+
+// Hash consed type table.
+//
+// Types are created anew for every declaration and literal. The
+// interner maps each type onto a canonical instance by the type
+// envelope, so structurally identical types share one allocation.
+// Canonical types are tagged with the generation of the interner.
+// Generations are never reused, two canonical types of the same
+// generation are equal if and only if they are the same object.
+// Canonical types cannot be altered after interning. The interner
+// is not synchronized, instead it is bound to a single thread with
+// a scope.
+class TypeInterner final
+{
+public:
+	using generation_type = size_t;
+
+	TypeInterner() noexcept;
+	TypeInterner(const TypeInterner&) = delete;
+	// The canonical types move with the table, the moved from
+	// interner starts over in a new generation.
+	TypeInterner(TypeInterner&&) noexcept;
+
+	TypeInterner& operator=(const TypeInterner&) = delete;
+	TypeInterner& operator=(TypeInterner&&) noexcept;
+
+	// Return the canonical instance of the type.
+	InternalBaseType Intern(const InternalBaseType&);
+	// Return the type facade with a canonical base type.
+	TypeFacade Intern(const TypeFacade&);
+
+	// Test if both types are canonical instances of the same interner.
+	static bool IsSameInterner(const AbstractType&, const AbstractType&) noexcept;
+
+	// Generation of the canonical types in this interner.
+	inline generation_type Generation() const noexcept { return m_generation; }
+
+	// Number of canonical types.
+	inline size_t Size() const noexcept { return m_typeMap.size(); }
+	// Number of types replaced by an existing canonical type.
+	inline size_t HitCount() const noexcept { return m_hitCount; }
+	// Approximate memory released by sharing types, in bytes.
+	inline size_t BytesSaved() const noexcept { return m_bytesSaved; }
+
+	// Get the interner bound to the calling thread. Returns nullptr if
+	// no interner was bound, types are then left as is.
+	static TypeInterner *Current() noexcept;
+
+	// Bind the interner to the calling thread for the lifetime of the scope.
+	class Scope final
+	{
+		TypeInterner *m_previous;
+
+	public:
+		explicit Scope(TypeInterner&) noexcept;
+		~Scope();
+
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+	};
+
+private:
+	generation_type m_generation;
+	std::unordered_map<std::string, InternalBaseType> m_typeMap;
+	size_t m_hitCount{ 0 };
+	size_t m_bytesSaved{ 0 };
+};
+
+} // namespace CryCC::SubValue::Typedef
@@ -0,0 +1,84 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+// Project includes.
+#include <CryCC/SubValue/Typedef.h>
+#include <CryCC/SubValue/BuiltinType.h>
+
+// Language includes.
+#include <memory>
+#include <vector>
+
+namespace CryCC::SubValue::Valuedef
+{
+
+// Memory layout of a type.
+//
+// The layout describes how an object of the type is placed in a
+// flat byte buffer. Scalars are builtin types with natural alignment.
+// Records and arrays are composed of fields, each field has an offset
+// from the start of the object and a nested layout. Arrays keep the
+// element layout once, the element offset follows from the element
+// size. Types which cannot be stored as plain bytes, such as pointers,
+// have no layout.
+class TypeLayout final
+{
+	struct Field
+	{
+		size_t offset;
+		std::shared_ptr<const TypeLayout> layout;
+	};
+
+public:
+	using size_type = size_t;
+	using offset_type = size_t;
+	using Specifier = Typedef::BuiltinType::Specifier;
+
+	// Compute the layout for the type. Returns nullptr if the type
+	// cannot be laid out in a flat buffer. Canonical types cannot be
+	// altered, their layout is computed once per thread.
+	static std::shared_ptr<const TypeLayout> Make(const Typedef::InternalBaseType&);
+
+	// Test if the layout is a single builtin type.
+	inline bool IsScalar() const noexcept { return m_fields.empty() && !m_element; }
+	// Test if the layout is an array of equal elements.
+	inline bool IsArray() const noexcept { return m_element != nullptr; }
+	// Builtin type specifier, only valid on scalars.
+	inline Specifier ScalarSpecifier() const noexcept { return m_specifier; }
+
+	// Object size in bytes including padding.
+	inline size_type Size() const noexcept { return m_size; }
+	// Object alignment in bytes.
+	inline size_type Alignment() const noexcept { return m_alignment; }
+
+	// Number of fields or array elements.
+	inline size_type FieldCount() const noexcept { return m_element ? m_elementCount : m_fields.size(); }
+	// Field offset from the start of the object.
+	offset_type FieldOffset(size_type idx) const;
+	// Field layout.
+	const TypeLayout& FieldLayout(size_type idx) const;
+
+	// Compare layouts.
+	bool operator==(const TypeLayout&) const;
+	bool operator!=(const TypeLayout& other) const { return !operator==(other); }
+
+private:
+	static std::shared_ptr<const TypeLayout> Compute(const Typedef::InternalBaseType&);
+
+private:
+	Specifier m_specifier{ Specifier::VOID_T };
+	size_type m_size{ 0 };
+	size_type m_alignment{ 1 };
+	std::vector<Field> m_fields;
+	std::shared_ptr<const TypeLayout> m_element;
+	size_type m_elementCount{ 0 };
+};
+
+} // namespace CryCC::SubValue::Valuedef
@@ -17,6 +17,7 @@
 // Language includes.
 #include <array>
 #include <vector>
+#include <stdexcept>
 
 //TODO:
 // - equal ops
@@ -25,8 +26,17 @@ namespace CryCC::SubValue::Typedef
 {
 
 class AbstractType;
+class TypeInterner;
 using InternalBaseType = std::shared_ptr<AbstractType>;
 
+struct CanonicalTypeException : public std::runtime_error
+{
+	explicit CanonicalTypeException()
+		: runtime_error{ "canonical type cannot be altered" }
+	{
+	}
+};
+
 // Envelope helper to identify type. For every specialization a
 // type variation must be defined in the base class. The variation
 // is primarily used for envelope operations. If the type system
@@ -186,10 +196,10 @@ public:
 	// Type specifier inputs.
 	//
 
-	virtual void SetStorageClass(StorageClassSpecifier storageClass) noexcept { m_storageClass = storageClass; }
-	virtual void SetQualifier(TypeQualifier typeQualifier) { m_typeQualifier.PushBack(typeQualifier); }
-	virtual void SetInline() noexcept { m_isInline = true; }
-	virtual void SetSensitive() noexcept { m_isSensitive = true; }
+	virtual void SetStorageClass(StorageClassSpecifier storageClass) { RequireMutable(); m_storageClass = storageClass; }
+	virtual void SetQualifier(TypeQualifier typeQualifier) { RequireMutable(); m_typeQualifier.PushBack(typeQualifier); }
+	virtual void SetInline() { RequireMutable(); m_isInline = true; }
+	virtual void SetSensitive() { RequireMutable(); m_isSensitive = true; }
 
 	//
 	// Stringify type name.
@@ -213,7 +223,35 @@ public:
 	bool operator==(const AbstractType&) const;
 	bool operator!=(const AbstractType&) const;
 
+	// Test if the type is the canonical instance in an interner.
+	inline bool IsCanonical() const noexcept { return m_internTag.generation != 0; }
+
+private:
+	friend class TypeInterner;
+
+	// Generation of the interner owning the canonical type. The tag is
+	// never copied, a copy of a canonical type is a regular type.
+	struct InternTag final
+	{
+		size_t generation{ 0 };
+
+		InternTag() = default;
+		InternTag(const InternTag&) noexcept {}
+		InternTag& operator=(const InternTag&) noexcept { return (*this); }
+	};
+
+	InternTag m_internTag;
+
 protected:
+	// Canonical types are shared by all users of the type and cannot be
+	// altered, alter a copy of the type instead.
+	inline void RequireMutable() const
+	{
+		if (IsCanonical()) {
+			throw CanonicalTypeException{};
+		}
+	}
+
 	bool m_isInline{ false };
 	bool m_isSensitive{ false };
 	StorageClassSpecifier m_storageClass = StorageClassSpecifier::NONE_T;
@@ -159,6 +159,14 @@ void MultiElementEmplace(const Value& value, Type&& newval)
 // Query value and type properties.
 //
 
+// Test if the value holds the value category. This only compares the category
+// identifier and should be preferred over a cast on the value category.
+template<typename ValueType>
+inline bool Isa(const Value& value) noexcept
+{
+	return value.Identifier() == ValueType::value_category_identifier;
+}
+
 // Evaluate the 'value' as either true or false.
 bool EvaluateValueAsBoolean(const Value&);
 // Evaluate the 'value' as an integer or throw exception.
@@ -22,6 +22,8 @@
 
 // Language includes.
 #include <string>
+#include <new>
+#include <cstddef>
 
 //TODO:
 // - Cleanup old obsolete code
@@ -370,16 +372,22 @@ public:
 	using default_value_type = NilValue;
 
 private:
+	class ProxyStorage;
+
 	struct ProxyInterface : public ValueContract
 	{
+		virtual ~ProxyInterface() = default;
+
 		// Check if value is set.
 		virtual bool IsInitialized() const noexcept = 0;
 		// Compare the proxy interface.
 		virtual bool Compare(ProxyInterface&) const = 0;
 		// Retrieve the value category identifier.
 		virtual int Id() const = 0;
-		// Clone the abstract proxy
-		virtual std::unique_ptr<ProxyInterface> Clone() const = 0;
+		// Clone the abstract proxy into the storage.
+		virtual void CloneInto(ProxyStorage&) const = 0;
+		// Move the proxy into the inline buffer.
+		virtual ProxyInterface *MoveInto(void *) noexcept = 0;
 		// Serialize the value.
 		virtual void Serialize(Cry::ByteArray& buffer) const = 0;
 		// Attach type facade to value.
@@ -400,6 +408,104 @@ private:
 		virtual Value ArithOperationValue(ArithOperation, const Typedef::TypeFacade&, ProxyInterface&) const = 0;
 	};
 
+	// Storage for the value proxy. Small proxies such as those of builtin and nil
+	// values are constructed in place in the inline buffer, and therefore require
+	// no heap allocation. Larger proxies are allocated on the heap. The storage
+	// mimics the owning pointer interface so that the proxy is accessed the same
+	// way in both cases.
+	class ProxyStorage final
+	{
+	public:
+		inline constexpr static const size_t inline_capacity = 64;
+		inline constexpr static const size_t inline_alignment = alignof(std::max_align_t);
+
+		// Test if the proxy type can be stored in the inline buffer.
+		template<typename ProxyType>
+		inline constexpr static const bool is_inline_v = sizeof(ProxyType) <= inline_capacity
+			&& alignof(ProxyType) <= inline_alignment
+			&& std::is_nothrow_move_constructible_v<ProxyType>;
+
+		ProxyStorage() noexcept = default;
+		ProxyStorage(const ProxyStorage&) = delete;
+		ProxyStorage(ProxyStorage&& other) noexcept
+		{
+			MoveFrom(other);
+		}
+
+		~ProxyStorage()
+		{
+			Reset();
+		}
+
+		ProxyStorage& operator=(const ProxyStorage&) = delete;
+		ProxyStorage& operator=(ProxyStorage&& other) noexcept
+		{
+			if (this != std::addressof(other)) {
+				Reset();
+				MoveFrom(other);
+			}
+			return (*this);
+		}
+
+		// Construct the proxy, the previous proxy is released.
+		template<typename ProxyType, typename... ArgTypes>
+		ProxyType *Emplace(ArgTypes&&... args)
+		{
+			Reset();
+			if constexpr (is_inline_v<ProxyType>) {
+				auto ptr = new (m_buffer) ProxyType(std::forward<ArgTypes>(args)...);
+				m_ptr = ptr;
+				m_isInline = true;
+				return ptr;
+			}
+			else {
+				auto ptr = new ProxyType(std::forward<ArgTypes>(args)...);
+				m_ptr = ptr;
+				m_isInline = false;
+				return ptr;
+			}
+		}
+
+		// Release the proxy.
+		void Reset() noexcept
+		{
+			if (!m_ptr) { return; }
+			if (m_isInline) {
+				m_ptr->~ProxyInterface();
+			}
+			else {
+				delete m_ptr;
+			}
+			m_ptr = nullptr;
+		}
+
+		inline ProxyInterface *get() const noexcept { return m_ptr; }
+		inline ProxyInterface *operator->() const noexcept { return m_ptr; }
+		inline ProxyInterface& operator*() const noexcept { return (*m_ptr); }
+		inline explicit operator bool() const noexcept { return m_ptr != nullptr; }
+
+	private:
+		void MoveFrom(ProxyStorage& other) noexcept
+		{
+			if (!other.m_ptr) { return; }
+			if (other.m_isInline) {
+				m_ptr = other.m_ptr->MoveInto(m_buffer);
+				m_isInline = true;
+				other.Reset();
+			}
+			else {
+				m_ptr = other.m_ptr;
+				m_isInline = false;
+				other.m_ptr = nullptr;
+			}
+		}
+
+	private:
+		alignas(inline_alignment) unsigned char m_buffer[inline_capacity];
+		ProxyInterface *m_ptr{ nullptr };
+		bool m_isInline{ false };
+	};
+
 	template<typename ValueType, typename = typename std::enable_if<IsValueContractCompliable<ValueType>::value>::type>
 	class AbstractValueProxy : public ProxyInterface
 	{
@@ -407,7 +513,7 @@ private:
 		auto ConstructValueFromOperator(Typedef::TypeFacade type, ProxyInterface& other) const
 		{
 			if (this->Id() != other.Id()) { CryImplExcept(); }
-			auto& otherProxy = dynamic_cast<AbstractValueProxy<ValueType>&>(other);
+			auto& otherProxy = static_cast<AbstractValueProxy<ValueType>&>(other);
 			ValueType value = std::invoke(BinaryOperation<ValueType>(), m_innerValue, otherProxy.m_innerValue);
 			return Value{ std::move(type), std::move(value) };
 		}
@@ -424,6 +530,7 @@ private:
 
 		explicit AbstractValueProxy() = default;
 		AbstractValueProxy(const AbstractValueProxy&) = default;
+		AbstractValueProxy(AbstractValueProxy&&) = default;
 
 		template<typename... ArgTypes>
 		AbstractValueProxy(ValueType&& valueCategory, ArgTypes... args)
@@ -444,10 +551,16 @@ private:
 		// Return the inner-value category.
 		ValueType& NativeValue() { return m_innerValue; }
 
-		// Clone the abstract proxy.
-		virtual std::unique_ptr<ProxyInterface> Clone() const
+		// Clone the abstract proxy into the storage.
+		virtual void CloneInto(ProxyStorage& storage) const
 		{
-			return std::make_unique<AbstractValueProxy<ValueType>>((*this));
+			storage.template Emplace<AbstractValueProxy<ValueType>>((*this));
+		}
+
+		// Move the proxy into the inline buffer.
+		virtual ProxyInterface *MoveInto(void *buffer) noexcept
+		{
+			return new (buffer) AbstractValueProxy<ValueType>(std::move(*this));
 		}
 
 		// Serialize the value.
@@ -478,7 +591,7 @@ private:
 		virtual bool Compare(ProxyInterface& other) const
 		{
 			if (this->Id() != other.Id()) { return false; }
-			auto& otherProxy = dynamic_cast<AbstractValueProxy<ValueType>&>(other);
+			auto& otherProxy = static_cast<AbstractValueProxy<ValueType>&>(other);
 			return m_innerValue == otherProxy.m_innerValue;
 		}
 
@@ -511,6 +624,7 @@ private:
 
 		explicit SingularValueProxy() = default;
 		SingularValueProxy(const SingularValueProxy&) = default;
+		SingularValueProxy(SingularValueProxy&&) = default;
 
 		template<typename... ArgTypes>
 		SingularValueProxy(ValueType&& valueCategory, ArgTypes... args)
@@ -518,10 +632,16 @@ private:
 		{
 		}
 
-		// Clone the abstract proxy.
-		virtual std::unique_ptr<ProxyInterface> Clone() const override
+		// Clone the abstract proxy into the storage.
+		virtual void CloneInto(ProxyStorage& storage) const override
+		{
+			storage.template Emplace<SingularValueProxy<ValueType>>((*this));
+		}
+
+		// Move the proxy into the inline buffer.
+		virtual ProxyInterface *MoveInto(void *buffer) noexcept override
 		{
-			return std::make_unique<SingularValueProxy<ValueType>>((*this));
+			return new (buffer) SingularValueProxy<ValueType>(std::move(*this));
 		}
 
 		//
@@ -545,6 +665,7 @@ private:
 
 		explicit MultiOrderValueProxy() = default;
 		MultiOrderValueProxy(const MultiOrderValueProxy&) = default;
+		MultiOrderValueProxy(MultiOrderValueProxy&&) = default;
 
 		template<typename... ArgTypes>
 		MultiOrderValueProxy(ValueType&& valueCategory, ArgTypes... args)
@@ -552,10 +673,16 @@ private:
 		{
 		}
 
-		// Clone the abstract proxy.
-		virtual std::unique_ptr<ProxyInterface> Clone() const override
+		// Clone the abstract proxy into the storage.
+		virtual void CloneInto(ProxyStorage& storage) const override
 		{
-			return std::make_unique<MultiOrderValueProxy<ValueType>>((*this));
+			storage.template Emplace<MultiOrderValueProxy<ValueType>>((*this));
+		}
+
+		// Move the proxy into the inline buffer.
+		virtual ProxyInterface *MoveInto(void *buffer) noexcept override
+		{
+			return new (buffer) MultiOrderValueProxy<ValueType>(std::move(*this));
 		}
 
 		//
@@ -580,6 +707,7 @@ private:
 
 		explicit IterableValueProxy() = default;
 		IterableValueProxy(const IterableValueProxy&) = default;
+		IterableValueProxy(IterableValueProxy&&) = default;
 
 		template<typename... ArgTypes>
 		IterableValueProxy(ValueType&& valueCategory, ArgTypes... args)
@@ -587,10 +715,16 @@ private:
 		{
 		}
 
-		// Clone the abstract proxy.
-		virtual std::unique_ptr<ProxyInterface> Clone() const override
+		// Clone the abstract proxy into the storage.
+		virtual void CloneInto(ProxyStorage& storage) const override
+		{
+			storage.template Emplace<IterableValueProxy<ValueType>>((*this));
+		}
+
+		// Move the proxy into the inline buffer.
+		virtual ProxyInterface *MoveInto(void *buffer) noexcept override
 		{
-			return std::make_unique<IterableValueProxy<ValueType>>((*this));
+			return new (buffer) IterableValueProxy<ValueType>(std::move(*this));
 		}
 
 		//
@@ -616,6 +750,11 @@ private:
 		{
 			return m_innerValue.Emplace(offset, std::forward<Type>(value));
 		}
+
+		auto Member(IterableContract::offset_type offset) -> decltype(auto)
+		{
+			return m_innerValue.Member(offset);
+		}
 	};
 
 	template<typename Type, typename = typename std::enable_if<IsValueContractCompliable<Type>::value>::type>
@@ -626,26 +765,41 @@ private:
 
 	// Initialize the value category with corresponing type reference.
 	template<typename ProxyType>
-	auto ProxyInit(const Typedef::TypeFacade& typeLink, const ProxyType* ptr)
+	auto ProxyInit(const Typedef::TypeFacade& typeLink, ProxyType *ptr)
 	{
-		ptr->get()->ReferenceType(std::addressof(typeLink));
-		ptr->get()->ValueInit();
+		ptr->ReferenceType(std::addressof(typeLink));
+		ptr->ValueInit();
 	}
 
 	template<typename ValueType, typename... ArgTypes>
 	auto MakeValueProxy(const Typedef::TypeFacade& typeLink, ValueType&& valueCategory, ArgTypes&&... args)
 	{
-		auto ptr = std::make_unique<ProxySelector<ValueType>>(std::forward<ValueType>(valueCategory), std::forward<ArgTypes>(args)...);
-		ProxyInit(typeLink, std::addressof(ptr));
-		return ptr;
+		ProxyStorage storage;
+		auto ptr = storage.Emplace<ProxySelector<ValueType>>(std::forward<ValueType>(valueCategory), std::forward<ArgTypes>(args)...);
+		ProxyInit(typeLink, ptr);
+		return storage;
 	}
 
 	template<typename ValueType>
 	auto MakeValueProxy(const Typedef::TypeFacade& typeLink)
 	{
-		auto ptr = std::make_unique<ProxySelector<ValueType>>();
-		ProxyInit(typeLink, std::addressof(ptr));
-		return ptr;
+		ProxyStorage storage;
+		auto ptr = storage.Emplace<ProxySelector<ValueType>>();
+		ProxyInit(typeLink, ptr);
+		return storage;
+	}
+
+	// Cast the proxy into the value category proxy. Each value category has a unique
+	// identifier and is always wrapped by the same proxy, so the identifier check is
+	// sufficient to perform a static cast. Returns nullptr on category mismatch.
+	template<typename ValueType>
+	inline auto ProxyCast() const noexcept
+	{
+		using InnerProxyType = typename std::add_pointer<ProxySelector<ValueType>>::type;
+		if (!m_valuePtr || m_valuePtr->Id() != ValueType::value_category_identifier) {
+			return static_cast<InnerProxyType>(nullptr);
+		}
+		return static_cast<InnerProxyType>(m_valuePtr.get());
 	}
 
 public:
@@ -689,8 +843,7 @@ public:
 	auto As() const -> decltype(auto)
 	{
 		static_assert(IsValueMultiOrdinal_v<ValueType>, "value type is not multiordinal");
-		using InnerProxyType = typename std::add_pointer<ProxySelector<ValueType>>::type;
-		auto proxy = dynamic_cast<InnerProxyType>(m_valuePtr.get());
+		auto proxy = ProxyCast<ValueType>();
 		if (!proxy) {
 			throw InvalidTypeCastException{};
 		}
@@ -701,8 +854,7 @@ public:
 	template<typename ValueType>
 	auto As() const -> decltype(auto)
 	{
-		using InnerProxyType = typename std::add_pointer<ProxySelector<ValueType>>::type;
-		return dynamic_cast<InnerProxyType>(m_valuePtr.get());
+		return ProxyCast<ValueType>();
 	}
 
 	// Request if element vector is empty.
@@ -710,8 +862,7 @@ public:
 	inline auto ElementEmpty() const
 	{
 		static_assert(IsValueIterable_v<ValueType>, "value type is not iterable");
-		using InnerProxyType = typename std::add_pointer<ProxySelector<ValueType>>::type;
-		return dynamic_cast<InnerProxyType>(m_valuePtr.get())->Empty();
+		return ProxyCast<ValueType>()->Empty();
 	}
 
 	// Request element vector size.
@@ -719,8 +870,7 @@ public:
 	inline auto ElementCount() const
 	{
 		static_assert(IsValueIterable_v<ValueType>, "value type is not iterable");
-		using InnerProxyType = typename std::add_pointer<ProxySelector<ValueType>>::type;
-		return dynamic_cast<InnerProxyType>(m_valuePtr.get())->Size();
+		return ProxyCast<ValueType>()->Size();
 	}
 
 	// Request value at offset.
@@ -728,16 +878,14 @@ public:
 	inline auto At() const -> decltype(auto)
 	{
 		static_assert(IsValueIterable_v<ValueType>, "value type is not iterable");
-		using InnerProxyType = typename std::add_pointer<ProxySelector<ValueType>>::type;
-		return dynamic_cast<InnerProxyType>(m_valuePtr.get())->At<ReturnType>(Offset);
+		return ProxyCast<ValueType>()->At<ReturnType>(Offset);
 	}
 	// Request value at offset.
 	template<typename ValueType, typename ReturnType, typename SizeType>
 	inline auto At(SizeType offset) const -> decltype(auto)
 	{
 		static_assert(IsValueIterable_v<ValueType>, "value type is not iterable");
-		using InnerProxyType = typename std::add_pointer<ProxySelector<ValueType>>::type;
-		return dynamic_cast<InnerProxyType>(m_valuePtr.get())->At<ReturnType>(offset);
+		return ProxyCast<ValueType>()->At<ReturnType>(offset);
 	}
 
 	// Replace value at offset.
@@ -745,16 +893,26 @@ public:
 	inline void Emplace(Type&& value) const
 	{
 		static_assert(IsValueIterable_v<ValueType>, "value type is not iterable");
-		using InnerProxyType = typename std::add_pointer<ProxySelector<ValueType>>::type;
-		dynamic_cast<InnerProxyType>(m_valuePtr.get())->Emplace(Offset, std::forward<Type>(value));
+		ProxyCast<ValueType>()->Emplace(Offset, std::forward<Type>(value));
 	}
 	// Replace value at offset.
 	template<typename ValueType, typename SizeType, typename Type>
 	inline void Emplace(SizeType offset, Type&& value) const
 	{
 		static_assert(IsValueIterable_v<ValueType>, "value type is not iterable");
-		using InnerProxyType = typename std::add_pointer<ProxySelector<ValueType>>::type;
-		dynamic_cast<InnerProxyType>(m_valuePtr.get())->Emplace(offset, std::forward<Type>(value));
+		ProxyCast<ValueType>()->Emplace(offset, std::forward<Type>(value));
+	}
+
+	// Access the member value at offset in place.
+	template<typename ValueType, typename SizeType>
+	inline auto Member(SizeType offset) const -> decltype(auto)
+	{
+		static_assert(IsValueIterable_v<ValueType>, "value type is not iterable");
+		auto proxy = ProxyCast<ValueType>();
+		if (!proxy) {
+			throw InvalidTypeCastException{};
+		}
+		return proxy->Member(offset);
 	}
 
 	// Return value as string.
@@ -798,7 +956,7 @@ private:
 	// Value type front.
 	Typedef::TypeFacade m_internalType; //TODO: replace by InternalBaseType
 	// Polymorphic value interface adopting the value category.
-	std::unique_ptr<ProxyInterface> m_valuePtr;
+	ProxyStorage m_valuePtr;
 };
 
 static_assert(std::is_copy_constructible_v<Value>, "Value !is_copy_constructible");
@@ -8,58 +8,42 @@
 
 #include <CryCC/AST/AST.h>
 
+#include <algorithm>
+
 namespace CryCC
 {
 namespace AST
 {
 
-void ForwardItemTree::ForwardInternalTree(std::shared_ptr<ASTNode>& node)
+ASTNode *ForwardItemTree::ForwardInternalTree(ASTNode *current)
 {
-	// No children in this node, work upwards and sideways
-	if (node->ChildrenCount() == 0) {
-	redo:
-		auto weakParent = node->Parent();
-		if (auto parent = weakParent.lock()) {
-			auto parentChildren = parent->Children();
+	// Node has children, descent to outer left
+	const auto& children = current->ChildNodes();
+	auto firstChild = std::find_if(children.cbegin(), children.cend(), [](const ASTNode *ptr) { return ptr != nullptr; });
+	if (firstChild != children.cend()) {
+		return (*firstChild);
+	}
 
-			auto selfListItem = std::find_if(parentChildren.begin(), parentChildren.end(), [=](std::weak_ptr<ASTNode>& wPtr)
-			{
-				return wPtr.lock() == node;
-			});
+	// No children in this node, work upwards and sideways
+	while (ASTNode *parent = current->ParentNode()) {
+		const auto& parentChildren = parent->ChildNodes();
 
-			// Parent cannot find this child, pass control back to parent
-			if (selfListItem == parentChildren.end()) {
-				node = parent;
-				goto redo;
-			}
+		auto selfListItem = std::find(parentChildren.cbegin(), parentChildren.cend(), current);
 
-			// Reached end of parent children list, move up
-			if (selfListItem + 1 == parentChildren.end()) {
-				node = parent;
-				goto redo;
-			}
-			// Pick right neighbor as next node
-			else {
-				auto weakNeighbor = selfListItem + 1;
-				if (auto neighbor = weakNeighbor->lock()) {
-					node = neighbor;
-				}
+		// Pick right neighbor as next node
+		if (selfListItem != parentChildren.cend()) {
+			auto neighbor = std::find_if(selfListItem + 1, parentChildren.cend(), [](const ASTNode *ptr) { return ptr != nullptr; });
+			if (neighbor != parentChildren.cend()) {
+				return (*neighbor);
 			}
 		}
-		else {
-			node = nullptr;
-		}
-	}
-	// Node has children, descent to outer left
-	else {
-		auto firstWeakChild = node->At(0);
-		if (auto firstChild = firstWeakChild.lock()) {
-			node = firstChild;
-		}
-		else {
-			node = nullptr;
-		}
+
+		// Parent cannot find this child or reached end of
+		// parent children list, pass control back to parent
+		current = parent;
 	}
+
+	return nullptr;
 }
 
 } // namespace CryCC
@@ -9,6 +9,7 @@
 #include <CryCC/AST/ASTNode.h>
 
 #include <iostream>
+#include <algorithm>
 
 using namespace CryCC::AST;
 
@@ -27,6 +28,64 @@ ASTNode::ASTNode(CryCC::SourceLocation::value_type line, CryCC::SourceLocation::
 {
 }
 
+// Copies only serve as node state snapshot. The snapshot holds on
+// to the child list for inspection, but is not linked into the tree.
+ASTNode::ASTNode(const ASTNode& other)
+	: UniqueObj{ other }
+	, VisitorInterface{ other }
+	, ModifierInterface{ other }
+	, UserDataAbstract{ other }
+	, IntrusiveRefCount{ other }
+	, m_location{ other.m_location }
+	, m_state{ other.m_state }
+	, children{ other.children }
+{
+	for (ASTNode *node : children) {
+		if (node) {
+			node->AddRef();
+		}
+	}
+}
+
+// Release the child list. Any child which is still referenced
+// elsewhere is orphaned unless another node adopted it.
+ASTNode::~ASTNode()
+{
+	for (ASTNode *node : children) {
+		if (node) {
+			if (node->m_parent == this) {
+				node->m_parent = nullptr;
+			}
+			ReleaseIntrusive(node);
+		}
+	}
+}
+
+void ASTNode::AppendChild(const ASTNodeType& node)
+{
+	ASTNode *child = node.get();
+	if (child) {
+		child->AddRef();
+		child->m_parent = this;
+	}
+
+	children.push_back(child);
+}
+
+void ASTNode::RemoveChild(size_t idx)
+{
+	assert(idx < children.size());
+
+	ASTNode *child = children[idx];
+	children.erase(children.begin() + idx);
+	if (child) {
+		if (child->m_parent == this && std::find(children.cbegin(), children.cend(), child) == children.cend()) {
+			child->m_parent = nullptr;
+		}
+		ReleaseIntrusive(child);
+	}
+}
+
 bool ASTNode::operator==(const ASTNode& other) const noexcept
 {
 	return (nodeId == other.nodeId)
@@ -61,11 +120,11 @@ void ASTNode::Print(int version, int level, bool last, std::vector<int> ignore)
 	}
 
 	// Traverse down the tree
-	const auto traverse = [=](const std::vector<std::weak_ptr<ASTNode>>& cList)
+	const auto traverse = [=](const std::vector<ASTNode *>& cList)
 	{
-		for (const auto& weakChild : cList) {
-			if (auto delegateChildren = weakChild.lock()) {
-				delegateChildren->Print(version, level + 1, &weakChild == &cList.back(), ignore);
+		for (const auto& child : cList) {
+			if (child) {
+				child->Print(version, level + 1, &child == &cList.back(), ignore);
 			}
 		}
 	};
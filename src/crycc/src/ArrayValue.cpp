@@ -8,6 +8,11 @@
 
 #include <CryCC/SubValue/ArrayValue.h>
 #include <CryCC/SubValue/BuiltinValue.h>
+#include <CryCC/SubValue/RecordValue.h>
+#include <CryCC/SubValue/RecordType.h>
+#include <CryCC/SubValue/TypedefType.h>
+
+#include <cstring>
 
 namespace CryCC::SubValue::Valuedef
 {
@@ -116,6 +121,16 @@ struct ArrayValue::PackerVisitor final : public boost::static_visitor<>
 		}
 	}
 
+	// The element storage is written as is, the layout is restored from the
+	// array type when the value is initialized.
+	void operator()(const CompositeArray& value) const
+	{
+		m_buffer.SerializeAs<Cry::Byte>(PrimitiveSpecifier::PS_RESV2);
+		m_buffer.SerializeAs<Cry::Word>(value.Size());
+		m_buffer.SerializeAs<Cry::Word>(value.ByteSize());
+		m_buffer.insert(m_buffer.cend(), value.Data(), value.Data() + value.ByteSize());
+	}
+
 	template<typename PrimitiveType>
 	auto DecodeValue(size_t size) const
 	{
@@ -197,6 +212,17 @@ struct ArrayValue::PackerVisitor final : public boost::static_visitor<>
 			variantValue = value;*/
 			break;
 		}
+		case PrimitiveSpecifier::PS_RESV2: {
+			size_t byteSize = m_buffer.Deserialize<Cry::Word>(Cry::ByteArray::AUTO);
+			if (m_buffer.size() < static_cast<size_t>(m_buffer.Offset()) + byteSize) {
+				throw OutOfBoundsException{};
+			}
+			const auto first = m_buffer.cbegin() + m_buffer.Offset();
+			std::vector<Cry::Byte> elementBuffer{ first, first + byteSize };
+			m_buffer.SetOffset(static_cast<int>(byteSize));
+			variantValue = CompositeArray{ std::move(elementBuffer), arraySize };
+			break;
+		}
 		default:
 			CryImplExcept();
 		}
@@ -209,11 +235,339 @@ ArrayValue::ArrayValue(buffer_type& buffer)
 	visitor(m_value);
 }
 
+namespace
+{
+
+// Test if the container is a list of primitive elements.
+template<typename Type>
+struct IsPrimitiveList : std::false_type {};
+template<typename Type>
+struct IsPrimitiveList<std::vector<Type>> : std::is_arithmetic<Type> {};
+
+template<typename Type>
+inline constexpr bool IsPrimitiveList_v = IsPrimitiveList<std::decay_t<Type>>::value;
+
+// Allocate zero initialized element list for the builtin type.
+template<typename VariantType>
+VariantType MakeElementList(Typedef::BuiltinType::Specifier specifier, size_t elementCount)
+{
+	using Specifier = Typedef::BuiltinType::Specifier;
+
+	switch (specifier) {
+	case Specifier::BOOL_T: return std::vector<BoolType::storage_type>(elementCount);
+	case Specifier::CHAR_T:
+	case Specifier::SIGNED_CHAR_T: return std::vector<CharType::storage_type>(elementCount);
+	case Specifier::UNSIGNED_CHAR_T: return std::vector<UnsignedCharType::storage_type>(elementCount);
+	case Specifier::SHORT_T: return std::vector<ShortType::storage_type>(elementCount);
+	case Specifier::UNSIGNED_SHORT_T: return std::vector<UnsignedShortType::storage_type>(elementCount);
+	case Specifier::INT_T: return std::vector<IntegerType::storage_type>(elementCount);
+	case Specifier::UNSIGNED_INT_T: return std::vector<UnsignedIntegerType::storage_type>(elementCount);
+	case Specifier::LONG_T: return std::vector<LongType::storage_type>(elementCount);
+	case Specifier::UNSIGNED_LONG_T: return std::vector<UnsignedLongType::storage_type>(elementCount);
+	case Specifier::FLOAT_T: return std::vector<FloatType::storage_type>(elementCount);
+	case Specifier::DOUBLE_T: return std::vector<DoubleType::storage_type>(elementCount);
+	case Specifier::LONG_DOUBLE_T: return std::vector<LongDoubleType::storage_type>(elementCount);
+	}
+
+	throw InvalidTypeCastException{};
+}
+
+// Invoke the function with the native type of the builtin type.
+template<typename Function>
+decltype(auto) DispatchSpecifier(Typedef::BuiltinType::Specifier specifier, Function&& func)
+{
+	using Specifier = Typedef::BuiltinType::Specifier;
+
+	switch (specifier) {
+	case Specifier::BOOL_T: return func(bool{});
+	case Specifier::CHAR_T: return func(char{});
+	case Specifier::SIGNED_CHAR_T: return func(static_cast<signed char>(0));
+	case Specifier::UNSIGNED_CHAR_T: return func(static_cast<unsigned char>(0));
+	case Specifier::SHORT_T: return func(short{});
+	case Specifier::UNSIGNED_SHORT_T: return func(static_cast<unsigned short>(0));
+	case Specifier::INT_T: return func(int{});
+	case Specifier::UNSIGNED_INT_T: return func(unsigned{});
+	case Specifier::LONG_T: return func(long{});
+	case Specifier::UNSIGNED_LONG_T: return func(static_cast<unsigned long>(0));
+	case Specifier::FLOAT_T: return func(float{});
+	case Specifier::DOUBLE_T: return func(double{});
+	case Specifier::LONG_DOUBLE_T: return func(static_cast<long double>(0));
+	}
+
+	throw InvalidTypeCastException{};
+}
+
+// Strip typedefs from the type.
+Typedef::InternalBaseType UnwrapTypedef(Typedef::InternalBaseType type)
+{
+	while (type && type->TypeId() == Typedef::TypeVariation::TYPEDEF) {
+		type = std::static_pointer_cast<Typedef::TypedefType>(type)->MarkType();
+	}
+	return type;
+}
+
+} // namespace
+
+// Arrays of records and nested arrays are allocated as one contiguous block
+// when the value is not yet initialized. A deserialized block is bound to the
+// layout of the element type. Arrays of builtin types are allocated as typed
+// element list.
 void ArrayValue::ConstructFromType()
 {
-	//
+	if (!m_linkType) { return; }
+
+	const auto arrayType = m_linkType->DataType<typdef_type>();
+	if (!arrayType) { return; }
+
+	auto layout = TypeLayout::Make(arrayType->Type());
+	if (!layout) { return; }
+
+	if (auto composite = boost::get<CompositeArray>(&m_value)) {
+		if (!composite->HasLayout() && !layout->IsScalar()) {
+			composite->BindLayout(std::move(layout));
+		}
+		return;
+	}
+
+	// Leave the value alone if it was initialized with elements.
+	const bool isEmpty = boost::apply_visitor([](const auto& value) -> bool
+	{
+		if constexpr (std::is_same_v<std::decay_t<decltype(value)>, CompositeArray>) {
+			return !value.Size();
+		}
+		else {
+			return value.empty();
+		}
+	}, m_value);
+	if (!isEmpty) { return; }
+
+	if (layout->IsScalar()) {
+		m_value = MakeElementList<ValueVariant>(layout->ScalarSpecifier(), arrayType->Order());
+		return;
+	}
+
+	m_value = CompositeArray{ std::move(layout), arrayType->Order() };
+}
+
+// Convert elements in contiguous storage from and to values.
+struct ArrayAccess final
+{
+	// Read single field from the object in place. Scalar fields are read from
+	// the buffer directly, nested objects are converted as a whole.
+	static Value ReadField(ConstElementView view, size_t idx, Typedef::InternalBaseType type)
+	{
+		const auto& fieldLayout = view.Layout().FieldLayout(idx);
+		if (!fieldLayout.IsScalar()) {
+			return ReadComposite(view.Member(idx), std::move(type));
+		}
+
+		return DispatchSpecifier(fieldLayout.ScalarSpecifier(), [&](auto native) -> Value
+		{
+			using native_type = decltype(native);
+			using storage_type = PrimitiveSelectorStorageType<native_type>;
+			return Value{ Typedef::TypeFacade{ std::move(type) }
+				, BuiltinValue{ static_cast<storage_type>(view.template Field<native_type>(idx)) } };
+		});
+	}
+
+	// Write single field of the object in place. Fields without a value are left as is.
+	static void WriteField(ElementView view, size_t idx, const Value& value)
+	{
+		const auto& fieldLayout = view.Layout().FieldLayout(idx);
+		if (!fieldLayout.IsScalar()) {
+			WriteComposite(view.Member(idx), value);
+			return;
+		}
+
+		const auto builtinValue = value.As<BuiltinValue>();
+		if (!builtinValue) { return; }
+
+		DispatchSpecifier(fieldLayout.ScalarSpecifier(), [&](auto native)
+		{
+			using native_type = decltype(native);
+			using storage_type = PrimitiveSelectorStorageType<native_type>;
+			view.template SetField<native_type>(idx, static_cast<native_type>(builtinValue->NativeValue().ConvertTo<storage_type>()));
+		});
+	}
+
+	// Records are converted field by field. Nested arrays of builtin types are copied
+	// into a typed element list, all other nested arrays are copied as contiguous block.
+	static Value ReadComposite(ConstElementView view, Typedef::InternalBaseType type)
+	{
+		const auto objectType = UnwrapTypedef(type);
+		const auto& layout = view.Layout();
+
+		if (objectType->TypeId() == Typedef::TypeVariation::RECORD) {
+			const auto fields = std::static_pointer_cast<Typedef::RecordType>(objectType)->Fields();
+
+			RecordValue record;
+			for (size_t i = 0; i < fields.size(); ++i) {
+				record.AddField(static_cast<int>(i), ReadField(view, i, fields[i].Type()));
+			}
+
+			return Value{ Typedef::TypeFacade{ std::move(type) }, std::move(record) };
+		}
+
+		ArrayValue array;
+		const auto& elementLayout = layout.FieldLayout(0);
+		if (elementLayout.IsScalar()) {
+			array.m_value = DispatchSpecifier(elementLayout.ScalarSpecifier(), [&](auto native) -> ArrayValue::ValueVariant
+			{
+				using native_type = decltype(native);
+				using storage_type = PrimitiveSelectorStorageType<native_type>;
+
+				std::vector<storage_type> elementList;
+				elementList.reserve(layout.FieldCount());
+				for (size_t i = 0; i < layout.FieldCount(); ++i) {
+					elementList.push_back(static_cast<storage_type>(view.template Field<native_type>(i)));
+				}
+				return elementList;
+			});
+		}
+		else {
+			// The layout is bound from the array type on value initialization.
+			array.m_value = CompositeArray{ std::vector<Cry::Byte>{ view.Data(), view.Data() + layout.Size() }, layout.FieldCount() };
+		}
+
+		return Value{ Typedef::TypeFacade{ std::move(type) }, std::move(array) };
+	}
+
+	// Fields without a value are left as is.
+	static void WriteComposite(ElementView view, const Value& value)
+	{
+		const auto& layout = view.Layout();
+
+		if (const auto recordValue = value.As<RecordValue>()) {
+			const auto& record = recordValue->NativeValue();
+			for (size_t i = 0; i < layout.FieldCount(); ++i) {
+				WriteField(view, i, record.At(i));
+			}
+			return;
+		}
+
+		if (const auto arrayValue = value.As<ArrayValue>()) {
+			const auto& array = arrayValue->NativeValue();
+			if (const auto composite = boost::get<CompositeArray>(&array.m_value)) {
+				if (composite->ByteSize() != layout.Size()) {
+					throw InvalidTypeCastException{};
+				}
+				std::memcpy(view.Data(), composite->Data(), layout.Size());
+				return;
+			}
+
+			for (size_t i = 0; i < layout.FieldCount(); ++i) {
+				WriteField(view, i, array.ElementValue<true>(i));
+			}
+			return;
+		}
+
+		throw InvalidTypeCastException{};
+	}
+};
+
+template<bool BoundsCheck>
+Value ArrayValue::ElementValue(offset_type offset) const
+{
+	return boost::apply_visitor([this, offset](const auto& elementList) -> Value
+	{
+		using ContainerType = std::decay_t<decltype(elementList)>;
+
+		if constexpr (IsPrimitiveList_v<ContainerType>) {
+			if constexpr (BoundsCheck) {
+				if (offset >= elementList.size()) {
+					throw OutOfBoundsException{};
+				}
+			}
+
+			using element_type = typename ContainerType::value_type;
+			return Value{ Typedef::TypeFacade{ m_linkType->DataType<typdef_type>()->Type() }
+				, BuiltinValue{ static_cast<element_type>(elementList[offset]) } };
+		}
+		else if constexpr (std::is_same_v<ContainerType, std::vector<Value>>) {
+			if constexpr (BoundsCheck) {
+				if (offset >= elementList.size()) {
+					throw OutOfBoundsException{};
+				}
+			}
+			return elementList[offset];
+		}
+		else {
+			// Contiguous storage is always bounds checked, the element view requires a valid offset.
+			return ArrayAccess::ReadComposite(elementList.Element(offset), m_linkType->DataType<typdef_type>()->Type());
+		}
+	}, m_value);
 }
 
+template<bool BoundsCheck>
+void ArrayValue::AssignElement(offset_type offset, const Value& value)
+{
+	const auto builtinValue = value.As<BuiltinValue>();
+
+	boost::apply_visitor([offset, &value, builtinValue](auto& elementList)
+	{
+		using ContainerType = std::decay_t<decltype(elementList)>;
+
+		if constexpr (IsPrimitiveList_v<ContainerType>) {
+			if constexpr (BoundsCheck) {
+				if (offset >= elementList.size()) {
+					throw OutOfBoundsException{};
+				}
+			}
+
+			if (!builtinValue) {
+				throw InvalidTypeCastException{};
+			}
+
+			using element_type = typename ContainerType::value_type;
+			elementList[offset] = builtinValue->NativeValue().ConvertTo<element_type>();
+		}
+		else if constexpr (std::is_same_v<ContainerType, std::vector<Value>>) {
+			if constexpr (BoundsCheck) {
+				if (offset >= elementList.size()) {
+					throw OutOfBoundsException{};
+				}
+			}
+			elementList[offset] = value;
+		}
+		else {
+			ArrayAccess::WriteComposite(elementList.Element(offset), value);
+		}
+	}, m_value);
+}
+
+// Only the field is converted, the element is not read as a whole.
+Value ArrayValue::ElementField(offset_type offset, size_t idx) const
+{
+	const auto view = Element(offset);
+	if (idx >= view.FieldCount()) {
+		throw OutOfBoundsException{};
+	}
+
+	const auto objectType = UnwrapTypedef(m_linkType->DataType<typdef_type>()->Type());
+	if (objectType->TypeId() == Typedef::TypeVariation::RECORD) {
+		return ArrayAccess::ReadField(view, idx, std::static_pointer_cast<Typedef::RecordType>(objectType)->Fields()[idx].Type());
+	}
+
+	// Nested array, the field is an element of the inner array.
+	return ArrayAccess::ReadField(view, idx, std::static_pointer_cast<Typedef::ArrayType>(objectType)->Type());
+}
+
+// Only the field is converted, other fields in the element are left untouched.
+void ArrayValue::AssignElementField(offset_type offset, size_t idx, const Value& value)
+{
+	const auto view = Element(offset);
+	if (idx >= view.FieldCount()) {
+		throw OutOfBoundsException{};
+	}
+
+	ArrayAccess::WriteField(view, idx, value);
+}
+
+template Value ArrayValue::ElementValue<true>(offset_type) const;
+template Value ArrayValue::ElementValue<false>(offset_type) const;
+template void ArrayValue::AssignElement<true>(offset_type, const Value&);
+template void ArrayValue::AssignElement<false>(offset_type, const Value&);
+
 // Convert single value into data stream.
 void ArrayValue::Serialize(const ArrayValue& value, Cry::ByteArray& buffer)
 {
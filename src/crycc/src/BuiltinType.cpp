@@ -175,6 +175,7 @@ bool BuiltinType::Equals(const InternalBaseType& other) const
 void BuiltinType::Consolidate(InternalBaseType& type)
 {
 	assert(type->AllowCoalescence());
+	RequireMutable();
 
 	auto otherType = std::dynamic_pointer_cast<BuiltinType>(type);
 	if (otherType->Unsigned()) {
@@ -10,6 +10,9 @@
 
 #include <Cry/Functional.h>
 
+#include <array>
+#include <utility>
+
 namespace CryCC::SubValue::Valuedef
 {
 
@@ -230,49 +233,94 @@ BuiltinValue BuiltinValue::operator--(int)
 	return tmp;
 }
 
-template<template<typename, typename> typename BinaryOperation>
-struct BinaryArithVisitor final : public boost::static_visitor<BuiltinValue>
+// Binary arithmetic is dispatched through a table of function pointers per
+// operator. The table is indexed by the variant index of both operands, so
+// that each entry is compiled for one pair of native types. This avoids the
+// double visitation of the value variant. The operands follow the usual
+// arithmetic conversions, booleans are promoted to integers.
+struct BuiltinValue::ArithDispatch final
 {
-	template<typename LHSType, typename RHSType>
-	BuiltinValue operator()(const LHSType& lhs, const RHSType& rhs) const
+	using function_type = BuiltinValue(*)(const ValueVariant&, const ValueVariant&);
+
+	inline constexpr static const size_t typeCount = NativeTypeList::size;
+
+	template<typename Type>
+	using PromoteType = std::conditional_t<std::is_same_v<Type, bool>, int, Type>;
+
+	// Variant index of the native type.
+	template<typename Type, size_t Idx = 0>
+	static constexpr int TypeIndex()
 	{
-		if constexpr (std::is_same_v<LHSType, bool> && std::is_same_v<RHSType, bool>) {
-			return std::invoke(BinaryOperation<int, int>(), lhs, rhs);
-		}
-		else if constexpr (std::is_same_v<LHSType, bool>) {
-			return std::invoke(BinaryOperation<int, RHSType>(), lhs, rhs);
-		}
-		else if constexpr (std::is_same_v<RHSType, bool>) {
-			return std::invoke(BinaryOperation<LHSType, int>(), lhs, rhs);
+		if constexpr (std::is_same_v<Type, NativeTypeList::element_type<Idx>>) {
+			return static_cast<int>(Idx);
 		}
 		else {
-			return std::invoke(BinaryOperation<LHSType, RHSType>(), lhs, rhs);
+			return TypeIndex<Type, Idx + 1>();
+		}
+	}
+
+	template<template<typename, typename> typename BinaryOperation, size_t LHSIdx, size_t RHSIdx>
+	static BuiltinValue Apply(const ValueVariant& lhs, const ValueVariant& rhs)
+	{
+		using LHSType = NativeTypeList::element_type<LHSIdx>;
+		using RHSType = NativeTypeList::element_type<RHSIdx>;
+
+		return std::invoke(BinaryOperation<PromoteType<LHSType>, PromoteType<RHSType>>()
+			, *boost::relaxed_get<LHSType>(&lhs)
+			, *boost::relaxed_get<RHSType>(&rhs));
+	}
+
+	template<template<typename, typename> typename BinaryOperation, size_t... Idx>
+	static constexpr std::array<function_type, sizeof...(Idx)> MakeTable(std::index_sequence<Idx...>)
+	{
+		return { { &Apply<BinaryOperation, Idx / typeCount, Idx % typeCount>... } };
+	}
+
+	template<template<typename, typename> typename BinaryOperation>
+	inline static const std::array<function_type, typeCount * typeCount> table
+		= MakeTable<BinaryOperation>(std::make_index_sequence<typeCount * typeCount>{});
+
+	template<template<typename, typename> typename BinaryOperation>
+	static BuiltinValue Invoke(const BuiltinValue& lhs, const BuiltinValue& rhs)
+	{
+		constexpr int intIndex = TypeIndex<IntegerType::storage_type>();
+		constexpr int doubleIndex = TypeIndex<DoubleType::storage_type>();
+
+		const int lhsIndex = lhs.m_value.which();
+		const int rhsIndex = rhs.m_value.which();
+
+		// Most arithmetic is performed on operands of the same type.
+		if (lhsIndex == rhsIndex) {
+			if (lhsIndex == intIndex) {
+				return Apply<BinaryOperation, intIndex, intIndex>(lhs.m_value, rhs.m_value);
+			}
+			else if (lhsIndex == doubleIndex) {
+				return Apply<BinaryOperation, doubleIndex, doubleIndex>(lhs.m_value, rhs.m_value);
+			}
 		}
+
+		return table<BinaryOperation>[lhsIndex * typeCount + rhsIndex](lhs.m_value, rhs.m_value);
 	}
 };
 
 BuiltinValue operator+(const BuiltinValue& lhs, const BuiltinValue& rhs)
 {
-	BinaryArithVisitor<Functional::Plus> valueVisitor;
-	return boost::apply_visitor(valueVisitor, lhs.m_value, rhs.m_value);
+	return BuiltinValue::ArithDispatch::Invoke<Functional::Plus>(lhs, rhs);
 }
 
 BuiltinValue operator-(const BuiltinValue& lhs, const BuiltinValue& rhs)
 {
-	BinaryArithVisitor<Functional::Minus> valueVisitor;
-	return boost::apply_visitor(valueVisitor, lhs.m_value, rhs.m_value);
+	return BuiltinValue::ArithDispatch::Invoke<Functional::Minus>(lhs, rhs);
 }
 
 BuiltinValue operator*(const BuiltinValue& lhs, const BuiltinValue& rhs)
 {
-	BinaryArithVisitor<Functional::Multiplies> valueVisitor;
-	return boost::apply_visitor(valueVisitor, lhs.m_value, rhs.m_value);
+	return BuiltinValue::ArithDispatch::Invoke<Functional::Multiplies>(lhs, rhs);
 }
 
 BuiltinValue operator/(const BuiltinValue& lhs, const BuiltinValue& rhs)
 {
-	BinaryArithVisitor<Functional::Divides> valueVisitor;
-	return boost::apply_visitor(valueVisitor, lhs.m_value, rhs.m_value);
+	return BuiltinValue::ArithDispatch::Invoke<Functional::Divides>(lhs, rhs);
 }
 
 //TODO:
@@ -0,0 +1,524 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include <CryCC/Program/Casm.h>
+
+#include <Cry/Except.h>
+
+#include <algorithm>
+#include <cstring>
+
+namespace CryCC::Program::Casm
+{
+
+namespace
+{
+
+constexpr const Cry::Byte casmMagic{ 0x3c };
+constexpr const Cry::Byte casmVersion{ 1 };
+
+constexpr const Word invalidIndex{ static_cast<Word>(-1) };
+
+// Operand roles of fixed length instructions.
+//   r  register
+//   k  constant
+//   i  immediate
+//   g  global slot
+//   j  jump offset
+//   n  array length
+const char *OperandRoles(Opcode opcode) noexcept
+{
+	switch (opcode) {
+	case Opcode::NOP:
+	case Opcode::RETV:
+		return "";
+
+	case Opcode::LOADK: return "rk";
+	case Opcode::LOADI: return "ri";
+	case Opcode::MOV: return "rr";
+	case Opcode::LOADG: return "rg";
+	case Opcode::STOREG: return "gr";
+	case Opcode::LOADX:
+	case Opcode::STOREX:
+		return "rrrn";
+
+	case Opcode::ADDI:
+	case Opcode::SUBI:
+	case Opcode::MULI:
+	case Opcode::DIVI:
+	case Opcode::MODI:
+	case Opcode::ANDI:
+	case Opcode::ORI:
+	case Opcode::XORI:
+	case Opcode::SHLI:
+	case Opcode::SHRI:
+	case Opcode::EQI:
+	case Opcode::NEI:
+	case Opcode::LTI:
+	case Opcode::LEI:
+	case Opcode::GTI:
+	case Opcode::GEI:
+	case Opcode::ADDF:
+	case Opcode::SUBF:
+	case Opcode::MULF:
+	case Opcode::DIVF:
+	case Opcode::EQF:
+	case Opcode::NEF:
+	case Opcode::LTF:
+	case Opcode::LEF:
+	case Opcode::GTF:
+	case Opcode::GEF:
+		return "rrr";
+	case Opcode::ADDIK:
+		return "rri";
+
+	case Opcode::NEGI:
+	case Opcode::NEGF:
+	case Opcode::NOT:
+	case Opcode::BNOT:
+	case Opcode::I2F:
+	case Opcode::F2I:
+		return "rr";
+
+	case Opcode::JMP: return "j";
+	case Opcode::JZ:
+	case Opcode::JNZ:
+		return "rj";
+
+	case Opcode::RET: return "r";
+
+	default:
+		break;
+	}
+
+	return nullptr;
+}
+
+// Compare constants by representation, floating point constants
+// are equal only if the bit patterns match.
+bool IsSameConstant(const Constant& lhs, const Constant& rhs) noexcept
+{
+	if (lhs.index() != rhs.index()) { return false; }
+	if (const auto *real = std::get_if<double>(&lhs)) {
+		return std::memcmp(real, std::get_if<double>(&rhs), sizeof(double)) == 0;
+	}
+	return lhs == rhs;
+}
+
+[[noreturn]] void InvalidModule(const std::string& message)
+{
+	throw Cry::Except::IncompatibleException{ "invalid bytecode module: " + message };
+}
+
+void WriteString(const std::string& str, Cry::ByteArray& buffer)
+{
+	buffer.SerializeAs<Word>(str.size());
+	buffer.insert(buffer.cend(), str.cbegin(), str.cend());
+}
+
+std::string ReadString(Cry::ByteArray& buffer)
+{
+	const size_t length = buffer.Deserialize<Word>();
+	const size_t offset = static_cast<size_t>(buffer.Offset());
+	if (length > buffer.size() - offset) {
+		InvalidModule("string out of bounds");
+	}
+
+	std::string str{ buffer.cbegin() + offset, buffer.cbegin() + offset + length };
+	buffer.SetOffset(static_cast<Cry::ByteArray::OffsetType>(length));
+	return str;
+}
+
+SlotKind ReadSlotKind(Cry::ByteArray& buffer)
+{
+	const auto kind = buffer.Deserialize<Cry::Byte>();
+	if (kind > static_cast<Cry::Byte>(SlotKind::FLOAT)) {
+		InvalidModule("unknown slot kind");
+	}
+	return static_cast<SlotKind>(kind);
+}
+
+void WriteSlotInfo(const SlotInfo& info, Cry::ByteArray& buffer)
+{
+	WriteString(info.name, buffer);
+	buffer.Serialize(static_cast<Cry::Byte>(info.kind));
+	buffer.Serialize(info.slot);
+	buffer.Serialize(info.count);
+}
+
+SlotInfo ReadSlotInfo(Cry::ByteArray& buffer)
+{
+	SlotInfo info;
+	info.name = ReadString(buffer);
+	info.kind = ReadSlotKind(buffer);
+	info.slot = buffer.Deserialize<Word>();
+	info.count = buffer.Deserialize<Word>();
+	return info;
+}
+
+// Test if the slot range fits in the storage area.
+inline bool IsInRange(Word slot, Word count, Word size) noexcept
+{
+	return slot < size && count <= size - slot;
+}
+
+} // namespace
+
+size_t InstructionLength(const Word *code, size_t available) noexcept
+{
+	if (!available || code[0] >= static_cast<Word>(Opcode::COUNT)) { return 0; }
+
+	size_t length;
+	const auto opcode = static_cast<Opcode>(code[0]);
+	switch (opcode) {
+	case Opcode::CALL:
+	case Opcode::CALLX:
+		if (available < 4 || code[3] > available) { return 0; }
+		length = 4 + (opcode == Opcode::CALL ? 1 : 2) * static_cast<size_t>(code[3]);
+		break;
+
+	default:
+		length = 1 + std::strlen(OperandRoles(opcode));
+		break;
+	}
+
+	return length <= available ? length : 0;
+}
+
+Word Module::AddConstant(Constant constant)
+{
+	const auto it = std::find_if(m_constants.cbegin(), m_constants.cend(), [&constant](const Constant& other)
+	{
+		return IsSameConstant(constant, other);
+	});
+	if (it != m_constants.cend()) {
+		return static_cast<Word>(std::distance(m_constants.cbegin(), it));
+	}
+
+	m_constants.emplace_back(std::move(constant));
+	return static_cast<Word>(m_constants.size() - 1);
+}
+
+Word Module::AddGlobal(const std::string& name, SlotKind kind, Word count)
+{
+	const Word slot = m_globalSize;
+	m_globals.push_back(SlotInfo{ name, kind, slot, count });
+	m_globalSize += count;
+	return slot;
+}
+
+Word Module::AddFunction(Function&& function)
+{
+	m_functions.emplace_back(std::move(function));
+	return static_cast<Word>(m_functions.size() - 1);
+}
+
+int Module::FindFunction(const std::string& name) const noexcept
+{
+	const auto it = std::find_if(m_functions.cbegin(), m_functions.cend(), [&name](const Function& function)
+	{
+		return function.name == name;
+	});
+	return it != m_functions.cend() ? static_cast<int>(std::distance(m_functions.cbegin(), it)) : npos;
+}
+
+int Module::FindGlobal(const std::string& name) const noexcept
+{
+	const auto it = std::find_if(m_globals.cbegin(), m_globals.cend(), [&name](const SlotInfo& info)
+	{
+		return info.name == name;
+	});
+	return it != m_globals.cend() ? static_cast<int>(std::distance(m_globals.cbegin(), it)) : npos;
+}
+
+void Module::Verify() const
+{
+	for (const auto& global : m_globals) {
+		if (!IsInRange(global.slot, global.count, m_globalSize)) {
+			InvalidModule("global '" + global.name + "' out of bounds");
+		}
+	}
+
+	if (m_initializer != npos) {
+		if (m_initializer < 0 || static_cast<size_t>(m_initializer) >= m_functions.size()
+			|| m_functions[m_initializer].paramCount) {
+			InvalidModule("invalid initializer");
+		}
+	}
+
+	for (const auto& function : m_functions) {
+		const Word frameSize = function.frameSize;
+		const auto& code = function.code;
+
+		if (function.paramCount > frameSize) {
+			InvalidModule("function '" + function.name + "' parameters exceed frame");
+		}
+		for (const auto& local : function.layout) {
+			if (!IsInRange(local.slot, local.count, frameSize)) {
+				InvalidModule("local '" + local.name + "' out of bounds");
+			}
+		}
+
+		const auto checkRegister = [&](Word reg)
+		{
+			if (reg >= frameSize) {
+				InvalidModule("register out of bounds in '" + function.name + "'");
+			}
+		};
+		const auto checkConstant = [this](Word idx)
+		{
+			if (idx >= m_constants.size()) {
+				InvalidModule("constant out of bounds");
+			}
+		};
+
+		// Walk the instructions and collect all jump targets. The targets
+		// are validated once all instruction boundaries are known.
+		std::vector<bool> boundary(code.size() + 1, false);
+		std::vector<size_t> targets;
+		Opcode last = Opcode::NOP;
+
+		for (size_t pc = 0; pc < code.size();) {
+			const size_t length = InstructionLength(code.data() + pc, code.size() - pc);
+			if (!length) {
+				InvalidModule("malformed instruction in '" + function.name + "'");
+			}
+
+			boundary[pc] = true;
+			last = static_cast<Opcode>(code[pc]);
+			const Word *operand = code.data() + pc + 1;
+
+			switch (last) {
+			case Opcode::CALL: {
+				checkRegister(operand[0]);
+				if (operand[1] >= m_functions.size() || m_functions[operand[1]].paramCount != operand[2]) {
+					InvalidModule("invalid call in '" + function.name + "'");
+				}
+				for (Word i = 0; i < operand[2]; ++i) {
+					checkRegister(operand[3 + i]);
+				}
+				break;
+			}
+			case Opcode::CALLX: {
+				checkRegister(operand[0]);
+				checkConstant(operand[1]);
+				if (!std::holds_alternative<std::string>(m_constants[operand[1]])) {
+					InvalidModule("invalid external call in '" + function.name + "'");
+				}
+				for (Word i = 0; i < operand[2]; ++i) {
+					const Word kind = operand[3 + i * 2];
+					const Word value = operand[3 + i * 2 + 1];
+					if (kind == static_cast<Word>(ArgKind::STRING)) {
+						checkConstant(value);
+						if (!std::holds_alternative<std::string>(m_constants[value])) {
+							InvalidModule("invalid external argument in '" + function.name + "'");
+						}
+					}
+					else if (kind <= static_cast<Word>(ArgKind::FLOAT)) {
+						checkRegister(value);
+					}
+					else {
+						InvalidModule("invalid external argument in '" + function.name + "'");
+					}
+				}
+				break;
+			}
+			case Opcode::LOADX:
+			case Opcode::STOREX: {
+				checkRegister(operand[0]);
+				checkRegister(operand[1]);
+				checkRegister(operand[2]);
+				const Word base = last == Opcode::LOADX ? operand[1] : operand[0];
+				if (!operand[3] || !IsInRange(base, operand[3], frameSize)) {
+					InvalidModule("array out of bounds in '" + function.name + "'");
+				}
+				break;
+			}
+			default: {
+				const char *roles = OperandRoles(last);
+				for (size_t i = 0; roles[i]; ++i) {
+					switch (roles[i]) {
+					case 'r':
+						checkRegister(operand[i]);
+						break;
+					case 'k':
+						checkConstant(operand[i]);
+						if (std::holds_alternative<std::string>(m_constants[operand[i]])) {
+							InvalidModule("string constant in register");
+						}
+						break;
+					case 'g':
+						if (operand[i] >= m_globalSize) {
+							InvalidModule("global out of bounds in '" + function.name + "'");
+						}
+						break;
+					case 'j': {
+						const auto target = static_cast<int64_t>(pc) + static_cast<int32_t>(operand[i]);
+						if (target < 0 || static_cast<size_t>(target) >= code.size()) {
+							InvalidModule("jump out of bounds in '" + function.name + "'");
+						}
+						targets.push_back(static_cast<size_t>(target));
+						break;
+					}
+					default:
+						break;
+					}
+				}
+				break;
+			}
+			}
+
+			pc += length;
+		}
+
+		// Execution must never run past the end of the code.
+		if (last != Opcode::RET && last != Opcode::RETV && last != Opcode::JMP) {
+			InvalidModule("function '" + function.name + "' is not terminated");
+		}
+		for (const auto target : targets) {
+			if (!boundary[target]) {
+				InvalidModule("jump into instruction in '" + function.name + "'");
+			}
+		}
+	}
+}
+
+void Module::Serialize(const Module& module, Cry::ByteArray& buffer)
+{
+	buffer.SetMagic(casmMagic);
+	buffer.SetPlatformCompat();
+	buffer.Serialize(casmVersion);
+
+	buffer.SerializeAs<Word>(module.m_constants.size());
+	for (const auto& constant : module.m_constants) {
+		buffer.SerializeAs<Cry::Byte>(constant.index());
+		std::visit([&buffer](auto&& value)
+		{
+			using Type = std::decay_t<decltype(value)>;
+			if constexpr (std::is_same_v<Type, int32_t>) {
+				buffer.SerializeAs<Word>(value);
+			}
+			else if constexpr (std::is_same_v<Type, double>) {
+				Cry::DoubleWord bits;
+				std::memcpy(&bits, &value, sizeof(bits));
+				buffer.Serialize(bits);
+			}
+			else {
+				WriteString(value, buffer);
+			}
+		}, constant);
+	}
+
+	buffer.Serialize(module.m_globalSize);
+	buffer.SerializeAs<Word>(module.m_globals.size());
+	for (const auto& global : module.m_globals) {
+		WriteSlotInfo(global, buffer);
+	}
+
+	buffer.SerializeAs<Word>(module.m_functions.size());
+	for (const auto& function : module.m_functions) {
+		WriteString(function.name, buffer);
+		buffer.Serialize(static_cast<Cry::Byte>(function.returnKind));
+		buffer.Serialize(function.paramCount);
+		buffer.Serialize(function.frameSize);
+		buffer.SerializeAs<Word>(function.layout.size());
+		for (const auto& local : function.layout) {
+			WriteSlotInfo(local, buffer);
+		}
+		buffer.SerializeAs<Word>(function.code.size());
+		for (const Word word : function.code) {
+			buffer.Serialize(word);
+		}
+	}
+
+	buffer.Serialize(module.m_initializer == npos ? invalidIndex : static_cast<Word>(module.m_initializer));
+}
+
+void Module::Deserialize(Module& module, Cry::ByteArray& buffer)
+{
+	if (!buffer.ValidateMagic(casmMagic) || !buffer.IsPlatformCompat()) {
+		InvalidModule("not a bytecode stream");
+	}
+	if (buffer.Deserialize<Cry::Byte>() != casmVersion) {
+		InvalidModule("unsupported version");
+	}
+
+	// Every element takes at least a byte, this bounds the preallocation
+	// for corrupt element counts.
+	const auto readCount = [&buffer]() -> size_t
+	{
+		const size_t count = buffer.Deserialize<Word>();
+		if (count > buffer.size() - static_cast<size_t>(buffer.Offset())) {
+			InvalidModule("element count out of bounds");
+		}
+		return count;
+	};
+
+	Module result;
+
+	const size_t constantCount = readCount();
+	result.m_constants.reserve(constantCount);
+	for (size_t i = 0; i < constantCount; ++i) {
+		switch (buffer.Deserialize<Cry::Byte>()) {
+		case 0:
+			result.m_constants.emplace_back(static_cast<int32_t>(buffer.Deserialize<Word>()));
+			break;
+		case 1: {
+			const auto bits = buffer.Deserialize<Cry::DoubleWord>();
+			double value;
+			std::memcpy(&value, &bits, sizeof(value));
+			result.m_constants.emplace_back(value);
+			break;
+		}
+		case 2:
+			result.m_constants.emplace_back(ReadString(buffer));
+			break;
+		default:
+			InvalidModule("unknown constant");
+		}
+	}
+
+	result.m_globalSize = buffer.Deserialize<Word>();
+	const size_t globalCount = readCount();
+	result.m_globals.reserve(globalCount);
+	for (size_t i = 0; i < globalCount; ++i) {
+		result.m_globals.push_back(ReadSlotInfo(buffer));
+	}
+
+	const size_t functionCount = readCount();
+	result.m_functions.reserve(functionCount);
+	for (size_t i = 0; i < functionCount; ++i) {
+		Function function;
+		function.name = ReadString(buffer);
+		function.returnKind = ReadSlotKind(buffer);
+		function.paramCount = buffer.Deserialize<Word>();
+		function.frameSize = buffer.Deserialize<Word>();
+
+		const size_t layoutCount = readCount();
+		function.layout.reserve(layoutCount);
+		for (size_t j = 0; j < layoutCount; ++j) {
+			function.layout.push_back(ReadSlotInfo(buffer));
+		}
+
+		const size_t codeCount = readCount();
+		function.code.reserve(codeCount);
+		for (size_t j = 0; j < codeCount; ++j) {
+			function.code.push_back(buffer.Deserialize<Word>());
+		}
+
+		result.m_functions.emplace_back(std::move(function));
+	}
+
+	const Word initializer = buffer.Deserialize<Word>();
+	result.m_initializer = initializer == invalidIndex ? npos : static_cast<int>(initializer);
+
+	result.Verify();
+	module = std::move(result);
+}
+
+} // namespace CryCC::Program::Casm
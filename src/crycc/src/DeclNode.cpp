@@ -463,6 +463,32 @@ void FunctionDecl::SetCompound(const std::shared_ptr<CompoundStmt>& node)
 	ASTNode::UpdateDelegate();
 }
 
+void FunctionDecl::SetCompoundLoader(CompoundLoader&& loader)
+{
+	assert(!m_body);
+
+	m_bodyLoader = std::move(loader);
+	m_isPrototype = false;
+	m_isDeferred.store(true, std::memory_order_release);
+}
+
+const std::shared_ptr<CompoundStmt>& FunctionDecl::LoadCompound()
+{
+	if (!HasDeferredCompound()) { return m_body; }
+
+	// If the loader throws the flag is not set and the next caller retries.
+	std::call_once(m_bodyLoaded, [this]()
+	{
+		if (auto body = m_bodyLoader()) {
+			SetCompound(body);
+		}
+		m_bodyLoader = nullptr;
+		m_isDeferred.store(false, std::memory_order_release);
+	});
+
+	return m_body;
+}
+
 void FunctionDecl::SetSignature(std::vector<Typedef::TypeFacade>&& signature)
 {
 	assert(!signature.empty());
@@ -499,6 +525,8 @@ void FunctionDecl::Serialize(Serializable::VisitorInterface& pack)
 
 	group++;
 	group.Size(1);
+	// The body must be loaded by the caller.
+	assert(!HasDeferredCompound());
 	group << NODE_UPCAST(m_body);
 
 	group++;
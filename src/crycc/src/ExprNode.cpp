@@ -538,11 +538,27 @@ std::shared_ptr<DeclRefExpr> MemberExpr::RecordRef()
 	return m_record;
 }
 
+void MemberExpr::Resolve(size_t index)
+{
+	m_fieldIndex = static_cast<int>(index);
+	m_fieldOffset = -1;
+}
+
+void MemberExpr::Resolve(size_t index, size_t offset)
+{
+	m_fieldIndex = static_cast<int>(index);
+	m_fieldOffset = static_cast<int>(offset);
+}
+
 void MemberExpr::Serialize(Serializable::VisitorInterface& pack)
 {
 	pack << nodeId;
 	pack << m_name;
 	pack << m_memberType;
+	if (pack.LayoutVersion() >= NODE_LAYOUT_V2) {
+		pack << m_fieldIndex;
+		pack << m_fieldOffset;
+	}
 
 	auto group = pack.ChildGroups(1);
 	group.Size(1);
@@ -563,6 +579,12 @@ void MemberExpr::Deserialize(Serializable::VisitorInterface& pack)
 	pack >> memberType;
 	m_memberType = static_cast<MemberType>(memberType);
 
+	// Older layouts leave the member unresolved.
+	if (pack.LayoutVersion() >= NODE_LAYOUT_V2) {
+		pack >> m_fieldIndex;
+		pack >> m_fieldOffset;
+	}
+
 	auto group = pack.ChildGroups();
 	pack <<= {group[0], [=](const std::shared_ptr<ASTNode>& node) {
 		m_record = std::dynamic_pointer_cast<DeclRefExpr>(node);
@@ -20,7 +20,7 @@ namespace
 template<typename NodeType, typename = typename std::enable_if<std::is_base_of<ASTNode, NodeType>::value>::type>
 ASTNodeType ReturnNode(Serializable::VisitorInterface *visitor)
 {
-	std::shared_ptr<ASTNode> node = std::make_shared<NodeType>(*visitor);
+	std::shared_ptr<ASTNode> node = MakeNodeHandle(new NodeType(*visitor));
 	visitor->FireDependencies(node);
 	return node;
 }
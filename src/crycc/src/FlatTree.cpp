@@ -0,0 +1,88 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include <CryCC/AST/FlatTree.h>
+#include <CryCC/AST/ASTNode.h>
+
+#include <algorithm>
+
+namespace CryCC
+{
+namespace AST
+{
+
+FlatTree FlatTree::Freeze(ASTNode *root)
+{
+	FlatTree tree;
+	if (!root) { return tree; }
+
+	// Queue of nodes in breadth first order, the node index is the
+	// position in this list.
+	std::vector<ASTNode *> nodeList;
+	nodeList.push_back(root);
+	tree.m_parent.push_back(npos);
+
+	for (index_type idx = 0; idx < static_cast<index_type>(nodeList.size()); ++idx) {
+		ASTNode *node = nodeList[idx];
+		const size_type kind = KindOffset(node->Label());
+
+		tree.m_label.push_back(node->Label());
+		tree.m_payload.push_back(static_cast<index_type>(tree.m_kindTable[kind].size()));
+		tree.m_kindTable[kind].push_back(node);
+		tree.m_kindIndex[kind].push_back(idx);
+
+		// The body is not part of the tree until it is loaded.
+		if (node->Label() == NodeID::FUNCTION_DECL_ID && static_cast<FunctionDecl *>(node)->HasDeferredCompound()) {
+			tree.m_deferredIndex.push_back(idx);
+			tree.m_deferredBody.push_back(std::make_unique<DeferredBody>());
+		}
+
+		// Children are appended in one go so they end up adjacent.
+		tree.m_firstChild.push_back(static_cast<index_type>(nodeList.size()));
+		index_type childCount = 0;
+		for (ASTNode *child : node->ChildNodes()) {
+			if (child) {
+				nodeList.push_back(child);
+				tree.m_parent.push_back(idx);
+				++childCount;
+			}
+		}
+		tree.m_childCount.push_back(childCount);
+	}
+
+	return tree;
+}
+
+FlatTree::NodeHandle FlatTree::FunctionBody(NodeHandle function) const
+{
+	assert(function.Label() == NodeID::FUNCTION_DECL_ID);
+
+	const auto it = std::lower_bound(m_deferredIndex.cbegin(), m_deferredIndex.cend(), function.Index());
+	if (it == m_deferredIndex.cend() || (*it) != function.Index()) {
+		const ASTNode *body = function.As<FunctionDecl>()->FunctionCompound().get();
+		for (size_type i = 0; i < function.ChildrenCount(); ++i) {
+			if (function.Child(i).Node() == body) {
+				return function.Child(i);
+			}
+		}
+		return {};
+	}
+
+	// If loading the body throws the next request retries.
+	DeferredBody& deferred = (*m_deferredBody[std::distance(m_deferredIndex.cbegin(), it)]);
+	std::call_once(deferred.frozen, [&deferred, function]()
+	{
+		const auto& body = function.As<FunctionDecl>()->LoadCompound();
+		deferred.tree = std::make_unique<FlatTree>(Freeze(body.get()));
+	});
+
+	return deferred.tree->Root();
+}
+
+} // namespace AST
+} // namespace CryCC
@@ -341,10 +341,10 @@ const char *CompoundAssignOperator::CompoundAssignOperandStr(CompoundAssignOpera
 	return "<unknown>";
 }
 
-CompoundAssignOperator::CompoundAssignOperator(CompoundAssignOperand operand, const std::shared_ptr<DeclRefExpr>& node)
+CompoundAssignOperator::CompoundAssignOperator(CompoundAssignOperand operand, const ASTNodeType& node)
 	: m_operand{ operand }
 {
-	ASTNode::AppendChild(NODE_UPCAST(node));
+	ASTNode::AppendChild(node);
 	m_identifier = node;
 }
 
@@ -367,7 +367,7 @@ void CompoundAssignOperator::Serialize(Serializable::VisitorInterface& pack)
 
 	group++;
 	group.Size(1);
-	group << NODE_UPCAST(m_identifier);
+	group << m_identifier;
 
 	Operator::Serialize(pack);
 }
@@ -389,7 +389,7 @@ void CompoundAssignOperator::Deserialize(Serializable::VisitorInterface& pack)
 
 	group++;
 	pack <<= {group[0], [=](const std::shared_ptr<ASTNode>& node) {
-		m_identifier = std::dynamic_pointer_cast<DeclRefExpr>(node);
+		m_identifier = node;
 		ASTNode::AppendChild(node);
 	}};
 
@@ -29,8 +29,21 @@ Program::Program(Program&& other, AST::ASTNodeType&& ast)
 	, m_treeCondition{ other.m_treeCondition }
 	, m_lastStage{ other.m_lastStage }
 	, m_locked{ other.m_locked }
+	, m_idAllocator{ other.m_idAllocator }
+	, m_typeInterner{ std::move(other.m_typeInterner) }
 {
 }
 
+const AST::FlatTree& Program::FlatAst()
+{
+	assert(m_locked);
+
+	if (!m_flatAst) {
+		m_flatAst = std::make_unique<AST::FlatTree>(AST::FlatTree::Freeze(m_ast ? AstPassthrough() : nullptr));
+	}
+
+	return (*m_flatAst);
+}
+
 } // namespace Program
 } // namespace CryCC
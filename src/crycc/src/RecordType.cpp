@@ -76,16 +76,19 @@ void RecordType::Unpack(buffer_type& buffer)
 
 void RecordType::AddField(const std::string& field, const InternalBaseType& type)
 {
+	RequireMutable();
 	m_fields.push_back(FieldType{ field, type });
 }
 
 void RecordType::AddField(std::string&& field, InternalBaseType&& type)
 {
+	RequireMutable();
 	m_fields.emplace_back(std::move(field), std::move(type));
 }
 
 void RecordType::AddField(FieldType&& field)
 {
+	RequireMutable();
 	m_fields.emplace_back(std::move(field));
 }
 
@@ -39,10 +39,20 @@ bool RecordValue::Compare(const RecordValue& other) const
 	});*/
 }
 
+// Create an empty value for every field in the record type which was
+// not set on construction. The field index matches the type field index.
 void RecordValue::ConstructFromType()
 {
-	//TODO:
-	m_linkType->DataType<typdef_type>();
+	if (!m_linkType) { return; }
+
+	const auto recordType = m_linkType->DataType<typdef_type>();
+	if (!recordType) { return; }
+
+	const auto fields = recordType->Fields();
+	m_fields.reserve(fields.size());
+	for (size_t i = m_fields.size(); i < fields.size(); ++i) {
+		m_fields.emplace_back(Value{ Typedef::TypeFacade{ fields[i].Type() } });
+	}
 }
 
 //void RecordValue::AddField(std::pair<std::string, std::shared_ptr<Value>>&& val)
@@ -55,7 +65,15 @@ void RecordValue::ConstructFromType()
 
 void RecordValue::AddField(int index, value_Type&& val)
 {
-	m_fields2.emplace(index, std::move(val));
+	const auto offset = static_cast<offset_type>(index);
+	if (offset < m_fields.size()) {
+		m_fields[offset] = std::move(val);
+		return;
+	}
+	if (index < 0 || offset > m_fields.size()) {
+		throw OutOfBoundsException{};
+	}
+	m_fields.emplace_back(std::move(val));
 }
 
 //bool RecordValue::HasField(const std::string& name) const
@@ -77,23 +95,32 @@ void RecordValue::AddField(int index, value_Type&& val)
 // Get the value at offset.
 RecordValue::value_Type RecordValue::At(offset_type offset) const
 {
-	if (m_fields2.size() < offset + 1) {
+	if (offset >= m_fields.size()) {
 		throw OutOfBoundsException{};
 	}
-	return m_fields2.at(offset);
+	return m_fields[offset];
 }
 
 // Emplace value at offset.
 void RecordValue::Emplace(offset_type offset, value_Type&& value)
 {
-	if (m_fields2.size() < offset + 1) {
+	if (offset >= m_fields.size()) {
 		throw OutOfBoundsException{};
 	}
-	m_fields2.at(offset) = std::move(value);
+	m_fields[offset] = std::move(value);
 
 	//TODO: trigger type update
 }
 
+// Get the field value at offset.
+RecordValue::value_Type& RecordValue::Member(offset_type offset)
+{
+	if (offset >= m_fields.size()) {
+		throw OutOfBoundsException{};
+	}
+	return m_fields[offset];
+}
+
 //TODO:
 // Convert record value into data stream.
 void RecordValue::Serialize(const RecordValue& /*value*/, buffer_type& buffer)
@@ -7,6 +7,7 @@
 // copied and/or distributed without the express of the author.
 
 #include <CryCC/SubValue/TypeFacade.h>
+#include <CryCC/SubValue/TypeInterner.h>
 
 namespace CryCC::SubValue::Typedef
 {
@@ -58,13 +59,19 @@ std::string TypeFacade::PointerName() const
 	return " " + std::string(m_ptrCount, '*');
 }
 
+// Canonical types of the same interner are equal only if they
+// are the same instance, the structure is not compared.
 bool TypeFacade::operator==(const TypeFacade& other) const
 {
+	if (m_type == other.m_type) { return true; }
+	if (m_type && other.m_type && TypeInterner::IsSameInterner(*m_type, *other.m_type)) {
+		return false;
+	}
 	return m_type->Equals(other.m_type.get());
 }
 bool TypeFacade::operator!=(const TypeFacade& other) const
 {
-	return !m_type->Equals(other.m_type.get());
+	return !operator==(other);
 }
 
 } // namespace namespace CryCC::SubValue::Typedef
@@ -0,0 +1,145 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include <CryCC/SubValue/TypeInterner.h>
+#include <CryCC/SubValue/NilType.h>
+#include <CryCC/SubValue/BuiltinType.h>
+#include <CryCC/SubValue/RecordType.h>
+#include <CryCC/SubValue/TypedefType.h>
+#include <CryCC/SubValue/VariadicType.h>
+#include <CryCC/SubValue/PointerType.h>
+#include <CryCC/SubValue/ArrayType.h>
+#include <CryCC/SubValue/VariantType.h>
+
+#include <atomic>
+#include <memory>
+
+namespace CryCC::SubValue::Typedef
+{
+
+namespace
+{
+
+// Generation zero marks a regular type.
+std::atomic<TypeInterner::generation_type> g_lastGeneration{ 0 };
+thread_local TypeInterner *t_boundInterner = nullptr;
+
+inline TypeInterner::generation_type NextGeneration() noexcept
+{
+	return ++g_lastGeneration;
+}
+
+// Allocation size of the type object, nested types are not included.
+size_t TypeFootprint(const AbstractType& type) noexcept
+{
+	switch (type.TypeId()) {
+	case TypeVariation::BUILTIN: return sizeof(BuiltinType);
+	case TypeVariation::RECORD: return sizeof(RecordType);
+	case TypeVariation::TYPEDEF: return sizeof(TypedefType);
+	case TypeVariation::VARIADIC: return sizeof(VariadicType);
+	case TypeVariation::POINTER: return sizeof(PointerType);
+	case TypeVariation::ARRAY: return sizeof(ArrayType);
+	case TypeVariation::VARIANT: return sizeof(VariantType);
+	case TypeVariation::NIL: return sizeof(NilType);
+	}
+
+	return 0;
+}
+
+} // namespace
+
+TypeInterner::TypeInterner() noexcept
+	: m_generation{ NextGeneration() }
+{
+}
+
+TypeInterner::TypeInterner(TypeInterner&& other) noexcept
+	: m_generation{ other.m_generation }
+	, m_typeMap{ std::move(other.m_typeMap) }
+	, m_hitCount{ other.m_hitCount }
+	, m_bytesSaved{ other.m_bytesSaved }
+{
+	other.m_generation = NextGeneration();
+	other.m_typeMap.clear();
+	other.m_hitCount = 0;
+	other.m_bytesSaved = 0;
+}
+
+TypeInterner& TypeInterner::operator=(TypeInterner&& other) noexcept
+{
+	if (this == std::addressof(other)) { return (*this); }
+
+	m_generation = other.m_generation;
+	m_typeMap = std::move(other.m_typeMap);
+	m_hitCount = other.m_hitCount;
+	m_bytesSaved = other.m_bytesSaved;
+
+	other.m_generation = NextGeneration();
+	other.m_typeMap.clear();
+	other.m_hitCount = 0;
+	other.m_bytesSaved = 0;
+	return (*this);
+}
+
+// The type envelope holds all type properties including the nested
+// types, and is used as the structural key of the type.
+InternalBaseType TypeInterner::Intern(const InternalBaseType& type)
+{
+	if (!type) { return type; }
+	if (type->m_internTag.generation == m_generation) { return type; }
+
+	AbstractType::buffer_type envelope;
+	AbstractType::Serialize((*type), envelope);
+	std::string key{ envelope.Buffer().cbegin(), envelope.Buffer().cend() };
+
+	const auto result = m_typeMap.emplace(std::move(key), type);
+	if (!result.second) {
+		++m_hitCount;
+		m_bytesSaved += TypeFootprint(*type);
+		return result.first->second;
+	}
+
+	// A type can only be canonical in a single interner.
+	if (!type->IsCanonical()) {
+		type->m_internTag.generation = m_generation;
+	}
+	return type;
+}
+
+TypeFacade TypeInterner::Intern(const TypeFacade& type)
+{
+	if (!type.HasValue()) { return type; }
+
+	TypeFacade canonicalType{ Intern(type.BaseType()) };
+	canonicalType.SetPointer(type.PointerCount());
+	return canonicalType;
+}
+
+bool TypeInterner::IsSameInterner(const AbstractType& type, const AbstractType& other) noexcept
+{
+	return type.m_internTag.generation
+		&& type.m_internTag.generation == other.m_internTag.generation;
+}
+
+TypeInterner *TypeInterner::Current() noexcept
+{
+	return t_boundInterner;
+}
+
+TypeInterner::Scope::Scope(TypeInterner& interner) noexcept
+	: m_previous{ t_boundInterner }
+{
+	t_boundInterner = std::addressof(interner);
+}
+
+TypeInterner::Scope::~Scope()
+{
+	t_boundInterner = m_previous;
+}
+
+} // namespace CryCC::SubValue::Typedef
@@ -0,0 +1,173 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include <CryCC/SubValue/TypeLayout.h>
+#include <CryCC/SubValue/RecordType.h>
+#include <CryCC/SubValue/ArrayType.h>
+#include <CryCC/SubValue/TypedefType.h>
+
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace CryCC::SubValue::Valuedef
+{
+
+using namespace Typedef;
+
+namespace
+{
+
+// Round offset up to the next multiple of the alignment.
+inline size_t AlignTo(size_t offset, size_t alignment) noexcept
+{
+	return (offset + alignment - 1) / alignment * alignment;
+}
+
+// Cached layout of a canonical type. The entry is stale once the type is released.
+struct LayoutCacheEntry
+{
+	std::weak_ptr<AbstractType> type;
+	std::shared_ptr<const TypeLayout> layout;
+};
+
+// The cache is kept per thread so the lookup requires no lock. Stale
+// entries are dropped when the cache grows past the limit.
+constexpr const size_t layoutCacheLimit = 256;
+thread_local std::unordered_map<const AbstractType *, LayoutCacheEntry> t_layoutCache;
+
+} // namespace
+
+std::shared_ptr<const TypeLayout> TypeLayout::Make(const InternalBaseType& type)
+{
+	if (!type || !type->IsCanonical() || type->TypeId() == TypeVariation::BUILTIN) {
+		return Compute(type);
+	}
+
+	auto it = t_layoutCache.find(type.get());
+	if (it != t_layoutCache.end() && !it->second.type.expired()) {
+		return it->second.layout;
+	}
+
+	auto layout = Compute(type);
+	if (t_layoutCache.size() >= layoutCacheLimit) {
+		for (auto cacheIt = t_layoutCache.begin(); cacheIt != t_layoutCache.end();) {
+			cacheIt = cacheIt->second.type.expired() ? t_layoutCache.erase(cacheIt) : std::next(cacheIt);
+		}
+	}
+
+	t_layoutCache[type.get()] = LayoutCacheEntry{ type, layout };
+	return layout;
+}
+
+std::shared_ptr<const TypeLayout> TypeLayout::Compute(const InternalBaseType& type)
+{
+	if (!type) { return nullptr; }
+
+	auto layout = std::make_shared<TypeLayout>();
+
+	switch (type->TypeId()) {
+	case TypeVariation::BUILTIN: {
+		const auto builtinType = std::static_pointer_cast<BuiltinType>(type);
+		if (builtinType->TypeSpecifier() == Specifier::VOID_T) { return nullptr; }
+
+		layout->m_specifier = builtinType->TypeSpecifier();
+		layout->m_size = builtinType->UnboxedSize();
+		layout->m_alignment = layout->m_size;
+		break;
+	}
+	case TypeVariation::RECORD: {
+		const auto recordType = std::static_pointer_cast<RecordType>(type);
+		const bool isUnion = recordType->TypeSpecifier() == RecordType::Specifier::UNION;
+
+		// Unaligned records are packed, this matches the unboxed size of the type.
+		for (const auto& field : recordType->Fields()) {
+			auto fieldLayout = Make(field.Type());
+			if (!fieldLayout) { return nullptr; }
+
+			const size_t alignment = recordType->IsAligned() ? fieldLayout->Alignment() : 1;
+			const size_t offset = isUnion ? 0 : AlignTo(layout->m_size, alignment);
+			layout->m_size = std::max(layout->m_size, offset + fieldLayout->Size());
+			layout->m_alignment = std::max(layout->m_alignment, alignment);
+			layout->m_fields.push_back(Field{ offset, std::move(fieldLayout) });
+		}
+
+		if (layout->m_fields.empty()) { return nullptr; }
+		layout->m_size = AlignTo(layout->m_size, layout->m_alignment);
+		break;
+	}
+	case TypeVariation::ARRAY: {
+		const auto arrayType = std::static_pointer_cast<ArrayType>(type);
+		if (!arrayType->Order()) { return nullptr; }
+
+		auto elementLayout = Make(arrayType->Type());
+		if (!elementLayout) { return nullptr; }
+
+		layout->m_size = elementLayout->Size() * arrayType->Order();
+		layout->m_alignment = elementLayout->Alignment();
+		layout->m_elementCount = arrayType->Order();
+		layout->m_element = std::move(elementLayout);
+		break;
+	}
+	case TypeVariation::TYPEDEF:
+		return Make(std::static_pointer_cast<TypedefType>(type)->MarkType());
+
+	default:
+		return nullptr;
+	}
+
+	return layout;
+}
+
+TypeLayout::offset_type TypeLayout::FieldOffset(size_type idx) const
+{
+	if (m_element) {
+		if (idx >= m_elementCount) {
+			throw std::out_of_range{ "field index" };
+		}
+		return idx * m_element->Size();
+	}
+
+	return m_fields.at(idx).offset;
+}
+
+const TypeLayout& TypeLayout::FieldLayout(size_type idx) const
+{
+	if (m_element) {
+		if (idx >= m_elementCount) {
+			throw std::out_of_range{ "field index" };
+		}
+		return (*m_element);
+	}
+
+	return (*m_fields.at(idx).layout);
+}
+
+bool TypeLayout::operator==(const TypeLayout& other) const
+{
+	if (m_specifier != other.m_specifier
+		|| m_size != other.m_size
+		|| m_alignment != other.m_alignment
+		|| m_elementCount != other.m_elementCount
+		|| m_fields.size() != other.m_fields.size()
+		|| (m_element == nullptr) != (other.m_element == nullptr)) {
+		return false;
+	}
+
+	if (m_element && m_element != other.m_element && (*m_element) != (*other.m_element)) {
+		return false;
+	}
+
+	return std::equal(m_fields.cbegin(), m_fields.cend(), other.m_fields.cbegin(), [](const Field& lhs, const Field& rhs)
+	{
+		return lhs.offset == rhs.offset && (lhs.layout == rhs.layout || (*lhs.layout) == (*rhs.layout));
+	});
+}
+
+} // namespace CryCC::SubValue::Valuedef
@@ -8,13 +8,36 @@
 
 #include <CryCC/AST/Unique.h>
 
+#include <memory>
 #include <iostream>
 
 namespace CryCC::AST
 {
 
-// Unique object counter initialization.
-int UniqueObj::s_id = DEFAULT_UNIQUE_CTR;
+namespace
+{
+
+// Fallback when no allocator is bound to the thread.
+thread_local UniqueIdAllocator t_defaultAllocator;
+thread_local UniqueIdAllocator *t_boundAllocator = nullptr;
+
+} // namespace
+
+UniqueIdAllocator& UniqueIdAllocator::Current() noexcept
+{
+	return t_boundAllocator ? (*t_boundAllocator) : t_defaultAllocator;
+}
+
+UniqueIdAllocator::Scope::Scope(UniqueIdAllocator& allocator) noexcept
+	: m_previous{ t_boundAllocator }
+{
+	t_boundAllocator = std::addressof(allocator);
+}
+
+UniqueIdAllocator::Scope::~Scope()
+{
+	t_boundAllocator = m_previous;
+}
 
 bool UniqueObj::operator==(const UniqueObj& other) const noexcept
 {
@@ -8,6 +8,7 @@
 
 #include <CryCC/SubValue/Valuedef.h>
 #include <CryCC/SubValue/ValueHelper.h> // << TODO: Maybe remove?
+#include <CryCC/SubValue/BuiltinValue.h>
 
 #include <Cry/Cry.h>
 #include <Cry/ByteOrder.h>
@@ -546,6 +547,9 @@ Value::Value(TypeFacade&& type)
 	: m_internalType{ std::move(type) }
 	, m_valuePtr{ MakeValueProxy<default_value_type>(m_internalType) }
 {
+	// Scalar values are the most common, they should never hit the heap.
+	static_assert(ProxyStorage::is_inline_v<ProxySelector<BuiltinValue>>, "builtin value proxy is not stored inline");
+	static_assert(ProxyStorage::is_inline_v<ProxySelector<NilValue>>, "nil value proxy is not stored inline");
 }
 
 // Initialize with base type only, set value empty.
@@ -557,8 +561,8 @@ Value::Value(TypeFacade::base_type&& type)
 
 Value::Value(const Value& other)
 	: m_internalType{ other.m_internalType }
-	, m_valuePtr{ other.m_valuePtr->Clone() }
 {
+	other.m_valuePtr->CloneInto(m_valuePtr);
 }
 
 const std::string Value::ToString() const noexcept
@@ -571,7 +575,7 @@ void Value::Swap(Value& other) noexcept
 	if (other == *this) { return; }
 
 	m_internalType = other.m_internalType;
-	m_valuePtr = std::move(other.m_valuePtr->Clone());
+	other.m_valuePtr->CloneInto(m_valuePtr);
 }
 
 void Value::Swap(Value&& other) noexcept
@@ -591,7 +595,7 @@ Value& Value::operator=(const Value& other)
 		throw InvalidTypeCastException{};
 	}
 
-	m_valuePtr = std::move(other.m_valuePtr->Clone());
+	other.m_valuePtr->CloneInto(m_valuePtr);
 	return (*this);
 }
 
@@ -13,6 +13,10 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 //
 // Key         : AST
 // Test        : Abstract Syntax Tree unit test
@@ -45,6 +49,32 @@ BOOST_AUTO_TEST_CASE(ASTBasicNode)
 	BOOST_REQUIRE(Util::IsNodeTranslationUnit(node));
 }
 
+BOOST_AUTO_TEST_CASE(ASTUniqueAllocator)
+{
+	UniqueIdAllocator allocator;
+	{
+		UniqueIdAllocator::Scope scope{ allocator };
+
+		auto node1 = Util::MakeASTNode<BreakStmt>();
+		auto node2 = Util::MakeASTNode<ContinueStmt>();
+		BOOST_REQUIRE_EQUAL(DEFAULT_UNIQUE_CTR + 1, node1->Id());
+		BOOST_REQUIRE_EQUAL(DEFAULT_UNIQUE_CTR + 2, node2->Id());
+		BOOST_REQUIRE_EQUAL(0, allocator.Index(node1->Id()));
+		BOOST_REQUIRE_EQUAL(1, allocator.Index(node2->Id()));
+	}
+
+	// Outside the scope the allocator is left untouched.
+	auto node3 = Util::MakeASTNode<BreakStmt>();
+	BOOST_REQUIRE_LT(0, node3->Id());
+	BOOST_REQUIRE_EQUAL(2, allocator.Count());
+
+	// Restored identifiers are taken as handed out.
+	allocator.Advance(DEFAULT_UNIQUE_CTR + 10);
+	BOOST_REQUIRE_EQUAL(DEFAULT_UNIQUE_CTR + 11, allocator.Next());
+	allocator.Advance(DEFAULT_UNIQUE_CTR + 5);
+	BOOST_REQUIRE_EQUAL(DEFAULT_UNIQUE_CTR + 12, allocator.Next());
+}
+
 BOOST_AUTO_TEST_CASE(ASTBasicTree)
 {
 	auto tree = Util::MakeUnitTree("source");
@@ -74,6 +104,65 @@ BOOST_AUTO_TEST_CASE(ASTEmplaceNode)
 	BOOST_REQUIRE_EQUAL(1, arg->ModifierCount());
 }
 
+BOOST_AUTO_TEST_CASE(ASTNodeRelation)
+{
+	auto arg = Util::MakeASTNode<ArgumentStmt>();
+	auto param1 = Util::MakeASTNode<ParamStmt>();
+	arg->AppendArgument(param1);
+	auto param2 = Util::MakeASTNode<ParamStmt>();
+	arg->AppendArgument(param2);
+	BOOST_REQUIRE_EQUAL(arg.get(), param1->ParentNode());
+	BOOST_REQUIRE_EQUAL(param2.get(), arg->ChildNode(1));
+
+	// All handles share a single reference, the child list slot holds another.
+	BOOST_REQUIRE_EQUAL(2, param2->RefCountValue());
+	BOOST_REQUIRE_EQUAL(param2, param2->PolySelf());
+
+	arg->Emplace(1, Util::MakeASTNode<ReturnStmt>());
+	BOOST_REQUIRE(!param2->ParentNode());
+	BOOST_REQUIRE(param2->Parent().expired());
+
+	// A node listed by a second parent survives the first parent.
+	auto compond = Util::MakeASTNode<CompoundStmt>();
+	compond->AppendChild(param1);
+	arg.reset();
+	BOOST_REQUIRE_EQUAL(2, param1->RefCountValue());
+	BOOST_REQUIRE_EQUAL(compond.get(), param1->ParentNode());
+
+	compond.reset();
+	BOOST_REQUIRE_EQUAL(1, param1->RefCountValue());
+	BOOST_REQUIRE(!param1->ParentNode());
+}
+
+BOOST_AUTO_TEST_CASE(ASTNodeRelationShared)
+{
+	auto compond = Util::MakeASTNode<CompoundStmt>();
+	compond->AppendChild(Util::MakeASTNode<ReturnStmt>());
+	ASTNode *node = compond->ChildNode(0);
+	BOOST_REQUIRE_EQUAL(1, node->RefCountValue());
+
+	// Handles are taken and dropped on several threads at once.
+	std::atomic<int> missing{ 0 };
+	std::vector<std::thread> workers;
+	for (int i = 0; i < 4; ++i) {
+		workers.emplace_back([node, &missing]()
+		{
+			for (int j = 0; j < 10000; ++j) {
+				if (!node->PolySelf()) {
+					++missing;
+				}
+			}
+		});
+	}
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	BOOST_REQUIRE_EQUAL(0, missing.load());
+	BOOST_REQUIRE_EQUAL(1, node->RefCountValue());
+	BOOST_REQUIRE_EQUAL(compond.get(), node->ParentNode());
+}
+
 BOOST_AUTO_TEST_CASE(ASTLiteral)
 {
 	static const std::string lstr{ "string" };
@@ -224,6 +313,148 @@ BOOST_AUTO_TEST_CASE(ASTWalker)
 	BOOST_REQUIRE_EQUAL(root, swh);
 }
 
+BOOST_AUTO_TEST_CASE(ASTFlatTree)
+{
+	auto tree = Util::MakeUnitTree("source");
+
+	auto compond1 = Util::MakeASTNode<CompoundStmt>();
+	tree->AppendChild(compond1);
+	auto compond2 = Util::MakeASTNode<CompoundStmt>();
+	tree->AppendChild(compond2);
+	auto stmt = Util::MakeASTNode<ReturnStmt>();
+	compond2->AppendChild(stmt);
+
+	FlatTree flatTree = FlatTree::Freeze(tree.get());
+	BOOST_REQUIRE_EQUAL(4, flatTree.Size());
+	BOOST_REQUIRE_EQUAL(2, flatTree.KindCount(NodeID::COMPOUND_STMT_ID));
+
+	auto root = flatTree.Root();
+	BOOST_REQUIRE(NodeID::TRANSLATION_UNIT_DECL_ID == root.Label());
+	BOOST_REQUIRE(!root.Parent());
+	BOOST_REQUIRE_EQUAL(2, root.ChildrenCount());
+	BOOST_REQUIRE_EQUAL(tree.get(), root.Node());
+
+	auto child1 = root.Child(0);
+	auto child2 = child1.NextSibling();
+	BOOST_REQUIRE(child2 == root.Child(1));
+	BOOST_REQUIRE(!child2.NextSibling());
+	BOOST_REQUIRE(child1.Parent() == root);
+	BOOST_REQUIRE_EQUAL(compond2.get(), child2.As<CompoundStmt>());
+	BOOST_REQUIRE_EQUAL(1, child2.ChildrenCount());
+	BOOST_REQUIRE(NodeID::RETURN_STMT_ID == child2.Child(0).Label());
+	BOOST_REQUIRE(child2.Child(0).Parent() == child2);
+
+	// Deferred function bodies are frozen when the body is requested.
+	auto func = Util::MakeASTNode<FunctionDecl>("func", nullptr);
+	func->SetCompoundLoader([] {
+		auto body = Util::MakeASTNode<CompoundStmt>();
+		body->AppendChild(Util::MakeASTNode<ReturnStmt>());
+		return body;
+	});
+	tree->AppendChild(func);
+	BOOST_REQUIRE(func->HasDeferredCompound());
+	FlatTree deferredTree = FlatTree::Freeze(tree.get());
+	BOOST_REQUIRE(func->HasDeferredCompound());
+	BOOST_REQUIRE(!func->FunctionCompound());
+	BOOST_REQUIRE_EQUAL(flatTree.Size() + 1, deferredTree.Size());
+
+	auto funcHandle = deferredTree.Root().Child(2);
+	BOOST_REQUIRE_EQUAL(func.get(), funcHandle.As<FunctionDecl>());
+	auto body = deferredTree.FunctionBody(funcHandle);
+	BOOST_REQUIRE(!func->HasDeferredCompound());
+	BOOST_REQUIRE(body);
+	BOOST_REQUIRE_EQUAL(func->FunctionCompound().get(), body.As<CompoundStmt>());
+	BOOST_REQUIRE_EQUAL(1, body.ChildrenCount());
+	BOOST_REQUIRE(NodeID::RETURN_STMT_ID == body.Child(0).Label());
+	BOOST_REQUIRE(body == deferredTree.FunctionBody(funcHandle));
+	BOOST_REQUIRE_EQUAL(flatTree.Size() + 1, deferredTree.Size());
+
+	// Bodies which were loaded are part of the frozen tree.
+	FlatTree loadedTree = FlatTree::Freeze(tree.get());
+	BOOST_REQUIRE_EQUAL(flatTree.Size() + 3, loadedTree.Size());
+	auto loadedBody = loadedTree.FunctionBody(loadedTree.Root().Child(2));
+	BOOST_REQUIRE(loadedBody.Parent() == loadedTree.Root().Child(2));
+	BOOST_REQUIRE_EQUAL(func->FunctionCompound().get(), loadedBody.Node());
+}
+
+BOOST_AUTO_TEST_CASE(ASTCast)
+{
+	ASTNodeType compond = Util::MakeASTNode<CompoundStmt>();
+	ASTNodeType varia = Util::MakeASTNode<VariadicDecl>();
+
+	BOOST_REQUIRE(Util::Isa<ASTNode>(compond));
+	BOOST_REQUIRE(Util::Isa<Stmt>(compond));
+	BOOST_REQUIRE(Util::Isa<CompoundStmt>(compond));
+	BOOST_REQUIRE(!Util::Isa<Decl>(compond));
+	BOOST_REQUIRE(Util::Isa<Decl>(varia.get()));
+	BOOST_REQUIRE(!Util::Isa<ParamDecl>(*varia));
+
+	BOOST_REQUIRE_EQUAL(compond.get(), Util::Cast<CompoundStmt>(compond).get());
+	BOOST_REQUIRE_EQUAL(varia.get(), Util::DynCast<Decl>(varia.get()));
+	BOOST_REQUIRE(!Util::DynCast<Stmt>(varia));
+	BOOST_REQUIRE(!Util::DynCast<Stmt>(ASTNodeType{}));
+
+	Compare::Equal<CompoundStmt> eqOp;
+	Compare::Derived<Decl> drivdOp;
+	BOOST_REQUIRE(eqOp(*compond));
+	BOOST_REQUIRE(!eqOp(*varia));
+	BOOST_REQUIRE(drivdOp(*varia));
+	BOOST_REQUIRE(!drivdOp(*compond));
+}
+
+namespace
+{
+
+struct StmtCounter : NodeVisitor<StmtCounter>
+{
+	int stmtCount{ 0 };
+	int declCount{ 0 };
+	int postCount{ 0 };
+
+	bool Visit(Stmt *) { ++stmtCount; return true; }
+	bool Visit(Decl *) { ++declCount; return true; }
+	bool PostVisit(ASTNode *) { ++postCount; return true; }
+};
+
+struct ReturnFinder : NodeVisitor<ReturnFinder>
+{
+	using NodeVisitor<ReturnFinder>::Visit;
+
+	ReturnStmt *stmt{ nullptr };
+
+	bool Visit(ReturnStmt *node) { stmt = node; return false; }
+};
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(ASTNodeVisitor)
+{
+	auto tree = Util::MakeUnitTree("source");
+	auto compond1 = Util::MakeASTNode<CompoundStmt>();
+	tree->AppendChild(compond1);
+	auto compond2 = Util::MakeASTNode<CompoundStmt>();
+	tree->AppendChild(compond2);
+	auto stmt = Util::MakeASTNode<ReturnStmt>();
+	compond2->AppendChild(stmt);
+	compond2->AppendChild(Util::MakeASTNode<BreakStmt>());
+
+	StmtCounter counter;
+	BOOST_REQUIRE(counter.Traverse(tree.get()));
+	BOOST_REQUIRE_EQUAL(4, counter.stmtCount);
+	BOOST_REQUIRE_EQUAL(1, counter.declCount);
+	BOOST_REQUIRE_EQUAL(5, counter.postCount);
+
+	ReturnFinder finder;
+	BOOST_REQUIRE(!finder.Traverse(tree.get()));
+	BOOST_REQUIRE_EQUAL(stmt.get(), finder.stmt);
+
+	FlatTree flatTree = FlatTree::Freeze(tree.get());
+	StmtCounter flatCounter;
+	BOOST_REQUIRE(flatCounter.Traverse(flatTree));
+	BOOST_REQUIRE_EQUAL(4, flatCounter.stmtCount);
+	BOOST_REQUIRE_EQUAL(1, flatCounter.declCount);
+}
+
 BOOST_AUTO_TEST_CASE(ASTMisc)
 {
 	std::shared_ptr<CompoundStmt> compond = Util::MakeASTNode<CompoundStmt>();
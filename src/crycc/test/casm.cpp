@@ -0,0 +1,154 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include <CryCC/Program/Casm.h>
+
+#include <Cry/Except.h>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace CryCC::Program::Casm;
+
+namespace
+{
+
+// Build function returning the first constant.
+Function MakeFunction(const std::string& name)
+{
+	Function function;
+	function.name = name;
+	function.returnKind = SlotKind::INTEGER;
+	function.frameSize = 1;
+	function.layout.push_back(SlotInfo{ "i", SlotKind::INTEGER, 0, 1 });
+	function.code = {
+		static_cast<Word>(Opcode::LOADK), 0, 0,
+		static_cast<Word>(Opcode::RET), 0,
+	};
+	return function;
+}
+
+} // namespace
+
+//
+// Key         : Casm
+// Test        : Register bytecode module unit test
+// Type        : unit
+// Description : Test the bytecode module constant pool, the
+//               verifier and the module serialization.
+//
+
+BOOST_AUTO_TEST_SUITE(Casm)
+
+BOOST_AUTO_TEST_CASE(CasmConstantPool)
+{
+	Module module;
+
+	BOOST_REQUIRE_EQUAL(0, module.AddConstant(7));
+	BOOST_REQUIRE_EQUAL(1, module.AddConstant(7.0));
+	BOOST_REQUIRE_EQUAL(2, module.AddConstant(std::string{ "7" }));
+	BOOST_REQUIRE_EQUAL(0, module.AddConstant(7));
+	BOOST_REQUIRE_EQUAL(1, module.AddConstant(7.0));
+	BOOST_REQUIRE_EQUAL(2, module.AddConstant(std::string{ "7" }));
+	BOOST_REQUIRE_EQUAL(3, module.Constants().size());
+}
+
+BOOST_AUTO_TEST_CASE(CasmVerify)
+{
+	// Valid module.
+	{
+		Module module;
+		module.AddConstant(12);
+		module.AddFunction(MakeFunction("main"));
+
+		BOOST_REQUIRE_NO_THROW(module.Verify());
+		BOOST_REQUIRE_EQUAL(0, module.FindFunction("main"));
+		BOOST_REQUIRE_EQUAL(Module::npos, module.FindFunction("start"));
+	}
+
+	// Constant out of bounds.
+	{
+		Module module;
+		module.AddFunction(MakeFunction("main"));
+
+		BOOST_REQUIRE_THROW(module.Verify(), Cry::Except::IncompatibleException);
+	}
+
+	// Register out of bounds.
+	{
+		Module module;
+		module.AddConstant(12);
+		auto function = MakeFunction("main");
+		function.code[1] = 1;
+		module.AddFunction(std::move(function));
+
+		BOOST_REQUIRE_THROW(module.Verify(), Cry::Except::IncompatibleException);
+	}
+
+	// Jump into instruction.
+	{
+		Module module;
+		module.AddConstant(12);
+		auto function = MakeFunction("main");
+		function.code.insert(function.code.begin(), { static_cast<Word>(Opcode::JMP), 3 });
+		module.AddFunction(std::move(function));
+
+		BOOST_REQUIRE_THROW(module.Verify(), Cry::Except::IncompatibleException);
+	}
+
+	// Function falls off the end.
+	{
+		Module module;
+		module.AddConstant(12);
+		auto function = MakeFunction("main");
+		function.code.resize(3);
+		module.AddFunction(std::move(function));
+
+		BOOST_REQUIRE_THROW(module.Verify(), Cry::Except::IncompatibleException);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(CasmSerialize)
+{
+	Module module;
+	module.AddConstant(12);
+	module.AddConstant(3.5);
+	module.AddConstant(std::string{ "printf" });
+	module.AddGlobal("counter", SlotKind::INTEGER);
+	module.AddFunction(MakeFunction("main"));
+
+	Cry::ByteArray buffer;
+	Module::Serialize(module, buffer);
+
+	buffer.StartOffset(0);
+	Module module2;
+	Module::Deserialize(module2, buffer);
+
+	BOOST_REQUIRE_EQUAL(3, module2.Constants().size());
+	BOOST_REQUIRE(module.Constants() == module2.Constants());
+	BOOST_REQUIRE_EQUAL(1, module2.Globals().size());
+	BOOST_REQUIRE_EQUAL(1, module2.GlobalSize());
+	BOOST_REQUIRE_EQUAL(0, module2.FindGlobal("counter"));
+	BOOST_REQUIRE_EQUAL(1, module2.Functions().size());
+	BOOST_REQUIRE_EQUAL(Module::npos, module2.Initializer());
+
+	const auto& function = module2.Functions().front();
+	BOOST_REQUIRE_EQUAL("main", function.name);
+	BOOST_REQUIRE(SlotKind::INTEGER == function.returnKind);
+	BOOST_REQUIRE_EQUAL(1, function.frameSize);
+	BOOST_REQUIRE_EQUAL(1, function.layout.size());
+	BOOST_REQUIRE(module.Functions().front().code == function.code);
+
+	// Truncated stream.
+	Cry::ByteArray truncated = buffer;
+	truncated.resize(truncated.size() - 4);
+	truncated.StartOffset(0);
+	Module module3;
+	BOOST_REQUIRE_THROW(Module::Deserialize(module3, truncated), std::exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -25,6 +25,7 @@
 //   5.) ArrayType.
 //   6.) RecordType.
 //   7.) VariadicType.
+//   8.) TypeInterner.
 
 using namespace CryCC::SubValue::Typedef;
 
@@ -398,4 +399,63 @@ BOOST_AUTO_TEST_CASE(TypeCatVariadicTypeMisc)
 	BOOST_REQUIRE(tyVar == tyMove);
 }
 
+//
+// TypeInterner.
+//
+
+BOOST_AUTO_TEST_CASE(TypeCatTypeInterner)
+{
+	TypeInterner interner;
+
+	auto tyInt = interner.Intern(Util::MakeBuiltinType(BuiltinType::Specifier::INT_T));
+	auto tyInt2 = interner.Intern(Util::MakeBuiltinType(BuiltinType::Specifier::INT_T));
+	auto tyChar = interner.Intern(Util::MakeBuiltinType(BuiltinType::Specifier::CHAR_T));
+
+	BOOST_REQUIRE(tyInt->IsCanonical());
+	BOOST_REQUIRE_EQUAL(tyInt.get(), tyInt2.get());
+	BOOST_REQUIRE_NE(tyInt.get(), tyChar.get());
+	BOOST_REQUIRE(TypeInterner::IsSameInterner(*tyInt, *tyChar));
+
+	auto tyArInt = interner.Intern(Util::MakeArrayType(4, tyInt));
+	auto tyArInt2 = interner.Intern(Util::MakeArrayType(4, tyInt2));
+	auto tyArInt3 = interner.Intern(Util::MakeArrayType(8, tyInt));
+	BOOST_REQUIRE_EQUAL(tyArInt.get(), tyArInt2.get());
+	BOOST_REQUIRE_NE(tyArInt.get(), tyArInt3.get());
+
+	auto tyConstInt = Util::MakeBuiltinType(BuiltinType::Specifier::INT_T);
+	tyConstInt->SetQualifier(AbstractType::TypeQualifier::CONST_T);
+	BOOST_REQUIRE_NE(interner.Intern(tyConstInt).get(), tyInt.get());
+
+	BOOST_REQUIRE_EQUAL(interner.Size(), 5);
+	BOOST_REQUIRE_EQUAL(interner.HitCount(), 2);
+	BOOST_REQUIRE_GT(interner.BytesSaved(), 0);
+
+	// A copy of a canonical type is a regular type.
+	BuiltinType tyCopy{ static_cast<const BuiltinType&>(*tyInt) };
+	BOOST_REQUIRE(!tyCopy.IsCanonical());
+
+	TypeInterner interner2;
+	auto tyOtherInt = interner2.Intern(Util::MakeBuiltinType(BuiltinType::Specifier::INT_T));
+	BOOST_REQUIRE(!TypeInterner::IsSameInterner(*tyInt, *tyOtherInt));
+
+	// Canonical types cannot be altered, the copy can.
+	BOOST_REQUIRE_THROW(tyInt->SetQualifier(AbstractType::TypeQualifier::CONST_T), CanonicalTypeException);
+	tyCopy.SetQualifier(AbstractType::TypeQualifier::CONST_T);
+
+	// The canonical types move along with the table.
+	TypeInterner interner3{ std::move(interner) };
+	BOOST_REQUIRE_EQUAL(interner3.Intern(Util::MakeBuiltinType(BuiltinType::Specifier::INT_T)).get(), tyInt.get());
+	BOOST_REQUIRE_EQUAL(interner3.Intern(tyInt).get(), tyInt.get());
+	BOOST_REQUIRE_EQUAL(interner.Size(), 0);
+	BOOST_REQUIRE_NE(interner.Generation(), interner3.Generation());
+	BOOST_REQUIRE(!TypeInterner::IsSameInterner(*interner.Intern(Util::MakeBuiltinType(BuiltinType::Specifier::INT_T)), *tyInt));
+
+	BOOST_REQUIRE(!TypeInterner::Current());
+	{
+		TypeInterner::Scope scope{ interner3 };
+		BOOST_REQUIRE_EQUAL(TypeInterner::Current(), &interner3);
+	}
+	BOOST_REQUIRE(!TypeInterner::Current());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
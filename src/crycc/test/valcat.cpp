@@ -272,6 +272,30 @@ BOOST_AUTO_TEST_CASE(ValCatArrayValueIterable)
 	BOOST_REQUIRE_EQUAL(77, valArInt.At<int>(6));
 }
 
+BOOST_AUTO_TEST_CASE(ValCatArrayValueElement)
+{
+	using namespace CryCC::SubValue::Typedef;
+
+	Value value{ Util::MakeArrayType(8, Util::MakeBuiltinType(BuiltinType::Specifier::SHORT_T)), ArrayValue{} };
+	auto& array = value.As<ArrayValue>()->NativeValue();
+	array.AssignElement(3, Util::MakeInt(912));
+	array.AssignElement<false>(7, Util::MakeChar('a'));
+
+	BOOST_REQUIRE_EQUAL(array.At<short>(3), 912);
+	BOOST_REQUIRE_EQUAL(Util::ValueCastNative<short>(array.ElementValue(3)), 912);
+	BOOST_REQUIRE_EQUAL(Util::ValueCastNative<short>(array.ElementValue<false>(7)), 'a');
+	BOOST_REQUIRE_EQUAL(Util::ValueCastNative<short>(array.ElementValue(0)), 0);
+	BOOST_REQUIRE_THROW(array.ElementValue(8), OutOfBoundsException);
+	BOOST_REQUIRE_THROW(array.AssignElement(8, Util::MakeInt(1)), OutOfBoundsException);
+
+	array.AlterElement(3, [](auto element) { return element + 88; });
+	array.AlterElement<false>(7, [](auto element) { return element - 1; });
+
+	BOOST_REQUIRE_EQUAL(array.At<short>(3), 1000);
+	BOOST_REQUIRE_EQUAL(array.At<short>(7), 'a' - 1);
+	BOOST_REQUIRE_THROW(array.AlterElement(8, [](auto element) { return element; }), OutOfBoundsException);
+}
+
 BOOST_AUTO_TEST_CASE(ValCatArrayValueMisc)
 {
 	ArrayValue valArInt{ 1,2,3,4,5,6,7,8,9,0 };
@@ -287,6 +311,80 @@ BOOST_AUTO_TEST_CASE(ValCatArrayValueMisc)
 	BOOST_REQUIRE(!(valArInt == valMove));
 }
 
+BOOST_AUTO_TEST_CASE(ValCatArrayValueComposite)
+{
+	using namespace CryCC::SubValue::Typedef;
+
+	auto intType = Util::MakeBuiltinType(BuiltinType::Specifier::INT_T);
+	auto doubleType = Util::MakeBuiltinType(BuiltinType::Specifier::DOUBLE_T);
+	auto pairType = Util::MakeArrayType(2, intType);
+
+	auto recordType = std::make_shared<RecordType>("somestruct");
+	recordType->AddField("someint", intType);
+	recordType->AddField("somedouble", doubleType);
+	recordType->AddField("somepair", pairType);
+
+	auto layout = TypeLayout::Make(recordType);
+	BOOST_REQUIRE(layout);
+	BOOST_REQUIRE(!layout->IsScalar());
+	BOOST_REQUIRE_EQUAL(layout->FieldCount(), 3);
+	BOOST_REQUIRE_EQUAL(layout->Size(), recordType->UnboxedSize());
+	BOOST_REQUIRE_EQUAL(layout->FieldOffset(1), sizeof(int));
+	BOOST_REQUIRE_EQUAL(layout->FieldLayout(2).FieldCount(), 2);
+	BOOST_REQUIRE(!TypeLayout::Make(Util::MakePointerType(intType)));
+
+	CompositeArray composite{ layout, 4 };
+	BOOST_REQUIRE_EQUAL(composite.Size(), 4);
+	BOOST_REQUIRE_EQUAL(composite.ByteSize(), layout->Size() * 4);
+
+	auto element = composite.Element(2);
+	element.SetField<int>(0, 12);
+	element.SetField<double>(1, 8734.823123);
+	element.Member(2).SetField<int>(1, 77);
+
+	const CompositeArray& compositeRef = composite;
+	BOOST_REQUIRE_EQUAL(compositeRef.Element(2).Field<int>(0), 12);
+	BOOST_REQUIRE_EQUAL(compositeRef.Element(2).Field<double>(1), 8734.823123);
+	BOOST_REQUIRE_EQUAL(compositeRef.Element(2).Member(2).Field<int>(1), 77);
+	BOOST_REQUIRE_EQUAL(compositeRef.Element(1).Field<int>(0), 0);
+	BOOST_REQUIRE_THROW(compositeRef.Element(2).Field<double>(0), InvalidTypeCastException);
+	BOOST_REQUIRE_THROW(compositeRef.Element(4), OutOfBoundsException);
+
+	CompositeArray compositeCopy{ std::vector<Cry::Byte>{ composite.Data(), composite.Data() + composite.ByteSize() }, 4 };
+	BOOST_REQUIRE(!compositeCopy.HasLayout());
+	compositeCopy.BindLayout(layout);
+	BOOST_REQUIRE(compositeCopy == composite);
+	BOOST_REQUIRE_EQUAL(compositeCopy.Element(2).Member(2).Field<int>(1), 77);
+
+	// Elements in contiguous storage are accessed as value.
+	Value value{ Util::MakeArrayType(4, recordType), ArrayValue{} };
+	auto& array = value.As<ArrayValue>()->NativeValue();
+	auto elementValue = array.At(2);
+	BOOST_REQUIRE(Util::Isa<RecordValue>(elementValue));
+	BOOST_REQUIRE_EQUAL(Util::ValueCastNative<int>(elementValue.Member<RecordValue>(0)), 0);
+
+	elementValue.Member<RecordValue>(0) = Util::MakeInt(12);
+	array.Emplace(2, elementValue);
+	BOOST_REQUIRE_EQUAL(array.Element(2).Field<int>(0), 12);
+	BOOST_REQUIRE_EQUAL(array.Element(1).Field<int>(0), 0);
+
+	auto recordValue = array.ElementValue(2);
+	BOOST_REQUIRE_EQUAL(Util::ValueCastNative<int>(recordValue.Member<RecordValue>(0)), 12);
+
+	// Fields are accessed in place.
+	array.AssignElementField(3, 1, Util::MakeDouble(1.5));
+	array.AssignElementField(3, 0, Util::MakeInt(4));
+	BOOST_REQUIRE_EQUAL(array.Element(3).Field<double>(1), 1.5);
+	BOOST_REQUIRE_EQUAL(Util::ValueCastNative<int>(array.ElementField(3, 0)), 4);
+	BOOST_REQUIRE_EQUAL(Util::ValueCastNative<double>(array.ElementField(3, 1)), 1.5);
+	BOOST_REQUIRE_EQUAL(Util::ValueCastNative<int>(array.ElementField(2, 0)), 12);
+	BOOST_REQUIRE(Util::Isa<ArrayValue>(array.ElementField(2, 2)));
+	BOOST_REQUIRE_THROW(array.ElementField(2, 3), OutOfBoundsException);
+	BOOST_REQUIRE_THROW(array.ElementField(4, 0), OutOfBoundsException);
+	BOOST_REQUIRE_THROW(array.At<int>(2), InvalidTypeCastException);
+	BOOST_REQUIRE_THROW(array.At(4), OutOfBoundsException);
+}
+
 //
 // RecordValue.
 //
@@ -301,6 +399,23 @@ BOOST_AUTO_TEST_CASE(ValCatRecordValue)
 		BOOST_REQUIRE_EQUAL(record.Size(), 1);
 	}
 
+	// Access record field in place.
+	{
+		RecordValue record;
+		record.AddField(0, Util::MakeInt(12));
+		record.AddField(1, Util::MakeInt(7));
+		record.Member(1) = Util::MakeInt(77);
+
+		BOOST_REQUIRE_EQUAL(Util::ValueCastNative<int>(record.At(0)), 12);
+		BOOST_REQUIRE_EQUAL(Util::ValueCastNative<int>(record.At(1)), 77);
+		BOOST_REQUIRE_THROW(record.Member(2), OutOfBoundsException);
+
+		// Fields are added in order, an existing field is replaced.
+		record.AddField(1, Util::MakeInt(8));
+		BOOST_REQUIRE_EQUAL(Util::ValueCastNative<int>(record.At(1)), 8);
+		BOOST_REQUIRE_THROW(record.AddField(3, Util::MakeInt(1)), OutOfBoundsException);
+	}
+
 	//TODO: FIXME: Rewrite the RecordValue::Compare()
 
 	// Compare records.
@@ -396,6 +396,16 @@ BOOST_AUTO_TEST_CASE(ValueArithOperators)
 		BOOST_REQUIRE_EQUAL(21, Util::ValueCastNative<int>(valResult));
 	}
 
+	// Mixed and equal integer operands.
+	{
+		auto valInt = Util::MakeInt(7612);
+		auto valInt2 = Util::MakeInt(-12);
+		auto valShort = Util::MakeShort(8);
+
+		BOOST_REQUIRE_EQUAL(7600, Util::ValueCastNative<int>(valInt + valInt2));
+		BOOST_REQUIRE_EQUAL(-96, Util::ValueCastNative<int>(valInt2 * valShort));
+	}
+
 	// Modulo.
 	{
 		// TODO:
@@ -416,6 +426,33 @@ BOOST_AUTO_TEST_CASE(ValueArithOperators)
 	}
 }
 
+BOOST_AUTO_TEST_CASE(ValueInlineStorage)
+{
+	// Scalar values are stored inline.
+	{
+		Value val = Util::MakeInt(7122);
+		Value val2{ val };
+		Value val3{ std::move(val) };
+		val2 = Util::MakeInt(12);
+
+		BOOST_REQUIRE_EQUAL(7122, (val3.As<BuiltinValue, int>()));
+		BOOST_REQUIRE_EQUAL(12, (val2.As<BuiltinValue, int>()));
+		BOOST_REQUIRE(val3 == Util::MakeInt(7122));
+	}
+
+	// Mixed inline and heap values.
+	{
+		std::vector<Value> list;
+		for (int i = 0; i < 32; ++i) {
+			list.push_back(Util::MakeInt(i));
+			list.push_back(Util::MakeIntArray({ i, i + 1 }));
+		}
+
+		BOOST_REQUIRE_EQUAL(31, (list[62].As<BuiltinValue, int>()));
+		BOOST_REQUIRE_EQUAL(2, list[63].ElementCount<ArrayValue>());
+	}
+}
+
 BOOST_AUTO_TEST_CASE(ValueReworkSerialize)
 {
 	using namespace Util;
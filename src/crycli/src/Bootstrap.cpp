@@ -43,6 +43,7 @@ class StreamReaderAdapter final
 		info.api_ref = COILCLAPIVER;
 		info.code_opt.standard = cil_standard::c99;
 		info.code_opt.optimization = optimization::NONE;
+		info.code_opt.emit_bytecode = m_emitBytecode ? 1 : 0;
 		info.streamReaderVPtr = &CCBFetchChunk;
 		info.loadStreamRequestVPtr = &CCBLoadExternalSource;
 		info.streamMetaVPtr = &CCBMetaInfo;
@@ -69,6 +70,12 @@ class StreamReaderAdapter final
 		m_chunkSize = size;
 	}
 
+	// Set bytecode emission.
+	void SetBytecodeEmission(bool emit)
+	{
+		m_emitBytecode = emit;
+	}
+
 public:
 	StreamReaderAdapter(const BaseReader&& reader, size_t size)
 		: m_contentReader{ std::move(reader) }
@@ -102,6 +109,7 @@ public:
 private:
 	const BaseReader&& m_contentReader;
 	size_t m_chunkSize = defaultChunkSize;
+	bool m_emitBytecode = false;
 };
 
 namespace Cry
@@ -203,6 +211,12 @@ CompilerAbstraction& CompilerAbstraction::SetBuffer(size_t size)
 	return (*this);
 }
 
+CompilerAbstraction& CompilerAbstraction::EmitBytecode(bool emit)
+{
+	m_compiler->SetBytecodeEmission(emit);
+	return (*this);
+}
+
 //TODO: ugly refactor & move into Direct
 void GetSectionMemoryBlock(const char *tag, void *programRaw, std::function<void(const char *, size_t)> callback)
 {
@@ -29,6 +29,9 @@ class CompilerContract
 
 	// Set stream chunk size.
 	virtual void SetStreamChuckSize(size_t) = 0;
+
+	// Lower the program into bytecode.
+	virtual void SetBytecodeEmission(bool) = 0;
 };
 
 struct CompilerAbstraction
@@ -43,6 +46,9 @@ struct CompilerAbstraction
 	// can be ignored and should bot be relied upon.
 	virtual CompilerAbstraction& SetBuffer(size_t);
 
+	// Emit the program as register bytecode next to the program tree.
+	virtual CompilerAbstraction& EmitBytecode(bool);
+
 private:
 	CompilerContract * m_compiler{ nullptr };
 };
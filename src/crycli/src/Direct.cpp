@@ -105,6 +105,15 @@ public:
 		return (*this);
 	}
 
+	// Apply the environment runtime options.
+	Executor& Configure(const Env& env)
+	{
+		m_execEnv.BoundsCheck(!env.IsUnchecked());
+		m_execEnv.Jit(!env.IsNoJit());
+		m_execEnv.Profile(env.ProfileFile());
+		return (*this);
+	}
+
 	// Run the program in a runtime executor.
 	Executor& Run(const std::vector<std::string>& arguments)
 	{
@@ -124,12 +133,12 @@ public:
 // Direct API call to run a single file.
 int RunSourceFile(Env& env, const std::string& sourceFile, const std::vector<std::string>& arguments)
 {
-	CRY_UNUSED(env);
 	try {
 		BaseReader reader = MakeReader<FileReader>(sourceFile);
-		auto program = CompilerAbstraction{ std::move(reader) }.Start();
+		auto program = CompilerAbstraction{ std::move(reader) }.EmitBytecode(env.Target() == "CASM").Start();
 		return Executor{ std::move(program) }
 			.AssertProgram()
+			.Configure(env)
 			.Run(arguments)
 			.ReturnCode();
 	}
@@ -154,12 +163,12 @@ int RunSourceFile(Env& env, const std::vector<std::string>& sourceFiles, const s
 // Direct API call to run source from memory.
 int RunMemoryString(Env& env, const std::string& content, const std::vector<std::string>& arguments)
 {
-	CRY_UNUSED(env);
 	try {
 		BaseReader reader = MakeReader<StringReader>(content);
-		auto program = CompilerAbstraction{ std::move(reader) }.SetBuffer(256).Start();
+		auto program = CompilerAbstraction{ std::move(reader) }.SetBuffer(256).EmitBytecode(env.Target() == "CASM").Start();
 		return Executor{ std::move(program) }
 			.AssertProgram()
+			.Configure(env)
 			.Run(arguments)
 			.ReturnCode();
 	}
@@ -180,7 +189,7 @@ class CEXWriter final
 	const std::string m_cexFile;
 
 public:
-	CEXWriter(const std::string& filename, ProgramWrapper&& program)
+	CEXWriter(const std::string& filename, const std::string& target, ProgramWrapper&& program)
 		: m_cexFile{ filename }
 		, m_program{ std::move(program) }
 	{
@@ -191,7 +200,7 @@ public:
 			file.open(m_cexFile, std::ios_base::binary);
 			assert(file.is_open());
 
-			GetSectionMemoryBlock("AIIPX", (*m_program),
+			GetSectionMemoryBlock(target.c_str(), (*m_program),
 				[&file](const char *buffer, size_t sz) {
 				file.write(buffer, sz);
 			});
@@ -205,8 +214,8 @@ int CompileSourceFile(Env& env, const std::string& sourceFile)
 {
 	try {
 		BaseReader reader = MakeReader<FileReader>(sourceFile);
-		auto program = CompilerAbstraction{ std::move(reader) }.Start();
-		CEXWriter{ env.ImageName(), std::move(program) };
+		auto program = CompilerAbstraction{ std::move(reader) }.EmitBytecode(env.Target() == "CASM").Start();
+		CEXWriter{ env.ImageName(), env.Target(), std::move(program) };
 	}
 	// Catch any missed exceptions.
 	catch (const std::exception& e) {
@@ -232,8 +241,8 @@ int CompileMemoryString(Env& env, const std::string& m_sourceFile)
 {
 	try {
 		BaseReader reader = MakeReader<StringReader>(m_sourceFile);
-		auto program = CompilerAbstraction{ std::move(reader) }.SetBuffer(256).Start();
-		CEXWriter{ env.ImageName(), std::move(program) };
+		auto program = CompilerAbstraction{ std::move(reader) }.SetBuffer(256).EmitBytecode(env.Target() == "CASM").Start();
+		CEXWriter{ env.ImageName(), env.Target(), std::move(program) };
 	}
 	// Catch any missed exceptions.
 	catch (const std::exception& e) {
@@ -21,7 +21,11 @@ class Env
 {
 	bool debugMode{ false };
 	bool safeMode{ false };
+	bool uncheckedMode{ false };
+	bool noJitMode{ false };
 	int debugLevel{ 0 };
+	std::string profileFile;
+	std::string targetName{ "AIIPX" };
 	fs::path imageFile;
 	std::vector<fs::path> includePaths; // Source header include paths
 	std::vector<fs::path> standardPaths; // Standard library paths
@@ -60,5 +64,53 @@ public:
 	{
 		debugMode = toggle;
 	}
+
+	// Skip runtime bounds checks.
+	inline void SetUnchecked(bool toggle) noexcept
+	{
+		uncheckedMode = toggle;
+	}
+
+	// Query if runtime bounds checks are skipped.
+	inline bool IsUnchecked() const noexcept
+	{
+		return uncheckedMode;
+	}
+
+	// Skip native code generation.
+	inline void SetNoJit(bool toggle) noexcept
+	{
+		noJitMode = toggle;
+	}
+
+	// Query if native code generation is skipped.
+	inline bool IsNoJit() const noexcept
+	{
+		return noJitMode;
+	}
+
+	// Set the profile output file.
+	inline void SetProfileFile(const std::string& file)
+	{
+		profileFile = file;
+	}
+
+	// Query the profile output file, empty if not profiling.
+	inline const std::string& ProfileFile() const noexcept
+	{
+		return profileFile;
+	}
+
+	// Set the output target.
+	inline void SetTarget(const std::string& target)
+	{
+		targetName = target;
+	}
+
+	// Query the output target.
+	inline const std::string& Target() const noexcept
+	{
+		return targetName;
+	}
 };
 
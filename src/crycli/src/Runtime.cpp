@@ -56,6 +56,11 @@ class ExecuteAdapter final
 		settings.args = nullptr;
 		settings.envs = nullptr;
 		settings.user_data = static_cast<void*>(this);
+		settings.cfg = {};
+		settings.cfg.disable_bounds_check = !m_boundsCheck;
+		settings.cfg.disable_jit = !m_jit;
+		settings.cfg.enable_profiler = !m_profileFile.empty();
+		settings.profile_file = m_profileFile.empty() ? nullptr : m_profileFile.c_str();
 
 		// Assign program arguments.
 		MapProgramArguments(&settings);
@@ -88,6 +93,24 @@ class ExecuteAdapter final
 		entrySymbol = str;
 	}
 
+	// Set array bounds checks.
+	void SetBoundsCheck(bool toggle)
+	{
+		m_boundsCheck = toggle;
+	}
+
+	// Set native code generation.
+	void SetJit(bool toggle)
+	{
+		m_jit = toggle;
+	}
+
+	// Set profile output file.
+	void SetProfile(const std::string& file)
+	{
+		m_profileFile = file;
+	}
+
 	// Map program arguments from the arguments list into a datalist.
 	void MapProgramArguments(runtime_settings_t *settings)
 	{
@@ -120,6 +143,9 @@ private:
 	ArgumentList m_args;
 	program_t m_program;
 	const char *entrySymbol{ nullptr };
+	bool m_boundsCheck{ true };
+	bool m_jit{ true };
+	std::string m_profileFile;
 };
 
 void CCBErrorHandler(void *user_data, const char *message, int fatal)
@@ -162,6 +188,24 @@ ExecutionEnv& ExecutionEnv::EntryPoint(const std::string& str)
 	return (*this);
 }
 
+ExecutionEnv& ExecutionEnv::BoundsCheck(bool toggle)
+{
+	m_virtualMachine->SetBoundsCheck(toggle);
+	return (*this);
+}
+
+ExecutionEnv& ExecutionEnv::Jit(bool toggle)
+{
+	m_virtualMachine->SetJit(toggle);
+	return (*this);
+}
+
+ExecutionEnv& ExecutionEnv::Profile(const std::string& file)
+{
+	m_virtualMachine->SetProfile(file);
+	return (*this);
+}
+
 ExecutionEnv::RunResult ExecutionEnv::ExecuteProgram(const ArgumentList args)
 {
 	if (!args.empty()) {
@@ -30,6 +30,15 @@ class VMContract
 
 	// Set symbol as entry point.
 	virtual void SetEntryPoint(const char *) = 0;
+
+	// Toggle array bounds checks.
+	virtual void SetBoundsCheck(bool) = 0;
+
+	// Toggle native code generation.
+	virtual void SetJit(bool) = 0;
+
+	// Set profile output file, empty to disable the profiler.
+	virtual void SetProfile(const std::string&) = 0;
 };
 
 class ExecutionEnv
@@ -49,6 +58,12 @@ public:
 	ExecutionEnv& Setup();
 	// Provide program main entry point.
 	ExecutionEnv& EntryPoint(const std::string&);
+	// Enable or disable array bounds checks.
+	ExecutionEnv& BoundsCheck(bool);
+	// Enable or disable native code generation.
+	ExecutionEnv& Jit(bool);
+	// Profile the program into the output file, if any.
+	ExecutionEnv& Profile(const std::string&);
 	// Run the program.
 	RunResult ExecuteProgram(const ArgumentList = {});
 
@@ -22,6 +22,7 @@
 
 // Language includes.
 #include <iostream>
+#include <stdexcept>
 
 #define SPECIFICATION_FILE "default.spec"
 
@@ -42,6 +43,9 @@ int main(int argc, const char *argv[])
 			("spec", po::value<std::string>()->value_name("<file>"), "Load specifications from file")
 			("plugin", po::value<std::string>()->value_name("<plugin>"), "Load compiler plugin")
 			("run", "Compile and execute")
+			("unchecked", "Execute without array bounds checks")
+			("no-jit", "Execute bytecode without native code generation")
+			("profile", po::value<std::string>()->value_name("<file>")->implicit_value("profile"), "Profile the interpreter, writes <file>.txt and <file>.folded")
 			("args", po::value<std::vector<std::string>>()->value_name("<arg>"), "Runner arguments");
 
 		// Compiler options.
@@ -110,6 +114,30 @@ int main(int argc, const char *argv[])
 			env.SetDebug(true);
 		}
 
+		// Skip runtime checks.
+		if (vm.count("unchecked")) {
+			env.SetUnchecked(true);
+		}
+
+		// Skip native code generation.
+		if (vm.count("no-jit")) {
+			env.SetNoJit(true);
+		}
+
+		// Profile program execution.
+		if (vm.count("profile")) {
+			env.SetProfileFile(vm["profile"].as<std::string>());
+		}
+
+		// Set output target.
+		if (vm.count("T")) {
+			const auto target = vm["T"].as<std::string>();
+			if (target != "AIIPX" && target != "CASM") {
+				throw std::invalid_argument{ "unknown output target '" + target + "'" };
+			}
+			env.SetTarget(target);
+		}
+
 		// Set image output name.
 		if (vm.count("out")) {
 			env.SetImageName(vm["out"].as<std::string>());
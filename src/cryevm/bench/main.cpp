@@ -0,0 +1,17 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include <Cry/Benchmark.h>
+
+//
+// Key         : Bench
+// Description : Virtual machine benchmarks. Pass a name filter as
+//               the first argument to run a subset of the benchmarks.
+//
+
+CRY_BENCHMARK_MAIN()
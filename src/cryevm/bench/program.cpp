@@ -0,0 +1,368 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include <cprg.h>
+#include <CoilCl/coilcl.h>
+#include <CryEVM/evm.h>
+
+#include <Cry/Benchmark.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <stdexcept>
+
+//
+// Key         : Program
+// Description : Measure the interpreter throughput on complete programs. The
+//               program is compiled once and executed for each iteration, which
+//               includes the virtual machine setup. Each program is executed
+//               with and without array bounds checks. The bytecode variants
+//               run the same program in the register machine instead of the
+//               tree walking interpreter, the native variants run the
+//               bytecode as native code. The throughput variants run many
+//               small programs, one after another and concurrently on a
+//               thread pool.
+//
+
+namespace
+{
+
+// Sieve of Eratosthenes, returns the number of primes below 8192.
+const char *g_sieveSource = ""
+	"int main() {\n"
+	"	int sieve[8192];\n"
+	"	int count = 0;\n"
+	"	for (int i = 2; i < 8192; i++) {\n"
+	"		if (sieve[i] == 0) {\n"
+	"			count = count + 1;\n"
+	"			for (int j = i * i; j < 8192; j = j + i) {\n"
+	"				sieve[j] = 1;\n"
+	"			}\n"
+	"		}\n"
+	"	}\n"
+	"	return count;\n"
+	"}";
+
+// Multiply two 16x16 matrices stored in row major order.
+const char *g_matmulSource = ""
+	"int main() {\n"
+	"	int a[256];\n"
+	"	int b[256];\n"
+	"	int c[256];\n"
+	"	for (int i = 0; i < 256; i++) {\n"
+	"		a[i] = i % 7;\n"
+	"		b[i] = i % 5;\n"
+	"	}\n"
+	"	for (int i = 0; i < 16; i++) {\n"
+	"		for (int j = 0; j < 16; j++) {\n"
+	"			int sum = 0;\n"
+	"			for (int k = 0; k < 16; k++) {\n"
+	"				sum = sum + a[i * 16 + k] * b[k * 16 + j];\n"
+	"			}\n"
+	"			c[i * 16 + j] = sum;\n"
+	"		}\n"
+	"	}\n"
+	"	return c[255];\n"
+	"}";
+
+// Naive recursive fibonacci, dominated by call overhead.
+const char *g_fibSource = ""
+	"int fib(int n) {\n"
+	"	if (n < 2) {\n"
+	"		return n;\n"
+	"	}\n"
+	"	return fib(n - 1) + fib(n - 2);\n"
+	"}\n"
+	"int main() {\n"
+	"	return fib(20) % 256;\n"
+	"}";
+
+// Nested counting loops without memory access.
+const char *g_loopSource = ""
+	"int main() {\n"
+	"	int sum = 0;\n"
+	"	for (int i = 0; i < 64; i++) {\n"
+	"		for (int j = 0; j < 64; j++) {\n"
+	"			for (int k = 0; k < 16; k++) {\n"
+	"				sum = sum + (i ^ j) + k;\n"
+	"			}\n"
+	"		}\n"
+	"	}\n"
+	"	return sum % 256;\n"
+	"}";
+
+// Fill a character buffer, reverse it in place and count a character.
+const char *g_stringSource = ""
+	"int main() {\n"
+	"	char text[512];\n"
+	"	int count = 0;\n"
+	"	for (int i = 0; i < 512; i++) {\n"
+	"		text[i] = 'a' + i % 26;\n"
+	"	}\n"
+	"	for (int n = 0; n < 16; n++) {\n"
+	"		for (int i = 0; i < 256; i++) {\n"
+	"			char c = text[i];\n"
+	"			text[i] = text[511 - i];\n"
+	"			text[511 - i] = c;\n"
+	"		}\n"
+	"		for (int i = 0; i < 512; i++) {\n"
+	"			if (text[i] == 'e') {\n"
+	"				count = count + 1;\n"
+	"			}\n"
+	"		}\n"
+	"	}\n"
+	"	return count % 256;\n"
+	"}";
+
+// Short program, dominated by the virtual machine setup.
+const char *g_smallSource = ""
+	"int square(int n) {\n"
+	"	return n * n;\n"
+	"}\n"
+	"int main() {\n"
+	"	int sum = 0;\n"
+	"	for (int i = 0; i < 32; i++) {\n"
+	"		sum = sum + square(i);\n"
+	"	}\n"
+	"	return sum % 256;\n"
+	"}";
+
+// Number of programs in the throughput variants.
+constexpr size_t g_programCount = 64;
+
+class ProgramRunner
+{
+	std::string m_source;
+	program_t m_program{ nullptr };
+	bool m_done{ false };
+
+	// Read the source in one go.
+	static datachunk_t *GetSource(void *user_data)
+	{
+		ProgramRunner *runner = static_cast<ProgramRunner *>(user_data);
+		if (runner->m_done) {
+			return nullptr;
+		}
+
+		datachunk_t *buffer = (datachunk_t*)malloc(sizeof(datachunk_t));
+		buffer->size = static_cast<unsigned int>(runner->m_source.size());
+		buffer->ptr = runner->m_source.data();
+		buffer->unmanaged_res = 0;
+		runner->m_done = true;
+		return buffer;
+	}
+
+	static int Load(void *user_data, const char *source)
+	{
+		CRY_UNUSED(user_data);
+		CRY_UNUSED(source);
+		return 0;
+	}
+
+	static metainfo_t *SourceInfo(void *user_data)
+	{
+		CRY_UNUSED(user_data);
+		metainfo_t *meta_info = (metainfo_t*)malloc(sizeof(metainfo_t));
+
+		std::string meta = "bench";
+		CRY_MEMZERO(meta_info->name, sizeof(meta_info->name));
+		std::copy(meta.begin(), meta.end(), meta_info->name);
+		meta_info->size = static_cast<unsigned int>(meta.size());
+		return meta_info;
+	}
+
+	static void ErrorHandler(void *user_data, const char *message, int fatal)
+	{
+		CRY_UNUSED(user_data);
+		CRY_UNUSED(fatal);
+		throw std::runtime_error{ message };
+	}
+
+public:
+	ProgramRunner(const std::string& source, bool bytecode)
+		: m_source{ source }
+	{
+		compiler_info_t info;
+		info.api_ref = COILCLAPIVER;
+		info.code_opt = {};
+		info.code_opt.standard = cil_standard::cil;
+		info.code_opt.optimization = optimization::NONE;
+		info.code_opt.emit_bytecode = bytecode;
+		info.streamReaderVPtr = &ProgramRunner::GetSource;
+		info.loadStreamRequestVPtr = &ProgramRunner::Load;
+		info.streamMetaVPtr = &ProgramRunner::SourceInfo;
+		info.error_handler = &ProgramRunner::ErrorHandler;
+		info.program.program_ptr = nullptr;
+		info.user_data = this;
+		::Compile(&info);
+		m_program = info.program;
+	}
+
+	~ProgramRunner()
+	{
+		::ReleaseProgram(&m_program);
+	}
+
+	// Runtime settings for the compiled program.
+	runtime_settings_t Settings(bool boundsCheck, bool jit)
+	{
+		runtime_settings_t settings;
+		settings.api_ref = EVMAPIVER;
+		settings.cfg = {};
+		settings.cfg.disable_bounds_check = !boundsCheck;
+		settings.cfg.disable_jit = !jit;
+		settings.entry_point = nullptr;
+		settings.return_code = EXIT_FAILURE;
+		settings.error_handler = &ProgramRunner::ErrorHandler;
+		settings.program = m_program;
+		settings.args = nullptr;
+		settings.envs = nullptr;
+		settings.profile_file = nullptr;
+		settings.user_data = this;
+		return settings;
+	}
+
+	// Execute the program and return the program exit code.
+	int Run(bool boundsCheck, bool jit)
+	{
+		runtime_settings_t settings = Settings(boundsCheck, jit);
+		::ExecuteProgram(&settings);
+		return settings.return_code;
+	}
+};
+
+void RunProgram(const char *source, bool boundsCheck, size_t iterations, bool bytecode = false, bool jit = false)
+{
+	ProgramRunner runner{ source, bytecode };
+	for (size_t i = 0; i < iterations; ++i) {
+		int result = runner.Run(boundsCheck, jit);
+		Cry::Benchmark::DoNotOptimize(result);
+	}
+}
+
+// Compile the program once per runner, each runner executes its own program.
+void RunPrograms(const char *source, size_t iterations, bool concurrent)
+{
+	std::vector<std::unique_ptr<ProgramRunner>> runners;
+	std::vector<runtime_settings_t> settings;
+	std::vector<runtime_settings_t *> batch;
+	std::vector<int> results(g_programCount);
+	for (size_t i = 0; i < g_programCount; ++i) {
+		runners.emplace_back(std::make_unique<ProgramRunner>(source, false));
+		settings.push_back(runners.back()->Settings(true, false));
+	}
+	for (auto& setting : settings) {
+		batch.push_back(&setting);
+	}
+
+	for (size_t i = 0; i < iterations; ++i) {
+		if (concurrent) {
+			::ExecuteProgramBatch(batch.data(), results.data(), batch.size(), 0);
+		}
+		else {
+			for (size_t j = 0; j < batch.size(); ++j) {
+				results[j] = ::ExecuteProgram(batch[j]);
+			}
+		}
+		Cry::Benchmark::DoNotOptimize(results);
+	}
+}
+
+} // namespace
+
+CRY_BENCHMARK(ProgramSieve)
+{
+	RunProgram(g_sieveSource, true, iterations);
+}
+
+CRY_BENCHMARK(ProgramSieveUnchecked)
+{
+	RunProgram(g_sieveSource, false, iterations);
+}
+
+CRY_BENCHMARK(ProgramMatrixMultiply)
+{
+	RunProgram(g_matmulSource, true, iterations);
+}
+
+CRY_BENCHMARK(ProgramMatrixMultiplyUnchecked)
+{
+	RunProgram(g_matmulSource, false, iterations);
+}
+
+CRY_BENCHMARK(ProgramSieveBytecode)
+{
+	RunProgram(g_sieveSource, true, iterations, true);
+}
+
+CRY_BENCHMARK(ProgramMatrixMultiplyBytecode)
+{
+	RunProgram(g_matmulSource, true, iterations, true);
+}
+
+CRY_BENCHMARK(ProgramSieveNative)
+{
+	RunProgram(g_sieveSource, true, iterations, true, true);
+}
+
+CRY_BENCHMARK(ProgramMatrixMultiplyNative)
+{
+	RunProgram(g_matmulSource, true, iterations, true, true);
+}
+
+CRY_BENCHMARK(ProgramFibonacci)
+{
+	RunProgram(g_fibSource, true, iterations);
+}
+
+CRY_BENCHMARK(ProgramFibonacciBytecode)
+{
+	RunProgram(g_fibSource, true, iterations, true);
+}
+
+CRY_BENCHMARK(ProgramFibonacciNative)
+{
+	RunProgram(g_fibSource, true, iterations, true, true);
+}
+
+CRY_BENCHMARK(ProgramNestedLoop)
+{
+	RunProgram(g_loopSource, true, iterations);
+}
+
+CRY_BENCHMARK(ProgramNestedLoopBytecode)
+{
+	RunProgram(g_loopSource, true, iterations, true);
+}
+
+CRY_BENCHMARK(ProgramNestedLoopNative)
+{
+	RunProgram(g_loopSource, true, iterations, true, true);
+}
+
+CRY_BENCHMARK(ProgramString)
+{
+	RunProgram(g_stringSource, true, iterations);
+}
+
+CRY_BENCHMARK(ProgramStringBytecode)
+{
+	RunProgram(g_stringSource, true, iterations, true);
+}
+
+CRY_BENCHMARK(ProgramThroughput)
+{
+	RunPrograms(g_smallSource, iterations, false);
+}
+
+CRY_BENCHMARK(ProgramThroughputConcurrent)
+{
+	RunPrograms(g_smallSource, iterations, true);
+}
@@ -45,6 +45,12 @@ extern "C" {
 		int enable_memory_table : 1;
 		// Use internal function stubs rather than native functions.
 		int enable_stub_functions : 1;
+		// Skip bounds checks on array element access.
+		int disable_bounds_check : 1;
+		// Skip native code generation for bytecode programs.
+		int disable_jit : 1;
+		// Profile the program in the interpreter.
+		int enable_profiler : 1;
 	};
 
 	typedef struct
@@ -81,13 +87,47 @@ extern "C" {
 		// Program environment variables. This is a null terminated list.
 		datalist_t envs;
 
+		// Profile output file name without extension. If the profiler is
+		// enabled the hot spot report is written to '<file>.txt' and the
+		// folded call stacks are written to '<file>.folded'.
+		const char *profile_file;
+
 		// User provided context.
 		void *user_data;
 	} runtime_settings_t;
 
+	// Pool of worker threads for concurrent program execution.
+	typedef struct execution_pool execution_pool_t;
+
+	// Called on the worker thread when an asynchronous program has finished,
+	// the result is the result of the program execution.
+	typedef void(*completion_handler_t)(runtime_settings_t *, int);
+
 	// Compiler library entry point
 	EVMAPI int ExecuteProgram(runtime_settings_t *) NOTHROW;
 
+	// Create a pool of worker threads. A thread count of zero selects the
+	// hardware concurrency.
+	EVMAPI execution_pool_t *CreateExecutionPool(unsigned int) NOTHROW;
+
+	// Queue the program for execution on the pool. Each program runs in its
+	// own execution engine, programs share the external module symbols. The
+	// runtime settings must remain valid until the completion handler is
+	// called. The error handler is called on the worker thread. A program
+	// shall not be queued more than once at the same time.
+	EVMAPI int ExecuteProgramAsync(execution_pool_t *, runtime_settings_t *, completion_handler_t) NOTHROW;
+
+	// Wait until all queued programs have finished.
+	EVMAPI void WaitExecutionPool(execution_pool_t *) NOTHROW;
+
+	// Wait until all queued programs have finished and release the pool.
+	EVMAPI void ReleaseExecutionPool(execution_pool_t *) NOTHROW;
+
+	// Run the list of programs concurrently and wait until all programs have
+	// finished. The result of each program execution is stored in the result
+	// list, if provided. A thread count of zero selects the hardware concurrency.
+	EVMAPI int ExecuteProgramBatch(runtime_settings_t **, int *, size_t, unsigned int) NOTHROW;
+
 	// Library version information.
 	EVMAPI void GetLibraryInfo(library_info_t *) NOTHROW;
 
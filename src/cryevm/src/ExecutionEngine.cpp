@@ -0,0 +1,57 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include "ExecutionEngine.h"
+#include "ModuleRegistry.h"
+
+#include <atomic>
+
+namespace EVM
+{
+
+namespace
+{
+
+thread_local ExecutionEngine *t_engine = nullptr;
+
+// Call targets cached on the program are tagged with the epoch, the
+// epoch must differ between engines. Zero is never handed out.
+std::atomic<unsigned int> g_symbolEpoch{ 0 };
+
+} // namespace
+
+ExecutionEngine::Activation::Activation(ExecutionEngine& engine) noexcept
+	: m_previous{ t_engine }
+{
+	t_engine = &engine;
+}
+
+ExecutionEngine::Activation::~Activation()
+{
+	t_engine = m_previous;
+}
+
+ExecutionEngine::ExecutionEngine(ModuleRegistry& registry, const struct vm_config& config)
+	: m_registry{ registry }
+	, m_symbolEpoch{ ++g_symbolEpoch }
+	, m_boundsCheck{ !config.disable_bounds_check }
+	, m_jit{ !config.disable_jit }
+{
+}
+
+ExecutionEngine *ExecutionEngine::Current() noexcept
+{
+	return t_engine;
+}
+
+const ExternalMethod *ExecutionEngine::FindExternalSymbol(const std::string& symbol) const
+{
+	return m_registry.Find(symbol);
+}
+
+} // namespace EVM
@@ -0,0 +1,71 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+#include <CryEVM/ExternalMethod.h>
+#include <CryEVM/evm.h>
+
+#include <string>
+
+namespace EVM
+{
+
+class ModuleRegistry;
+
+// Execution state of a program run.
+//
+// The engine holds the runtime configuration and resolves external symbols
+// through the module registry. The registry is shared between all engines,
+// modules are loaded once per process. The engine is bound to the thread
+// which runs the program, the strategies query the bound engine via the
+// global execution state. Engines on different threads are independent and
+// the programs can therefore run concurrently.
+class ExecutionEngine final
+{
+public:
+	// Bind the engine to the current thread for the lifetime of the
+	// activation.
+	class Activation final
+	{
+		ExecutionEngine *m_previous;
+
+	public:
+		explicit Activation(ExecutionEngine&) noexcept;
+		~Activation();
+
+		Activation(const Activation&) = delete;
+		Activation& operator=(const Activation&) = delete;
+	};
+
+	ExecutionEngine(ModuleRegistry&, const struct vm_config&);
+
+	ExecutionEngine(const ExecutionEngine&) = delete;
+	ExecutionEngine& operator=(const ExecutionEngine&) = delete;
+
+	// Engine bound to the current thread, or nullptr.
+	static ExecutionEngine *Current() noexcept;
+
+	// Find an external symbol, returns either external method or nullptr.
+	const ExternalMethod *FindExternalSymbol(const std::string&) const;
+
+	// Epoch of the external symbol table, each engine has a unique epoch.
+	inline unsigned int SymbolEpoch() const noexcept { return m_symbolEpoch; }
+	// Test if array element access is bounds checked.
+	inline bool IsBoundsCheckEnabled() const noexcept { return m_boundsCheck; }
+	// Test if bytecode programs may be compiled into native code.
+	inline bool IsJitEnabled() const noexcept { return m_jit; }
+
+private:
+	ModuleRegistry& m_registry;
+	const unsigned int m_symbolEpoch;
+	const bool m_boundsCheck;
+	const bool m_jit;
+};
+
+} // namespace EVM
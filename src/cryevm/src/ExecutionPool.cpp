@@ -0,0 +1,83 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include "ExecutionPool.h"
+
+#include <algorithm>
+
+namespace EVM
+{
+
+ExecutionPool::ExecutionPool(size_t threads)
+{
+	if (!threads) {
+		threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+	m_threads.reserve(threads);
+	for (size_t i = 0; i < threads; ++i) {
+		m_threads.emplace_back(&ExecutionPool::Worker, this);
+	}
+}
+
+ExecutionPool::~ExecutionPool()
+{
+	Wait();
+
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_stop = true;
+	}
+	m_workQueued.notify_all();
+
+	for (auto& thread : m_threads) {
+		thread.join();
+	}
+}
+
+void ExecutionPool::Submit(std::function<void()> work)
+{
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		m_queue.push_back(std::move(work));
+		++m_pending;
+	}
+	m_workQueued.notify_one();
+}
+
+void ExecutionPool::Wait()
+{
+	std::unique_lock<std::mutex> lock{ m_mutex };
+	m_workDone.wait(lock, [this] { return !m_pending; });
+}
+
+// Take work items from the queue until the pool is stopped. The
+// queue is drained before the worker exits.
+void ExecutionPool::Worker()
+{
+	for (;;) {
+		std::function<void()> work;
+		{
+			std::unique_lock<std::mutex> lock{ m_mutex };
+			m_workQueued.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+			if (m_queue.empty()) { return; }
+
+			work = std::move(m_queue.front());
+			m_queue.pop_front();
+		}
+
+		work();
+
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		if (!--m_pending) {
+			m_workDone.notify_all();
+		}
+	}
+}
+
+} // namespace EVM
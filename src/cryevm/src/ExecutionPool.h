@@ -0,0 +1,55 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace EVM
+{
+
+// Fixed set of worker threads running queued work items in order of
+// submission. The work items must not throw.
+class ExecutionPool final
+{
+public:
+	// Start the worker threads, zero selects the hardware concurrency.
+	explicit ExecutionPool(size_t threads);
+	// Wait for the queued work items and stop the worker threads.
+	~ExecutionPool();
+
+	ExecutionPool(const ExecutionPool&) = delete;
+	ExecutionPool& operator=(const ExecutionPool&) = delete;
+
+	// Queue the work item.
+	void Submit(std::function<void()>);
+	// Wait until all queued work items have completed.
+	void Wait();
+
+	// Number of worker threads.
+	inline size_t ThreadCount() const noexcept { return m_threads.size(); }
+
+private:
+	void Worker();
+
+private:
+	std::mutex m_mutex;
+	std::condition_variable m_workQueued;
+	std::condition_variable m_workDone;
+	std::deque<std::function<void()>> m_queue;
+	size_t m_pending{ 0 };
+	bool m_stop{ false };
+	std::vector<std::thread> m_threads;
+};
+
+} // namespace EVM
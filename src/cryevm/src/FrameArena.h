@@ -0,0 +1,193 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace EVM
+{
+
+// Stack disciplined memory arena for contexts and frames.
+//
+// Contexts are created and released in call order, which allows the memory
+// to be bump allocated from a list of blocks. Memory released in LIFO order
+// is popped from the top immediately. Memory released out of order is kept
+// on a free list and is handed out again to the next allocation which fits
+// in the chunk, or popped once all memory allocated after it has been
+// released. The arena is bound to the thread, a context must be released on
+// the thread which created the context.
+class FrameArena final
+{
+	static constexpr size_t blockSize = 64 * 1024;
+	static constexpr size_t alignment = alignof(std::max_align_t);
+
+	static constexpr size_t Align(size_t size) noexcept
+	{
+		return (size + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Every allocation is prefixed with the index of the chunk record.
+	static constexpr size_t headerSize = alignment;
+	static_assert(headerSize >= sizeof(size_t), "header does not fit chunk index");
+
+	struct Chunk
+	{
+		size_t block;
+		size_t offset;
+		size_t size;
+		bool released;
+	};
+
+	struct Block
+	{
+		std::unique_ptr<std::max_align_t[]> data;
+		size_t size;
+		size_t top;
+	};
+
+	static Block MakeBlock(size_t size)
+	{
+		return Block{ std::make_unique<std::max_align_t[]>(size / alignment), size, 0 };
+	}
+
+	inline unsigned char *ChunkBase(const Chunk& chunk) const noexcept
+	{
+		return reinterpret_cast<unsigned char *>(m_blocks[chunk.block].data.get()) + chunk.offset;
+	}
+
+public:
+	// Arena of the calling thread.
+	static FrameArena& Current()
+	{
+		static thread_local FrameArena arena;
+		return arena;
+	}
+
+	// Allocate memory from a released chunk which fits, or on top of the arena.
+	void *Allocate(size_t size)
+	{
+		const size_t chunkSize = headerSize + Align(size);
+
+		// Take the smallest released chunk which fits, the chunk keeps its size.
+		auto fit = m_free.end();
+		for (auto it = m_free.begin(); it != m_free.end(); ++it) {
+			const size_t available = m_chunks[*it].size;
+			if (available >= chunkSize && (fit == m_free.end() || available < m_chunks[*fit].size)) {
+				fit = it;
+			}
+		}
+		if (fit != m_free.end()) {
+			Chunk& chunk = m_chunks[*fit];
+			chunk.released = false;
+			m_free.erase(fit);
+			return ChunkBase(chunk) + headerSize;
+		}
+
+		if (m_blocks.empty() || m_blocks[m_current].top + chunkSize > m_blocks[m_current].size) {
+			if (!m_blocks.empty()) { ++m_current; }
+
+			// Blocks past the current block are empty and can be reused.
+			if (m_current == m_blocks.size()) {
+				m_blocks.push_back(MakeBlock(std::max(blockSize, chunkSize)));
+			}
+			else if (m_blocks[m_current].size < chunkSize) {
+				m_blocks[m_current] = MakeBlock(chunkSize);
+			}
+		}
+
+		Block& block = m_blocks[m_current];
+		auto base = reinterpret_cast<unsigned char *>(block.data.get()) + block.top;
+		*reinterpret_cast<size_t *>(base) = m_chunks.size();
+		m_chunks.push_back(Chunk{ m_current, block.top, chunkSize, false });
+		block.top += chunkSize;
+		return base + headerSize;
+	}
+
+	// Release memory and pop all released chunks from the top of the arena.
+	void Release(void *ptr) noexcept
+	{
+		const size_t index = *reinterpret_cast<size_t *>(static_cast<unsigned char *>(ptr) - headerSize);
+		m_chunks[index].released = true;
+		if (index + 1 < m_chunks.size()) {
+			m_free.push_back(index);
+			return;
+		}
+
+		while (!m_chunks.empty() && m_chunks.back().released) {
+			const Chunk& chunk = m_chunks.back();
+			m_blocks[chunk.block].top -= chunk.size;
+			m_current = chunk.block;
+			m_chunks.pop_back();
+		}
+
+		// Popped chunks are no longer available for reuse.
+		const size_t count = m_chunks.size();
+		m_free.erase(std::remove_if(m_free.begin(), m_free.end(), [count](size_t idx) { return idx >= count; }), m_free.end());
+	}
+
+	// Number of bytes in use, including released chunks below the top.
+	size_t Size() const noexcept
+	{
+		size_t size = 0;
+		for (const Block& block : m_blocks) {
+			size += block.top;
+		}
+		return size;
+	}
+
+	// Number of bytes reserved by the arena.
+	size_t Capacity() const noexcept
+	{
+		size_t capacity = 0;
+		for (const Block& block : m_blocks) {
+			capacity += block.size;
+		}
+		return capacity;
+	}
+
+private:
+	std::vector<Block> m_blocks;
+	std::vector<Chunk> m_chunks;
+	std::vector<size_t> m_free;
+	size_t m_current{ 0 };
+};
+
+// Allocator on the frame arena of the calling thread.
+template<typename Type>
+struct FrameAllocator
+{
+	using value_type = Type;
+
+	FrameAllocator() noexcept = default;
+	template<typename OtherType>
+	FrameAllocator(const FrameAllocator<OtherType>&) noexcept
+	{
+	}
+
+	Type *allocate(size_t count)
+	{
+		static_assert(alignof(Type) <= alignof(std::max_align_t), "overaligned type");
+		return static_cast<Type *>(FrameArena::Current().Allocate(count * sizeof(Type)));
+	}
+
+	void deallocate(Type *ptr, size_t) noexcept
+	{
+		FrameArena::Current().Release(ptr);
+	}
+
+	template<typename OtherType>
+	bool operator==(const FrameAllocator<OtherType>&) const noexcept { return true; }
+	template<typename OtherType>
+	bool operator!=(const FrameAllocator<OtherType>&) const noexcept { return false; }
+};
+
+} // namespace EVM
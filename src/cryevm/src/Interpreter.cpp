@@ -7,6 +7,9 @@
 // copied and/or distributed without the express of the author.
 
 #include "Interpreter.h"
+#include "State.h"
+#include "Profiler.h"
+#include "FrameArena.h"
 
 // Project includes.
 #include <CryEVM/ExternalMethod.h>
@@ -19,8 +22,12 @@
 #include <Cry/Except.h>
 
 // Language includes.
+#include <algorithm>
+#include <cstddef>
 #include <numeric>
-#include <set>
+#include <stdexcept>
+#include <unordered_map>
+#include <vector>
 
 //TODO:
 // - Stacktrace
@@ -35,7 +42,7 @@
 #define DEFAULT_MAKE_CONTEXT() \
 	template<typename ContextType, typename... ArgTypes> \
 	std::shared_ptr<ContextType> MakeContext(ArgTypes&&... args) { \
-		return std::make_shared<ContextType>(shared_from_this(), std::forward<ArgTypes>(args)...); \
+		return std::allocate_shared<ContextType>(FrameAllocator<ContextType>{}, shared_from_this(), std::forward<ArgTypes>(args)...); \
 	}
 
 using namespace CryCC::AST;
@@ -63,6 +70,22 @@ private:
 	std::string m_msg;
 };
 
+// Error in the program which is only detected while the program runs.
+class RuntimeException : public std::runtime_error
+{
+public:
+	using std::runtime_error::runtime_error;
+};
+
+class InvalidAddressException : public std::exception
+{
+public:
+	virtual const char *what() const noexcept
+	{
+		return "dereference of invalid or released address";
+	}
+};
+
 EVM::Interpreter::Interpreter(Planner& planner)
 	: Strategy{ planner }
 {
@@ -78,7 +101,7 @@ bool EVM::Interpreter::IsRunnable() const noexcept
 {
 	return (Program()->Condition().IsRunnable()
 		&& Program()->AstPassthrough()->ChildrenCount()
-		&& Program()->AstPassthrough()->Parent().expired()
+		&& Program()->AstPassthrough()->ParentNode() == nullptr
 		&& IsTranslationUnitNode(Program()->Ast().Front()));
 }
 
@@ -199,30 +222,30 @@ struct DeclarationRegistry
 
 		AddressType address;
 
-		OpaqueAddress(AddressType address, std::weak_ptr<Valuedef::Value> ptr)
+		OpaqueAddress(AddressType address, Valuedef::Value *ptr)
 			: address{ address }
 			, m_ptr{ ptr }
 		{
 		}
 
-		inline std::shared_ptr<Valuedef::Value> operator->() const
+		inline Valuedef::Value *operator->() const
 		{
 			return this->Get();
 		}
 
-		inline std::shared_ptr<Valuedef::Value> operator*() const
+		inline Valuedef::Value *operator*() const
 		{
 			return this->Get();
 		}
 
-		inline std::shared_ptr<Valuedef::Value> Get() const
+		inline Valuedef::Value *Get() const
 		{
-			return m_ptr.lock();
+			return m_ptr;
 		}
 
 		inline bool Expired() const noexcept
 		{
-			return m_ptr.expired();
+			return !m_ptr;
 		}
 
 		bool operator==(const OpaqueAddress& other) const
@@ -256,19 +279,25 @@ struct DeclarationRegistry
 		}
 
 	private:
-		std::weak_ptr<Valuedef::Value> m_ptr;
+		Valuedef::Value *m_ptr;
 
 	private:
-		static AddressType s_addressSequnce;
+		static thread_local AddressType s_addressSequnce;
 	};
 
-	~DeclarationRegistry()
+	// Storage slot of a declaration. The value is stored in place.
+	struct StorageSlot
 	{
-		// Force reset of values in this scope.
-		for (auto& map : m_namedMap) {
-			std::get<std::shared_ptr<Valuedef::Value>>(map.second).reset();
-		}
-	}
+		OpaqueAddress::AddressType address{ 0 };
+		boost::optional<Valuedef::Value> value;
+	};
+
+	// Slot storage of a function or unit. All nested scopes of a
+	// function share the frame of the function.
+	using Frame = std::vector<StorageSlot, FrameAllocator<StorageSlot>>;
+
+	// Frame depth of a resolved reference.
+	enum { LOCAL_FRAME, UNIT_FRAME };
 
 	//TODO
 	//virtual PushVar() = 0;
@@ -287,13 +316,8 @@ struct DeclarationRegistry
 		static_assert(std::is_same<InternalType, std::string>::value ||
 			std::is_same<InternalType, const char *>::value, "");
 
-		auto ptr = std::make_shared<Valuedef::Value>(value);
-		const auto addr = OpaqueAddress::Advance();
-		s_global.emplace(addr, ptr);
-		m_namedMap.emplace(key, std::make_tuple(OpaqueAddress{ addr,ptr }, ptr));
-
-		//TODO: remove
-		m_localObj.emplace(std::forward<KeyType>(key), std::forward<ValueType>(value));
+		m_namedMap.emplace(std::forward<KeyType>(key)
+			, StorageSlot{ OpaqueAddress::Advance(), Valuedef::Value{ std::forward<ValueType>(value) } });
 	}
 
 	//FUTURE: maybe remove?
@@ -303,15 +327,69 @@ struct DeclarationRegistry
 	}
 
 	// Find the value by identifier, if not found IdentifierNotFoundException is thrown.
-	virtual std::weak_ptr<Valuedef::Value> ValueByIdentifier(const std::string& key)
+	virtual Valuedef::Value *ValueByIdentifier(const std::string& key)
 	{
 		auto val = m_namedMap.find(key);
 		if (val == m_namedMap.end()) {
 			throw IdentifierNotFoundException{ key };
 		}
 
-		// Get the value part from the tuple.
-		return std::get<std::shared_ptr<Valuedef::Value>>(val->second);
+		return val->second.value.get_ptr();
+	}
+
+	// Reserve the slots of the frame of this scope. Values in a reserved
+	// frame are not moved when slots are set.
+	void ReserveFrame(size_t size)
+	{
+		assert(m_frame);
+		if (size > m_frame->size()) {
+			m_frame->resize(size);
+		}
+	}
+
+	// Bind the value to a slot in the frame of this scope. A declaration
+	// which is executed again replaces the value in the slot.
+	void PushSlot(size_t slot, Valuedef::Value&& value)
+	{
+		ReserveFrame(slot + 1);
+
+		StorageSlot& storage = (*m_frame)[slot];
+		storage.address = OpaqueAddress::Advance();
+		storage.value = std::move(value);
+	}
+
+	// Find the value by resolved slot, returns nullptr if the slot is not set.
+	Valuedef::Value *ValueBySlot(size_t depth, size_t slot) const
+	{
+		Frame *frame = depth == LOCAL_FRAME ? m_frame : m_unitFrame;
+		if (!frame || slot >= frame->size()) { return nullptr; }
+		return (*frame)[slot].value.get_ptr();
+	}
+
+	// Find the address by resolved slot.
+	OpaqueAddress AddressBySlot(size_t depth, size_t slot) const
+	{
+		Frame *frame = depth == LOCAL_FRAME ? m_frame : m_unitFrame;
+		assert(frame && slot < frame->size());
+		return OpaqueAddress{ (*frame)[slot].address, (*frame)[slot].value.get_ptr() };
+	}
+
+	// Frame of the enclosing function or unit.
+	inline Frame *LocalFrame() const noexcept { return m_frame; }
+	// Frame of the unit.
+	inline Frame *UnitFrame() const noexcept { return m_unitFrame; }
+
+	// Find the value by address in the live frames, starting at the innermost
+	// frame. Returns nullptr if the storage was released, or if the declaration
+	// was executed again since the address was taken.
+	static Valuedef::Value *ValueByAddress(OpaqueAddress::AddressType address)
+	{
+		for (auto it = s_frameOwners.rbegin(); it != s_frameOwners.rend(); ++it) {
+			if (auto value = (*it)->FindAddress(address)) {
+				return value;
+			}
+		}
+		return nullptr;
 	}
 
 	// Find the address by identifier, if not found null should be returned.
@@ -323,8 +401,7 @@ struct DeclarationRegistry
 			throw IdentifierNotFoundException{ key };
 		}
 
-		// Get the address part from the tuple.
-		return std::get<OpaqueAddress>(val->second);
+		return OpaqueAddress{ val->second.address, val->second.value.get_ptr() };
 	}
 
 	// Test if there are any declarations in the current context.
@@ -343,33 +420,70 @@ struct DeclarationRegistry
 	void DumpVar(const std::string& key)
 	{
 		auto var = ValueByIdentifier(key);
-		if (!var.lock()) { printf("%s -> (null)", key.c_str()); }
+		if (!var) { printf("%s -> (null)", key.c_str()); }
 		else {
 			printf("%s -> ", key.c_str());
-			//DUMP_VALUE((*var.lock().get()));
+			//DUMP_VALUE((*var));
 		}
 	}
 #endif
 
-	// Get value from global address.
-	static std::shared_ptr<Valuedef::Value> ValueByAddress(const OpaqueAddress& address)
+protected:
+	// Set the frames used for resolved slots. The frames are owned
+	// by the function and unit contexts.
+	inline void BindFrame(Frame *frame, Frame *unitFrame) noexcept
+	{
+		m_frame = frame;
+		m_unitFrame = unitFrame;
+	}
+
+	// Register the owner of the frame, the values of the owner can be found
+	// by address for as long as the owner is attached.
+	void AttachFrameOwner()
 	{
-		return s_global.find(address)->Get();
+		s_frameOwners.push_back(this);
 	}
 
-	// Clear object registery.
-	static void ClearGlobalObject() { s_global.clear(); }
+	// Owners are detached in reverse order, except for replaced activations.
+	void DetachFrameOwner() noexcept
+	{
+		const auto it = std::find(s_frameOwners.rbegin(), s_frameOwners.rend(), this);
+		if (it != s_frameOwners.rend()) {
+			s_frameOwners.erase(std::next(it).base());
+		}
+	}
+
+private:
+	// Search the owned frame and the named declarations for the address.
+	Valuedef::Value *FindAddress(OpaqueAddress::AddressType address)
+	{
+		if (m_frame) {
+			for (StorageSlot& slot : (*m_frame)) {
+				if (slot.address == address) {
+					return slot.value.get_ptr();
+				}
+			}
+		}
+		for (auto& named : m_namedMap) {
+			if (named.second.address == address) {
+				return named.second.value.get_ptr();
+			}
+		}
+		return nullptr;
+	}
 
 protected:
-	std::map<std::string, Valuedef::Value> m_localObj; //TODO: remove
-	std::map<std::string, std::tuple<OpaqueAddress, std::shared_ptr<Valuedef::Value>>> m_namedMap;
+	std::map<std::string, StorageSlot> m_namedMap;
+	Frame *m_frame{ nullptr };
+	Frame *m_unitFrame{ nullptr };
 
 private:
-	static std::set<OpaqueAddress> s_global;
+	static thread_local std::vector<DeclarationRegistry *> s_frameOwners;
 };
 
-DeclarationRegistry::OpaqueAddress::AddressType DeclarationRegistry::OpaqueAddress::s_addressSequnce{ ADDRESS_SEQUENCE };
-std::set<DeclarationRegistry::OpaqueAddress> DeclarationRegistry::s_global;
+// Programs on different threads have their own address sequence.
+thread_local DeclarationRegistry::OpaqueAddress::AddressType DeclarationRegistry::OpaqueAddress::s_addressSequnce{ ADDRESS_SEQUENCE };
+thread_local std::vector<DeclarationRegistry *> DeclarationRegistry::s_frameOwners;
 
 struct SymbolRegistry
 {
@@ -377,6 +491,101 @@ protected:
 	std::map<std::string, std::weak_ptr<ASTNode>> m_symbolTable;
 };
 
+// Bind declaration references to storage slots.
+//
+// Every variable in a function is assigned a slot in the frame of the
+// function, the parameters take the first slots in order of declaration.
+// Nested scopes only shadow the names in the scope, slots are not reused
+// within a function. References to unit variables are bound to the unit
+// frame. References which cannot be resolved, such as the parameters of
+// external routines, are left unbound and are looked up by identifier.
+class SlotResolver final
+{
+	using Scope = std::unordered_map<std::string, size_t>;
+
+public:
+	explicit SlotResolver(const Scope& unitScope)
+		: m_unitScope{ unitScope }
+	{
+	}
+
+	// Resolve the parameters and the frozen body of the function, returns
+	// the number of slots in the function frame.
+	size_t Function(const FunctionDecl& node, FlatTree::NodeHandle body)
+	{
+		m_scopes.emplace_back();
+		if (node.HasParameters()) {
+			for (ASTNode *child : node.ParameterStatement()->ChildNodes()) {
+				if (!child || child->Label() != NodeID::PARAM_DECL_ID) { continue; }
+				m_scopes.back()[Util::Cast<ParamDecl>(child)->Identifier()] = m_nextSlot++;
+			}
+		}
+
+		Walk(body);
+		m_scopes.pop_back();
+		return m_nextSlot;
+	}
+
+private:
+	void Walk(FlatTree::NodeHandle handle)
+	{
+		if (!handle) { return; }
+
+		switch (handle.Label()) {
+		case NodeID::COMPOUND_STMT_ID:
+		case NodeID::FOR_STMT_ID:
+			m_scopes.emplace_back();
+			WalkChildren(handle);
+			m_scopes.pop_back();
+			return;
+		// The initializer is resolved before the name is declared.
+		case NodeID::VAR_DECL_ID: {
+			WalkChildren(handle);
+			auto decl = handle.As<VarDecl>();
+			decl->SetStorageSlot(m_nextSlot);
+			m_scopes.back()[decl->Identifier()] = m_nextSlot++;
+			return;
+		}
+		case NodeID::DECL_REF_EXPR_ID:
+			Bind(*handle.As<DeclRefExpr>());
+			return;
+		default:
+			break;
+		}
+
+		WalkChildren(handle);
+	}
+
+	void WalkChildren(FlatTree::NodeHandle handle)
+	{
+		for (size_t i = 0; i < handle.ChildrenCount(); ++i) {
+			Walk(handle.Child(i));
+		}
+	}
+
+	void Bind(DeclRefExpr& reference)
+	{
+		const std::string identifier = reference.Identifier();
+		for (auto it = m_scopes.crbegin(); it != m_scopes.crend(); ++it) {
+			const auto slot = it->find(identifier);
+			if (slot != it->cend()) {
+				reference.Bind(DeclarationRegistry::LOCAL_FRAME, slot->second);
+				return;
+			}
+		}
+
+		const auto slot = m_unitScope.find(identifier);
+		if (slot != m_unitScope.cend()) {
+			reference.Bind(DeclarationRegistry::UNIT_FRAME, slot->second);
+		}
+	}
+
+private:
+	const Scope& m_unitScope;
+	std::vector<Scope> m_scopes;
+	size_t m_nextSlot{ 0 };
+};
+
 class AbstractContext
 {
 	friend class Evaluator;
@@ -530,14 +739,53 @@ class UnitContext
 
 public:
 	template<typename ContextType>
-	UnitContext(std::shared_ptr<ContextType>&& parent, const std::string& name)
+	UnitContext(std::shared_ptr<ContextType>&& parent, const std::string& name, const FlatTree& tree)
 		: AbstractContext{ Context::tag::UNIT, std::move(parent) }
 		, m_name{ name }
+		, m_tree{ tree }
+	{
+		BindFrame(&m_slots, &m_slots);
+		AttachFrameOwner();
+	}
+
+	~UnitContext()
 	{
+		DetachFrameOwner();
 	}
 
 	DEFAULT_MAKE_CONTEXT(); //TODO: some contexts should be initiated from higher up
 
+	// Declare unit variable and assign the next unit slot.
+	void DeclareSlot(VarDecl& node, Valuedef::Value&& value)
+	{
+		const size_t slot = m_slotScope.size();
+		m_slotScope[node.Identifier()] = slot;
+		node.SetStorageSlot(slot);
+		PushSlot(slot, std::move(value));
+	}
+
+	// Declare the function at the position in the frozen tree.
+	void DeclareFunction(FlatTree::NodeHandle handle)
+	{
+		m_functionHandles[handle.As<FunctionDecl>()] = handle;
+	}
+
+	// Resolve the function slots once and return the frame size. Function
+	// bodies can be loaded on first use, and are therefore loaded, frozen
+	// and resolved when first invoked.
+	size_t ResolveFunction(FunctionDecl& node)
+	{
+		auto it = m_frameSizes.find(&node);
+		if (it == m_frameSizes.end()) {
+			const auto handle = m_functionHandles.find(&node);
+			if (handle == m_functionHandles.end()) {
+				throw std::logic_error{ "function '" + node.Identifier() + "' is not declared in unit" };
+			}
+			it = m_frameSizes.emplace(&node, SlotResolver{ m_slotScope }.Function(node, m_tree.FunctionBody(handle->second))).first;
+		}
+		return it->second;
+	}
+
 	/*template<typename Object, typename = typename std::enable_if<std::is_base_of<Context, std::decay<Object>::type>::value>::type>
 	void RegisterObject(Object&& object)
 	{
@@ -590,7 +838,7 @@ public:
 		}
 
 		// If only a function prototype was defined, let the parent context do the work
-		auto func = std::dynamic_pointer_cast<FunctionDecl>(node);
+		auto func = Util::NodeCast<FunctionDecl>(node);
 		if (func->IsPrototypeDefinition()) {
 			return ParentAs<GlobalContext>()->LookupSymbol<FunctionDecl>(symbol);
 		}
@@ -607,6 +855,11 @@ private:
 private:
 	//std::list<std::shared_ptr<AbstractContext>> m_objects;
 	std::string m_name;
+	const FlatTree& m_tree;
+	Frame m_slots;
+	std::unordered_map<std::string, size_t> m_slotScope;
+	std::unordered_map<const FunctionDecl *, FlatTree::NodeHandle> m_functionHandles;
+	std::unordered_map<const FunctionDecl *, size_t> m_frameSizes;
 };
 
 namespace Detail
@@ -625,7 +878,7 @@ struct MakeContextImpl
 	template<typename... Args>
 	auto operator()(Args&&... args)
 	{
-		return std::make_shared<ContextType>(std::move(contex), std::forward<Args>(args)...);
+		return std::allocate_shared<ContextType>(FrameAllocator<ContextType>{}, std::move(contex), std::forward<Args>(args)...);
 	}
 };
 
@@ -642,7 +895,7 @@ struct MakeContextImpl<FunctionContext>
 	template<typename... Args>
 	auto operator()(Args&&... args)
 	{
-		return std::make_shared<FunctionContext>(std::move(contex), std::forward<Args>(args)...);
+		return std::allocate_shared<FunctionContext>(FrameAllocator<FunctionContext>{}, std::move(contex), std::forward<Args>(args)...);
 	}
 };
 
@@ -661,6 +914,14 @@ public:
 		: AbstractContext{ Context::tag::FUNCTION, std::move(parent) }
 		, m_name{ name }
 	{
+		const auto registry = std::dynamic_pointer_cast<DeclarationRegistry>(m_parentContext);
+		BindFrame(&m_slots, registry ? registry->UnitFrame() : nullptr);
+		AttachFrameOwner();
+	}
+
+	~FunctionContext()
+	{
+		DetachFrameOwner();
 	}
 
 	template<typename ContextType, typename... ArgTypes>
@@ -676,8 +937,14 @@ public:
 		m_bodyContext = ctx;
 	}
 
+	// Mark the locals as referenced by address, the activation
+	// can no longer be replaced by a tail call.
+	inline void MarkAddressTaken() noexcept { m_addressTaken = true; }
+	// Test if the address of any local was taken.
+	inline bool IsAddressTaken() const noexcept { return m_addressTaken; }
+
 	// Find the value by identifier, if not found IdentifierNotFoundException is thrown.
-	virtual std::weak_ptr<Valuedef::Value> ValueByIdentifier(const std::string& key) override
+	virtual Valuedef::Value *ValueByIdentifier(const std::string& key) override
 	{
 		auto val = m_namedMap.find(key);
 		if (val == m_namedMap.end()) {
@@ -692,8 +959,7 @@ public:
 			return std::dynamic_pointer_cast<DeclarationRegistry>(Parent())->ValueByIdentifier(key);
 		}
 
-		// Get the value part from the tuple.
-		return std::get<std::shared_ptr<Valuedef::Value>>(val->second);
+		return val->second.value.get_ptr();
 	}
 
 private:
@@ -705,6 +971,8 @@ private:
 private:
 	Context::WeakCompound m_bodyContext;
 	std::string m_name;
+	Frame m_slots;
+	bool m_addressTaken{ false };
 };
 
 class CompoundContext
@@ -717,6 +985,9 @@ public:
 	CompoundContext(std::shared_ptr<ContextType>&& parent)
 		: AbstractContext{ Context::tag::COMPOUND, std::move(parent) }
 	{
+		const auto registry = std::dynamic_pointer_cast<DeclarationRegistry>(m_parentContext);
+		assert(registry);
+		BindFrame(registry->LocalFrame(), registry->UnitFrame());
 	}
 
 	template<typename ContextType, typename... Args>
@@ -727,15 +998,14 @@ public:
 	}
 
 	// Find the value by identifier, if not found IdentifierNotFoundException is thrown.
-	virtual std::weak_ptr<Valuedef::Value> ValueByIdentifier(const std::string& key) override
+	virtual Valuedef::Value *ValueByIdentifier(const std::string& key) override
 	{
 		auto val = m_namedMap.find(key);
 		if (val == m_namedMap.end()) {
 			return std::dynamic_pointer_cast<DeclarationRegistry>(Parent())->ValueByIdentifier(key);
 		}
 
-		// Get the value part from the tuple.
-		return std::get<std::shared_ptr<Valuedef::Value>>(val->second);
+		return val->second.value.get_ptr();
 	}
 
 private:
@@ -756,12 +1026,12 @@ class Runnable
 
 		// Convert paramters.
 		if (!funcNode->HasParameters()) { return; }
-		for (const auto& child : funcNode->ParameterStatement()->Children()) {
-			if (child.lock()->Label() == NodeID::VARIADIC_DECL_ID) {
+		for (ASTNode *child : funcNode->ParameterStatement()->ChildNodes()) {
+			if (child->Label() == NodeID::VARIADIC_DECL_ID) {
 				m_paramList.emplace_back("__va_list__");
 			}
 			else {
-				auto paramDecl = Util::NodeCast<ParamDecl>(child);
+				auto paramDecl = Util::Cast<ParamDecl>(child);
 				assert(paramDecl->HasReturnType());
 				m_paramList.emplace_back(paramDecl->Identifier(), paramDecl->ReturnType());
 			}
@@ -828,89 +1098,93 @@ private:
 	EVM::ExternalMethod::ParameterList m_paramList;
 };
 
-EVM::Context::Unit InitializeContext(AST& ast, std::shared_ptr<EVM::GlobalContext>& ctx)
+EVM::Context::Unit InitializeContext(const FlatTree& tree, std::shared_ptr<EVM::GlobalContext>& ctx)
 {
-	auto func = static_cast<TranslationUnitDecl&>(ast.Front());
-	return ctx->MakeContext<EVM::UnitContext>(func.Identifier());
+	auto unit = tree.Root().As<TranslationUnitDecl>();
+	return ctx->MakeContext<EVM::UnitContext>(unit->Identifier(), tree);
 }
 
 class Evaluator
 {
-	void Unit(const TranslationUnitDecl&);
+	void Unit(FlatTree::NodeHandle);
 
 public:
-	Evaluator(AST&&, std::shared_ptr<EVM::GlobalContext>&);
-	Evaluator(AST&&, std::shared_ptr<EVM::GlobalContext>&&);
+	Evaluator(const FlatTree&, std::shared_ptr<EVM::GlobalContext>&);
+	Evaluator(const FlatTree&, std::shared_ptr<EVM::GlobalContext>&&);
 
 	Evaluator& CallRoutine(const std::string&, const ArgumentList&);
 	int YieldResult();
 
-	static int CallFunction(AST&&, const std::string&, const ArgumentList&);
+	static int CallFunction(const FlatTree&, const std::string&, const ArgumentList&);
 
 private:
-	AST&& m_ast;
+	const FlatTree& m_tree;
 	EVM::Context::Unit m_unitContext;
 };
 
-Evaluator::Evaluator(AST&& ast, std::shared_ptr<EVM::GlobalContext>&& ctx)
-	: Evaluator{ std::move(ast), ctx }
+Evaluator::Evaluator(const FlatTree& tree, std::shared_ptr<EVM::GlobalContext>&& ctx)
+	: Evaluator{ tree, ctx }
 {
 }
 
-Evaluator::Evaluator(AST&& ast, std::shared_ptr<EVM::GlobalContext>& ctx)
-	: m_ast{ std::move(ast) }
-	, m_unitContext{ InitializeContext(m_ast, ctx) }
+Evaluator::Evaluator(const FlatTree& tree, std::shared_ptr<EVM::GlobalContext>& ctx)
+	: m_tree{ tree }
+	, m_unitContext{ InitializeContext(m_tree, ctx) }
 {
-	assert(IsTranslationUnitNode(m_ast.Front()));
-	EVM::DeclarationRegistry::ClearGlobalObject();
-	Unit(static_cast<TranslationUnitDecl&>(m_ast.Front()));
+	assert(m_tree.Root().Label() == NodeID::TRANSLATION_UNIT_DECL_ID);
+	Unit(m_tree.Root());
 }
 
 // Global scope, evaluate an entire unit and registger
 // toplevel objects such as records, variables and functions.
-void Evaluator::Unit(const TranslationUnitDecl& node)
+void Evaluator::Unit(FlatTree::NodeHandle unit)
 {
 	assert(m_unitContext);
-	for (const auto& weaknode : node.Children()) {
-		if (const auto ptr = weaknode.lock()) {
-			//TODO: switch can have more elements
-			switch (ptr->Label())
-			{
-			case NodeID::RECORD_DECL_ID: {
-				break;
-			}
-			case NodeID::TYPEDEF_DECL_ID: {
-				// Type definitions should already have been resolved in an earlier stage
-				// and thus is error checking alone sufficient.
-				auto typedefDecl = Util::NodeCast<TypedefDecl>(ptr);
-				if (!typedefDecl->HasReturnType()) {
-					throw std::logic_error{ "type alias is empty" };//TODO
-				}
-				break;
+	for (size_t i = 0; i < unit.ChildrenCount(); ++i) {
+		const auto handle = unit.Child(i);
+		ASTNode *ptr = handle.Node();
+		//TODO: switch can have more elements
+		switch (handle.Label())
+		{
+		case NodeID::RECORD_DECL_ID: {
+			break;
+		}
+		case NodeID::TYPEDEF_DECL_ID: {
+			// Type definitions should already have been resolved in an earlier stage
+			// and thus is error checking alone sufficient.
+			auto typedefDecl = Util::Cast<TypedefDecl>(ptr);
+			if (!typedefDecl->HasReturnType()) {
+				throw std::logic_error{ "type alias is empty" };//TODO
 			}
-			case NodeID::DECL_STMT_ID: {
-				for (const auto& child : ptr->Children()) {
-					auto varDecl = Util::NodeCast<VarDecl>(child);
-					if (varDecl->HasExpression()) {
-						if (Util::IsNodeLiteral(varDecl->Expression())) {
-							auto type = Util::NodeCast<Literal>(varDecl->Expression())->Value();
-							m_unitContext->PushVar({ varDecl->Identifier(), type });
-						}
-						else {
-							throw std::logic_error{ "initializer element is not constant" };//TODO
-						}
+			break;
+		}
+		case NodeID::DECL_STMT_ID: {
+			for (size_t j = 0; j < handle.ChildrenCount(); ++j) {
+				auto varDecl = handle.Child(j).As<VarDecl>();
+				if (varDecl->HasExpression()) {
+					if (Util::IsNodeLiteral(varDecl->Expression())) {
+						auto value = Util::NodeCast<Literal>(varDecl->Expression())->Value();
+						m_unitContext->DeclareSlot(*varDecl, std::move(value));
+					}
+					else {
+						throw std::logic_error{ "initializer element is not constant" };//TODO
 					}
 				}
-				break;
-			}
-			case NodeID::FUNCTION_DECL_ID: {
-				auto func = std::dynamic_pointer_cast<FunctionDecl>(ptr);
-				m_unitContext->RegisterSymbol(func->Identifier(), func);
-				break;
-			}
-			default:
-				CryImplExcept(); //TODO: THROW: statement or declaration is unqualified in global scope.
+				else {
+					auto returnType = varDecl->ReturnType();
+					m_unitContext->DeclareSlot(*varDecl, Valuedef::Value{ std::move(returnType) });
+				}
 			}
+			break;
+		}
+		case NodeID::FUNCTION_DECL_ID: {
+			auto func = handle.As<FunctionDecl>();
+			m_unitContext->RegisterSymbol(func->Identifier(), Util::Cast<FunctionDecl>(ptr->PolySelf()));
+			m_unitContext->DeclareFunction(handle);
+			break;
+		}
+		default:
+			CryImplExcept(); //TODO: THROW: statement or declaration is unqualified in global scope.
 		}
 	}
 }
@@ -1029,7 +1303,8 @@ void Invoke(const ExternalMethod *method, Context::Function& ctx)
 	ctx->AttachCompound(compCtx);
 	ExternalFunctionContext exCtx{ [&compCtx](const std::string& name) -> std::shared_ptr<Value>
 	{
-		return compCtx->ValueByIdentifier(name).lock();
+		// The value is owned by the context, the pointer does not share ownership.
+		return std::shared_ptr<Value>{ std::shared_ptr<Value>{}, compCtx->ValueByIdentifier(name) };
 	} };
 	method->Call(exCtx);
 	auto ptr = exCtx.GetReturn();
@@ -1048,9 +1323,23 @@ namespace InternalRoutine
 
 using namespace EVM;
 
-enum { RETURN_NORMAL, RETURN_BREAK, RETURN_RETURN };
+// Fetch the value from context by reference.
+//
+// Bound references index the frame directly, any other reference is looked up by
+// identifier in the context hierarchy.
+template<typename ContextType>
+Value *ReferenceValue(const DeclRefExpr& reference, ContextType& ctx)
+{
+	if (!reference.IsBound()) {
+		return ctx->ValueByIdentifier(reference.Identifier());
+	}
 
-int ExecuteStatement(const std::shared_ptr<ASTNode>&, Context::Compound&);
+	auto value = ctx->ValueBySlot(reference.BindingDepth(), reference.BindingSlot());
+	if (!value) {
+		throw IdentifierNotFoundException{ reference.Identifier() };
+	}
+	return value;
+}
 
 // Fetch the value from context by declaration.
 //
@@ -1059,41 +1348,98 @@ int ExecuteStatement(const std::shared_ptr<ASTNode>&, Context::Compound&);
 // context. The value must be present in the context at this point, or a runtime error will
 // occur.
 template<typename ContextType>
-std::shared_ptr<Value> DeclarationReference(const std::shared_ptr<ASTNode>& node, ContextType& ctx)
+Value *DeclarationReference(ASTNode *node, ContextType& ctx)
 {
 	switch (node->Label()) {
 
 		// Retrieve value via reference declaration.
 	case NodeID::DECL_REF_EXPR_ID:
-	{
-		const auto reference = Util::NodeCast<DeclRefExpr>(node);
-		return ctx->ValueByIdentifier(reference->Identifier()).lock();
-	}
+		return ReferenceValue(*Util::Cast<DeclRefExpr>(node), ctx);
 
 	// Retrieve member value via member declaration.
 	case NodeID::MEMBER_EXPR_ID:
 	{
-		const auto member = Util::NodeCast<MemberExpr>(node);
-		std::shared_ptr<Value> value = ctx->ValueByIdentifier(member->RecordRef()->Identifier()).lock(); //TODO: RecordRef -> RecordDeclaration
-		//return RecordProxy::MemberValue(value, member->FieldName()); //TODO
-		return nullptr;
+		const auto member = Util::Cast<MemberExpr>(node);
+		assert(member->IsResolved());
+
+		Value *value = ReferenceValue(*member->RecordRef(), ctx); //TODO: RecordRef -> RecordDeclaration
+		assert(value);
+
+		// The record pointer holds the address of the record declaration.
+		if (member->m_memberType == MemberExpr::MemberType::POINTER) {
+			const auto address = Util::EvaluateValueAsInteger(*value);
+			value = DeclarationRegistry::ValueByAddress(static_cast<DeclarationRegistry::OpaqueAddress::AddressType>(address));
+			if (!value) {
+				throw InvalidAddressException{};
+			}
+		}
+
+		// The record value is created from the record type on first access.
+		if (!Util::Isa<RecordValue>(*value)) {
+			(*value) = Value{ value->Type(), RecordValue{} };
+		}
+
+		// Field value is owned by the record value.
+		return std::addressof(value->Member<RecordValue>(member->FieldIndex()));
 	}
 
-	// Retrieve array item value via subscript declaration.
+	// Array elements are not stored as values, see ArrayElement.
 	case NodeID::ARRAY_SUBSCRIPT_EXPR_ID:
-	{
-		const auto subscr = Util::NodeCast<ArraySubscriptExpr>(node);
-		std::shared_ptr<Value> value = ctx->ValueByIdentifier(subscr->ArrayDeclaration()->Identifier()).lock();
-		Value offset = ResolveExpression(subscr->OffsetExpression(), ctx);
+		break;
 
-		//auto array = Util::ValueCastNative<int>(*value);//value->As<std::vector<int>>(); //TODO: could be any type
-		//return std::make_shared<Value>(Util::MakeInt(array[Util::ValueCastNative<int>(offset)])); //TODO: could be any integral type
-		return nullptr;
 	}
 
+	CryImplExcept(); //TODO
+}
+
+// Fetch the array value and the element offset from the subscript expression.
+//
+// The array value is created from the array type on first access. Elements are stored
+// in the typed element list of the array value and are accessed in place. The offset
+// expression must be evaluated by the caller. The bounds check setting is taken from
+// the caller, the execution state is not queried per element.
+template<typename ContextType>
+std::pair<Value *, size_t> ArraySubscript(ASTNode *node, const Value& offsetValue, ContextType& ctx, bool boundsCheck)
+{
+	const auto subscr = Util::Cast<ArraySubscriptExpr>(node);
+	Value *value = ReferenceValue(*subscr->ArrayDeclaration(), ctx);
+	assert(value);
+
+	if (!Util::Isa<ArrayValue>(*value)) {
+		(*value) = Value{ value->Type(), ArrayValue{} };
+	}
+
+	const auto offset = Util::EvaluateValueAsInteger(offsetValue);
+	if (offset < 0 && boundsCheck) {
+		throw OutOfBoundsException{};
 	}
 
-	CryImplExcept(); //TODO
+	return { value, static_cast<size_t>(offset) };
+}
+
+// Read array element.
+template<typename ContextType>
+Value ArrayElement(ASTNode *node, const Value& offsetValue, ContextType& ctx, bool boundsCheck)
+{
+	const auto[value, offset] = ArraySubscript(node, offsetValue, ctx, boundsCheck);
+	auto& array = value->As<ArrayValue>()->NativeValue();
+	if (boundsCheck) {
+		return array.ElementValue<true>(offset);
+	}
+	return array.ElementValue<false>(offset);
+}
+
+// Assign value to array element.
+template<typename ContextType>
+void ArrayElementAssign(ASTNode *node, const Value& offsetValue, const Value& elementValue, ContextType& ctx, bool boundsCheck)
+{
+	const auto[value, offset] = ArraySubscript(node, offsetValue, ctx, boundsCheck);
+	auto& array = value->As<ArrayValue>()->NativeValue();
+	if (boundsCheck) {
+		array.AssignElement<true>(offset, elementValue);
+		return;
+	}
+	array.AssignElement<false>(offset, elementValue);
 }
 
 //template<typename OperandPred, typename ContainerType = Valuedef::Value>
@@ -1114,544 +1460,942 @@ Value EvaluateInverse(const Value& value)
 
 //FUTURE: both operations can be improved.
 template<int Increment, typename OperandPred, typename ContextType>
-Value ValueAlteration(OperandPred predicate, UnaryOperator::OperandSide side, std::shared_ptr<ASTNode> node, ContextType& ctx)
+Value ValueAlteration(OperandPred predicate, UnaryOperator::OperandSide side, ASTNode *node, ContextType& ctx)
 {
-	std::shared_ptr<Value> value = DeclarationReference(node, ctx);
+	Value *value = DeclarationReference(node, ctx);
 	int result = predicate(Util::ValueCastNative<int>(*value), Increment); //TODO: not always an integer
 
 	// On postfix operand, copy the original first.
 	if (side == UnaryOperator::OperandSide::POSTFIX) {
-		auto origvalue = Value{ (*value.get()) };
+		auto origvalue = Value{ (*value) };
 		(*value) = Util::MakeInt(result); //TODO: not always an integer
 		return origvalue;
 	}
 
 	// On prefix, perform the unary operand on the original.
 	(*value) = Util::MakeInt(result); //TODO: not always an integer
-	return (*value.get());
+	return (*value);
+}
+
+// Array elements are altered in place in the typed element storage, the
+// operation is performed in the element type.
+template<int Increment, typename OperandPred, typename ContextType>
+Value ElementAlteration(OperandPred predicate, UnaryOperator::OperandSide side, ASTNode *node, const Value& offsetValue, ContextType& ctx, bool boundsCheck)
+{
+	const auto[value, offset] = ArraySubscript(node, offsetValue, ctx, boundsCheck);
+	auto& array = value->As<ArrayValue>()->NativeValue();
+	const auto operation = [&predicate](auto element) { return predicate(element, Increment); };
+
+	// On postfix operand, copy the original first.
+	if (side == UnaryOperator::OperandSide::POSTFIX) {
+		auto origvalue = boundsCheck
+			? array.ElementValue<true>(offset)
+			: array.ElementValue<false>(offset);
+		array.AlterElement<false>(offset, operation);
+		return origvalue;
+	}
+
+	if (boundsCheck) {
+		array.AlterElement<true>(offset, operation);
+	}
+	else {
+		array.AlterElement<false>(offset, operation);
+	}
+	return array.ElementValue<false>(offset);
+}
+
+// Binary operation performed by the compound assignment.
+BinaryOperator::BinOperand CompoundOperation(CompoundAssignOperator::CompoundAssignOperand operand)
+{
+	switch (operand) {
+	case CompoundAssignOperator::MUL: return BinaryOperator::BinOperand::MUL;
+	case CompoundAssignOperator::DIV: return BinaryOperator::BinOperand::DIV;
+	case CompoundAssignOperator::MOD: return BinaryOperator::BinOperand::MOD;
+	case CompoundAssignOperator::ADD: return BinaryOperator::BinOperand::PLUS;
+	case CompoundAssignOperator::SUB: return BinaryOperator::BinOperand::MINUS;
+	case CompoundAssignOperator::LEFT: return BinaryOperator::BinOperand::SLEFT;
+	case CompoundAssignOperator::RIGHT: return BinaryOperator::BinOperand::SRIGHT;
+	case CompoundAssignOperator::AND: return BinaryOperator::BinOperand::AND;
+	case CompoundAssignOperator::XOR: return BinaryOperator::BinOperand::XOR;
+	case CompoundAssignOperator::OR: return BinaryOperator::BinOperand::OR;
+	}
+
+	CryImplExcept(); //TODO
 }
 
 template<typename ContextType>
-Value ValueReference(std::shared_ptr<ASTNode> node, ContextType& ctx)
+Value ValueReference(ASTNode *node, ContextType& ctx)
 {
-	const auto declRef = Util::NodeCast<DeclRefExpr>(node);
-	DeclarationRegistry::OpaqueAddress address = ctx->AddressByIdentifier(declRef->Identifier());
+	const auto declRef = Util::Cast<DeclRefExpr>(node);
+	DeclarationRegistry::OpaqueAddress address = declRef->IsBound()
+		? ctx->AddressBySlot(declRef->BindingDepth(), declRef->BindingSlot())
+		: ctx->AddressByIdentifier(declRef->Identifier());
 	assert(!address.Expired());
 
 	//TODO: Util::MakePointer(address.address);
 	return Util::MakeInt(address.address);
 }
 
-template<typename ContextType>
-Value ResolveExpression(std::shared_ptr<ASTNode> node, ContextType& ctx)
+// Explicit stack evaluator.
+//
+// Statements and expressions are not evaluated by recursion on the host stack. Every
+// node is a task on the work stack which is stepped until the node is done. Operands
+// are scheduled as tasks on top of the node and their results are taken from the value
+// stack. A call schedules the function body on the same work stack, the depth of guest
+// recursion is therefore only bounded by the heap. A call in return position replaces
+// the frame of the calling function instead of growing the stack.
+class Machine final
 {
-	switch (node->Label())
+	enum class Kind : uint8_t
 	{
-		{
-			//
-			// Return literal types.
-			//
-		}
+		EXPRESSION,	// Evaluate expression, the result is pushed on the value stack.
+		STATEMENT,	// Execute statement.
+		BLOCK,		// Execute compound children in the context of the task.
+		CALL,		// Call function, the call is the boundary of the function frame.
+	};
 
-	case NodeID::CHARACTER_LITERAL_ID: {
-		return Util::NodeCast<CharacterLiteral>(node)->Value();
-	}
-	case NodeID::STRING_LITERAL_ID: {
-		return Util::NodeCast<StringLiteral>(node)->Value();
-	}
-	case NodeID::INTEGER_LITERAL_ID: {
-		return Util::NodeCast<IntegerLiteral>(node)->Value();
-	}
-	case NodeID::FLOAT_LITERAL_ID: {
-		return Util::NodeCast<FloatingLiteral>(node)->Value();
-	}
-	case NodeID::INIT_LIST_EXPR_ID: {
-		std::vector<int> dummyArray; //TODO: only only integer
-		const auto list = Util::NodeCast<InitListExpr>(node)->List();
-		std::transform(list.cbegin(), list.cend(), std::back_inserter(dummyArray), [&ctx](const std::shared_ptr<ASTNode>& value) -> int
-		{
-			return Util::ValueCastNative<int>(ResolveExpression(value, ctx));
-		});
+	enum class Signal
+	{
+		BREAK,
+		RETURN,
+	};
 
-		return Util::MakeIntArray(dummyArray);
-	}
+	// Steps of a call task.
+	enum : uint8_t
+	{
+		CALL_SETUP,
+		CALL_ARGUMENT,
+		CALL_ASSIGN,
+		CALL_INVOKE,
+		CALL_FINISH,
+	};
 
+	// Call task flags.
+	enum : uint8_t
 	{
-		//
-		// Operators.
-		//
-	}
+		CALL_RESULT = 1 << 0,	// Push the return value on the value stack.
+		CALL_TAIL = 1 << 1,		// Call is in return position.
+	};
 
-	case NodeID::BINARY_OPERATOR_ID: {
-		const auto op = std::dynamic_pointer_cast<BinaryOperator>(node);
+	// Unit of work on the work stack.
+	struct Task
+	{
+		Kind kind;
+		uint8_t step;
+		uint8_t flags;
+		size_t index;
+		ASTNode *node;
+		CompoundContext *ctx;
+		Context::Compound scope; // Context owned by the task, if any.
+	};
 
-		// If the binary operand is an assignment do it right now.
-		if (op->Operand() == BinaryOperator::BinOperand::ASSGN) {
+	// Function activation. The result context receives the return value if
+	// the activation was replaced by a tail call.
+	struct Frame
+	{
+		Runnable function;
+		Context::Function ctx;
+		Context::Function result;
+		Context::Compound body;
+	};
 
-			// The left hand side must be a lvalue and thus can be converted into an declaration
-			// reference. The declaration reference value is altered when the new value is assigned
-			// and as a consequence updates the declaration table entry.
-			const auto assignValue = DeclarationReference(op->LHS(), ctx);
+public:
+	// Call internal function.
+	void Invoke(std::shared_ptr<FunctionDecl>& funcNode, Context::Function& ctx)
+	{
+		m_frames.push_back(Frame{ Runnable{ funcNode }, ctx, ctx, nullptr });
+		m_tasks.push_back(Task{ Kind::CALL, CALL_FINISH, 0, 0, nullptr, nullptr, nullptr });
+		EnterFunction(m_frames.back());
+		Run();
+	}
 
-			//const auto assignValue = ctx->ValueByIdentifier(declRef->Identifier()).lock();
-			(*assignValue) = ResolveExpression(op->RHS(), ctx);
-			return (*assignValue.get());
+private:
+	// Step the top of the work stack until the work stack is empty.
+	void Run()
+	{
+		while (!m_tasks.empty()) {
+			switch (m_tasks.back().kind)
+			{
+			case Kind::EXPRESSION:
+				StepExpression();
+				break;
+			case Kind::STATEMENT:
+				StepStatement();
+				break;
+			case Kind::BLOCK:
+				StepBlock();
+				break;
+			case Kind::CALL:
+				StepCall();
+				break;
+			}
 		}
+	}
 
-		auto lhsValue = ResolveExpression(op->LHS(), ctx);
-		auto rhsValue = ResolveExpression(op->RHS(), ctx);
-		//return BinaryOperation(OperandFactory<int>(op->Operand()), lhsValue, rhsValue); //TODO: not always an integer
-		return std::invoke(OperandFactory{ op->Operand() }, lhsValue, rhsValue);
+	inline Value PopValue()
+	{
+		Value value = std::move(m_values.back());
+		m_values.pop_back();
+		return value;
 	}
-	case NodeID::CONDITIONAL_OPERATOR_ID: {
-		const auto op = std::dynamic_pointer_cast<ConditionalOperator>(node);
-		auto value = ResolveExpression(op->Expression(), ctx);
-		if (Util::EvaluateValueAsBoolean(value)) {
-			return ResolveExpression(op->TruthStatement(), ctx);
+
+	// Evaluate the expression. Expressions which do not have operands are evaluated in place
+	// and return true, any other expression is scheduled as a task. The task reference of the
+	// caller is no longer valid if the expression was scheduled.
+	bool PushExpression(ASTNode *node, CompoundContext *ctx)
+	{
+		// Enclosed expression.
+		while (node->Label() == NodeID::PAREN_EXPR_ID) {
+			auto expr = Util::Cast<ParenExpr>(node);
+			assert(expr->HasExpression());
+			node = expr->Expression().get();
 		}
 
-		// Handle alternative path.
-		return ResolveExpression(op->AltStatement(), ctx);
-	}
-	case NodeID::UNARY_OPERATOR_ID: {
-		const auto op = std::dynamic_pointer_cast<UnaryOperator>(node);
-		switch (op->Operand())
+		switch (node->Label())
 		{
-		case UnaryOperator::UnaryOperand::INC:
-			return ValueAlteration<1>(std::plus<int>(), op->OperationSide(), op->Expression(), ctx); //TODO: not always an integer
-		case UnaryOperator::UnaryOperand::DEC:
-			return ValueAlteration<1>(std::minus<int>(), op->OperationSide(), op->Expression(), ctx); //TODO: not always an integer
-
-			/*
-			case AST::UnaryOperator::UnaryOperand::INTPOS:
-				return ValueSignedness();
-			case AST::UnaryOperator::UnaryOperand::INTNEG:
-				return ValueSignedness();
-			*/
-
-		case UnaryOperator::UnaryOperand::ADDR:
-			return ValueReference(op->Expression(), ctx);
-		case UnaryOperator::UnaryOperand::PTRVAL:
-			//ValueIndirection();
+		case NodeID::CHARACTER_LITERAL_ID:
+			m_values.push_back(Util::Cast<CharacterLiteral>(node)->Value());
+			return true;
+		case NodeID::STRING_LITERAL_ID:
+			m_values.push_back(Util::Cast<StringLiteral>(node)->Value());
+			return true;
+		case NodeID::INTEGER_LITERAL_ID:
+			m_values.push_back(Util::Cast<IntegerLiteral>(node)->Value());
+			return true;
+		case NodeID::FLOAT_LITERAL_ID:
+			m_values.push_back(Util::Cast<FloatingLiteral>(node)->Value());
+			return true;
+		case NodeID::MEMBER_EXPR_ID:
+		case NodeID::DECL_REF_EXPR_ID:
+			m_values.push_back(*DeclarationReference(node, ctx));
+			return true;
+		case NodeID::IMPLICIT_CONVERTION_EXPR_ID:
+			m_values.push_back(Util::MakeInt(12)); //TODO: for now
+			return true;
+		case NodeID::CALL_EXPR_ID:
+			PushCall(node, ctx, CALL_RESULT);
+			return false;
+		default:
 			break;
-
-			//case AST::UnaryOperator::UnaryOperand::BITNOT:
-		case UnaryOperator::UnaryOperand::BOOLNOT:
-			return EvaluateInverse(ResolveExpression(op->Expression(), ctx));
 		}
-		CryImplExcept(); //TODO:
-	}
-	case NodeID::COMPOUND_ASSIGN_OPERATOR_ID: {
-		Util::NodeCast<CompoundAssignOperator>(node);
-		break;
+
+		m_tasks.push_back(Task{ Kind::EXPRESSION, 0, 0, 0, node, ctx, nullptr });
+		return false;
 	}
 
+	void PushStatement(ASTNode *node, CompoundContext *ctx)
 	{
-		//
-		// Return routine result.
-		//
+		EVM_PROFILE_ENTER_STATEMENT(*node);
+		m_tasks.push_back(Task{ Kind::STATEMENT, 0, 0, 0, node, ctx, nullptr });
 	}
 
-	case NodeID::CALL_EXPR_ID: {
-		auto op = Util::NodeCast<CallExpr>(node);
-		Context::Function funcCtx = CallExpression(op, ctx);
-		if (!funcCtx->HasReturnValue()) {
-			throw std::logic_error{ "function must return a value" }; //TODO:
-		}
-		return funcCtx->ReturnValue();
+	void PushBlock(ASTNode *node, CompoundContext *ctx)
+	{
+		m_tasks.push_back(Task{ Kind::BLOCK, 0, 0, 0, node, ctx, nullptr });
 	}
 
+	void PushCall(ASTNode *node, CompoundContext *ctx, uint8_t flags)
 	{
-		//
-		// Lookup symbol reference.
-		//
+		m_tasks.push_back(Task{ Kind::CALL, CALL_SETUP, flags, 0, node, ctx, nullptr });
 	}
 
-	case NodeID::MEMBER_EXPR_ID:
-	case NodeID::DECL_REF_EXPR_ID:
-	case NodeID::ARRAY_SUBSCRIPT_EXPR_ID: {
-		const auto value = DeclarationReference(node, ctx);
-		return (*value.get());
+	// Complete the expression on top of the work stack, the result must be on the value stack.
+	inline void CompleteExpression()
+	{
+		m_tasks.pop_back();
 	}
 
+	inline void CompleteStatement()
 	{
-		//
-		// Type casting.
-		//
+		EVM_PROFILE_LEAVE_STATEMENT();
+		m_tasks.pop_back();
 	}
 
-	case NodeID::IMPLICIT_CONVERTION_EXPR_ID: {
-		auto convRef = Util::NodeCast<ImplicitConvertionExpr>(node);
-		CRY_UNUSED(convRef);
-		return Util::MakeInt(12); //TODO: for now
+	static bool IsBreakTarget(const ASTNode& node)
+	{
+		switch (node.Label())
+		{
+		case NodeID::SWITCH_STMT_ID:
+		case NodeID::WHILE_STMT_ID:
+		case NodeID::DO_STMT_ID:
+		case NodeID::FOR_STMT_ID:
+			return true;
+		}
+
+		return false;
 	}
 
+	// Unwind the work stack to the task which handles the signal. A return is handled by
+	// the call of the current function, a break completes the innermost loop or switch.
+	void Unwind(Signal signal)
 	{
-		//
-		// Enclosed expression.
-		//
+		for (;;) {
+			Task& task = m_tasks.back();
+			if (task.kind == Kind::CALL) {
+				if (signal == Signal::BREAK) {
+					throw RuntimeException{ "break statement not within loop or switch" };
+				}
+				return;
+			}
+			if (task.kind == Kind::STATEMENT) {
+				if (signal == Signal::BREAK && IsBreakTarget(*task.node)) {
+					CompleteStatement();
+					return;
+				}
+				EVM_PROFILE_LEAVE_STATEMENT();
+			}
+			m_tasks.pop_back();
+		}
 	}
 
-	case NodeID::PAREN_EXPR_ID: {
-		auto expr = Util::NodeCast<ParenExpr>(node);
-		assert(expr->HasExpression());
-		return ResolveExpression(expr->Expression(), ctx);
+	// Run the function body in a new compound context.
+	void EnterFunction(Frame& frame)
+	{
+		auto funcNode = frame.function.Data<std::shared_ptr<FunctionDecl>>();
+		assert(funcNode->ChildrenCount());
+		EVM_PROFILE_ENTER_FUNCTION(*funcNode);
+
+		frame.body = frame.ctx->MakeContext<CompoundContext>();
+		frame.ctx->AttachCompound(frame.body);
+		PushBlock(funcNode->FunctionCompound().get(), frame.body.get());
 	}
 
-	default:
-		break;
+	void LeaveFunction(Frame& frame)
+	{
+		EVM_PROFILE_LEAVE_FUNCTION();
+		frame.body.reset();
 	}
 
-	CryImplExcept(); //TODO
-}
+	// Assign the argument to the function parameter.
+	void AssignArgument(Frame& frame, size_t index, Value&& value)
+	{
+		// Arguments past the last parameter belong to the variadic parameter.
+		const auto& params = frame.function.Parameters();
+		const size_t i = std::min(index, params.size() - 1);
+		if (params.at(i).Empty()) {
+			CryImplExcept(); //TODO: source.c:0:0: error: parameter name omitted to function 'funcNode'
+		}
+		if (params.at(i).IsVariadic()) {
+			std::string autoVA{ "__va_arg" + std::to_string(index - i) + "__" };
+			frame.ctx->PushVar(autoVA, std::move(value));
+			return;
+		}
 
-template<typename ContextType>
-Context::Function CallExpression(const std::shared_ptr<CallExpr>& callNode, ContextType& ctx)
-{
-	assert(callNode);
-	assert(callNode->ChildrenCount());
-	assert(callNode->FunctionReference()->IsResolved());
-	const std::string& functionIdentifier = callNode->FunctionReference()->Identifier();
-	Runnable function;
-
-	// Create a new function context. Depending on the parent context the new context
-	// is a direct hierarchical or a sub-hierarchical child.
-	Context::Function funcCtx = ctx->MakeContext<FunctionContext>(functionIdentifier);
-	assert(!funcCtx->HasLocalValues());
-
-	// The symbol is can be found in different places. The interpreter will locate
-	// the runnable object according to the following algorithm:
-	//   1.) Look for the symbol in the current program assuming it is a local object
-	//   2.) Request the symbol as an external routine (internal or external module)
-	//   3.) Throw an symbol not found exception halting from further execution
-	if (auto funcNode = ctx->FindContext<UnitContext>(Context::tag::UNIT)->LookupSymbol<FunctionDecl>(functionIdentifier)) {
-		function = funcNode;
-	}
-	else if (auto exfuncRef = GlobalExecutionState::FindExternalSymbol(functionIdentifier)) {
-		function = exfuncRef;
-	}
-	else {
-		CryImplExcept(); //TODO: symbol not found in internal or external module
+		if (params.at(i).DataType() != value.Type()) {
+			CryImplExcept(); //TODO: source.c:0:0: error: cannot convert argument of type 'X' to parameter type 'Y'
+		}
+		//TODO: check if param is pointer
+		// Parameters of program functions take the first slots of the frame.
+		if (frame.function.IsExternal()) {
+			frame.ctx->PushVar(params.at(i).Identifier(), std::move(value));
+		}
+		else {
+			frame.ctx->PushSlot(i, std::move(value));
+		}
 	}
 
-	// Check if call expression has arguments, if so assign paramters to the arguments
-	// and commit the arguments into the function context.
-	if (callNode->HasArguments() && function.HasArguments()) {
-		assert(callNode->ArgumentStatement()->ChildrenCount());
-		const auto argsDecls = callNode->ArgumentStatement()->Children();
+	// Create the function frame and locate the function.
+	//
+	// Depending on the parent context the new context is a direct hierarchical or a
+	// sub-hierarchical child. The symbol is can be found in different places. The
+	// interpreter will locate the runnable object according to the following algorithm:
+	//   1.) Use the external routine cached on the call expression
+	//   2.) Look for the symbol in the current program assuming it is a local object
+	//   3.) Request the symbol as an external routine (internal or external module)
+	//   4.) Throw an symbol not found exception halting from further execution
+	void SetupCall(CallExpr *callNode, CompoundContext *ctx)
+	{
+		assert(callNode->ChildrenCount());
+		assert(callNode->FunctionReference()->IsResolved());
+		const std::string& functionIdentifier = callNode->FunctionReference()->Identifier();
+		Runnable function;
+
+		Context::Function funcCtx = ctx->MakeContext<FunctionContext>(functionIdentifier);
+		assert(!funcCtx->HasLocalValues());
+
+		const auto unitCtx = ctx->FindContext<UnitContext>(Context::tag::UNIT);
+		const auto symbolEpoch = GlobalExecutionState::SymbolEpoch();
+		if (auto exfuncRef = static_cast<const ExternalMethod *>(callNode->CallTarget(symbolEpoch))) {
+			function = exfuncRef;
+		}
+		else if (auto funcNode = unitCtx->LookupSymbol<FunctionDecl>(functionIdentifier)) {
+			// Reserve the frame before any of the parameters are set.
+			funcCtx->ReserveFrame(unitCtx->ResolveFunction(*funcNode));
+			function = funcNode;
+		}
+		else if (auto exfuncRef = GlobalExecutionState::FindExternalSymbol(functionIdentifier)) {
+			callNode->SetCallTarget(exfuncRef, symbolEpoch);
+			function = exfuncRef;
+		}
+		else {
+			CryImplExcept(); //TODO: symbol not found in internal or external module
+		}
 
 		// Sanity check, should have been done by semer.
-		if (function.ArgumentSize() > argsDecls.size()) {
-			CryImplExcept(); //TODO: source.c:0:0: error: too many arguments to function 'funcNode'
+		if (callNode->HasArguments() && function.HasArguments()) {
+			const size_t argumentCount = callNode->ArgumentStatement()->ChildrenCount();
+			assert(argumentCount);
+			if (function.ArgumentSize() > argumentCount) {
+				CryImplExcept(); //TODO: source.c:0:0: error: too many arguments to function 'funcNode'
+			}
+			else if (function.ArgumentSize() < argumentCount && !function.Parameters().back().IsVariadic()) {
+				CryImplExcept(); //TODO: source.c:0:0: error: too few arguments to function 'funcNode'
+			}
 		}
-		else if (function.ArgumentSize() < argsDecls.size() && !function.Parameters().back().IsVariadic()) {
-			CryImplExcept(); //TODO: source.c:0:0: error: too few arguments to function 'funcNode'
+
+		m_frames.push_back(Frame{ std::move(function), funcCtx, funcCtx, nullptr });
+	}
+
+	// Replace the frame of the calling function by the frame of the callee. The return
+	// statement and any scope of the caller are unwound, and the contexts of the caller
+	// are released before the callee is entered. The callee context was allocated on top
+	// of the caller, the released chunks of the caller are taken by the next activation
+	// and the frame arena does not grow.
+	void TailCall()
+	{
+		Frame callee = std::move(m_frames.back());
+		m_frames.pop_back();
+		m_tasks.pop_back();
+		Unwind(Signal::RETURN);
+
+		Frame& frame = m_frames.back();
+		LeaveFunction(frame);
+		frame.function = std::move(callee.function);
+		frame.ctx = std::move(callee.ctx);
+		EnterFunction(frame);
+	}
+
+	// Call the routine with a new functional context. An new instance is created intentionally
+	// to restrict context scope, and to allow the compiler to RAII all resources. The return
+	// value of the routine is the result of the expression.
+	void StepCall()
+	{
+		Task& task = m_tasks.back();
+
+		switch (task.step)
+		{
+		case CALL_SETUP: {
+			const auto callNode = Util::Cast<CallExpr>(task.node);
+			SetupCall(callNode, task.ctx);
+			task.step = callNode->HasArguments() && m_frames.back().function.HasArguments()
+				? CALL_ARGUMENT
+				: CALL_INVOKE;
+			return;
 		}
 
-		// Assign function arguments to parameters.
-		int i = 0;
-		auto itArgs = argsDecls.cbegin();
-		while (itArgs != argsDecls.cend()) {
-			if (function.Parameters().at(i).Empty()) {
-				CryImplExcept(); //TODO: source.c:0:0: error: parameter name omitted to function 'funcNode'
+		// Evaluate the arguments in order and commit each argument to the function context.
+		case CALL_ARGUMENT:
+		case CALL_ASSIGN: {
+			Frame& frame = m_frames.back();
+			const auto& argsDecls = Util::Cast<CallExpr>(task.node)->ArgumentStatement()->ChildNodes();
+			if (task.step == CALL_ASSIGN) {
+				AssignArgument(frame, task.index - 1, PopValue());
 			}
-			if (function.Parameters().at(i).IsVariadic()) {
-				int v_i = 0;
-				while (itArgs != argsDecls.cend()) {
-					auto value = ResolveExpression(itArgs->lock(), ctx);
-					std::string autoVA{ "__va_arg" + std::to_string(v_i++) + "__" };
-					funcCtx->PushVar(autoVA, Valuedef::Value{ value });
-					++itArgs;
+			while (task.index < argsDecls.size()) {
+				task.step = CALL_ASSIGN;
+				if (!PushExpression(argsDecls[task.index++], task.ctx)) {
+					return;
 				}
-				break;
+				AssignArgument(frame, task.index - 1, PopValue());
 			}
-			else {
-				auto value = ResolveExpression(itArgs->lock(), ctx);
-				if (function.Parameters().at(i).DataType() != value.Type()) {
-					CryImplExcept(); //TODO: source.c:0:0: error: cannot convert argument of type 'X' to parameter type 'Y'
-				}
-				//TODO: check if param is pointer
-				funcCtx->PushVar(function.Parameters().at(i).Identifier(), Valuedef::Value{ value });
-				++itArgs;
-				++i;
+			task.step = CALL_INVOKE;
+			return;
+		}
+
+		case CALL_INVOKE: {
+			Frame& frame = m_frames.back();
+			if (frame.function.IsExternal()) {
+				ExternalRoutine::Invoke(frame.function.Data<const ExternalMethod*>(), frame.ctx);
+				task.step = CALL_FINISH;
+				return;
+			}
+			// The locals of the caller must outlive the call if their address was taken.
+			if ((task.flags & CALL_TAIL) && !m_frames[m_frames.size() - 2].ctx->IsAddressTaken()) {
+				TailCall();
+				return;
 			}
+			task.step = CALL_FINISH;
+			EnterFunction(frame);
+			return;
 		}
-	}
 
-	// Call the routine with a new functional context. An new instance is created intentionally
-	// to restrict context scope, and to allow the compiler to RAII all resources. The context
-	// is returned as the result of the expression.
-	assert(function);
-	if (function.IsExternal()) {
-		ExternalRoutine::Invoke(function.Data<const ExternalMethod*>(), funcCtx);
-	}
-	else {
-		auto func = function.Data<std::shared_ptr<FunctionDecl>>();
-		InternalRoutine::Invoke(func, funcCtx);
+		case CALL_FINISH: {
+			Frame& frame = m_frames.back();
+			if (!frame.function.IsExternal()) {
+				LeaveFunction(frame);
+			}
+			if (frame.ctx != frame.result && frame.ctx->HasReturnValue()) {
+				frame.result->CreateSpecialVar<RETURN_VALUE>(frame.ctx->ReturnValue());
+			}
+			if (task.flags & CALL_RESULT) {
+				if (!frame.result->HasReturnValue()) {
+					throw RuntimeException{ "control reached end of function without return value" };
+				}
+				m_values.push_back(frame.result->ReturnValue());
+			}
+			m_frames.pop_back();
+			m_tasks.pop_back();
+			return;
+		}
+		}
 	}
 
-	return funcCtx;
-}
+	// Run all nodes in the compound.
+	void StepBlock()
+	{
+		Task& task = m_tasks.back();
+		const auto& body = task.node->ChildNodes();
+		if (task.index == body.size()) {
+			m_tasks.pop_back();
+			return;
+		}
 
-// Run all nodes in the compound.
-template<typename Node>
-void ProcessCompound(const std::shared_ptr<Node>& node, Context::Compound& ctx)
-{
-	auto body = node->Children();
-	if (!body.size()) {
-		return; //TODO: Check if return type is void
+		PushStatement(body[task.index++], task.ctx);
 	}
 
-	// Process each child node.
-	for (const auto& childNode : body) {
-		auto child = childNode.lock();
-		auto returnType = ExecuteStatement(child, ctx);
-		switch (returnType)
+	void StepExpression()
+	{
+		Task& task = m_tasks.back();
+		ASTNode *node = task.node;
+		CompoundContext *ctx = task.ctx;
+
+		switch (node->Label())
 		{
-		case RETURN_RETURN:
-			goto done;
-		case RETURN_BREAK:
-			CryImplExcept(); //TODO: break statement not within loop or switch
+		case NodeID::INIT_LIST_EXPR_ID: {
+			const auto list = Util::Cast<InitListExpr>(node)->List();
+			while (task.index < list.size()) {
+				if (!PushExpression(list[task.index++].get(), ctx)) {
+					return;
+				}
+			}
+
+			std::vector<int> dummyArray; //TODO: only only integer
+			const size_t base = m_values.size() - list.size();
+			std::transform(m_values.cbegin() + base, m_values.cend(), std::back_inserter(dummyArray), [](const Value& value) -> int
+			{
+				return Util::ValueCastNative<int>(value);
+			});
+			m_values.resize(base);
+			m_values.push_back(Util::MakeIntArray(dummyArray));
+			break;
 		}
-	}
-done: {}
-}
 
-// Call internal function.
-void Invoke(std::shared_ptr<FunctionDecl>& funcNode, Context::Function& ctx)
-{
-	assert(funcNode->ChildrenCount());
-	if (funcNode->HasParameters()) {
-		//TODO: Do something?
-	}
+		case NodeID::BINARY_OPERATOR_ID: {
+			const auto op = Util::Cast<BinaryOperator>(node);
 
-	Context::Compound compCtx = ctx->MakeContext<CompoundContext>();
-	ctx->AttachCompound(compCtx);
-	ProcessCompound(const_cast<std::shared_ptr<CompoundStmt>&>(funcNode->FunctionCompound()), compCtx);
-	compCtx.reset();
-}
+			// If the binary operand is an assignment do it right now.
+			if (op->Operand() == BinaryOperator::BinOperand::ASSGN) {
+				if (task.step == 0) {
+					task.step = 1;
+					if (!PushExpression(op->RHS().get(), ctx)) { return; }
+				}
 
-// If all else fails, try the node as expression.
-void ProcessExpression(const std::shared_ptr<ASTNode>& node, Context::Compound& ctx)
-{
-	// Only execute the expression and ignore the result.
-	ResolveExpression(node, ctx);
-}
+				// Array elements are assigned in place, the assigned value is the result.
+				if (op->LHS()->Label() == NodeID::ARRAY_SUBSCRIPT_EXPR_ID) {
+					const auto subscr = Util::Cast<ArraySubscriptExpr>(op->LHS().get());
+					if (task.step == 1) {
+						task.step = 2;
+						if (!PushExpression(subscr->OffsetExpression().get(), ctx)) { return; }
+					}
+					const auto offset = PopValue();
+					ArrayElementAssign(subscr, offset, m_values.back(), ctx, m_boundsCheck);
+					break;
+				}
 
-// Register the declaration in the current context scope.
-void ProcessDeclaration(std::shared_ptr<DeclStmt>& declNode, Context::Compound& ctx)
-{
-	for (const auto& child : declNode->Children()) {
-		auto node = Util::NodeCast<VarDecl>(child);
-		assert(node->HasReturnType());
+				// The left hand side must be a lvalue and thus can be converted into an declaration
+				// reference. The declaration reference value is altered when the new value is assigned
+				// and as a consequence updates the declaration table entry.
+				const auto assignValue = DeclarationReference(op->LHS().get(), ctx);
+				(*assignValue) = m_values.back();
+				break;
+			}
 
-		if (node->HasExpression()) {
-			Valuedef::Value value = ResolveExpression(node->Expression(), ctx);
-			ctx->PushVar(node->Identifier(), std::move(value));
+			if (task.step == 0) {
+				task.step = 1;
+				if (!PushExpression(op->LHS().get(), ctx)) { return; }
+			}
+			if (task.step == 1) {
+				task.step = 2;
+				if (!PushExpression(op->RHS().get(), ctx)) { return; }
+			}
+
+			auto rhsValue = PopValue();
+			auto lhsValue = PopValue();
+			//return BinaryOperation(OperandFactory<int>(op->Operand()), lhsValue, rhsValue); //TODO: not always an integer
+			m_values.push_back(std::invoke(OperandFactory{ op->Operand() }, lhsValue, rhsValue));
+			break;
 		}
-		else {
-			auto returnType = node->ReturnType();
-			Valuedef::Value value = Valuedef::Value{ std::move(returnType) };
-			ctx->PushVar(node->Identifier(), std::move(value));
+
+		// The selected path replaces the conditional on the work stack.
+		case NodeID::CONDITIONAL_OPERATOR_ID: {
+			const auto op = Util::Cast<ConditionalOperator>(node);
+			if (task.step == 0) {
+				task.step = 1;
+				if (!PushExpression(op->Expression().get(), ctx)) { return; }
+			}
+
+			const bool truth = Util::EvaluateValueAsBoolean(PopValue());
+			CompleteExpression();
+			PushExpression(truth ? op->TruthStatement().get() : op->AltStatement().get(), ctx);
+			return;
 		}
-	}
-}
 
-// Run the expression and evaluate return values as boolean.
-int ProcessCondition(std::shared_ptr<IfStmt>& node, Context::Compound& ctx)
-{
-	auto value = ResolveExpression(node->Expression(), ctx);
-	if (Util::EvaluateValueAsBoolean(value)) {
-		if (node->HasTruthCompound()) {
-			auto continueNode = node->TruthCompound();
-			if (Util::IsNodeCompound(continueNode)) {
-				auto compoundNode = Util::NodeCast<CompoundStmt>(continueNode);
-				ProcessCompound(compoundNode, ctx);
+		case NodeID::UNARY_OPERATOR_ID: {
+			const auto op = Util::Cast<UnaryOperator>(node);
+			ASTNode *operand = op->Expression().get();
+			switch (op->Operand())
+			{
+			case UnaryOperator::UnaryOperand::INC:
+			case UnaryOperator::UnaryOperand::DEC: {
+				const bool increment = op->Operand() == UnaryOperator::UnaryOperand::INC;
+				if (operand->Label() != NodeID::ARRAY_SUBSCRIPT_EXPR_ID) {
+					m_values.push_back(increment
+						? ValueAlteration<1>(std::plus<int>(), op->OperationSide(), operand, ctx) //TODO: not always an integer
+						: ValueAlteration<1>(std::minus<int>(), op->OperationSide(), operand, ctx)); //TODO: not always an integer
+					break;
+				}
+
+				const auto subscr = Util::Cast<ArraySubscriptExpr>(operand);
+				if (task.step == 0) {
+					task.step = 1;
+					if (!PushExpression(subscr->OffsetExpression().get(), ctx)) { return; }
+				}
+				const auto offset = PopValue();
+				m_values.push_back(increment
+					? ElementAlteration<1>(std::plus<>(), op->OperationSide(), operand, offset, ctx, m_boundsCheck)
+					: ElementAlteration<1>(std::minus<>(), op->OperationSide(), operand, offset, ctx, m_boundsCheck));
+				break;
 			}
-			else {
-				auto compoundNode = Util::NodeCast<ASTNode>(continueNode);
-				return ExecuteStatement(compoundNode, ctx);
+
+				/*
+				case AST::UnaryOperator::UnaryOperand::INTPOS:
+					return ValueSignedness();
+				case AST::UnaryOperator::UnaryOperand::INTNEG:
+					return ValueSignedness();
+				*/
+
+			case UnaryOperator::UnaryOperand::ADDR:
+				if (auto funcCtx = ctx->FindContext<FunctionContext>(Context::tag::FUNCTION)) {
+					funcCtx->MarkAddressTaken();
+				}
+				m_values.push_back(ValueReference(operand, ctx));
+				break;
+			case UnaryOperator::UnaryOperand::PTRVAL:
+				//ValueIndirection();
+				CryImplExcept(); //TODO:
+
+				//case AST::UnaryOperator::UnaryOperand::BITNOT:
+			case UnaryOperator::UnaryOperand::BOOLNOT:
+				if (task.step == 0) {
+					task.step = 1;
+					if (!PushExpression(operand, ctx)) { return; }
+				}
+				m_values.push_back(EvaluateInverse(PopValue()));
+				break;
+			default:
+				CryImplExcept(); //TODO:
 			}
+			break;
 		}
-	}
-	// Handle alternative path, if defined.
-	else if (node->HasAltCompound()) {
-		auto continueNode = node->AltCompound();
-		if (Util::IsNodeCompound(continueNode)) {
-			auto compoundNode = Util::NodeCast<CompoundStmt>(continueNode);
-			ProcessCompound(compoundNode, ctx);
+
+		case NodeID::ARRAY_SUBSCRIPT_EXPR_ID: {
+			const auto subscr = Util::Cast<ArraySubscriptExpr>(node);
+			if (task.step == 0) {
+				task.step = 1;
+				if (!PushExpression(subscr->OffsetExpression().get(), ctx)) { return; }
+			}
+			const auto offset = PopValue();
+			m_values.push_back(ArrayElement(node, offset, ctx, m_boundsCheck));
+			break;
 		}
-		else {
-			auto compoundNode = Util::NodeCast<ASTNode>(continueNode);
-			return ExecuteStatement(compoundNode, ctx);
+
+		// Compound assignment computes the operation on the current value and assigns
+		// the result, the assigned value is the result.
+		case NodeID::COMPOUND_ASSIGN_OPERATOR_ID: {
+			const auto op = Util::Cast<CompoundAssignOperator>(node);
+			if (task.step == 0) {
+				task.step = 1;
+				if (!PushExpression(op->Expression().get(), ctx)) { return; }
+			}
+
+			const OperandFactory operation{ CompoundOperation(op->Operand()) };
+
+			// Array elements are read and assigned in place.
+			ASTNode *lhs = op->Identifier().get();
+			if (lhs->Label() == NodeID::ARRAY_SUBSCRIPT_EXPR_ID) {
+				const auto subscr = Util::Cast<ArraySubscriptExpr>(lhs);
+				if (task.step == 1) {
+					task.step = 2;
+					if (!PushExpression(subscr->OffsetExpression().get(), ctx)) { return; }
+				}
+				const auto offset = PopValue();
+				auto result = std::invoke(operation, ArrayElement(subscr, offset, ctx, m_boundsCheck), m_values.back());
+				ArrayElementAssign(subscr, offset, result, ctx, m_boundsCheck);
+				m_values.back() = std::move(result);
+				break;
+			}
+
+			const auto assignValue = DeclarationReference(lhs, ctx);
+			(*assignValue) = std::invoke(operation, (*assignValue), m_values.back());
+			m_values.back() = (*assignValue);
+			break;
+		}
+
+		default:
+			CryImplExcept(); //TODO
 		}
+
+		CompleteExpression();
 	}
 
-	return RETURN_NORMAL;
-}
+	// Run the statement.
+	void StepStatement()
+	{
+		Task& task = m_tasks.back();
+		ASTNode *node = task.node;
+		CompoundContext *ctx = task.ctx;
 
-// Process the switch statement.
-int ProcessSwitch(std::shared_ptr<SwitchStmt>& node, Context::Compound& ctx)
-{
-	if (!node->HasBodyExpression()) { return RETURN_NORMAL; } //TODO: set warning about useless statement
+		switch (node->Label())
+		{
+		// Create new compound context.
+		case NodeID::COMPOUND_STMT_ID: {
+			if (task.step == 0) {
+				task.step = 1;
+				task.scope = ctx->MakeContext<CompoundContext>();
+				PushBlock(node, task.scope.get());
+				return;
+			}
+			break;
+		}
 
-	// Body node must be compound in order to be executable.
-	if (node->BodyExpression()->Label() != NodeID::COMPOUND_STMT_ID) {
-		//TODO: set warning about non-executable
-		return RETURN_NORMAL;
-	}
+		// Call without using the return value.
+		case NodeID::CALL_EXPR_ID: {
+			if (task.step == 0) {
+				task.step = 1;
+				PushCall(node, ctx, 0);
+				return;
+			}
+			break;
+		}
 
-	auto value = ResolveExpression(node->Expression(), ctx);
-	auto compoundNode = Util::NodeCast<CompoundStmt>(node->BodyExpression());
+		// Register the declaration in the current context scope.
+		case NodeID::DECL_STMT_ID: {
+			const auto& decls = node->ChildNodes();
+			if (task.step == 1) {
+				task.step = 0;
+				StoreDeclaration(Util::Cast<VarDecl>(decls[task.index - 1]), PopValue(), ctx);
+			}
+			while (task.index < decls.size()) {
+				auto declNode = Util::Cast<VarDecl>(decls[task.index++]);
+				assert(declNode->HasReturnType());
+				if (declNode->HasExpression()) {
+					task.step = 1;
+					if (!PushExpression(declNode->Expression().get(), ctx)) { return; }
+					task.step = 0;
+					StoreDeclaration(declNode, PopValue(), ctx);
+					continue;
+				}
 
-	// Process compound within the switch statement instead of calling process compound
-	// since the switch body compound semantically differs from a generic compound block.
-	Context::Compound compCtx = ctx->MakeContext<CompoundContext>();
-	{
-		auto body = compoundNode->Children();
-		if (!body.size()) {
-			return RETURN_NORMAL; //TODO: set warning: empty statement
+				auto returnType = declNode->ReturnType();
+				StoreDeclaration(declNode, Valuedef::Value{ std::move(returnType) }, ctx);
+			}
+			break;
 		}
 
-		// Process each child node.
-		for (const auto& childNode : body) {
-			auto child = childNode.lock();
-			if (child->Label() != NodeID::CASE_STMT_ID) {
-				continue; //TODO: set warning: statement will never be executed
+		// Run the expression and evaluate return values as boolean. The
+		// compound of the path is run in the current context.
+		case NodeID::IF_STMT_ID: {
+			const auto ifNode = Util::Cast<IfStmt>(node);
+			if (task.step == 0) {
+				task.step = 1;
+				if (!PushExpression(ifNode->Expression().get(), ctx)) { return; }
 			}
-			auto caseNode = Util::NodeCast<CaseStmt>(child);
-			if (!Util::IsNodeLiteral(caseNode->Identifier())) {
-				CryImplExcept(); //TODO: case label must be integer constant
+			if (task.step == 1) {
+				task.step = 2;
+				const auto& continueNode = Util::EvaluateValueAsBoolean(PopValue())
+					? ifNode->TruthCompound()
+					: ifNode->AltCompound();
+				if (continueNode) {
+					if (Util::IsNodeCompound(continueNode)) {
+						PushBlock(continueNode.get(), ctx);
+					}
+					else {
+						PushStatement(continueNode.get(), ctx);
+					}
+					return;
+				}
+			}
+			break;
+		}
+
+		// Process the switch statement. Only the statement of the matching case label
+		// is run in a new compound context.
+		case NodeID::SWITCH_STMT_ID: {
+			const auto switchNode = Util::Cast<SwitchStmt>(node);
+			if (!switchNode->HasBodyExpression()) { break; } //TODO: set warning about useless statement
+
+			// Body node must be compound in order to be executable.
+			if (switchNode->BodyExpression()->Label() != NodeID::COMPOUND_STMT_ID) {
+				//TODO: set warning about non-executable
+				break;
+			}
+
+			if (task.step == 0) {
+				task.step = 1;
+				if (!PushExpression(switchNode->Expression().get(), ctx)) { return; }
 			}
-			auto literal = Util::NodeCast<Literal>(caseNode->Identifier());
-			const int caseLabelInt = Util::EvaluateValueAsInteger(literal->Value());
-			const int valueInt = Util::EvaluateValueAsInteger(value);
-			if (caseLabelInt == valueInt) {
-				return ExecuteStatement(caseNode->Expression(), compCtx);
+			if (task.step == 1) {
+				task.step = 2;
+				const int valueInt = Util::EvaluateValueAsInteger(PopValue());
+				for (ASTNode *child : switchNode->BodyExpression()->ChildNodes()) {
+					if (child->Label() != NodeID::CASE_STMT_ID) {
+						continue; //TODO: set warning: statement will never be executed
+					}
+					auto caseNode = Util::Cast<CaseStmt>(child);
+					if (!Util::IsNodeLiteral(caseNode->Identifier())) {
+						CryImplExcept(); //TODO: case label must be integer constant
+					}
+					auto literal = Util::NodeCast<Literal>(caseNode->Identifier());
+					if (Util::EvaluateValueAsInteger(literal->Value()) == valueInt) {
+						task.scope = ctx->MakeContext<CompoundContext>();
+						PushStatement(caseNode->Expression().get(), task.scope.get());
+						return;
+					}
+				}
 			}
+			break;
 		}
-	}
 
-	compCtx.reset();
-	return RETURN_NORMAL;
-}
+		// Execute body statement as long as expression is true.
+		case NodeID::WHILE_STMT_ID: {
+			const auto whileNode = Util::Cast<WhileStmt>(node);
+			if (!whileNode->HasBodyExpression()) { break; }
+			if (task.step == 0) {
+				task.step = 1;
+				if (!PushExpression(whileNode->Expression().get(), ctx)) { return; }
+			}
+			if (!Util::EvaluateValueAsBoolean(PopValue())) { break; }
+			task.step = 0;
+			PushStatement(whileNode->BodyExpression().get(), ctx);
+			return;
+		}
 
-// Execute body statement as long as expression is true.
-void ProcessWhileLoop(std::shared_ptr<WhileStmt>& node, Context::Compound& ctx)
-{
-	if (!node->HasBodyExpression()) { return; }
-	while (Util::EvaluateValueAsBoolean(ResolveExpression(node->Expression(), ctx))) {
-		ExecuteStatement(node->BodyExpression(), ctx);
-	}
-}
+		// Execute body statement once and then as long as expression is true.
+		case NodeID::DO_STMT_ID: {
+			const auto doNode = Util::Cast<DoStmt>(node);
+			if (!doNode->HasBodyExpression()) { break; }
+			if (task.step == 0) {
+				task.step = 1;
+				PushStatement(doNode->BodyExpression().get(), ctx);
+				return;
+			}
+			if (task.step == 1) {
+				task.step = 2;
+				if (!PushExpression(doNode->Expression().get(), ctx)) { return; }
+			}
+			if (!Util::EvaluateValueAsBoolean(PopValue())) { break; }
+			task.step = 1;
+			PushStatement(doNode->BodyExpression().get(), ctx);
+			return;
+		}
 
-// Execute body statement once and then as long as expression is true.
-void ProcessDoLoop(std::shared_ptr<DoStmt>& node, Context::Compound& ctx)
-{
-	if (!node->HasBodyExpression()) { return; }
-	do {
-		ExecuteStatement(node->BodyExpression(), ctx);
-	} while (Util::EvaluateValueAsBoolean(ResolveExpression(node->Expression(), ctx)));
-}
+		// Loop over statement unil expression is false.
+		case NodeID::FOR_STMT_ID: {
+			const auto forNode = Util::Cast<ForStmt>(node);
+			if (!forNode->HasBodyExpression()) { break; }
+			switch (task.step)
+			{
+			case 0:
+				task.step = 1;
+				PushStatement(forNode->Declaration().get(), ctx);
+				return;
+			case 1:
+				task.step = 2;
+				if (!PushExpression(forNode->Expression().get(), ctx)) { return; }
+				[[fallthrough]];
+			case 2:
+				if (!Util::EvaluateValueAsBoolean(PopValue())) { break; }
+				task.step = 3;
+				PushStatement(forNode->BodyExpression().get(), ctx);
+				return;
+			case 3:
+				task.step = 1;
+				PushStatement(forNode->FinishStatement().get(), ctx);
+				return;
+			}
+			break;
+		}
 
-// Loop over statement unil expression is false.
-void ProcessForLoop(std::shared_ptr<ForStmt>& node, Context::Compound& ctx)
-{
-	if (!node->HasBodyExpression()) { return; }
-	for (ExecuteStatement(node->Declaration(), ctx);
-		Util::EvaluateValueAsBoolean(ResolveExpression(node->Expression(), ctx));
-		ExecuteStatement(node->FinishStatement(), ctx)) {
-		ExecuteStatement(node->BodyExpression(), ctx);
-	}
-}
+		case NodeID::BREAK_STMT_ID: {
+			Unwind(Signal::BREAK);
+			return;
+		}
 
-// Return from function with either special value or none.
-void ProcessReturn(std::shared_ptr<ReturnStmt>& node, Context::Function& ctx)
-{
-	// Create explicit return type.
-	if (!node->HasExpression()) {
-		//TODO: Why not empty?
-		//ctx->CreateSpecialVar<RETURN_VALUE>(CoilCl::Util::MakeVoid());
-		return;
-	}
+		// Return from function with either special value or none. A call in return
+		// position is a tail call.
+		case NodeID::RETURN_STMT_ID: {
+			const auto returnNode = Util::Cast<ReturnStmt>(node);
+			if (!returnNode->HasExpression()) {
+				//TODO: Why not empty?
+				//ctx->CreateSpecialVar<RETURN_VALUE>(CoilCl::Util::MakeVoid());
+				Unwind(Signal::RETURN);
+				return;
+			}
 
-	// Resolve return expression.
-	ctx->CreateSpecialVar<RETURN_VALUE>(ResolveExpression(node->Expression(), ctx));
-}
+			if (task.step == 0) {
+				task.step = 1;
+				ASTNode *expr = returnNode->Expression().get();
+				while (expr->Label() == NodeID::PAREN_EXPR_ID) {
+					expr = Util::Cast<ParenExpr>(expr)->Expression().get();
+				}
+				if (expr->Label() == NodeID::CALL_EXPR_ID) {
+					PushCall(expr, ctx, CALL_RESULT | CALL_TAIL);
+					return;
+				}
+				if (!PushExpression(expr, ctx)) { return; }
+			}
 
-// Create new compound context.
-void CreateCompound(const std::shared_ptr<ASTNode>& node, Context::Compound& ctx)
-{
-	auto compNode = Util::NodeCast<CompoundStmt>(node);
-	Context::Compound compCtx = ctx->MakeContext<CompoundContext>();
-	ProcessCompound(compNode, compCtx);
-	compCtx.reset();
-}
+			m_frames.back().ctx->CreateSpecialVar<RETURN_VALUE>(PopValue());
+			Unwind(Signal::RETURN);
+			return;
+		}
 
-// Run the statement.
-int ExecuteStatement(const std::shared_ptr<ASTNode>& childNode, Context::Compound& ctx)
-{
-	switch (childNode->Label())
-	{
-	case NodeID::COMPOUND_STMT_ID: {
-		auto node = Util::NodeCast<CompoundStmt>(childNode);
-		CreateCompound(node, ctx);
-		break;
-	}
-	case NodeID::CALL_EXPR_ID: {
-		auto node = Util::NodeCast<CallExpr>(childNode);
-		CallExpression(node, ctx);
-		break;
-	}
-	case NodeID::DECL_STMT_ID: {
-		auto node = Util::NodeCast<DeclStmt>(childNode);
-		ProcessDeclaration(node, ctx);
-		break;
-	}
-	case NodeID::IF_STMT_ID: {
-		auto node = Util::NodeCast<IfStmt>(childNode);
-		if (ProcessCondition(node, ctx) == RETURN_RETURN) {
-			return RETURN_RETURN;
+		// If all else fails, try the node as expression and ignore the result.
+		default: {
+			if (task.step == 0) {
+				task.step = 1;
+				if (!PushExpression(node, ctx)) { return; }
+			}
+			m_values.pop_back();
+			break;
 		}
-		break;
-	}
-	case NodeID::SWITCH_STMT_ID: {
-		auto node = Util::NodeCast<SwitchStmt>(childNode);
-		if (ProcessSwitch(node, ctx) == RETURN_RETURN) {
-			return RETURN_RETURN;
 		}
-		break;
-	}
-	case NodeID::WHILE_STMT_ID: {
-		auto node = Util::NodeCast<WhileStmt>(childNode);
-		ProcessWhileLoop(node, ctx);
-		break;
-	}
-	case NodeID::DO_STMT_ID: {
-		auto node = Util::NodeCast<DoStmt>(childNode);
-		ProcessDoLoop(node, ctx);
-		break;
-	}
-	case NodeID::FOR_STMT_ID: {
-		auto node = Util::NodeCast<ForStmt>(childNode);
-		ProcessForLoop(node, ctx);
-		break;
-	}
-	case NodeID::BREAK_STMT_ID: {
-		return RETURN_BREAK;
-	}
-	case NodeID::RETURN_STMT_ID: {
-		auto node = Util::NodeCast<ReturnStmt>(childNode);
-		Context::Function funcCtx = ctx->FindContext<FunctionContext>(Context::tag::FUNCTION);
-		assert(funcCtx);
-		ProcessReturn(node, funcCtx);
-		return RETURN_RETURN;
+
+		CompleteStatement();
 	}
-	default:
-		ProcessExpression(childNode, ctx);
+
+	static void StoreDeclaration(VarDecl *node, Valuedef::Value&& value, CompoundContext *ctx)
+	{
+		if (node->HasStorageSlot()) {
+			ctx->PushSlot(node->StorageSlot(), std::move(value));
+		}
+		else {
+			ctx->PushVar(node->Identifier(), std::move(value));
+		}
 	}
 
-	return RETURN_NORMAL;
+private:
+	std::vector<Task> m_tasks;
+	std::vector<Value> m_values;
+	std::vector<Frame> m_frames;
+	// Bounds check setting, read once for the activation.
+	const bool m_boundsCheck{ GlobalExecutionState::IsBoundsCheckEnabled() };
+};
+
+// Call internal function.
+void Invoke(std::shared_ptr<FunctionDecl>& funcNode, Context::Function& ctx)
+{
+	Machine{}.Invoke(funcNode, ctx);
 }
 
 } // namespace InternalRoutine
@@ -1697,15 +2441,20 @@ Parameters ConvertToValueDef(const ArgumentList&& args)
 //   1.) argc, the argument count.
 //   2.) argv, an array to string literal parameters.
 //   3.) envp, an array to string literal environment variables.
-void FormatStartupParameters(std::array<std::string, 3> mapper, Parameters&& params, EVM::Context::Function& ctx)
+void FormatStartupParameters(size_t count, Parameters&& params, EVM::Context::Function& ctx)
 {
 	if (params.empty()) { return; }
 
 	//TODO: Capture the environment variables
 
-	ctx->PushVar({ mapper[0], Util::MakeInt(static_cast<int>(params.size())) });
-	ctx->PushVar({ mapper[1], Util::MakeFloatArray({872.21f}) }); //TODO: Util::MakeArray
-	ctx->PushVar({ mapper[2], Util::MakeString("test") }); //TODO: Util::MakeArray
+	// The startup parameters take the first slots of the frame.
+	ctx->PushSlot(0, Util::MakeInt(static_cast<int>(params.size())));
+	if (count > 1) {
+		ctx->PushSlot(1, Util::MakeFloatArray({ 872.21f })); //TODO: Util::MakeArray
+	}
+	if (count > 2) {
+		ctx->PushSlot(2, Util::MakeString("test")); //TODO: Util::MakeArray
+	}
 }
 
 } // namespace
@@ -1717,24 +2466,17 @@ Evaluator& Evaluator::CallRoutine(const std::string& symbol, const ArgumentList&
 
 	auto funcNode = m_unitContext->LookupSymbol<FunctionDecl>(symbol);
 	Context::Function funcCtx = m_unitContext->MakeContext<FunctionContext>(funcNode->Identifier());
+	funcCtx->ReserveFrame(m_unitContext->ResolveFunction(*funcNode));
 
 	// If the entry function does not accept parameters, then there is no point in
 	// converting the passed arguments. Likewise skip argument parsing if there are
 	// no commandline arguments supplied.
 	if (funcNode->HasParameters() && !args.empty()) {
-		std::string argv = "argv";
-		std::string envp = "envp";
-		std::string argc = Util::NodeCast<ParamDecl>(funcNode->ParameterStatement()->Children()[0])->Identifier();
-		if (funcNode->ParameterStatement()->ChildrenCount() > 1) {
-			argv = Util::NodeCast<ParamDecl>(funcNode->ParameterStatement()->Children()[1])->Identifier();
-		}
-		if (funcNode->ParameterStatement()->ChildrenCount() > 2) {
-			envp = Util::NodeCast<ParamDecl>(funcNode->ParameterStatement()->Children()[2])->Identifier();
-		}
-		if (funcNode->ParameterStatement()->ChildrenCount() > 3) {
+		const size_t count = funcNode->ParameterStatement()->ChildrenCount();
+		if (count > 3) {
 			CryImplExcept(); //TODO
 		}
-		FormatStartupParameters({ argc, argv, envp }, ConvertToValueDef(std::move(args)), funcCtx);
+		FormatStartupParameters(count, ConvertToValueDef(std::move(args)), funcCtx);
 	}
 
 	// Go run the startup routine.
@@ -1768,9 +2510,9 @@ int Evaluator::YieldResult()
 	return EXIT_SUCCESS;
 }
 
-int Evaluator::CallFunction(AST&& ast, const std::string& symbol, const ArgumentList& args)
+int Evaluator::CallFunction(const FlatTree& tree, const std::string& symbol, const ArgumentList& args)
 {
-	return Evaluator{ std::move(ast), EVM::Context::MakeGlobalContext() }
+	return Evaluator{ tree, EVM::Context::MakeGlobalContext() }
 		.CallRoutine(symbol, args)
 		.YieldResult();
 }
@@ -1802,8 +2544,8 @@ Interpreter::ReturnCode Interpreter::Execute(const std::string& entry
 	// Check if program can be run by this executor.
 	PreliminaryCheck(entry);
 
-	// Call entry point routine.
-	return Evaluator::CallFunction(Program()->Ast(), entry, args);
+	// Call entry point routine. The unit is walked on the frozen tree.
+	return Evaluator::CallFunction(Program()->FlatAst(), entry, args);
 }
 
 } // namespace EVM
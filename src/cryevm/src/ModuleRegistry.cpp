@@ -0,0 +1,165 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include "ModuleRegistry.h"
+#include "Functional.h"
+
+// Framework includes.
+#include <Cry/Config.h>
+#include <Cry/Loader.h>
+
+#include <algorithm>
+#include <fstream>
+#include <mutex>
+
+#define MANIFEST_EXTENSION ".manifest"
+
+namespace Loader = Cry::Module;
+
+namespace EVM
+{
+
+namespace
+{
+
+bool IsModuleFile(const boost::filesystem::path& file)
+{
+	return std::any_of(g_moduleExtensions.cbegin(), g_moduleExtensions.cend(), [&file](const std::string& ext) {
+		return file.extension() == ext;
+	});
+}
+
+} // namespace
+
+ModuleRegistry& ModuleRegistry::Instance()
+{
+	static ModuleRegistry registry{ DIST_BINARY_DIR };
+	return registry;
+}
+
+// Load the local symbols first, module symbols cannot override local
+// symbols. If the directory does not exist only the local symbols are
+// available.
+ModuleRegistry::ModuleRegistry(const std::string& directory)
+{
+	Merge(EVM::SymbolIndex());
+
+	const boost::filesystem::path path{ directory };
+	if (boost::filesystem::is_directory(path)) {
+		Scan(path);
+	}
+}
+
+ModuleRegistry::~ModuleRegistry()
+{
+	for (const auto& module : m_modules) {
+		module->OnUnload();
+	}
+}
+
+void ModuleRegistry::Scan(const boost::filesystem::path& path)
+{
+	for (const boost::filesystem::directory_entry& entry : boost::filesystem::directory_iterator(path)) {
+		const auto& file = entry.path();
+		if (!boost::filesystem::is_regular_file(file) || !IsModuleFile(file)) {
+			continue;
+		}
+
+		// Defer loading when the module has a manifest.
+		auto manifest = file;
+		manifest.replace_extension(MANIFEST_EXTENSION);
+		if (boost::filesystem::is_regular_file(manifest)) {
+			ReadManifest(manifest, file);
+			continue;
+		}
+
+		try {
+			LoadModule(file);
+		}
+		catch (const Loader::LoaderException&) {
+			continue;
+		}
+	}
+}
+
+// Register each symbol in the manifest. Empty lines and lines
+// starting with '#' are ignored.
+void ModuleRegistry::ReadManifest(const boost::filesystem::path& manifest, const boost::filesystem::path& module)
+{
+	std::ifstream stream{ manifest.string() };
+	std::string line;
+	while (std::getline(stream, line)) {
+		line.erase(0, line.find_first_not_of(" \t"));
+		line.erase(line.find_last_not_of(" \t\r") + 1);
+		if (line.empty() || line.front() == '#') { continue; }
+		m_manifestTable.emplace(std::move(line), module);
+	}
+}
+
+void ModuleRegistry::LoadModule(const boost::filesystem::path& file)
+{
+	if (!m_loadedFiles.insert(file.string()).second) { return; }
+
+	auto module = Loader::Detail::LoadAsModule<RuntimeInterface>(file, RuntimeInterface::GetComponentId());
+	module.Load();
+
+	std::list<ExternalMethod> symbolList;
+	module->LoadSymbolIndex(symbolList);
+	Merge(std::move(symbolList));
+
+	m_modules.push_back(module.operator->());
+}
+
+// The first registered method wins on duplicate symbols.
+void ModuleRegistry::Merge(std::list<ExternalMethod>&& symbolList)
+{
+	if (symbolList.empty()) { return; }
+
+	// Splicing keeps the iterators valid, the list nodes are not copied.
+	auto it = symbolList.begin();
+	m_symbolList.splice(m_symbolList.end(), symbolList);
+	for (; it != m_symbolList.end(); ++it) {
+		m_symbolTable.emplace(it->Symbol(), &(*it));
+	}
+}
+
+const ExternalMethod *ModuleRegistry::Find(const std::string& symbol)
+{
+	{
+		std::shared_lock<std::shared_mutex> lock{ m_mutex };
+		const auto it = m_symbolTable.find(symbol);
+		if (it != m_symbolTable.cend()) { return it->second; }
+		if (m_manifestTable.find(symbol) == m_manifestTable.cend()) { return nullptr; }
+	}
+
+	// Load the module listing the symbol. Another thread could have
+	// loaded the module in the mean time.
+	std::unique_lock<std::shared_mutex> lock{ m_mutex };
+	const auto itManifest = m_manifestTable.find(symbol);
+	if (itManifest != m_manifestTable.cend()) {
+		const auto file = itManifest->second;
+		m_manifestTable.erase(itManifest);
+		try {
+			LoadModule(file);
+		}
+		catch (const Loader::LoaderException&) {
+			return nullptr;
+		}
+	}
+
+	const auto it = m_symbolTable.find(symbol);
+	return it != m_symbolTable.cend() ? it->second : nullptr;
+}
+
+size_t ModuleRegistry::LoadedModuleCount() const
+{
+	std::shared_lock<std::shared_mutex> lock{ m_mutex };
+	return m_modules.size();
+}
+
+} // namespace EVM
@@ -0,0 +1,71 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+#include <CryEVM/ExternalMethod.h>
+#include <CryEVM/RuntimeInterface.h>
+
+#include <boost/filesystem.hpp>
+
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+#include <shared_mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace EVM
+{
+
+// Process wide registry of external symbols.
+//
+// The registry is created on first use and holds the local symbol index
+// and the symbols of the runtime modules. The module directory is scanned
+// once. A module can ship a manifest next to the module file, a text file
+// with the same name and the '.manifest' extension listing one exported
+// symbol per line. Modules with a manifest are only loaded when one of
+// the listed symbols is requested, modules without a manifest are loaded
+// during the scan. Loaded modules stay loaded for the lifetime of the
+// process. Symbols are never removed, returned methods remain valid.
+class ModuleRegistry final
+{
+public:
+	// Registry for the distribution module directory.
+	static ModuleRegistry& Instance();
+
+	explicit ModuleRegistry(const std::string& directory);
+	~ModuleRegistry();
+
+	ModuleRegistry(const ModuleRegistry&) = delete;
+	ModuleRegistry& operator=(const ModuleRegistry&) = delete;
+
+	// Find an external symbol, returns either external method or nullptr. If
+	// the symbol is listed in a manifest the module is loaded first.
+	const ExternalMethod *Find(const std::string&);
+
+	// Number of modules loaded so far.
+	size_t LoadedModuleCount() const;
+
+private:
+	void Scan(const boost::filesystem::path&);
+	void ReadManifest(const boost::filesystem::path& manifest, const boost::filesystem::path& module);
+	void LoadModule(const boost::filesystem::path&);
+	void Merge(std::list<ExternalMethod>&&);
+
+private:
+	mutable std::shared_mutex m_mutex;
+	std::list<ExternalMethod> m_symbolList;
+	std::unordered_map<std::string, const ExternalMethod *> m_symbolTable;
+	std::unordered_map<std::string, boost::filesystem::path> m_manifestTable;
+	std::unordered_set<std::string> m_loadedFiles;
+	std::vector<std::shared_ptr<RuntimeInterface>> m_modules;
+};
+
+} // namespace EVM
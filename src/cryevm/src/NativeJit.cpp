@@ -0,0 +1,721 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include "NativeJit.h"
+
+// Project includes.
+#include <CryCC/SubValue.h>
+
+// Framework includes.
+#include <Cry/Cry.h>
+
+// Language includes.
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+#include <stdexcept>
+#include <unordered_map>
+
+#ifdef EVM_NATIVE_JIT
+# include <sys/mman.h>
+#endif
+
+#define ENTRY_SYMBOL "main"
+
+using namespace CryCC::Program::Casm;
+using namespace CryCC::SubValue::Valuedef;
+
+namespace
+{
+
+constexpr const size_t npos = static_cast<size_t>(-1);
+
+// Largest frame and global area with slot offsets encoded as 32 bit
+// displacements in any instruction, including the callee frame offset.
+constexpr const Word maxAreaSize = 1 << 24;
+// Number of slots reserved for the value stack.
+constexpr const size_t stackSlots = 1 << 25;
+
+// Reason the generated code returned to the host.
+enum Trap : int32_t
+{
+	TRAP_NONE,
+	TRAP_DIVISION_BY_ZERO,
+	TRAP_OUT_OF_BOUNDS,
+	TRAP_CALL_DEPTH,
+	TRAP_COUNT,
+};
+
+// Register state shared between the host and the generated code, the
+// field offsets are encoded in the generated code. While the generated
+// code runs the registers hold:
+//
+//   rbx  base of the current frame, slot n at [rbx + n * 8]
+//   r12  base of the global area
+//   r14d remaining call depth
+//   r15  this context
+//
+// All other registers are scratch registers, functions return the
+// result slot in rax.
+struct Context
+{
+	Slot *globals;
+	Slot *stackLimit;
+	void *savedStack;
+	int32_t depth;
+	int32_t status;
+};
+
+using EnterFunction = uint64_t(*)(Context *, Slot *, const void *);
+
+struct Fixup
+{
+	size_t at;
+	size_t target;
+};
+
+inline int32_t SlotOffset(size_t slot) noexcept
+{
+	return static_cast<int32_t>(slot * sizeof(Slot));
+}
+
+inline int32_t FieldOffset(size_t offset) noexcept
+{
+	return static_cast<int32_t>(offset);
+}
+
+// Machine code buffer.
+class Emitter final
+{
+public:
+	inline size_t Offset() const noexcept { return m_code.size(); }
+	inline const std::vector<unsigned char>& Code() const noexcept { return m_code; }
+
+	void Bytes(std::initializer_list<unsigned char> bytes)
+	{
+		m_code.insert(m_code.end(), bytes);
+	}
+
+	void Imm32(int32_t value)
+	{
+		unsigned char bytes[sizeof(value)];
+		std::memcpy(bytes, &value, sizeof(value));
+		m_code.insert(m_code.end(), std::begin(bytes), std::end(bytes));
+	}
+
+	void Imm64(uint64_t value)
+	{
+		unsigned char bytes[sizeof(value)];
+		std::memcpy(bytes, &value, sizeof(value));
+		m_code.insert(m_code.end(), std::begin(bytes), std::end(bytes));
+	}
+
+	// Instruction ending in a 32 bit displacement or immediate.
+	void Op32(std::initializer_list<unsigned char> bytes, int32_t value)
+	{
+		Bytes(bytes);
+		Imm32(value);
+	}
+
+	// Instruction ending in a relative target, returns the position
+	// of the target for the fixup.
+	size_t Rel32(std::initializer_list<unsigned char> bytes)
+	{
+		Op32(bytes, 0);
+		return Offset() - sizeof(int32_t);
+	}
+
+	void Patch(size_t at, size_t target)
+	{
+		const int32_t rel = static_cast<int32_t>(static_cast<ptrdiff_t>(target) - static_cast<ptrdiff_t>(at + sizeof(int32_t)));
+		std::memcpy(m_code.data() + at, &rel, sizeof(rel));
+	}
+
+	// mov eax, [rbx + slot]
+	void LoadEax(Word slot) { Op32({ 0x8B, 0x83 }, SlotOffset(slot)); }
+	// mov ecx, [rbx + slot]
+	void LoadEcx(Word slot) { Op32({ 0x8B, 0x8B }, SlotOffset(slot)); }
+	// mov [rbx + slot], eax
+	void StoreEax(Word slot) { Op32({ 0x89, 0x83 }, SlotOffset(slot)); }
+	// mov rax, [rbx + slot]
+	void LoadRax(Word slot) { Op32({ 0x48, 0x8B, 0x83 }, SlotOffset(slot)); }
+	// mov [rbx + slot], rax
+	void StoreRax(Word slot) { Op32({ 0x48, 0x89, 0x83 }, SlotOffset(slot)); }
+
+private:
+	std::vector<unsigned char> m_code;
+};
+
+bool IsNativeOpcode(Opcode opcode) noexcept
+{
+	switch (opcode) {
+	case Opcode::NOP:
+	case Opcode::LOADK:
+	case Opcode::LOADI:
+	case Opcode::MOV:
+	case Opcode::LOADG:
+	case Opcode::STOREG:
+	case Opcode::LOADX:
+	case Opcode::STOREX:
+	case Opcode::ADDI:
+	case Opcode::SUBI:
+	case Opcode::MULI:
+	case Opcode::DIVI:
+	case Opcode::MODI:
+	case Opcode::ANDI:
+	case Opcode::ORI:
+	case Opcode::XORI:
+	case Opcode::SHLI:
+	case Opcode::SHRI:
+	case Opcode::EQI:
+	case Opcode::NEI:
+	case Opcode::LTI:
+	case Opcode::LEI:
+	case Opcode::GTI:
+	case Opcode::GEI:
+	case Opcode::ADDIK:
+	case Opcode::NEGI:
+	case Opcode::NOT:
+	case Opcode::BNOT:
+	case Opcode::JMP:
+	case Opcode::JZ:
+	case Opcode::JNZ:
+	case Opcode::CALL:
+	case Opcode::RET:
+	case Opcode::RETV:
+		return true;
+	default:
+		break;
+	}
+
+	return false;
+}
+
+// Select the functions which can be compiled. A function is dropped
+// if it calls a dropped function, which is repeated until no more
+// functions are dropped.
+std::vector<bool> SelectFunctions(const Module& module)
+{
+	const auto& functions = module.Functions();
+	std::vector<bool> selected(functions.size(), module.GlobalSize() <= maxAreaSize);
+	std::vector<std::vector<Word>> callees(functions.size());
+
+	for (size_t i = 0; i < functions.size(); ++i) {
+		const auto& code = functions[i].code;
+		if (functions[i].frameSize > maxAreaSize) {
+			selected[i] = false;
+		}
+
+		for (size_t pc = 0; selected[i] && pc < code.size();) {
+			const size_t length = InstructionLength(code.data() + pc, code.size() - pc);
+			const Opcode opcode = static_cast<Opcode>(code[pc]);
+			if (!length || !IsNativeOpcode(opcode)) {
+				selected[i] = false;
+				break;
+			}
+			if (opcode == Opcode::CALL) {
+				callees[i].push_back(code[pc + 2]);
+			}
+			pc += length;
+		}
+	}
+
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (size_t i = 0; i < functions.size(); ++i) {
+			if (selected[i] && std::any_of(callees[i].cbegin(), callees[i].cend(), [&selected](Word callee) { return !selected[callee]; })) {
+				selected[i] = false;
+				changed = true;
+			}
+		}
+	}
+
+	return selected;
+}
+
+// Slot image of the constant. String constants are never loaded
+// into a slot as a value and are left empty.
+uint64_t ConstantImage(const Constant& constant) noexcept
+{
+	uint64_t image = 0;
+	if (const auto value = std::get_if<int32_t>(&constant)) {
+		std::memcpy(&image, value, sizeof(*value));
+	}
+	else if (const auto value = std::get_if<double>(&constant)) {
+		std::memcpy(&image, value, sizeof(*value));
+	}
+	return image;
+}
+
+// Translate the function, each instruction is replaced by its template.
+// Branches are resolved once the function is complete, calls are
+// resolved by the caller once all functions are placed. Returns false
+// if the function has an instruction without template.
+bool EmitFunction(Emitter& e, const Module& module, const Function& function, const size_t *traps, std::vector<Fixup>& calls)
+{
+	const Word *code = function.code.data();
+	const size_t size = function.code.size();
+	std::unordered_map<size_t, size_t> labels;
+	std::vector<Fixup> jumps;
+
+	const auto jumpTarget = [](size_t pc, Word offset)
+	{
+		return static_cast<size_t>(static_cast<ptrdiff_t>(pc) + static_cast<int32_t>(offset));
+	};
+
+	const auto binary = [&e](std::initializer_list<unsigned char> op, const Word *pc)
+	{
+		e.LoadEax(pc[2]);
+		e.Op32(op, SlotOffset(pc[3]));
+		e.StoreEax(pc[1]);
+	};
+
+	// Compare and materialize the condition code as 0 or 1.
+	const auto compare = [&e](unsigned char cc, const Word *pc)
+	{
+		e.LoadEax(pc[2]);
+		e.Op32({ 0x3B, 0x83 }, SlotOffset(pc[3])); // cmp eax, [rbx + c]
+		e.Bytes({ 0x0F, cc, 0xC0 }); // setcc al
+		e.Bytes({ 0x0F, 0xB6, 0xC0 }); // movzx eax, al
+		e.StoreEax(pc[1]);
+	};
+
+	const auto shift = [&e](unsigned char op, const Word *pc)
+	{
+		e.LoadEax(pc[2]);
+		e.LoadEcx(pc[3]);
+		e.Bytes({ 0xD3, op }); // shl/sar eax, cl
+		e.StoreEax(pc[1]);
+	};
+
+	// Division by minus one is handled apart, the processor faults on
+	// the smallest integer divided by minus one.
+	const auto divide = [&e, traps](bool remainder, const Word *pc)
+	{
+		e.LoadEax(pc[2]);
+		e.LoadEcx(pc[3]);
+		e.Bytes({ 0x85, 0xC9 }); // test ecx, ecx
+		e.Patch(e.Rel32({ 0x0F, 0x84 }), traps[TRAP_DIVISION_BY_ZERO]); // jz trap
+		e.Bytes({ 0x83, 0xF9, 0xFF }); // cmp ecx, -1
+		e.Bytes({ 0x75, 0x04 }); // jne divide
+		if (remainder) {
+			e.Bytes({ 0x31, 0xC0 }); // xor eax, eax
+			e.Bytes({ 0xEB, 0x05 }); // jmp done
+			e.Bytes({ 0x99, 0xF7, 0xF9 }); // divide: cdq; idiv ecx
+			e.Bytes({ 0x89, 0xD0 }); // mov eax, edx
+		}
+		else {
+			e.Bytes({ 0xF7, 0xD8 }); // neg eax
+			e.Bytes({ 0xEB, 0x03 }); // jmp done
+			e.Bytes({ 0x99, 0xF7, 0xF9 }); // divide: cdq; idiv ecx
+		}
+		e.StoreEax(pc[1]); // done
+	};
+
+	for (size_t offset = 0; offset < size; offset += InstructionLength(code + offset, size - offset)) {
+		labels.emplace(offset, e.Offset());
+		const Word *pc = code + offset;
+
+		switch (static_cast<Opcode>(pc[0])) {
+		case Opcode::NOP:
+			break;
+		case Opcode::LOADK:
+			e.Bytes({ 0x48, 0xB8 }); // mov rax, imm64
+			e.Imm64(ConstantImage(module.Constants()[pc[2]]));
+			e.StoreRax(pc[1]);
+			break;
+		case Opcode::LOADI:
+			e.Op32({ 0xC7, 0x83 }, SlotOffset(pc[1])); // mov dword [rbx + a], imm32
+			e.Imm32(static_cast<int32_t>(pc[2]));
+			break;
+		case Opcode::MOV:
+			e.LoadRax(pc[2]);
+			e.StoreRax(pc[1]);
+			break;
+		case Opcode::LOADG:
+			e.Op32({ 0x49, 0x8B, 0x84, 0x24 }, SlotOffset(pc[2])); // mov rax, [r12 + b]
+			e.StoreRax(pc[1]);
+			break;
+		case Opcode::STOREG:
+			e.LoadRax(pc[2]);
+			e.Op32({ 0x49, 0x89, 0x84, 0x24 }, SlotOffset(pc[1])); // mov [r12 + a], rax
+			break;
+
+		// The index is compared unsigned, negative indices are out of bounds.
+		case Opcode::LOADX:
+			e.LoadEax(pc[3]);
+			e.Op32({ 0x3D }, static_cast<int32_t>(pc[4])); // cmp eax, d
+			e.Patch(e.Rel32({ 0x0F, 0x83 }), traps[TRAP_OUT_OF_BOUNDS]); // jae trap
+			e.Op32({ 0x48, 0x8B, 0x84, 0xC3 }, SlotOffset(pc[2])); // mov rax, [rbx + rax * 8 + b]
+			e.StoreRax(pc[1]);
+			break;
+		case Opcode::STOREX:
+			e.LoadEax(pc[2]);
+			e.Op32({ 0x3D }, static_cast<int32_t>(pc[4])); // cmp eax, d
+			e.Patch(e.Rel32({ 0x0F, 0x83 }), traps[TRAP_OUT_OF_BOUNDS]); // jae trap
+			e.Op32({ 0x48, 0x8B, 0x8B }, SlotOffset(pc[3])); // mov rcx, [rbx + c]
+			e.Op32({ 0x48, 0x89, 0x8C, 0xC3 }, SlotOffset(pc[1])); // mov [rbx + rax * 8 + a], rcx
+			break;
+
+		case Opcode::ADDI:
+			binary({ 0x03, 0x83 }, pc); // add eax, [rbx + c]
+			break;
+		case Opcode::SUBI:
+			binary({ 0x2B, 0x83 }, pc); // sub eax, [rbx + c]
+			break;
+		case Opcode::MULI:
+			binary({ 0x0F, 0xAF, 0x83 }, pc); // imul eax, [rbx + c]
+			break;
+		case Opcode::DIVI:
+			divide(false, pc);
+			break;
+		case Opcode::MODI:
+			divide(true, pc);
+			break;
+		case Opcode::ANDI:
+			binary({ 0x23, 0x83 }, pc); // and eax, [rbx + c]
+			break;
+		case Opcode::ORI:
+			binary({ 0x0B, 0x83 }, pc); // or eax, [rbx + c]
+			break;
+		case Opcode::XORI:
+			binary({ 0x33, 0x83 }, pc); // xor eax, [rbx + c]
+			break;
+		case Opcode::SHLI:
+			shift(0xE0, pc);
+			break;
+		case Opcode::SHRI:
+			shift(0xF8, pc);
+			break;
+		case Opcode::EQI:
+			compare(0x94, pc);
+			break;
+		case Opcode::NEI:
+			compare(0x95, pc);
+			break;
+		case Opcode::LTI:
+			compare(0x9C, pc);
+			break;
+		case Opcode::LEI:
+			compare(0x9E, pc);
+			break;
+		case Opcode::GTI:
+			compare(0x9F, pc);
+			break;
+		case Opcode::GEI:
+			compare(0x9D, pc);
+			break;
+		case Opcode::ADDIK:
+			e.LoadEax(pc[2]);
+			e.Op32({ 0x05 }, static_cast<int32_t>(pc[3])); // add eax, imm32
+			e.StoreEax(pc[1]);
+			break;
+
+		case Opcode::NEGI:
+			e.LoadEax(pc[2]);
+			e.Bytes({ 0xF7, 0xD8 }); // neg eax
+			e.StoreEax(pc[1]);
+			break;
+		case Opcode::NOT:
+			e.LoadEax(pc[2]);
+			e.Bytes({ 0x85, 0xC0 }); // test eax, eax
+			e.Bytes({ 0x0F, 0x94, 0xC0 }); // sete al
+			e.Bytes({ 0x0F, 0xB6, 0xC0 }); // movzx eax, al
+			e.StoreEax(pc[1]);
+			break;
+		case Opcode::BNOT:
+			e.LoadEax(pc[2]);
+			e.Bytes({ 0xF7, 0xD0 }); // not eax
+			e.StoreEax(pc[1]);
+			break;
+
+		case Opcode::JMP:
+			jumps.push_back(Fixup{ e.Rel32({ 0xE9 }), jumpTarget(offset, pc[1]) });
+			break;
+		case Opcode::JZ:
+			e.LoadEax(pc[1]);
+			e.Bytes({ 0x85, 0xC0 }); // test eax, eax
+			jumps.push_back(Fixup{ e.Rel32({ 0x0F, 0x84 }), jumpTarget(offset, pc[2]) });
+			break;
+		case Opcode::JNZ:
+			e.LoadEax(pc[1]);
+			e.Bytes({ 0x85, 0xC0 }); // test eax, eax
+			jumps.push_back(Fixup{ e.Rel32({ 0x0F, 0x85 }), jumpTarget(offset, pc[2]) });
+			break;
+
+		// The callee frame is placed directly above the caller frame, the
+		// frame base is moved for the duration of the call.
+		case Opcode::CALL: {
+			const Word frameSize = function.frameSize;
+			const Word calleeSize = module.Functions()[pc[2]].frameSize;
+			const Word argc = pc[3];
+
+			e.Bytes({ 0x45, 0x85, 0xF6 }); // test r14d, r14d
+			e.Patch(e.Rel32({ 0x0F, 0x84 }), traps[TRAP_CALL_DEPTH]); // jz trap
+			e.Op32({ 0x48, 0x8D, 0x83 }, SlotOffset(static_cast<size_t>(frameSize) + calleeSize)); // lea rax, [rbx + top]
+			e.Op32({ 0x49, 0x3B, 0x87 }, FieldOffset(offsetof(Context, stackLimit))); // cmp rax, [r15 + limit]
+			e.Patch(e.Rel32({ 0x0F, 0x87 }), traps[TRAP_CALL_DEPTH]); // ja trap
+
+			if (calleeSize) {
+				e.Op32({ 0x48, 0x8D, 0xBB }, SlotOffset(frameSize)); // lea rdi, [rbx + frame]
+				e.Op32({ 0xB9 }, static_cast<int32_t>(calleeSize)); // mov ecx, size
+				e.Bytes({ 0x31, 0xC0 }); // xor eax, eax
+				e.Bytes({ 0xF3, 0x48, 0xAB }); // rep stosq
+			}
+			for (Word i = 0; i < argc; ++i) {
+				e.LoadRax(pc[4 + i]);
+				e.StoreRax(frameSize + i);
+			}
+
+			e.Bytes({ 0x41, 0xFF, 0xCE }); // dec r14d
+			e.Op32({ 0x48, 0x81, 0xC3 }, SlotOffset(frameSize)); // add rbx, frame
+			calls.push_back(Fixup{ e.Rel32({ 0xE8 }), pc[2] }); // call function
+			e.Op32({ 0x48, 0x81, 0xEB }, SlotOffset(frameSize)); // sub rbx, frame
+			e.Bytes({ 0x41, 0xFF, 0xC6 }); // inc r14d
+			e.StoreRax(pc[1]);
+			break;
+		}
+		case Opcode::RET:
+			e.LoadRax(pc[1]);
+			e.Bytes({ 0xC3 }); // ret
+			break;
+		case Opcode::RETV:
+			e.Bytes({ 0x31, 0xC0 }); // xor eax, eax
+			e.Bytes({ 0xC3 }); // ret
+			break;
+
+		default:
+			return false;
+		}
+	}
+
+	// The verifier guarantees all jump targets are instruction boundaries.
+	for (const auto& jump : jumps) {
+		e.Patch(jump.at, labels.at(jump.target));
+	}
+
+	return true;
+}
+
+} // namespace
+
+namespace EVM
+{
+
+NativeModule::NativeModule(const Module& module)
+	: m_module{ module }
+	, m_entries(module.Functions().size(), npos)
+{
+	if (IsSupported()) {
+		Compile();
+	}
+}
+
+NativeModule::~NativeModule()
+{
+#ifdef EVM_NATIVE_JIT
+	if (m_code) {
+		::munmap(m_code, m_codeSize);
+	}
+	if (m_stack) {
+		::munmap(m_stack, m_stackSize * sizeof(Slot));
+	}
+#endif
+}
+
+bool NativeModule::IsSupported() noexcept
+{
+#ifdef EVM_NATIVE_JIT
+	return true;
+#else
+	return false;
+#endif
+}
+
+bool NativeModule::IsCompiled(int function) const noexcept
+{
+	return function >= 0
+		&& static_cast<size_t>(function) < m_entries.size()
+		&& m_entries[function] != npos;
+}
+
+size_t NativeModule::CompiledCount() const noexcept
+{
+	return std::count_if(m_entries.cbegin(), m_entries.cend(), [](size_t entry) { return entry != npos; });
+}
+
+// The code starts with the enter routine and the trap handlers followed
+// by the functions. The generated code is written once and the memory
+// is made executable afterwards. If the memory cannot be mapped none of
+// the functions are compiled.
+void NativeModule::Compile()
+{
+#ifdef EVM_NATIVE_JIT
+	const auto selected = SelectFunctions(m_module);
+	if (std::none_of(selected.cbegin(), selected.cend(), [](bool compile) { return compile; })) {
+		return;
+	}
+
+	Emitter e;
+
+	// Enter the generated code with the context, the frame base and the
+	// function as arguments. The host stack is saved for the traps.
+	m_enter = e.Offset();
+	e.Bytes({ 0x53, 0x41, 0x54, 0x41, 0x56, 0x41, 0x57 }); // push rbx, r12, r14, r15
+	e.Bytes({ 0x49, 0x89, 0xFF }); // mov r15, rdi
+	e.Bytes({ 0x48, 0x89, 0xF3 }); // mov rbx, rsi
+	e.Op32({ 0x4D, 0x8B, 0xA7 }, FieldOffset(offsetof(Context, globals))); // mov r12, [r15 + globals]
+	e.Op32({ 0x45, 0x8B, 0xB7 }, FieldOffset(offsetof(Context, depth))); // mov r14d, [r15 + depth]
+	e.Op32({ 0x49, 0x89, 0xA7 }, FieldOffset(offsetof(Context, savedStack))); // mov [r15 + saved], rsp
+	e.Bytes({ 0xFF, 0xD2 }); // call rdx
+	const size_t leave = e.Offset();
+	e.Bytes({ 0x41, 0x5F, 0x41, 0x5E, 0x41, 0x5C, 0x5B, 0xC3 }); // pop r15, r14, r12, rbx; ret
+
+	// Traps record the reason and unwind all generated frames at once.
+	const size_t unwind = e.Offset();
+	e.Op32({ 0x41, 0x89, 0x8F }, FieldOffset(offsetof(Context, status))); // mov [r15 + status], ecx
+	e.Op32({ 0x49, 0x8B, 0xA7 }, FieldOffset(offsetof(Context, savedStack))); // mov rsp, [r15 + saved]
+	e.Patch(e.Rel32({ 0xE9 }), leave); // jmp leave
+
+	size_t traps[TRAP_COUNT] = {};
+	for (int32_t trap = TRAP_NONE + 1; trap < TRAP_COUNT; ++trap) {
+		traps[trap] = e.Offset();
+		e.Op32({ 0xB9 }, trap); // mov ecx, trap
+		e.Patch(e.Rel32({ 0xE9 }), unwind); // jmp unwind
+	}
+
+	std::vector<size_t> entries(m_entries.size(), npos);
+	std::vector<Fixup> calls;
+	for (size_t i = 0; i < selected.size(); ++i) {
+		if (!selected[i]) { continue; }
+		entries[i] = e.Offset();
+
+		// Selected functions only use instructions with a template, if not
+		// none of the functions are compiled and all run in the register machine.
+		if (!EmitFunction(e, m_module, m_module.Functions()[i], traps, calls)) {
+			return;
+		}
+	}
+
+	for (const auto& call : calls) {
+		e.Patch(call.at, entries[call.target]);
+	}
+
+	const auto& code = e.Code();
+	void *memory = ::mmap(nullptr, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED) { return; }
+
+	std::memcpy(memory, code.data(), code.size());
+	if (::mprotect(memory, code.size(), PROT_READ | PROT_EXEC)) {
+		::munmap(memory, code.size());
+		return;
+	}
+
+	m_code = static_cast<unsigned char *>(memory);
+	m_codeSize = code.size();
+	m_entries = std::move(entries);
+#endif
+}
+
+Slot NativeModule::Run(int function, const std::vector<Slot>& args)
+{
+	// Native code cannot call into the register machine, the entire run is left
+	// to the register machine if either function was not compiled.
+	const int initializer = m_module.Initializer();
+	if (!IsCompiled(function) || (initializer != Module::npos && !IsCompiled(initializer))) {
+		return VirtualMachine::Run(m_module, function, args);
+	}
+
+#ifdef EVM_NATIVE_JIT
+	// Pages of the value stack are only committed when touched.
+	if (!m_stack) {
+		void *memory = ::mmap(nullptr, stackSlots * sizeof(Slot), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (memory == MAP_FAILED) {
+			throw std::bad_alloc{};
+		}
+		m_stack = static_cast<Slot *>(memory);
+		m_stackSize = stackSlots;
+	}
+#endif
+
+	std::vector<Slot> globals(m_module.GlobalSize(), Slot{});
+	if (initializer != Module::npos) {
+		Invoke(globals.data(), initializer, {});
+	}
+
+	return Invoke(globals.data(), function, args);
+}
+
+Slot NativeModule::Invoke(Slot *globals, int function, const std::vector<Slot>& args)
+{
+	const Function& entry = m_module.Functions()[function];
+	std::memset(m_stack, 0, entry.frameSize * sizeof(Slot));
+	std::copy_n(args.cbegin(), std::min<size_t>(args.size(), entry.paramCount), m_stack);
+
+	Context context{ globals, m_stack + m_stackSize, nullptr, static_cast<int32_t>(VirtualMachine::maxCallDepth), TRAP_NONE };
+	const auto enter = reinterpret_cast<EnterFunction>(m_code + m_enter);
+	const uint64_t value = enter(&context, m_stack, m_code + m_entries[function]);
+
+	switch (context.status) {
+	case TRAP_NONE:
+		break;
+	case TRAP_DIVISION_BY_ZERO:
+		throw std::runtime_error{ "division by zero" };
+	case TRAP_OUT_OF_BOUNDS:
+		throw OutOfBoundsException{};
+	case TRAP_CALL_DEPTH:
+		throw std::runtime_error{ "call stack exhausted" };
+	default:
+		throw std::runtime_error{ "native code returned with unknown trap" };
+	}
+
+	Slot result;
+	std::memcpy(&result, &value, sizeof(result));
+	return result;
+}
+
+NativeJit::NativeJit(Planner& planner)
+	: VirtualMachine{ planner }
+{
+	if (VirtualMachine::IsRunnable() && NativeModule::IsSupported()) {
+		m_native = std::make_unique<NativeModule>(m_module);
+	}
+}
+
+// The program entry point and the global initializer must be compiled.
+bool NativeJit::IsRunnable() const noexcept
+{
+	if (!m_native) {
+		return false;
+	}
+
+	const int initializer = m_module.Initializer();
+	if (initializer != Module::npos && !m_native->IsCompiled(initializer)) {
+		return false;
+	}
+
+	return m_native->IsCompiled(m_module.FindFunction(ENTRY_SYMBOL));
+}
+
+VirtualMachine::ReturnCode NativeJit::Execute(const std::string& entry
+	, const ArgumentList& args
+	, const ArgumentList& envs)
+{
+	const int index = m_module.FindFunction(entry);
+	const int initializer = m_module.Initializer();
+	if (!m_native || !m_native->IsCompiled(index) || (initializer != Module::npos && !m_native->IsCompiled(initializer))) {
+		return VirtualMachine::Execute(entry, args, envs);
+	}
+
+	const Function& function = m_module.Functions()[index];
+	return ExitCode(function, m_native->Run(index, StartupArguments(function, args)));
+}
+
+} // namespace EVM
@@ -0,0 +1,91 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+#include "VirtualMachine.h"
+
+#include <memory>
+#include <vector>
+
+// Native code is only generated on 64 bit Linux, other platforms
+// keep running the bytecode in the register machine.
+#if defined(__x86_64__) && defined(__linux__)
+# define EVM_NATIVE_JIT 1
+#endif
+
+namespace EVM
+{
+
+// Bytecode module compiled into x86-64 machine code.
+//
+// Each instruction is translated into a fixed machine code template,
+// the frame slots remain in memory and no registers are allocated
+// across instructions. Only functions restricted to integer
+// arithmetic, locals, globals, branches and calls into other compiled
+// functions are compiled. A function calling any function which cannot
+// be compiled is not compiled either. The compiled code behaves as the
+// register machine, errors are raised with the same exceptions. The
+// module must outlive the native module. A native module runs one
+// function at a time.
+class NativeModule final
+{
+public:
+	explicit NativeModule(const CryCC::Program::Casm::Module&);
+	~NativeModule();
+
+	NativeModule(const NativeModule&) = delete;
+	NativeModule& operator=(const NativeModule&) = delete;
+
+	// Test if native code can be generated on this platform.
+	static bool IsSupported() noexcept;
+
+	// Test if the function was compiled.
+	bool IsCompiled(int function) const noexcept;
+	// Number of compiled functions.
+	size_t CompiledCount() const noexcept;
+
+	// Run the module initializer and the function with new globals and
+	// return the result slot. If either function was not compiled, both
+	// are run in the register machine.
+	CryCC::Program::Casm::Slot Run(int function, const std::vector<CryCC::Program::Casm::Slot>& args);
+
+private:
+	void Compile();
+	CryCC::Program::Casm::Slot Invoke(CryCC::Program::Casm::Slot *globals, int function, const std::vector<CryCC::Program::Casm::Slot>& args);
+
+private:
+	const CryCC::Program::Casm::Module& m_module;
+	std::vector<size_t> m_entries;
+	size_t m_enter{ 0 };
+	unsigned char *m_code{ nullptr };
+	size_t m_codeSize{ 0 };
+	CryCC::Program::Casm::Slot *m_stack{ nullptr };
+	size_t m_stackSize{ 0 };
+};
+
+// Run the CASM section of the program as native code.
+//
+// The strategy is only runnable if the entry point and the global
+// initializer were compiled. The register machine runs the program
+// if the strategy is asked for an entry point which was not compiled.
+class NativeJit : public VirtualMachine
+{
+public:
+	NativeJit(Planner&);
+
+	// Check if strategy can run the program.
+	virtual bool IsRunnable() const noexcept;
+	// Run the program with current strategy.
+	virtual ReturnCode Execute(const std::string& entry, const ArgumentList&, const ArgumentList&);
+
+private:
+	std::unique_ptr<NativeModule> m_native;
+};
+
+} // namespace EVM
@@ -9,6 +9,10 @@
 #include "Planner.h"
 #include "NoStrat.h"
 #include "Interpreter.h"
+#include "VirtualMachine.h"
+#include "NativeJit.h"
+
+#include <CoilCl/coilcl.h>
 
 using namespace EVM;
 
@@ -62,6 +66,24 @@ std::unique_ptr<Strategy> Planner::DetermineStrategy()
 	}
 	return YieldStrategy<>();
 	*/
-	
+
+	// Prefer native code whenever the bytecode can be compiled for the host,
+	// then the register machine whenever the compiler emitted bytecode. The
+	// tree walker remains the fallback for any unlowered program.
+	if (m_program->HasResultSection<result_section_tag::CASM>()) {
+		if (m_opt != Plan::NOARCH_ONLY && GlobalExecutionState::IsJitEnabled()) {
+			auto strategy = YieldStrategy<NativeJit>(this);
+			if (strategy->IsRunnable()) {
+				return strategy;
+			}
+		}
+		if (m_opt == Plan::ALL) {
+			auto strategy = YieldStrategy<VirtualMachine>(this);
+			if (strategy->IsRunnable()) {
+				return strategy;
+			}
+		}
+	}
+
 	return YieldStrategy<Interpreter>(this);
 }
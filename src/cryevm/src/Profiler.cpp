@@ -0,0 +1,215 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include "Profiler.h"
+
+// Project includes.
+#include <CryCC/AST.h>
+
+// Language includes.
+#include <algorithm>
+#include <iomanip>
+
+namespace EVM
+{
+
+namespace
+{
+
+thread_local Profiler *t_profiler = nullptr;
+
+// Node name without the node details.
+std::string ShortNodeName(const CryCC::AST::ASTNode& node)
+{
+	std::string name = node.NodeName();
+	return name.substr(0, name.find(' '));
+}
+
+double Milliseconds(std::chrono::steady_clock::duration duration)
+{
+	return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+template<typename RecordType>
+std::vector<const RecordType *> SortRecords(const std::unordered_map<int, RecordType>& records)
+{
+	std::vector<const RecordType *> sorted;
+	sorted.reserve(records.size());
+	for (const auto& record : records) {
+		sorted.push_back(&record.second);
+	}
+
+	std::sort(sorted.begin(), sorted.end(), [](const RecordType *lhs, const RecordType *rhs)
+	{
+		if (lhs->total != rhs->total) {
+			return lhs->total > rhs->total;
+		}
+		return lhs->count > rhs->count;
+	});
+	return sorted;
+}
+
+} // namespace
+
+Profiler::Activation::Activation(Profiler& profiler) noexcept
+	: m_previous{ t_profiler }
+{
+	t_profiler = &profiler;
+}
+
+Profiler::Activation::~Activation()
+{
+	t_profiler = m_previous;
+}
+
+void Profiler::FunctionEntered(const CryCC::AST::FunctionDecl& node)
+{
+	if (t_profiler) {
+		t_profiler->EnterFunction(node);
+	}
+}
+
+void Profiler::FunctionLeft()
+{
+	if (t_profiler) {
+		t_profiler->LeaveFunction();
+	}
+}
+
+void Profiler::StatementEntered(const CryCC::AST::ASTNode& node)
+{
+	if (t_profiler) {
+		t_profiler->EnterStatement(node);
+	}
+}
+
+void Profiler::StatementLeft()
+{
+	if (t_profiler) {
+		t_profiler->LeaveStatement();
+	}
+}
+
+Profiler *Profiler::Current() noexcept
+{
+	return t_profiler;
+}
+
+// The record is created on first execution, the name is only
+// formatted once per node.
+void Profiler::EnterFunction(const CryCC::AST::FunctionDecl& node)
+{
+	auto it = m_functions.find(node.Id());
+	if (it == m_functions.end()) {
+		it = m_functions.emplace(node.Id(), Record{ node.Identifier(), 0, {}, {}, 0 }).first;
+	}
+
+	Record& record = it->second;
+	++record.count;
+	++record.depth;
+
+	const size_t stackLength = m_stack.size();
+	if (!m_stack.empty()) {
+		m_stack += ';';
+	}
+	m_stack += record.name;
+	m_functionStack.push_back(Frame{ &record, Clock::now(), {}, stackLength });
+}
+
+void Profiler::LeaveFunction()
+{
+	const Frame& frame = m_functionStack.back();
+	const size_t stackLength = frame.stackLength;
+	const auto self = Leave(m_functionStack);
+	m_foldedStacks[m_stack] += self;
+	m_stack.resize(stackLength);
+}
+
+// Statements are labeled with the enclosing function.
+void Profiler::EnterStatement(const CryCC::AST::ASTNode& node)
+{
+	auto it = m_statements.find(node.Id());
+	if (it == m_statements.end()) {
+		const auto location = node.Location();
+		std::string name = m_functionStack.empty() ? std::string{} : m_functionStack.back().record->name;
+		name += ":" + std::to_string(location.Line()) + ":" + std::to_string(location.Column()) + " " + ShortNodeName(node);
+		it = m_statements.emplace(node.Id(), Record{ std::move(name), 0, {}, {}, 0 }).first;
+	}
+
+	Record& record = it->second;
+	++record.count;
+	++record.depth;
+	m_statementStack.push_back(Frame{ &record, Clock::now(), {}, 0 });
+}
+
+void Profiler::LeaveStatement()
+{
+	Leave(m_statementStack);
+}
+
+// Pop the frame and account the elapsed time. The cumulative time is
+// only taken by the outermost activation of the record.
+Profiler::Clock::duration Profiler::Leave(std::vector<Frame>& stack)
+{
+	const Frame frame = stack.back();
+	stack.pop_back();
+
+	const auto elapsed = Clock::now() - frame.start;
+	const auto self = elapsed - frame.children;
+	frame.record->self += self;
+	if (!--frame.record->depth) {
+		frame.record->total += elapsed;
+	}
+	if (!stack.empty()) {
+		stack.back().children += elapsed;
+	}
+
+	return self;
+}
+
+void Profiler::WriteReport(std::ostream& os) const
+{
+	const auto flags = os.flags();
+	os << std::fixed << std::setprecision(3);
+
+	os << std::left << std::setw(40) << "Function"
+		<< std::right << std::setw(12) << "Calls"
+		<< std::setw(14) << "Total (ms)"
+		<< std::setw(14) << "Self (ms)" << '\n';
+	for (const auto record : SortRecords(m_functions)) {
+		os << std::left << std::setw(40) << record->name
+			<< std::right << std::setw(12) << record->count
+			<< std::setw(14) << Milliseconds(record->total)
+			<< std::setw(14) << Milliseconds(record->self) << '\n';
+	}
+
+	os << '\n';
+	os << std::left << std::setw(40) << "Statement"
+		<< std::right << std::setw(12) << "Count"
+		<< std::setw(14) << "Total (ms)"
+		<< std::setw(14) << "Self (ms)" << '\n';
+	for (const auto record : SortRecords(m_statements)) {
+		os << std::left << std::setw(40) << record->name
+			<< std::right << std::setw(12) << record->count
+			<< std::setw(14) << Milliseconds(record->total)
+			<< std::setw(14) << Milliseconds(record->self) << '\n';
+	}
+
+	os.flags(flags);
+}
+
+void Profiler::WriteFoldedStacks(std::ostream& os) const
+{
+	std::vector<std::pair<std::string, Clock::duration>> stacks{ m_foldedStacks.cbegin(), m_foldedStacks.cend() };
+	std::sort(stacks.begin(), stacks.end());
+	for (const auto& stack : stacks) {
+		os << stack.first << ' ' << std::chrono::duration_cast<std::chrono::microseconds>(stack.second).count() << '\n';
+	}
+}
+
+} // namespace EVM
@@ -0,0 +1,117 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// The profiler hooks are only compiled into the interpreter if the
+// build enables the profiler, otherwise the hooks compile to nothing.
+#ifdef EVM_PROFILER
+# define EVM_PROFILE_ENTER_FUNCTION(n) EVM::Profiler::FunctionEntered(n)
+# define EVM_PROFILE_LEAVE_FUNCTION() EVM::Profiler::FunctionLeft()
+# define EVM_PROFILE_ENTER_STATEMENT(n) EVM::Profiler::StatementEntered(n)
+# define EVM_PROFILE_LEAVE_STATEMENT() EVM::Profiler::StatementLeft()
+#else
+# define EVM_PROFILE_ENTER_FUNCTION(n)
+# define EVM_PROFILE_LEAVE_FUNCTION()
+# define EVM_PROFILE_ENTER_STATEMENT(n)
+# define EVM_PROFILE_LEAVE_STATEMENT()
+#endif
+
+namespace CryCC::AST
+{
+class ASTNode;
+class FunctionDecl;
+} // namespace CryCC::AST
+
+namespace EVM
+{
+
+// Execution profiler for the interpreter.
+//
+// The profiler counts the number of executions and the cumulative time
+// per function and per statement, indexed by the node identifier. The
+// cumulative time includes any nested call or statement, recursive calls
+// are only counted once. The profiler is bound to the current thread
+// while it is active, the interpreter hooks report to the active profiler.
+// Every enter hook must be matched by a leave hook.
+class Profiler final
+{
+	using Clock = std::chrono::steady_clock;
+
+	struct Record
+	{
+		std::string name;
+		uint64_t count;
+		Clock::duration total;
+		Clock::duration self;
+		int depth;
+	};
+
+	struct Frame
+	{
+		Record *record;
+		Clock::time_point start;
+		Clock::duration children;
+		size_t stackLength;
+	};
+
+public:
+	// Bind the profiler to the current thread for the lifetime of the
+	// activation.
+	class Activation final
+	{
+		Profiler *m_previous;
+
+	public:
+		explicit Activation(Profiler&) noexcept;
+		~Activation();
+
+		Activation(const Activation&) = delete;
+		Activation& operator=(const Activation&) = delete;
+	};
+
+	// Interpreter hooks, ignored if no profiler is active.
+	static void FunctionEntered(const CryCC::AST::FunctionDecl&);
+	static void FunctionLeft();
+	static void StatementEntered(const CryCC::AST::ASTNode&);
+	static void StatementLeft();
+
+	// Profiler bound to the current thread, or nullptr.
+	static Profiler *Current() noexcept;
+
+	// Write the functions and statements ordered by cumulative time.
+	void WriteReport(std::ostream&) const;
+	// Write the function call stacks in folded format, one stack per line
+	// followed by the time spent in the last function in microseconds.
+	void WriteFoldedStacks(std::ostream&) const;
+
+private:
+	void EnterFunction(const CryCC::AST::FunctionDecl&);
+	void LeaveFunction();
+	void EnterStatement(const CryCC::AST::ASTNode&);
+	void LeaveStatement();
+
+	static Clock::duration Leave(std::vector<Frame>&);
+
+private:
+	std::unordered_map<int, Record> m_functions;
+	std::unordered_map<int, Record> m_statements;
+	std::vector<Frame> m_functionStack;
+	std::vector<Frame> m_statementStack;
+	std::string m_stack;
+	std::unordered_map<std::string, Clock::duration> m_foldedStacks;
+};
+
+} // namespace EVM
@@ -7,35 +7,37 @@
 // copied and/or distributed without the express of the author.
 
 #include "State.h"
+#include "ExecutionEngine.h"
 
 namespace EVM
 {
 namespace GlobalExecutionState
 {
 
-static std::list<ExternalMethod> g_externalSymbolList;
-
-void Set(const std::list<ExternalMethod>& symbolList)
+const ExternalMethod *FindExternalSymbol(const std::string& symbol)
 {
-	g_externalSymbolList = symbolList;
+	const auto engine = ExecutionEngine::Current();
+	if (!engine) { return nullptr; }
+	return engine->FindExternalSymbol(symbol);
 }
 
-void UnsetAll()
+unsigned int SymbolEpoch() noexcept
 {
-	g_externalSymbolList.clear();
+	const auto engine = ExecutionEngine::Current();
+	return engine ? engine->SymbolEpoch() : 0;
 }
 
-// FUTURE: logarithmic search or static search
-// FUTURE: memory priority cache
-const ExternalMethod *FindExternalSymbol(const std::string& symbol)
+bool IsBoundsCheckEnabled() noexcept
 {
-	auto it = std::find_if(g_externalSymbolList.cbegin(), g_externalSymbolList.cend(), [&](const ExternalMethod& method) {
-		return method.Symbol() == symbol;
-	});
-	if (it == g_externalSymbolList.cend()) { return nullptr; }
-	return &(*it);
+	const auto engine = ExecutionEngine::Current();
+	return engine ? engine->IsBoundsCheckEnabled() : true;
 }
 
+bool IsJitEnabled() noexcept
+{
+	const auto engine = ExecutionEngine::Current();
+	return engine ? engine->IsJitEnabled() : true;
+}
 
 } // namespace GlobalExecutionState
 } // namespace EVM
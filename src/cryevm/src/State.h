@@ -10,19 +10,26 @@
 
 #include <CryEVM/ExternalMethod.h>
 
+#include <string>
+
 namespace EVM
 {
+
+// State of the execution engine bound to the current thread. Without a
+// bound engine no external symbols are found and the defaults apply.
 namespace GlobalExecutionState
 {
 
-// Set the external symbol list.
-void Set(const std::list<ExternalMethod>&);
-
-// Clear any gobal state.
-void UnsetAll();
-
 // Find an external symbol, returns either external method or nullptr.
 const ExternalMethod *FindExternalSymbol(const std::string&);
+// Epoch of the external symbol table, the epoch changes when the table is
+// replaced and invalidates any external method cached by the caller.
+unsigned int SymbolEpoch() noexcept;
+
+// Test if array element access is bounds checked.
+bool IsBoundsCheckEnabled() noexcept;
+// Test if bytecode programs may be compiled into native code.
+bool IsJitEnabled() noexcept;
 
 } // namespace GlobalExecutionState
 } // namespace EVM
@@ -0,0 +1,512 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include "VirtualMachine.h"
+#include "State.h"
+
+// Project includes.
+#include <CoilCl/coilcl.h>
+#include <CryEVM/ExternalMethod.h>
+#include <CryCC/SubValue.h>
+
+// Framework includes.
+#include <Cry/Cry.h>
+#include <Cry/Except.h>
+
+// Language includes.
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+// Computed goto is a compiler extension, other compilers
+// dispatch through the switch statement.
+#if defined(__GNUC__) || defined(__clang__)
+# define EVM_COMPUTED_GOTO 1
+#endif
+
+#define ENTRY_SYMBOL "main"
+
+using namespace CryCC::Program::Casm;
+using namespace CryCC::SubValue::Valuedef;
+
+namespace
+{
+
+constexpr const size_t maxCallDepth = EVM::VirtualMachine::maxCallDepth;
+
+// Integer arithmetic wraps on overflow.
+inline int32_t WrapAdd(int32_t x, int32_t y) noexcept { return static_cast<int32_t>(static_cast<uint32_t>(x) + static_cast<uint32_t>(y)); }
+inline int32_t WrapSub(int32_t x, int32_t y) noexcept { return static_cast<int32_t>(static_cast<uint32_t>(x) - static_cast<uint32_t>(y)); }
+inline int32_t WrapMul(int32_t x, int32_t y) noexcept { return static_cast<int32_t>(static_cast<uint32_t>(x) * static_cast<uint32_t>(y)); }
+
+inline int32_t CheckedDiv(int32_t x, int32_t y)
+{
+	if (!y) { throw std::runtime_error{ "division by zero" }; }
+	return y == -1 ? WrapSub(0, x) : x / y;
+}
+
+inline int32_t CheckedMod(int32_t x, int32_t y)
+{
+	if (!y) { throw std::runtime_error{ "division by zero" }; }
+	return y == -1 ? 0 : x % y;
+}
+
+// Execution state of a single module.
+//
+// All frames live in one contiguous value stack. The frame of the
+// callee is placed directly above the frame of the caller and the
+// arguments are copied into the first slots of the new frame. The
+// frame records only hold what is required to resume the caller,
+// guest calls therefore never recurse on the host stack.
+class Machine final
+{
+	struct Frame
+	{
+		const Function *function;
+		const Word *pc;
+		size_t base;
+		Word dst;
+	};
+
+public:
+	explicit Machine(const Module& module);
+
+	// Run the function to completion and return the result slot.
+	Slot Run(int function, const std::vector<Slot>& args);
+
+private:
+	// Make room for a zeroed frame at the base offset.
+	Slot *Reserve(size_t base, Word frameSize);
+	// Call an external routine with the operands of the instruction.
+	Slot CallExternal(const Word *pc, const Slot *r);
+
+private:
+	const Module& m_module;
+	std::vector<Slot> m_constants;
+	std::vector<Slot> m_globals;
+	std::vector<Slot> m_stack;
+	std::vector<Frame> m_frames;
+	std::vector<const EVM::ExternalMethod *> m_externals;
+};
+
+Machine::Machine(const Module& module)
+	: m_module{ module }
+	, m_constants(module.Constants().size(), Slot{})
+	, m_globals(module.GlobalSize(), Slot{})
+	, m_externals(module.Constants().size(), nullptr)
+{
+	// Materialize the numeric constants once, string constants are
+	// only ever passed by reference to external routines.
+	for (size_t i = 0; i < module.Constants().size(); ++i) {
+		const auto& constant = module.Constants()[i];
+		if (const auto value = std::get_if<int32_t>(&constant)) {
+			m_constants[i].i = (*value);
+		}
+		else if (const auto value = std::get_if<double>(&constant)) {
+			m_constants[i].f = (*value);
+		}
+	}
+}
+
+Slot *Machine::Reserve(size_t base, Word frameSize)
+{
+	const size_t top = base + frameSize;
+	if (m_stack.size() < top) {
+		m_stack.resize(std::max(top, m_stack.size() * 2));
+	}
+
+	Slot *r = m_stack.data() + base;
+	std::memset(r, 0, frameSize * sizeof(Slot));
+	return r;
+}
+
+Slot Machine::CallExternal(const Word *pc, const Slot *r)
+{
+	// Resolve the symbol once per call site name.
+	const Word name = pc[2];
+	const EVM::ExternalMethod *method = m_externals[name];
+	if (!method) {
+		method = EVM::GlobalExecutionState::FindExternalSymbol(std::get<std::string>(m_module.Constants()[name]));
+		if (!method) {
+			CryImplExcept(); //TODO: symbol not found in external module
+		}
+		m_externals[name] = method;
+	}
+
+	// Bind the arguments to the named parameters, any arguments matching
+	// a variadic parameter are named in order of appearance.
+	std::vector<std::pair<std::string, std::shared_ptr<Value>>> arguments;
+	const auto& params = method->Parameters();
+	if (!params.empty()) {
+		size_t i = 0;
+		int v_i = 0;
+		const Word argc = pc[3];
+		for (Word n = 0; n < argc; ++n) {
+			const Word kind = pc[4 + n * 2];
+			const Word value = pc[4 + n * 2 + 1];
+
+			std::shared_ptr<Value> argument;
+			switch (static_cast<ArgKind>(kind)) {
+			case ArgKind::INTEGER:
+				argument = std::make_shared<Value>(Util::MakeInt(r[value].i));
+				break;
+			case ArgKind::FLOAT:
+				argument = std::make_shared<Value>(Util::MakeDouble(r[value].f));
+				break;
+			case ArgKind::STRING:
+				argument = std::make_shared<Value>(Util::MakeString(std::get<std::string>(m_module.Constants()[value])));
+				break;
+			}
+
+			if (i >= params.size()) {
+				CryImplExcept(); //TODO: error: too many arguments to function
+			}
+			if (params[i].IsVariadic()) {
+				arguments.emplace_back("__va_arg" + std::to_string(v_i++) + "__", std::move(argument));
+				continue;
+			}
+			arguments.emplace_back(params[i++].Identifier(), std::move(argument));
+		}
+	}
+
+	EVM::ExternalFunctionContext exCtx{ [&arguments](const std::string& name) -> std::shared_ptr<Value>
+	{
+		for (const auto& argument : arguments) {
+			if (argument.first == name) { return argument.second; }
+		}
+		return nullptr;
+	} };
+	method->Call(exCtx);
+
+	Slot result{};
+	if (auto ptr = exCtx.GetReturn()) {
+		if (Util::IsFloatingPoint(*ptr)) {
+			result.f = Util::ValueCastNative<double>(*ptr);
+		}
+		else {
+			result.i = Util::ValueCastNative<int>(*ptr);
+		}
+	}
+	return result;
+}
+
+// Dispatch loop of the machine.
+//
+// The hot state is kept in locals, the register pointer is the base
+// of the current frame and is reloaded after the value stack grows.
+// Each handler dispatches the next instruction itself, which gives
+// the branch predictor a jump per opcode with computed goto.
+Slot Machine::Run(int index, const std::vector<Slot>& args)
+{
+	const Function *function = &m_module.Functions()[index];
+	const Function *functions = m_module.Functions().data();
+	const Slot *k = m_constants.data();
+	Slot *g = m_globals.data();
+	size_t base = 0;
+	Slot result{};
+
+	m_frames.clear();
+	Slot *r = Reserve(base, function->frameSize);
+	std::copy_n(args.cbegin(), std::min<size_t>(args.size(), function->paramCount), r);
+	const Word *pc = function->code.data();
+
+#ifdef EVM_COMPUTED_GOTO
+	// Must follow the opcode order.
+	static const void *const dispatchTable[] = {
+		&&op_NOP, &&op_LOADK, &&op_LOADI, &&op_MOV, &&op_LOADG, &&op_STOREG, &&op_LOADX, &&op_STOREX,
+		&&op_ADDI, &&op_SUBI, &&op_MULI, &&op_DIVI, &&op_MODI, &&op_ANDI, &&op_ORI, &&op_XORI,
+		&&op_SHLI, &&op_SHRI, &&op_EQI, &&op_NEI, &&op_LTI, &&op_LEI, &&op_GTI, &&op_GEI, &&op_ADDIK,
+		&&op_ADDF, &&op_SUBF, &&op_MULF, &&op_DIVF, &&op_EQF, &&op_NEF, &&op_LTF, &&op_LEF, &&op_GTF, &&op_GEF,
+		&&op_NEGI, &&op_NEGF, &&op_NOT, &&op_BNOT, &&op_I2F, &&op_F2I,
+		&&op_JMP, &&op_JZ, &&op_JNZ,
+		&&op_CALL, &&op_CALLX, &&op_RET, &&op_RETV,
+	};
+	static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == static_cast<size_t>(Opcode::COUNT), "dispatch table out of sync");
+
+# define VM_CASE(o) op_##o
+# define VM_NEXT(n) pc += (n); goto *dispatchTable[*pc]
+#else
+# define VM_CASE(o) case Opcode::o
+# define VM_NEXT(n) pc += (n); goto dispatch
+#endif
+
+#define VM_BINARY(o,m,expr) \
+	VM_CASE(o): { \
+		const auto x = r[pc[2]].m; \
+		const auto y = r[pc[3]].m; \
+		r[pc[1]].expr; \
+		VM_NEXT(4); \
+	}
+
+#ifdef EVM_COMPUTED_GOTO
+	VM_NEXT(0);
+#else
+dispatch:
+	switch (static_cast<Opcode>(*pc)) {
+#endif
+
+	VM_CASE(NOP): {
+		VM_NEXT(1);
+	}
+	VM_CASE(LOADK): {
+		r[pc[1]] = k[pc[2]];
+		VM_NEXT(3);
+	}
+	VM_CASE(LOADI): {
+		r[pc[1]].i = static_cast<int32_t>(pc[2]);
+		VM_NEXT(3);
+	}
+	VM_CASE(MOV): {
+		r[pc[1]] = r[pc[2]];
+		VM_NEXT(3);
+	}
+	VM_CASE(LOADG): {
+		r[pc[1]] = g[pc[2]];
+		VM_NEXT(3);
+	}
+	VM_CASE(STOREG): {
+		g[pc[1]] = r[pc[2]];
+		VM_NEXT(3);
+	}
+
+	// The verifier only guarantees the array itself is within the frame,
+	// the element index is always checked to protect the value stack.
+	VM_CASE(LOADX): {
+		const Word offset = static_cast<Word>(r[pc[3]].i);
+		if (offset >= pc[4]) { throw OutOfBoundsException{}; }
+		r[pc[1]] = r[pc[2] + offset];
+		VM_NEXT(5);
+	}
+	VM_CASE(STOREX): {
+		const Word offset = static_cast<Word>(r[pc[2]].i);
+		if (offset >= pc[4]) { throw OutOfBoundsException{}; }
+		r[pc[1] + offset] = r[pc[3]];
+		VM_NEXT(5);
+	}
+
+	VM_BINARY(ADDI, i, i = WrapAdd(x, y))
+	VM_BINARY(SUBI, i, i = WrapSub(x, y))
+	VM_BINARY(MULI, i, i = WrapMul(x, y))
+	VM_BINARY(DIVI, i, i = CheckedDiv(x, y))
+	VM_BINARY(MODI, i, i = CheckedMod(x, y))
+	VM_BINARY(ANDI, i, i = x & y)
+	VM_BINARY(ORI, i, i = x | y)
+	VM_BINARY(XORI, i, i = x ^ y)
+	VM_BINARY(SHLI, i, i = static_cast<int32_t>(static_cast<uint32_t>(x) << (y & 31)))
+	VM_BINARY(SHRI, i, i = x >> (y & 31))
+	VM_BINARY(EQI, i, i = x == y)
+	VM_BINARY(NEI, i, i = x != y)
+	VM_BINARY(LTI, i, i = x < y)
+	VM_BINARY(LEI, i, i = x <= y)
+	VM_BINARY(GTI, i, i = x > y)
+	VM_BINARY(GEI, i, i = x >= y)
+	VM_CASE(ADDIK): {
+		r[pc[1]].i = WrapAdd(r[pc[2]].i, static_cast<int32_t>(pc[3]));
+		VM_NEXT(4);
+	}
+
+	VM_BINARY(ADDF, f, f = x + y)
+	VM_BINARY(SUBF, f, f = x - y)
+	VM_BINARY(MULF, f, f = x * y)
+	VM_BINARY(DIVF, f, f = x / y)
+	VM_BINARY(EQF, f, i = x == y)
+	VM_BINARY(NEF, f, i = x != y)
+	VM_BINARY(LTF, f, i = x < y)
+	VM_BINARY(LEF, f, i = x <= y)
+	VM_BINARY(GTF, f, i = x > y)
+	VM_BINARY(GEF, f, i = x >= y)
+
+	VM_CASE(NEGI): {
+		r[pc[1]].i = WrapSub(0, r[pc[2]].i);
+		VM_NEXT(3);
+	}
+	VM_CASE(NEGF): {
+		r[pc[1]].f = -r[pc[2]].f;
+		VM_NEXT(3);
+	}
+	VM_CASE(NOT): {
+		r[pc[1]].i = !r[pc[2]].i;
+		VM_NEXT(3);
+	}
+	VM_CASE(BNOT): {
+		r[pc[1]].i = ~r[pc[2]].i;
+		VM_NEXT(3);
+	}
+	VM_CASE(I2F): {
+		r[pc[1]].f = static_cast<double>(r[pc[2]].i);
+		VM_NEXT(3);
+	}
+	VM_CASE(F2I): {
+		r[pc[1]].i = static_cast<int32_t>(r[pc[2]].f);
+		VM_NEXT(3);
+	}
+
+	VM_CASE(JMP): {
+		VM_NEXT(static_cast<int32_t>(pc[1]));
+	}
+	VM_CASE(JZ): {
+		VM_NEXT(r[pc[1]].i ? 3 : static_cast<int32_t>(pc[2]));
+	}
+	VM_CASE(JNZ): {
+		VM_NEXT(r[pc[1]].i ? static_cast<int32_t>(pc[2]) : 3);
+	}
+
+	VM_CASE(CALL): {
+		if (m_frames.size() >= maxCallDepth) {
+			throw std::runtime_error{ "call stack exhausted" };
+		}
+
+		const Function *callee = &functions[pc[2]];
+		const Word argc = pc[3];
+		const size_t calleeBase = base + function->frameSize;
+		m_frames.push_back(Frame{ function, pc + 4 + argc, base, pc[1] });
+
+		// The value stack may move, the caller frame is reloaded.
+		r = Reserve(calleeBase, callee->frameSize);
+		const Slot *caller = m_stack.data() + base;
+		for (Word i = 0; i < argc; ++i) {
+			r[i] = caller[pc[4 + i]];
+		}
+
+		function = callee;
+		base = calleeBase;
+		pc = callee->code.data();
+		VM_NEXT(0);
+	}
+	VM_CASE(CALLX): {
+		r[pc[1]] = CallExternal(pc, r);
+		VM_NEXT(4 + pc[3] * 2);
+	}
+	VM_CASE(RET): {
+		result = r[pc[1]];
+		goto leave;
+	}
+	VM_CASE(RETV): {
+		result = Slot{};
+		goto leave;
+	}
+
+#ifndef EVM_COMPUTED_GOTO
+	default:
+		CryImplExcept(); //TODO: module was not verified
+	}
+#endif
+
+leave:
+	if (m_frames.empty()) {
+		return result;
+	}
+
+	{
+		const Frame frame = m_frames.back();
+		m_frames.pop_back();
+		function = frame.function;
+		base = frame.base;
+		r = m_stack.data() + base;
+		r[frame.dst] = result;
+		pc = frame.pc;
+	}
+	VM_NEXT(0);
+
+#undef VM_BINARY
+#undef VM_NEXT
+#undef VM_CASE
+}
+
+} // namespace
+
+namespace EVM
+{
+
+VirtualMachine::VirtualMachine(Planner& planner)
+	: Strategy{ planner }
+{
+	auto section = Program()->ResultSection<result_section_tag::CASM>();
+	if (!section || !section->Size()) { return; }
+
+	// The section is read from the start, the data is copied so the
+	// program section is left untouched.
+	try {
+		Cry::ByteArray buffer = section->Data();
+		buffer.StartOffset(0);
+		Module::Deserialize(m_module, buffer);
+		m_isLoaded = true;
+	}
+	catch (const std::exception&) {
+		m_module = Module{};
+	}
+}
+
+// The bytecode was lowered from a runnable program and passed the
+// verifier, only the presence of any code is required.
+bool VirtualMachine::IsRunnable() const noexcept
+{
+	return m_isLoaded && !m_module.Empty();
+}
+
+std::string VirtualMachine::EntryPoint(const char *entry)
+{
+	return entry ? entry : ENTRY_SYMBOL;
+}
+
+// Run the program with current strategy. The global initializers
+// run before the entry point is called. Only the argument count
+// is passed to the entry point, the register machine has no
+// representation for the argument vector.
+VirtualMachine::ReturnCode VirtualMachine::Execute(const std::string& entry
+	, const ArgumentList& args
+	, const ArgumentList& envs)
+{
+	CRY_UNUSED(envs);
+
+	const int index = m_module.FindFunction(entry);
+	if (index == Module::npos) {
+		CryImplExcept();
+	}
+
+	const Function& function = m_module.Functions()[index];
+	return ExitCode(function, Run(m_module, index, StartupArguments(function, args)));
+}
+
+Slot VirtualMachine::Run(const Module& module, int function, const std::vector<Slot>& args)
+{
+	Machine machine{ module };
+	if (module.Initializer() != Module::npos) {
+		machine.Run(module.Initializer(), {});
+	}
+
+	return machine.Run(function, args);
+}
+
+std::vector<Slot> VirtualMachine::StartupArguments(const Function& function, const ArgumentList& args)
+{
+	std::vector<Slot> startup;
+	if (function.paramCount && !args.empty()) {
+		Slot argc{};
+		argc.i = static_cast<int32_t>(args.size());
+		startup.push_back(argc);
+	}
+
+	return startup;
+}
+
+VirtualMachine::ReturnCode VirtualMachine::ExitCode(const Function& function, Slot result)
+{
+	switch (function.returnKind) {
+	case SlotKind::INTEGER:
+		return result.i;
+	case SlotKind::FLOAT:
+		return static_cast<int>(result.f);
+	default:
+		break;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+} // namespace EVM
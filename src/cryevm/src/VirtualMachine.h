@@ -0,0 +1,57 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+#include "Planner.h"
+
+#include <CryCC/Program/Casm.h>
+
+#include <vector>
+
+namespace EVM
+{
+
+// Register machine running the CASM section of the program.
+//
+// The module is read from the program result set when the strategy is
+// created. The strategy is not runnable if the program has no bytecode
+// section or if the section does not pass the module verifier.
+class VirtualMachine : public Strategy
+{
+public:
+	// Maximum number of nested calls before the machine gives up.
+	static constexpr const size_t maxCallDepth = 1 << 16;
+
+	VirtualMachine(Planner&);
+
+	// Check if strategy can run the program.
+	virtual bool IsRunnable() const noexcept;
+	// Program entry point.
+	virtual std::string EntryPoint(const char *);
+	// Run the program with current strategy.
+	virtual ReturnCode Execute(const std::string& entry, const ArgumentList&, const ArgumentList&);
+
+	// Run the module initializer and the function in a new machine and
+	// return the result slot.
+	static CryCC::Program::Casm::Slot Run(const CryCC::Program::Casm::Module&
+		, int function
+		, const std::vector<CryCC::Program::Casm::Slot>& args);
+
+protected:
+	// Convert the startup arguments into entry point arguments.
+	static std::vector<CryCC::Program::Casm::Slot> StartupArguments(const CryCC::Program::Casm::Function&, const ArgumentList&);
+	// Convert the result of the entry point into the exit code.
+	static ReturnCode ExitCode(const CryCC::Program::Casm::Function&, CryCC::Program::Casm::Slot);
+
+protected:
+	CryCC::Program::Casm::Module m_module;
+	bool m_isLoaded{ false };
+};
+
+} // namespace EVM
@@ -11,8 +11,11 @@
 #include "Functional.h"
 #include <CryEVM/ExternalMethod.h>  //TODO: move down
 #include <CryEVM/RuntimeInterface.h>  //TODO: move down
-#include "State.h"
+#include "ExecutionEngine.h"
+#include "ExecutionPool.h"
+#include "ModuleRegistry.h"
 #include "Planner.h"
+#include "Profiler.h"
 #include "UniquePreservePtr.h"
 
 // Project includes.
@@ -21,13 +24,18 @@
 // Framework includes.
 #include <Cry/Cry.h>
 #include <Cry/Config.h>
-#include <Cry/Loader.h>
 
 #ifdef AUTO_CONVERT
 #include <boost/lexical_cast.hpp>
 #endif
 
 #include <memory>
+#include <thread>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+#define PROFILE_FILE "profile"
 
 //#define AUTO_CONVERT 1
 
@@ -39,8 +47,6 @@
 //    - Or Virtual machine
 //    - Or native
 
-namespace Loader = Cry::Module;
-
 using ProgramPtr = Detail::UniquePreservePtr<CryCC::Program::Program>;
 
 #ifdef AUTO_CONVERT
@@ -77,6 +83,37 @@ void ConvertToArgumentList(ArgumentList& list, const datalist_t pointerList)
 	} while (pointerList[sz]);
 }
 
+#ifdef EVM_PROFILER
+
+// Run the program with the profiler bound to the current thread and
+// write the profile once the program returns.
+int ExecuteProfiled(EVM::Strategy& runner
+	, const std::string& entry
+	, const ArgumentList& args
+	, const ArgumentList& envs
+	, const char *profileFile)
+{
+	EVM::Profiler profiler;
+	int returnCode = EXIT_FAILURE;
+	{
+		EVM::Profiler::Activation activation{ profiler };
+		returnCode = runner.Execute(entry, args, envs);
+	}
+
+	const std::string file = profileFile ? profileFile : PROFILE_FILE;
+	std::ofstream report{ file + ".txt" };
+	std::ofstream stacks{ file + ".folded" };
+	if (!report || !stacks) {
+		throw std::runtime_error{ "cannot write profile '" + file + "'" };
+	}
+
+	profiler.WriteReport(report);
+	profiler.WriteFoldedStacks(stacks);
+	return returnCode;
+}
+
+#endif // EVM_PROFILER
+
 class Configuration
 {
 
@@ -97,9 +134,19 @@ private:
 	struct vm_config *m_config;
 };
 
-// [ API ENTRY ]
-// Program executor.
-EVMAPI int ExecuteProgram(runtime_settings_t *runtime) noexcept
+// Opaque pool handle.
+struct execution_pool
+{
+	EVM::ExecutionPool pool;
+
+	explicit execution_pool(size_t threads)
+		: pool{ threads }
+	{
+	}
+};
+
+// Run the program in a new execution engine bound to the current thread.
+static int RunProgram(runtime_settings_t *runtime) noexcept
 {
 	using namespace EVM;
 
@@ -116,24 +163,22 @@ EVMAPI int ExecuteProgram(runtime_settings_t *runtime) noexcept
 	// Capture program pointer and cast into program structure.
 	ProgramPtr program = ProgramPtr{ runtime->program.program_ptr };
 
-	// Load modules to import external functionality.
-	auto runtimeModules = Loader::Load<RuntimeInterface>(DIST_BINARY_DIR);
-	Loader::ForEachLoad(runtimeModules);
+	// Set the execution options. External symbols are resolved via the process
+	// wide module registry, modules are loaded once and not per program.
+	ExecutionEngine engine{ ModuleRegistry::Instance(), runtime->cfg };
+	ExecutionEngine::Activation activation{ engine };
 
-	// Collect all external symbols. Load the local symbols first, and give
-	// the external symbols loaded from modules the chance to override functions.
-	std::list<EVM::ExternalMethod> list;
-	list.merge(EVM::SymbolIndex(), [](auto, auto) { return false; });
-	for (auto& module : runtimeModules) {
-		module->LoadSymbolIndex(list);
+#ifndef EVM_PROFILER
+	if (runtime->cfg.enable_profiler) {
+		runtime->error_handler(runtime->user_data, "profiler is not available in this build", false);
 	}
+#endif
 
-	// Set the execution options.
-	GlobalExecutionState::Set(list);
-	//GlobalExecutionState::Set(config);
-
-	// Determine strategy for program.
-	auto runner = Planner{ std::move(program), Planner::Plan::ALL }.DetermineStrategy();
+	// Determine strategy for program. The strategy refers back to
+	// the planner, which must therefore outlive the runner. Only
+	// the interpreter is profiled.
+	Planner planner{ std::move(program), runtime->cfg.enable_profiler ? Planner::Plan::NOARCH_ONLY : Planner::Plan::ALL };
+	auto runner = planner.DetermineStrategy();
 	if (!runner->IsRunnable()) {
 		return RETURN_NOT_RUNNABLE;
 	}
@@ -146,17 +191,108 @@ EVMAPI int ExecuteProgram(runtime_settings_t *runtime) noexcept
 		ConvertToArgumentList(envs, runtime->envs);
 
 		// Execute the program in the designated strategy.
-		runtime->return_code = runner->Execute(runner->EntryPoint(runtime->entry_point), args, envs);
+		const auto entry = runner->EntryPoint(runtime->entry_point);
+#ifdef EVM_PROFILER
+		if (runtime->cfg.enable_profiler) {
+			runtime->return_code = ExecuteProfiled(*runner, entry, args, envs, runtime->profile_file);
+		}
+		else {
+			runtime->return_code = runner->Execute(entry, args, envs);
+		}
+#else
+		runtime->return_code = runner->Execute(entry, args, envs);
+#endif
 	}
 	// Catch any runtime errors.
 	catch (const std::exception& e) {
 		runtime->error_handler(runtime->user_data, e.what(), true);
 	}
 
-	// Unset the execution options.
-	GlobalExecutionState::UnsetAll();
-	Loader::ForEachUnload(runtimeModules);
+	return RETURN_OK;
+}
+
+// [ API ENTRY ]
+// Program executor.
+EVMAPI int ExecuteProgram(runtime_settings_t *runtime) noexcept
+{
+	return RunProgram(runtime);
+}
+
+// [ API ENTRY ]
+// Create program executor pool.
+EVMAPI execution_pool_t *CreateExecutionPool(unsigned int threads) noexcept
+{
+	try {
+		return new execution_pool{ threads };
+	}
+	catch (const std::exception&) {
+		return nullptr;
+	}
+}
+
+// [ API ENTRY ]
+// Asynchronous program executor.
+EVMAPI int ExecuteProgramAsync(execution_pool_t *pool, runtime_settings_t *runtime, completion_handler_t completion) noexcept
+{
+	assert(pool);
+	assert(runtime);
+
+	CHECK_API_VERSION(runtime, EVMAPIVER);
+
+	pool->pool.Submit([runtime, completion]
+	{
+		const int result = RunProgram(runtime);
+		if (completion) {
+			completion(runtime, result);
+		}
+	});
+
+	return RETURN_OK;
+}
+
+// [ API ENTRY ]
+// Wait for program executor pool.
+EVMAPI void WaitExecutionPool(execution_pool_t *pool) noexcept
+{
+	assert(pool);
+	pool->pool.Wait();
+}
+
+// [ API ENTRY ]
+// Release program executor pool.
+EVMAPI void ReleaseExecutionPool(execution_pool_t *pool) noexcept
+{
+	delete pool;
+}
+
+// [ API ENTRY ]
+// Batch program executor.
+EVMAPI int ExecuteProgramBatch(runtime_settings_t **runtimes, int *results, size_t count, unsigned int threads) noexcept
+{
+	assert(runtimes || !count);
+
+	if (!threads) {
+		threads = std::max(std::thread::hardware_concurrency(), 1U);
+	}
+
+	// Reject the batch before any of the programs has started.
+	for (size_t i = 0; i < count; ++i) {
+		CHECK_API_VERSION(runtimes[i], EVMAPIVER);
+	}
+
+	// No point in starting more threads than there are programs.
+	execution_pool pool{ std::min<size_t>(threads, std::max<size_t>(count, 1)) };
+	for (size_t i = 0; i < count; ++i) {
+		pool.pool.Submit([runtimes, results, i]
+		{
+			const int result = RunProgram(runtimes[i]);
+			if (results) {
+				results[i] = result;
+			}
+		});
+	}
 
+	pool.pool.Wait();
 	return RETURN_OK;
 }
 
@@ -0,0 +1,65 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include "../src/FrameArena.h"
+
+#include <boost/test/unit_test.hpp>
+
+//
+// Key         : Arena
+// Test        : Frame arena unit test
+// Type        : unit
+// Description : Memory released in call order is popped from the arena,
+//               memory released out of order is reused before the arena
+//               grows.
+//
+
+using namespace EVM;
+
+BOOST_AUTO_TEST_SUITE(Arena)
+
+BOOST_AUTO_TEST_CASE(ArenaStackOrder)
+{
+	FrameArena arena;
+	void *first = arena.Allocate(64);
+	void *second = arena.Allocate(128);
+	const size_t size = arena.Size();
+	BOOST_REQUIRE_GT(size, 0U);
+
+	arena.Release(second);
+	arena.Release(first);
+	BOOST_REQUIRE_EQUAL(0U, arena.Size());
+}
+
+BOOST_AUTO_TEST_CASE(ArenaOutOfOrder)
+{
+	FrameArena arena;
+	void *caller = arena.Allocate(256);
+	void *callee = arena.Allocate(256);
+	const size_t size = arena.Size();
+
+	// The released chunk below the top is handed out again.
+	for (int i = 0; i < 1000; ++i) {
+		arena.Release(caller);
+		caller = arena.Allocate(200);
+	}
+	BOOST_REQUIRE_EQUAL(size, arena.Size());
+
+	// Smaller chunks do not fit, the arena grows on top.
+	arena.Release(caller);
+	void *large = arena.Allocate(512);
+	BOOST_REQUIRE_GT(arena.Size(), size);
+
+	// Releasing the top pops the released chunks below as well.
+	arena.Release(large);
+	BOOST_REQUIRE_EQUAL(size, arena.Size());
+	arena.Release(callee);
+	BOOST_REQUIRE_EQUAL(0U, arena.Size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,333 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include "../src/NativeJit.h"
+
+#include <CryCC/SubValue.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef EVM_NATIVE_JIT
+
+using namespace EVM;
+using namespace CryCC::Program::Casm;
+using namespace CryCC::SubValue::Valuedef;
+
+namespace
+{
+
+constexpr Word Op(Opcode opcode) noexcept
+{
+	return static_cast<Word>(opcode);
+}
+
+constexpr Word Imm(int32_t value) noexcept
+{
+	return static_cast<Word>(value);
+}
+
+Function MakeFunction(const std::string& name, Word paramCount, Word frameSize, std::vector<Word>&& code)
+{
+	Function function;
+	function.name = name;
+	function.returnKind = SlotKind::INTEGER;
+	function.paramCount = paramCount;
+	function.frameSize = frameSize;
+	function.code = std::move(code);
+	return function;
+}
+
+std::vector<Slot> MakeArguments(std::initializer_list<int32_t> values)
+{
+	std::vector<Slot> args;
+	for (const auto value : values) {
+		Slot slot{};
+		slot.i = value;
+		args.push_back(slot);
+	}
+	return args;
+}
+
+// Run the function in the register machine and as native code, both
+// results must be identical up to the last bit of the slot.
+int32_t RunDifferential(const Module& module, int function, std::initializer_list<int32_t> values = {})
+{
+	BOOST_REQUIRE_NO_THROW(module.Verify());
+
+	NativeModule native{ module };
+	BOOST_REQUIRE(native.IsCompiled(function));
+
+	const auto args = MakeArguments(values);
+	const Slot expected = VirtualMachine::Run(module, function, args);
+	const Slot actual = native.Run(function, args);
+	BOOST_REQUIRE_EQUAL(expected.i, actual.i);
+	BOOST_REQUIRE_EQUAL(0, std::memcmp(&expected, &actual, sizeof(Slot)));
+	return actual.i;
+}
+
+// Single instruction function r(2) = r(0) op r(1).
+Module MakeBinary(Opcode opcode)
+{
+	Module module;
+	module.AddFunction(MakeFunction("binary", 2, 3, {
+		Op(opcode), 2, 0, 1,
+		Op(Opcode::RET), 2,
+	}));
+	return module;
+}
+
+// Fill an array with the squares of the index and return the sum.
+Module MakeLoop()
+{
+	// Slots: a[8] at 0, i at 8, s at 9, t at 10, limit at 11, condition at 12.
+	Module module;
+	module.AddFunction(MakeFunction("main", 0, 13, {
+		Op(Opcode::LOADI), 8, 0,			// 0
+		Op(Opcode::LOADI), 11, 8,			// 3
+		Op(Opcode::LTI), 12, 8, 11,			// 6
+		Op(Opcode::JZ), 12, Imm(18),		// 10
+		Op(Opcode::MULI), 10, 8, 8,			// 13
+		Op(Opcode::STOREX), 0, 8, 10, 8,	// 17
+		Op(Opcode::ADDIK), 8, 8, 1,			// 22
+		Op(Opcode::JMP), Imm(-20),			// 26
+		Op(Opcode::LOADI), 8, 0,			// 28
+		Op(Opcode::LOADI), 9, 0,			// 31
+		Op(Opcode::LTI), 12, 8, 11,			// 34
+		Op(Opcode::JZ), 12, Imm(18),		// 38
+		Op(Opcode::LOADX), 10, 0, 8, 8,		// 41
+		Op(Opcode::ADDI), 9, 9, 10,			// 46
+		Op(Opcode::ADDIK), 8, 8, 1,			// 50
+		Op(Opcode::JMP), Imm(-20),			// 54
+		Op(Opcode::RET), 9,					// 56
+	}));
+	return module;
+}
+
+// Naive recursive fibonacci called from the entry point.
+Module MakeFibonacci()
+{
+	// Slots: n at 0, condition at 1, temporaries at 2 and 3, constant at 4.
+	Module module;
+	module.AddFunction(MakeFunction("fib", 1, 5, {
+		Op(Opcode::LOADI), 4, 2,			// 0
+		Op(Opcode::LTI), 1, 0, 4,			// 3
+		Op(Opcode::JZ), 1, Imm(5),			// 7
+		Op(Opcode::RET), 0,					// 10
+		Op(Opcode::ADDIK), 2, 0, Imm(-1),	// 12
+		Op(Opcode::CALL), 2, 0, 1, 2,		// 16
+		Op(Opcode::ADDIK), 3, 0, Imm(-2),	// 21
+		Op(Opcode::CALL), 3, 0, 1, 3,		// 25
+		Op(Opcode::ADDI), 1, 2, 3,			// 30
+		Op(Opcode::RET), 1,					// 34
+	}));
+	module.AddFunction(MakeFunction("main", 1, 1, {
+		Op(Opcode::CALL), 0, 0, 1, 0,
+		Op(Opcode::RET), 0,
+	}));
+	return module;
+}
+
+// Function calling itself without end.
+Module MakeRecursion()
+{
+	Module module;
+	module.AddFunction(MakeFunction("main", 0, 1, {
+		Op(Opcode::CALL), 0, 0, 0,
+		Op(Opcode::RET), 0,
+	}));
+	return module;
+}
+
+} // namespace
+
+//
+// Key         : Jit
+// Test        : Native code generator unit test
+// Type        : unit
+// Description : Differential test of the native code generator against
+//               the register machine. Each module is run by both and the
+//               results and raised errors must be identical.
+//
+
+BOOST_AUTO_TEST_SUITE(Jit)
+
+BOOST_AUTO_TEST_CASE(JitIntegerBinary)
+{
+	const int32_t values[] = { 0, 1, -1, 2, 7, -7, 31, 32, 33, 100000, -100000, INT_MAX, INT_MIN };
+	const Opcode opcodes[] = {
+		Opcode::ADDI, Opcode::SUBI, Opcode::MULI, Opcode::DIVI, Opcode::MODI,
+		Opcode::ANDI, Opcode::ORI, Opcode::XORI, Opcode::SHLI, Opcode::SHRI,
+		Opcode::EQI, Opcode::NEI, Opcode::LTI, Opcode::LEI, Opcode::GTI, Opcode::GEI,
+	};
+
+	for (const auto opcode : opcodes) {
+		const Module module = MakeBinary(opcode);
+		for (const auto x : values) {
+			for (const auto y : values) {
+				if (!y && (opcode == Opcode::DIVI || opcode == Opcode::MODI)) { continue; }
+				RunDifferential(module, 0, { x, y });
+			}
+		}
+	}
+
+	BOOST_REQUIRE_EQUAL(INT_MIN, RunDifferential(MakeBinary(Opcode::DIVI), 0, { INT_MIN, -1 }));
+	BOOST_REQUIRE_EQUAL(0, RunDifferential(MakeBinary(Opcode::MODI), 0, { INT_MIN, -1 }));
+	BOOST_REQUIRE_EQUAL(INT_MIN, RunDifferential(MakeBinary(Opcode::ADDI), 0, { INT_MAX, 1 }));
+}
+
+BOOST_AUTO_TEST_CASE(JitIntegerUnary)
+{
+	Module module;
+	module.AddFunction(MakeFunction("unary", 1, 5, {
+		Op(Opcode::NEGI), 1, 0,
+		Op(Opcode::NOT), 2, 1,
+		Op(Opcode::BNOT), 3, 2,
+		Op(Opcode::ADDIK), 4, 3, Imm(-3),
+		Op(Opcode::ADDI), 4, 4, 1,
+		Op(Opcode::RET), 4,
+	}));
+
+	for (const auto x : { 0, 1, -1, 42, INT_MAX, INT_MIN }) {
+		RunDifferential(module, 0, { x });
+	}
+}
+
+BOOST_AUTO_TEST_CASE(JitConstant)
+{
+	Module module;
+	module.AddConstant(-5);
+	module.AddConstant(2.5);
+	module.AddFunction(MakeFunction("main", 0, 3, {
+		Op(Opcode::LOADK), 0, 0,
+		Op(Opcode::LOADK), 1, 1,
+		Op(Opcode::MOV), 2, 1,
+		Op(Opcode::ADDI), 2, 2, 0,
+		Op(Opcode::RET), 2,
+	}));
+
+	RunDifferential(module, 0);
+}
+
+BOOST_AUTO_TEST_CASE(JitLoop)
+{
+	BOOST_REQUIRE_EQUAL(140, RunDifferential(MakeLoop(), 0));
+}
+
+BOOST_AUTO_TEST_CASE(JitRecursion)
+{
+	const Module module = MakeFibonacci();
+	BOOST_REQUIRE_EQUAL(0, RunDifferential(module, 1, { 0 }));
+	BOOST_REQUIRE_EQUAL(1, RunDifferential(module, 1, { 1 }));
+	BOOST_REQUIRE_EQUAL(6765, RunDifferential(module, 1, { 20 }));
+}
+
+BOOST_AUTO_TEST_CASE(JitGlobal)
+{
+	Module module;
+	module.AddGlobal("g", SlotKind::INTEGER);
+	module.AddFunction(MakeFunction("__init", 0, 1, {
+		Op(Opcode::LOADI), 0, 41,
+		Op(Opcode::STOREG), 0, 0,
+		Op(Opcode::RETV),
+	}));
+	module.AddFunction(MakeFunction("main", 0, 1, {
+		Op(Opcode::LOADG), 0, 0,
+		Op(Opcode::ADDIK), 0, 0, 1,
+		Op(Opcode::STOREG), 0, 0,
+		Op(Opcode::LOADG), 0, 0,
+		Op(Opcode::RET), 0,
+	}));
+	module.SetInitializer(0);
+
+	// Each run starts with new globals.
+	NativeModule native{ module };
+	BOOST_REQUIRE_EQUAL(42, native.Run(1, {}).i);
+	BOOST_REQUIRE_EQUAL(42, native.Run(1, {}).i);
+	BOOST_REQUIRE_EQUAL(42, RunDifferential(module, 1));
+}
+
+BOOST_AUTO_TEST_CASE(JitTrap)
+{
+	// Division by zero.
+	{
+		const Module module = MakeBinary(Opcode::DIVI);
+		NativeModule native{ module };
+		BOOST_REQUIRE_THROW(VirtualMachine::Run(module, 0, MakeArguments({ 1, 0 })), std::runtime_error);
+		BOOST_REQUIRE_THROW(native.Run(0, MakeArguments({ 1, 0 })), std::runtime_error);
+
+		// The module remains usable after a trap.
+		BOOST_REQUIRE_EQUAL(3, native.Run(0, MakeArguments({ 7, 2 })).i);
+	}
+
+	// Array index out of bounds.
+	{
+		Module module;
+		module.AddFunction(MakeFunction("load", 1, 6, {
+			Op(Opcode::LOADX), 5, 1, 0, 4,
+			Op(Opcode::RET), 5,
+		}));
+		NativeModule native{ module };
+		for (const auto index : { 4, -1, INT_MIN }) {
+			BOOST_REQUIRE_THROW(VirtualMachine::Run(module, 0, MakeArguments({ index })), OutOfBoundsException);
+			BOOST_REQUIRE_THROW(native.Run(0, MakeArguments({ index })), OutOfBoundsException);
+		}
+		RunDifferential(module, 0, { 3 });
+	}
+
+	// Call stack exhausted.
+	{
+		const Module module = MakeRecursion();
+		NativeModule native{ module };
+		BOOST_REQUIRE_THROW(VirtualMachine::Run(module, 0, {}), std::runtime_error);
+		BOOST_REQUIRE_THROW(native.Run(0, {}), std::runtime_error);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(JitFallback)
+{
+	Module module;
+	module.AddConstant(std::string{ "puts" });
+	module.AddFunction(MakeFunction("float", 0, 1, {
+		Op(Opcode::ADDF), 0, 0, 0,
+		Op(Opcode::F2I), 0, 0,
+		Op(Opcode::RET), 0,
+	}));
+	module.AddFunction(MakeFunction("external", 0, 1, {
+		Op(Opcode::CALLX), 0, 0, 0,
+		Op(Opcode::RET), 0,
+	}));
+	module.AddFunction(MakeFunction("caller", 0, 1, {
+		Op(Opcode::CALL), 0, 0, 0,
+		Op(Opcode::RET), 0,
+	}));
+	module.AddFunction(MakeFunction("integer", 0, 1, {
+		Op(Opcode::LOADI), 0, 12,
+		Op(Opcode::RET), 0,
+	}));
+	BOOST_REQUIRE_NO_THROW(module.Verify());
+
+	NativeModule native{ module };
+	BOOST_REQUIRE(!native.IsCompiled(0));
+	BOOST_REQUIRE(!native.IsCompiled(1));
+	BOOST_REQUIRE(!native.IsCompiled(2));
+	BOOST_REQUIRE(native.IsCompiled(3));
+	BOOST_REQUIRE(!native.IsCompiled(Module::npos));
+	BOOST_REQUIRE_EQUAL(1, native.CompiledCount());
+	BOOST_REQUIRE_EQUAL(12, RunDifferential(module, 3));
+
+	// Functions which were not compiled run in the register machine.
+	BOOST_REQUIRE_EQUAL(VirtualMachine::Run(module, 2, {}).i, native.Run(2, {}).i);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif // EVM_NATIVE_JIT
@@ -0,0 +1,538 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include "../src/FrameArena.h"
+
+#include <cprg.h>
+#include <CoilCl/coilcl.h>
+#include <CryEVM/evm.h>
+
+#include <CryCC/AST.h>
+#include <CryCC/Program.h>
+
+#include <Cry/Cry.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <boost/filesystem.hpp>
+
+#include <atomic>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdlib>
+#include <fstream>
+#include <utility>
+#include <thread>
+
+namespace
+{
+
+class ProgramRunner
+{
+	std::string m_source;
+	std::string m_error;
+	program_t m_program{ nullptr };
+	bool m_done{ false };
+
+	// Read the source in one go.
+	static datachunk_t *GetSource(void *user_data)
+	{
+		ProgramRunner *runner = static_cast<ProgramRunner *>(user_data);
+		if (runner->m_done) {
+			return nullptr;
+		}
+
+		datachunk_t *buffer = (datachunk_t*)malloc(sizeof(datachunk_t));
+		buffer->size = static_cast<unsigned int>(runner->m_source.size());
+		buffer->ptr = runner->m_source.data();
+		buffer->unmanaged_res = 0;
+		runner->m_done = true;
+		return buffer;
+	}
+
+	static int Load(void *user_data, const char *source)
+	{
+		CRY_UNUSED(user_data);
+		CRY_UNUSED(source);
+		return 0;
+	}
+
+	static metainfo_t *SourceInfo(void *user_data)
+	{
+		CRY_UNUSED(user_data);
+		metainfo_t *meta_info = (metainfo_t*)malloc(sizeof(metainfo_t));
+
+		std::string meta = "test";
+		CRY_MEMZERO(meta_info->name, sizeof(meta_info->name));
+		std::copy(meta.begin(), meta.end(), meta_info->name);
+		meta_info->size = static_cast<unsigned int>(meta.size());
+		return meta_info;
+	}
+
+	// The compiler and the runtime cannot be unwound from the handler, the
+	// error is kept instead. Programs may run on another thread, each runner
+	// is only reported to by its own program.
+	static void ErrorHandler(void *user_data, const char *message, int fatal)
+	{
+		CRY_UNUSED(fatal);
+		static_cast<ProgramRunner *>(user_data)->m_error = message;
+	}
+
+public:
+	ProgramRunner(const std::string& source, bool bytecode)
+		: m_source{ source }
+	{
+		compiler_info_t info;
+		info.api_ref = COILCLAPIVER;
+		info.code_opt = {};
+		info.code_opt.standard = cil_standard::cil;
+		info.code_opt.optimization = optimization::NONE;
+		info.code_opt.emit_bytecode = bytecode;
+		info.streamReaderVPtr = &ProgramRunner::GetSource;
+		info.loadStreamRequestVPtr = &ProgramRunner::Load;
+		info.streamMetaVPtr = &ProgramRunner::SourceInfo;
+		info.error_handler = &ProgramRunner::ErrorHandler;
+		info.program.program_ptr = nullptr;
+		info.user_data = this;
+		::Compile(&info);
+		m_program = info.program;
+
+		BOOST_REQUIRE_MESSAGE(m_error.empty(), m_error);
+	}
+
+	~ProgramRunner()
+	{
+		::ReleaseProgram(&m_program);
+	}
+
+	// Replace the compiled program by the program restored from its
+	// AIIPX section.
+	void Restore()
+	{
+		result_t result;
+		result.api_ref = COILCLAPIVER;
+		result.tag = result_section_tag::AIIPX;
+		result.program = m_program;
+		::GetResultSection(&result);
+
+		result.program.program_ptr = nullptr;
+		::LoadResultSection(&result);
+		BOOST_REQUIRE(result.program.program_ptr);
+
+		::ReleaseProgram(&m_program);
+		m_program = result.program;
+	}
+
+	// Top level function declaration by name.
+	CryCC::AST::FunctionDecl *Function(const std::string& name)
+	{
+		using namespace CryCC::AST;
+
+		auto program = static_cast<CryCC::Program::Program *>(m_program.program_ptr);
+		for (ASTNode *node : program->AstPassthrough()->ChildNodes()) {
+			if (node && node->Label() == NodeID::FUNCTION_DECL_ID) {
+				auto func = static_cast<FunctionDecl *>(node);
+				if (func->Identifier() == name) {
+					return func;
+				}
+			}
+		}
+		return nullptr;
+	}
+
+	// Runtime settings for the compiled program. The program is profiled
+	// if a profile file is given.
+	runtime_settings_t Settings(bool jit, const char *profileFile = nullptr)
+	{
+		runtime_settings_t settings;
+		settings.api_ref = EVMAPIVER;
+		settings.cfg = {};
+		settings.cfg.disable_jit = !jit;
+		settings.cfg.enable_profiler = profileFile != nullptr;
+		settings.profile_file = profileFile;
+		settings.entry_point = nullptr;
+		settings.return_code = EXIT_FAILURE;
+		settings.error_handler = &ProgramRunner::ErrorHandler;
+		settings.program = m_program;
+		settings.args = nullptr;
+		settings.envs = nullptr;
+		settings.user_data = this;
+		return settings;
+	}
+
+	// Last error reported by the compiler or the runtime.
+	const std::string& Error() const noexcept { return m_error; }
+
+	// Execute the program and return the program exit code.
+	int Run(bool jit, const char *profileFile = nullptr)
+	{
+		runtime_settings_t settings = Settings(jit, profileFile);
+		BOOST_REQUIRE_EQUAL(RETURN_OK, ::ExecuteProgram(&settings));
+		BOOST_REQUIRE_MESSAGE(m_error.empty(), m_error);
+		return settings.return_code;
+	}
+};
+
+// Sum of squares below the given bound.
+std::string SquareSumSource(int bound)
+{
+	return ""
+		"int square(int n) {\n"
+		"	return n * n;\n"
+		"}\n"
+		"int main() {\n"
+		"	int sum = 0;\n"
+		"	for (int i = 0; i < " + std::to_string(bound) + "; i++) {\n"
+		"		sum = sum + square(i);\n"
+		"	}\n"
+		"	return sum;\n"
+		"}";
+}
+
+int SquareSum(int bound)
+{
+	int sum = 0;
+	for (int i = 0; i < bound; ++i) {
+		sum += i * i;
+	}
+	return sum;
+}
+
+// Count down in tail position.
+std::string CountSource(int count)
+{
+	return ""
+		"int count(int n, int acc) {\n"
+		"	if (n == 0) {\n"
+		"		return acc;\n"
+		"	}\n"
+		"	return count(n - 1, acc + 1);\n"
+		"}\n"
+		"int main() {\n"
+		"	return (count(" + std::to_string(count) + ", 0));\n"
+		"}";
+}
+
+// Run the program in the tree walker, the register machine and as
+// native code, all must agree on the exit code.
+int RunDifferential(const char *source)
+{
+	const int expected = ProgramRunner{ source, false }.Run(false);
+
+	ProgramRunner runner{ source, true };
+	BOOST_REQUIRE_EQUAL(expected, runner.Run(false));
+	BOOST_REQUIRE_EQUAL(expected, runner.Run(true));
+	return expected;
+}
+
+} // namespace
+
+//
+// Key         : Program
+// Test        : Program execution unit test
+// Type        : unit
+// Description : Compile complete programs and run them in each strategy,
+//               the exit code must not depend on the strategy. Programs
+//               which cannot be compiled into native code must still
+//               run in another strategy.
+//
+
+BOOST_AUTO_TEST_SUITE(Program)
+
+BOOST_AUTO_TEST_CASE(ProgramArithmetic)
+{
+	BOOST_REQUIRE_EQUAL(61, RunDifferential(""
+		"int main() {\n"
+		"	int a = 7;\n"
+		"	int b = -3;\n"
+		"	int c = a * b + a / b - a % b;\n"
+		"	return (c ^ 85) & 127;\n"
+		"}"));
+}
+
+BOOST_AUTO_TEST_CASE(ProgramLoop)
+{
+	RunDifferential(""
+		"int main() {\n"
+		"	int sieve[512];\n"
+		"	int count = 0;\n"
+		"	for (int i = 2; i < 512; i++) {\n"
+		"		if (sieve[i] == 0) {\n"
+		"			count = count + 1;\n"
+		"			for (int j = i * i; j < 512; j = j + i) {\n"
+		"				sieve[j] = 1;\n"
+		"			}\n"
+		"		}\n"
+		"	}\n"
+		"	return count;\n"
+		"}");
+}
+
+BOOST_AUTO_TEST_CASE(ProgramCall)
+{
+	BOOST_REQUIRE_EQUAL(55, RunDifferential(""
+		"int counter = 0;\n"
+		"int fib(int n) {\n"
+		"	counter = counter + 1;\n"
+		"	if (n < 2) {\n"
+		"		return n;\n"
+		"	}\n"
+		"	return fib(n - 1) + fib(n - 2);\n"
+		"}\n"
+		"int main() {\n"
+		"	return fib(10);\n"
+		"}"));
+}
+
+BOOST_AUTO_TEST_CASE(ProgramFloat)
+{
+	RunDifferential(""
+		"double half(int n) {\n"
+		"	return n / 2.0;\n"
+		"}\n"
+		"int main() {\n"
+		"	return half(9) * 4;\n"
+		"}");
+}
+
+// Record members are accessed through a pointer to the record, also from
+// another function.
+BOOST_AUTO_TEST_CASE(ProgramRecordPointer)
+{
+	BOOST_REQUIRE_EQUAL(84, ProgramRunner(""
+		"struct point {\n"
+		"	int x;\n"
+		"	int y;\n"
+		"};\n"
+		"int move(struct point *p, int dx) {\n"
+		"	p->x = p->x + dx;\n"
+		"	return p->x;\n"
+		"}\n"
+		"int main() {\n"
+		"	struct point q;\n"
+		"	struct point *p = &q;\n"
+		"	p->x = 3;\n"
+		"	p->y = 4;\n"
+		"	move(p, 5);\n"
+		"	return q.x * 10 + p->y;\n"
+		"}", false).Run(false));
+}
+
+// Single precision values are not narrowed in a double slot.
+BOOST_AUTO_TEST_CASE(ProgramSinglePrecision)
+{
+	RunDifferential(""
+		"int main() {\n"
+		"	float f = 0.1;\n"
+		"	return f == 0.1;\n"
+		"}");
+}
+
+// Guest recursion does not recurse on the host stack.
+BOOST_AUTO_TEST_CASE(ProgramDeepRecursion)
+{
+	BOOST_REQUIRE_EQUAL(100000, ProgramRunner(""
+		"int depth(int n) {\n"
+		"	if (n == 0) {\n"
+		"		return 0;\n"
+		"	}\n"
+		"	return 1 + depth(n - 1);\n"
+		"}\n"
+		"int main() {\n"
+		"	return depth(100000);\n"
+		"}", false).Run(false));
+}
+
+// Calls in return position reuse the frame of the caller.
+BOOST_AUTO_TEST_CASE(ProgramTailCall)
+{
+	BOOST_REQUIRE_EQUAL(250000, ProgramRunner(CountSource(250000), false).Run(false));
+}
+
+// Tail calls do not grow the frame arena. The programs run on a new thread
+// which has its own arena, other tests do not affect the arena capacity.
+BOOST_AUTO_TEST_CASE(ProgramTailCallArena)
+{
+	ProgramRunner shallow{ CountSource(100), false };
+	ProgramRunner deep{ CountSource(250000), false };
+	runtime_settings_t shallowSettings = shallow.Settings(false);
+	runtime_settings_t deepSettings = deep.Settings(false);
+
+	size_t shallowCapacity = 0;
+	size_t deepCapacity = 0;
+	std::thread{ [&]
+	{
+		::ExecuteProgram(&shallowSettings);
+		shallowCapacity = EVM::FrameArena::Current().Capacity();
+		::ExecuteProgram(&deepSettings);
+		deepCapacity = EVM::FrameArena::Current().Capacity();
+	} }.join();
+
+	BOOST_REQUIRE_EQUAL(100, shallowSettings.return_code);
+	BOOST_REQUIRE_EQUAL(250000, deepSettings.return_code);
+	BOOST_REQUIRE_GT(shallowCapacity, 0U);
+	BOOST_REQUIRE_EQUAL(shallowCapacity, deepCapacity);
+}
+
+// Errors detected while the program runs are reported to the error handler.
+BOOST_AUTO_TEST_CASE(ProgramRuntimeError)
+{
+	const std::pair<const char *, const char *> programs[] = {
+		{ ""
+			"int value(int n) {\n"
+			"	if (n > 0) {\n"
+			"		return n;\n"
+			"	}\n"
+			"}\n"
+			"int main() {\n"
+			"	return value(0) + 1;\n"
+			"}", "control reached end of function without return value" },
+		{ ""
+			"int main() {\n"
+			"	break;\n"
+			"	return 1;\n"
+			"}", "break statement not within loop or switch" },
+	};
+
+	for (const auto& program : programs) {
+		ProgramRunner runner{ program.first, false };
+		runtime_settings_t settings = runner.Settings(false);
+		BOOST_REQUIRE_EQUAL(RETURN_OK, ::ExecuteProgram(&settings));
+		BOOST_REQUIRE_EQUAL(program.second, runner.Error());
+	}
+}
+
+// Restored programs load the function bodies on first call.
+BOOST_AUTO_TEST_CASE(ProgramLazyLoad)
+{
+	ProgramRunner runner{ ""
+		"int negative(int n) {\n"
+		"	return -n;\n"
+		"}\n"
+		"int square(int n) {\n"
+		"	if (n < 0) {\n"
+		"		return negative(n);\n"
+		"	}\n"
+		"	return n * n;\n"
+		"}\n"
+		"int main() {\n"
+		"	int sum = 0;\n"
+		"	for (int i = 0; i < 10; i++) {\n"
+		"		sum = sum + square(i);\n"
+		"	}\n"
+		"	return sum;\n"
+		"}", false };
+	runner.Restore();
+
+	for (const auto name : { "negative", "square", "main" }) {
+		BOOST_REQUIRE(runner.Function(name));
+		BOOST_REQUIRE(runner.Function(name)->HasDeferredCompound());
+	}
+
+	BOOST_REQUIRE_EQUAL(285, runner.Run(false));
+	BOOST_REQUIRE(!runner.Function("main")->HasDeferredCompound());
+	BOOST_REQUIRE(!runner.Function("square")->HasDeferredCompound());
+	BOOST_REQUIRE(runner.Function("negative")->HasDeferredCompound());
+}
+
+// Independent programs run concurrently, each program has its own result.
+BOOST_AUTO_TEST_CASE(ProgramBatch)
+{
+	constexpr size_t programCount = 8;
+
+	std::vector<std::unique_ptr<ProgramRunner>> runners;
+	std::vector<runtime_settings_t> settings;
+	for (size_t i = 0; i < programCount; ++i) {
+		runners.emplace_back(std::make_unique<ProgramRunner>(SquareSumSource(static_cast<int>(i) + 4), i % 2 != 0));
+		settings.push_back(runners.back()->Settings(false));
+	}
+
+	std::vector<runtime_settings_t *> batch;
+	for (auto& setting : settings) {
+		batch.push_back(&setting);
+	}
+
+	std::vector<int> results(programCount, RETURN_NOT_RUNNABLE);
+	BOOST_REQUIRE_EQUAL(RETURN_OK, ::ExecuteProgramBatch(batch.data(), results.data(), batch.size(), 4));
+	for (size_t i = 0; i < programCount; ++i) {
+		BOOST_REQUIRE_EQUAL(RETURN_OK, results[i]);
+		BOOST_REQUIRE_MESSAGE(runners[i]->Error().empty(), runners[i]->Error());
+		BOOST_REQUIRE_EQUAL(SquareSum(static_cast<int>(i) + 4), settings[i].return_code);
+	}
+}
+
+BOOST_AUTO_TEST_CASE(ProgramAsync)
+{
+	static std::atomic<int> completed;
+	completed = 0;
+
+	ProgramRunner first{ SquareSumSource(10), false };
+	ProgramRunner second{ SquareSumSource(12), false };
+	runtime_settings_t firstSettings = first.Settings(false);
+	runtime_settings_t secondSettings = second.Settings(false);
+
+	execution_pool_t *pool = ::CreateExecutionPool(2);
+	BOOST_REQUIRE(pool);
+
+	auto completion = [](runtime_settings_t *, int result)
+	{
+		if (result == RETURN_OK) {
+			++completed;
+		}
+	};
+	BOOST_REQUIRE_EQUAL(RETURN_OK, ::ExecuteProgramAsync(pool, &firstSettings, completion));
+	BOOST_REQUIRE_EQUAL(RETURN_OK, ::ExecuteProgramAsync(pool, &secondSettings, completion));
+	::WaitExecutionPool(pool);
+
+	BOOST_REQUIRE_EQUAL(2, completed.load());
+	BOOST_REQUIRE_MESSAGE(first.Error().empty(), first.Error());
+	BOOST_REQUIRE_MESSAGE(second.Error().empty(), second.Error());
+	BOOST_REQUIRE_EQUAL(SquareSum(10), firstSettings.return_code);
+	BOOST_REQUIRE_EQUAL(SquareSum(12), secondSettings.return_code);
+
+	::ReleaseExecutionPool(pool);
+}
+
+#ifdef EVM_PROFILER
+
+BOOST_AUTO_TEST_CASE(ProgramProfile)
+{
+	namespace fs = boost::filesystem;
+
+	const fs::path file = fs::temp_directory_path() / fs::unique_path();
+	ProgramRunner runner{ ""
+		"int square(int n) {\n"
+		"	return n * n;\n"
+		"}\n"
+		"int main() {\n"
+		"	int sum = 0;\n"
+		"	for (int i = 0; i < 10; i++) {\n"
+		"		sum = sum + square(i);\n"
+		"	}\n"
+		"	return sum;\n"
+		"}", false };
+	BOOST_REQUIRE_EQUAL(285, runner.Run(false, file.string().c_str()));
+
+	std::ifstream report{ file.string() + ".txt" };
+	std::ifstream stacks{ file.string() + ".folded" };
+	BOOST_REQUIRE(report.good());
+	BOOST_REQUIRE(stacks.good());
+
+	const std::string content{ std::istreambuf_iterator<char>{ stacks }, std::istreambuf_iterator<char>{} };
+	BOOST_CHECK(content.find("main;square ") != std::string::npos);
+
+	report.close();
+	stacks.close();
+	fs::remove(file.string() + ".txt");
+	fs::remove(file.string() + ".folded");
+}
+
+#endif // EVM_PROFILER
+
+BOOST_AUTO_TEST_SUITE_END()
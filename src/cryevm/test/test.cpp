@@ -0,0 +1,13 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#include <Cry/Config.h>
+
+#define BOOST_TEST_MODULE PROGRAM_NAME
+
+#include <boost/test/unit_test.hpp>
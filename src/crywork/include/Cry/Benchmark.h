@@ -0,0 +1,122 @@
+// Copyright (c) 2017 Quenza Inc. All rights reserved.
+//
+// This file is part of the Cryptox project.
+//
+// Use of this source code is governed by a private license
+// that can be found in the LICENSE file. Content can not be 
+// copied and/or distributed without the express of the author.
+
+#pragma once
+
+#include <Cry/Cry.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+namespace Cry
+{
+namespace Benchmark
+{
+
+// Keep the value alive so the optimizer cannot discard the
+// computation which produced the value.
+template<typename Type>
+inline void DoNotOptimize(const Type& value)
+{
+	static volatile const void *sink;
+	sink = static_cast<const void *>(&value);
+}
+
+// Benchmark result.
+struct Result
+{
+	std::string name;
+	size_t iterations;
+	double nanoPerIteration;
+};
+
+using BenchmarkFunction = std::function<void(size_t)>;
+
+struct Entry
+{
+	const char *name;
+	BenchmarkFunction function;
+};
+
+// Global benchmark registry.
+inline std::vector<Entry>& Registry()
+{
+	static std::vector<Entry> s_registry;
+	return s_registry;
+}
+
+struct Register
+{
+	Register(const char *name, BenchmarkFunction function)
+	{
+		Registry().push_back({ name, std::move(function) });
+	}
+};
+
+// Run the benchmark function with an increasing number of iterations
+// until the minimum duration is reached. The function receives the
+// iteration count and must run the measured operation as many times.
+inline Result Measure(const char *name, const BenchmarkFunction& function, std::chrono::milliseconds minTime = std::chrono::milliseconds{ 250 })
+{
+	using clock_type = std::chrono::steady_clock;
+
+	size_t iterations = 1;
+	for (;;) {
+		const auto start = clock_type::now();
+		function(iterations);
+		const auto elapsed = clock_type::now() - start;
+		if (elapsed >= minTime || iterations >= (SIZE_MAX >> 1)) {
+			const auto nano = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(elapsed).count();
+			return { name, iterations, nano / iterations };
+		}
+		iterations <<= 1;
+	}
+}
+
+// Run all registered benchmarks, or the benchmarks which contain the
+// filter in their name. Results are written to the standard output.
+inline int RunAll(int argc, char *argv[])
+{
+	const char *filter = argc > 1 ? argv[1] : nullptr;
+
+	std::printf("%-48s %14s %14s\n", "Benchmark", "Iterations", "ns/op");
+	for (const auto& entry : Registry()) {
+		if (filter && !std::strstr(entry.name, filter)) {
+			continue;
+		}
+
+		const auto result = Measure(entry.name, entry.function);
+		std::printf("%-48s %14zu %14.2f\n", result.name.c_str(), result.iterations, result.nanoPerIteration);
+	}
+
+	return 0;
+}
+
+} // namespace Benchmark
+} // namespace Cry
+
+#define CRY_BENCH_CONCAT_IMPL(a,b) a##b
+#define CRY_BENCH_CONCAT(a,b) CRY_BENCH_CONCAT_IMPL(a,b)
+
+// Register benchmark function with the global registry.
+#define CRY_BENCHMARK(n) \
+	static void n(size_t); \
+	static Cry::Benchmark::Register CRY_BENCH_CONCAT(s_benchRegister_, n){ #n, n }; \
+	static void n(size_t iterations)
+
+// Benchmark entry point.
+#define CRY_BENCHMARK_MAIN() \
+	int main(int argc, char *argv[]) \
+	{ \
+		return Cry::Benchmark::RunAll(argc, argv); \
+	}
@@ -98,6 +98,7 @@ class CompilerHelper
 	{
 		runtime_settings_t settings;
 		settings.api_ref = EVMAPIVER;
+		settings.cfg = {};
 		settings.entry_point = nullptr;
 		settings.return_code = EXIT_FAILURE;
 		settings.error_handler = &CompilerHelper::ErrorHandler;
@@ -471,4 +472,32 @@ BOOST_AUTO_TEST_CASE(ClSysRecord)
 	BOOST_REQUIRE_EQUAL(compiler.ExecutionResult(), 10126);
 }
 
+BOOST_AUTO_TEST_CASE(ClSysArraySubscript)
+{
+	const std::string source = ""
+		"int main() {\n"
+		"	int sieve[100];\n"
+		"	int count = 0;\n"
+		"	for (int i = 2; i < 100; i++) {\n"
+		"		if (sieve[i] == 0) {\n"
+		"			count = count + 1;\n"
+		"			for (int j = i * i; j < 100; j = j + i) {\n"
+		"				sieve[j] = 1;\n"
+		"			}\n"
+		"		}\n"
+		"	}\n"
+		"	sieve[0] = count;\n"
+		"	sieve[0]++;\n"
+		"	return sieve[0];\n"
+		"}";
+
+	CompilerHelper compiler{ source };
+	compiler.RunCompiler();
+	BOOST_REQUIRE(!compiler.IsProgramEmpty());
+
+	compiler.RunVirtualMachine();
+	BOOST_REQUIRE_EQUAL(compiler.VMResult(), 0);
+	BOOST_REQUIRE_EQUAL(compiler.ExecutionResult(), 26);
+}
+
 BOOST_AUTO_TEST_SUITE_END()